@@ -119,6 +119,7 @@ setup(
             libraries=libraries,
         ),
     ],
+    python_requires=">=3.10",
     keywords=keywords,
     classifiers=classifiers,
     long_description=long_description,
@@ -14,6 +14,8 @@
 #--------------------------------------------------------------------------------------------------
 
 import asyncio
+import glob
+import importlib.util
 import math
 import os
 import random
@@ -28,6 +30,13 @@ import unittest
 from tkrzw import *
 
 
+# Returns the length of the value if the key is even.
+def MapEvenKeyToValueSize(key, value):
+  if int(key) % 2 == 0:
+    return (int(key), len(value))
+  return None
+
+
 # Unit testing framework.
 class TestTkrzw(unittest.TestCase):
 
@@ -44,6 +53,27 @@ class TestTkrzw(unittest.TestCase):
   def _make_tmp_path(self, name):
     return os.path.join(self.test_dir, name)
 
+  # Blocks the single worker of an AsyncDBM on a non-concurrent database.  The record "block" is
+  # held by another thread until the returned function is called.
+  def _block_async_worker(self, dbm, adbm):
+    held = threading.Event()
+    release = threading.Event()
+    def Hold(key, value):
+      held.set()
+      release.wait()
+      return None
+    holder = threading.Thread(target=lambda: dbm.Process("block", Hold, True))
+    holder.start()
+    held.wait()
+    future = adbm.Set("block", "done")
+    while adbm.Inspect()["num_running"] < 1:
+      time.sleep(0.001)
+    def Release():
+      release.set()
+      holder.join()
+      self.assertEqual(Status.SUCCESS, future.Get())
+    return Release
+
   # Utility tests.
   def testUtility(self):
     self.assertTrue(re.search(r"^\d+.\d+.\d+$", Utility.VERSION))
@@ -71,6 +101,26 @@ class TestTkrzw(unittest.TestCase):
     float_seq = Utility.SerializeFloat(-123.456)
     self.assertEqual(8, len(float_seq))
     self.assertEqual(-123.456, Utility.DeserializeFloat(float_seq))
+    with self.assertRaises(TypeError):
+      Utility()
+    spec = importlib.util.find_spec("tkrzw")
+    other = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(other)
+    self.assertIsNot(DBM, other.DBM)
+    self.assertEqual(Utility.VERSION, other.Utility.VERSION)
+    with self.assertRaises(StatusException):
+      Status(Status.NOT_FOUND_ERROR).OrDie()
+    with self.assertRaises(other.StatusException):
+      other.Status(Status.NOT_FOUND_ERROR).OrDie()
+    dbm = DBM()
+    self.assertEqual(Status.SUCCESS, dbm.Open("", True))
+    self.assertEqual(type(dbm.Set("a", "b")), Status)
+    other_dbm = other.DBM()
+    self.assertEqual(Status.SUCCESS, other_dbm.Open("", True))
+    self.assertEqual(type(other_dbm.Set("a", "b")), other.Status)
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+    self.assertEqual(Status.SUCCESS, other_dbm.Close())
+    del other
 
   # Status tests.
   def testStatus(self):
@@ -625,6 +675,474 @@ class TestTkrzw(unittest.TestCase):
     self.assertEqual(records, it_records)
     self.assertEqual(Status.SUCCESS, dbm.Close())
 
+  # Parallel map tests.
+  def testParallelMap(self):
+    for num_shards in [0, 3]:
+      path = self._make_tmp_path("casket-{}.tkh".format(num_shards))
+      params = {"num_shards": num_shards} if num_shards else {}
+      dbm = DBM()
+      self.assertEqual(Status.SUCCESS, dbm.Open(path, True, truncate=True, **params))
+      for i in range(100):
+        self.assertEqual(Status.SUCCESS, dbm.Set(str(i), "x" * i))
+      with self.assertRaises(StatusException):
+        dbm.ParallelMap(MapEvenKeyToValueSize, 2)
+      self.assertEqual(Status.SUCCESS, dbm.Close())
+      self.assertEqual(Status.SUCCESS, dbm.Open(path, False, **params))
+      desc = dbm.GetDescriptor()
+      self.assertEqual(path, desc["path"])
+      self.assertTrue(desc["params"]["no_wait"])
+      other = DBM()
+      self.assertEqual(Status.SUCCESS, other.Open(desc["path"], False, **desc["params"]))
+      self.assertEqual(100, other.Count())
+      self.assertEqual(Status.SUCCESS, other.Close())
+      results = dbm.ParallelMap(MapEvenKeyToValueSize, 2)
+      self.assertEqual([(i, i) for i in range(0, 100, 2)], sorted(results))
+      self.assertEqual(100, dbm.Count())
+      results = dbm.ParallelMap(MapEvenKeyToValueSize, 3)
+      self.assertEqual([(i, i) for i in range(0, 100, 2)], sorted(results))
+      if hasattr(os, "fork"):
+        it = dbm.MakeIterator()
+        self.assertEqual(Status.SUCCESS, it.First())
+        pid = os.fork()
+        if pid == 0:
+          code = 0 if not dbm.IsOpen() else 1
+          try:
+            it.Next()
+            code = 1
+          except TypeError:
+            pass
+          os._exit(code)
+        self.assertEqual(0, os.waitpid(pid, 0)[1])
+        self.assertTrue(dbm.IsOpen())
+        self.assertEqual(Status.SUCCESS, it.Next())
+        del it
+      self.assertEqual(Status.SUCCESS, dbm.Close())
+    dbm = DBM()
+    self.assertEqual(Status.SUCCESS, dbm.Open("", True))
+    with self.assertRaises(StatusException):
+      dbm.GetDescriptor()
+    with self.assertRaises(StatusException):
+      dbm.ParallelMap(MapEvenKeyToValueSize)
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+
+  # Shared memory tests.
+  def testSharedMemory(self):
+    if sys.platform == "linux":
+      name = "tkrzw-python-{}.tkh".format(os.getpid())
+    else:
+      name = self._make_tmp_path("casket-shm.tkh")
+    dbm = DBM()
+    self.assertEqual(Status.SUCCESS, dbm.Open(
+      name, True, truncate=True, shared_memory=True, num_buckets=100))
+    path = dbm.GetFilePath()
+    if sys.platform == "linux":
+      self.assertEqual(os.path.join("/dev/shm", name), path)
+    self.assertEqual("HashDBM", dbm.Inspect()["class"])
+    for i in range(100):
+      self.assertEqual(Status.SUCCESS, dbm.Set(str(i), str(i * i)))
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+    readers = [DBM(), DBM()]
+    for reader in readers:
+      self.assertEqual(Status.SUCCESS, reader.Open(name, False, shared_memory=True))
+    for reader in readers:
+      self.assertEqual(100, reader.Count())
+      self.assertEqual("81", reader.GetStr("9"))
+      self.assertEqual(Status.SUCCESS, reader.Close())
+    os.remove(path)
+
+  # Object cache tests.
+  def testObjectCache(self):
+    dbm = DBM()
+    self.assertEqual(Status.SUCCESS, dbm.Open(self._make_tmp_path("casket.tkmt"), True))
+    with self.assertRaises(TypeError):
+      dbm.GetObject("a")
+    decoded = []
+    def Decode(value):
+      decoded.append(value)
+      return [int(x) for x in value.split(b",")]
+    dbm.SetObjectCache(Decode, 20)
+    for i in range(10):
+      self.assertEqual(Status.SUCCESS, dbm.Set(str(i), "{},{}".format(i, i * i)))
+    self.assertEqual([3, 9], dbm.GetObject("3"))
+    self.assertIs(dbm.GetObject("3"), dbm.GetObject("3"))
+    self.assertEqual(1, len(decoded))
+    status = Status()
+    self.assertEqual(None, dbm.GetObject("x", status))
+    self.assertEqual(Status.NOT_FOUND_ERROR, status)
+    self.assertEqual(Status.SUCCESS, dbm.Set("3", "3,3"))
+    self.assertEqual([3, 3], dbm.GetObject("3"))
+    self.assertEqual(Status.SUCCESS, dbm.Append("3", "4", ","))
+    self.assertEqual([3, 3, 4], dbm.GetObject("3"))
+    self.assertEqual(Status.SUCCESS, dbm.Process("3", lambda k, v: "5", True))
+    self.assertEqual([5], dbm.GetObject("3"))
+    self.assertEqual(Status.SUCCESS, dbm.Remove("3"))
+    self.assertEqual(None, dbm.GetObject("3"))
+    for i in range(10):
+      dbm.GetObject(str(i))
+    stats = dbm.InspectObjectCache()
+    self.assertEqual(20, stats["capacity"])
+    self.assertTrue(stats["size"] <= 20)
+    self.assertTrue(stats["num_evictions"] > 0)
+    self.assertEqual(2, stats["num_hits"])
+    self.assertEqual(16, stats["num_misses"])
+    self.assertEqual(Status.SUCCESS, dbm.Clear())
+    self.assertEqual(0, dbm.InspectObjectCache()["count"])
+    self.assertEqual(Status.SUCCESS, dbm.Set("a", "1,2"))
+    self.assertEqual([1, 2], dbm.GetObject("a"))
+    it = dbm.MakeIterator()
+    self.assertEqual(Status.SUCCESS, it.First())
+    self.assertEqual(Status.SUCCESS, it.Set("3,4"))
+    self.assertEqual([3, 4], dbm.GetObject("a"))
+    self.assertEqual(Status.SUCCESS, it.Remove())
+    self.assertEqual(None, dbm.GetObject("a"))
+    self.assertEqual(Status.SUCCESS, dbm.Set("a", "1,2"))
+    self.assertEqual([1, 2], dbm.GetObject("a"))
+    async_dbm = AsyncDBM(dbm, 2)
+    self.assertEqual(Status.SUCCESS, async_dbm.Set("a", "5,6").Get())
+    self.assertEqual([5, 6], dbm.GetObject("a"))
+    self.assertEqual(Status.SUCCESS, async_dbm.SetMulti(a="7,8").Get())
+    self.assertEqual([7, 8], dbm.GetObject("a"))
+    async_dbm.Destruct()
+    def Reconfigure(value):
+      dbm.SetObjectCache(Decode, 100)
+      return Decode(value)
+    dbm.SetObjectCache(Reconfigure, 100)
+    self.assertEqual([7, 8], dbm.GetObject("a"))
+    self.assertEqual([7, 8], dbm.GetObject("a"))
+    self.assertEqual(1, dbm.InspectObjectCache()["count"])
+    dbm.SetObjectCache(None)
+    with self.assertRaises(TypeError):
+      dbm.InspectObjectCache()
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+
+  # Bloom filter tests.
+  def testBloomFilter(self):
+    path = self._make_tmp_path("casket.tkh")
+    dbm = DBM()
+    self.assertEqual(Status.SUCCESS, dbm.Open(
+      path, True, truncate=True, num_buckets=100, bloom_filter=True))
+    for i in range(100):
+      self.assertEqual(Status.SUCCESS, dbm.Set(str(i), str(i * i)))
+    self.assertEqual("81", dbm.GetStr("9"))
+    self.assertTrue("99" in dbm)
+    self.assertFalse("100" in dbm)
+    status = Status()
+    self.assertEqual(None, dbm.GetStr("100", status))
+    self.assertEqual(Status.NOT_FOUND_ERROR, status)
+    self.assertEqual({"1": "1", "2": "4"}, dbm.GetMultiStr("1", "2", "100", "200"))
+    with self.assertRaises(StatusException):
+      dbm["100"]
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+    self.assertTrue(os.path.exists(path + ".bloom"))
+    self.assertEqual(Status.SUCCESS, dbm.Open(path, True, bloom_filter=True))
+    self.assertFalse(os.path.exists(path + ".bloom"))
+    self.assertEqual(100, dbm.Count())
+    for i in range(100):
+      self.assertEqual(str(i * i), dbm.GetStr(str(i)))
+    self.assertEqual(Status.SUCCESS, dbm.Rekey("0", "zero"))
+    self.assertEqual("0", dbm.GetStr("zero"))
+    self.assertEqual(Status.SUCCESS, dbm.Remove("1"))
+    self.assertEqual(None, dbm.GetStr("1"))
+    self.assertEqual(Status.SUCCESS, dbm.Rebuild())
+    self.assertEqual(99, dbm.Count())
+    self.assertEqual("4", dbm.GetStr("2"))
+    self.assertEqual(Status.SUCCESS, dbm.PushLast("queued", 0))
+    queued_keys = [key for key, value in dbm if value == b"queued"]
+    self.assertEqual(1, len(queued_keys))
+    self.assertEqual(b"queued", dbm.Get(queued_keys[0]))
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+    self.assertFalse(os.path.exists(path + ".bloom"))
+
+  # Rebuild job tests.
+  def testRebuildJob(self):
+    path = self._make_tmp_path("casket.tkh")
+    dbm = DBM()
+    self.assertEqual(Status.SUCCESS, dbm.Open(path, True, truncate=True, num_buckets=1000))
+    for i in range(1000):
+      self.assertEqual(Status.SUCCESS, dbm.Set(str(i), str(i) * 10))
+    for i in range(0, 1000, 2):
+      self.assertEqual(Status.SUCCESS, dbm.Remove(str(i)))
+    with self.assertRaises(StatusException):
+      RebuildJob()
+    job = dbm.StartRebuild(delay=60)
+    self.assertEqual("waiting", job.Inspect()["state"])
+    self.assertFalse(job.Wait(0))
+    self.assertTrue(job.Cancel())
+    self.assertFalse(job.Cancel())
+    self.assertTrue(job.Wait(0))
+    self.assertEqual(Status.CANCELED_ERROR, job.Get())
+    self.assertEqual("canceled", job.Inspect()["state"])
+    job = dbm.StartRebuild(num_buckets=200)
+    self.assertTrue(job.Wait(60))
+    self.assertEqual(Status.SUCCESS, job.Get())
+    self.assertFalse(job.Cancel())
+    stats = job.Inspect()
+    self.assertEqual("done", stats["state"])
+    self.assertEqual("SUCCESS", stats["status"])
+    self.assertTrue(int(stats["file_size_after"]) < int(stats["file_size_before"]))
+    self.assertTrue(float(stats["running_time"]) >= 0)
+    self.assertEqual("200", dbm.Inspect()["num_buckets"])
+    self.assertEqual(500, dbm.Count())
+    self.assertEqual("999" * 10, dbm.GetStr("999"))
+    job = dbm.StartRebuild(delay=0.1, low_priority=False)
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+    self.assertTrue(job.Get() in [Status.SUCCESS, Status.PRECONDITION_ERROR])
+    self.assertEqual(Status.SUCCESS, dbm.Open(path, True))
+    job = dbm.StartRebuild(low_priority=False)
+    del dbm
+    self.assertEqual(Status.SUCCESS, job.Get())
+    dbm = DBM()
+    self.assertEqual(Status.SUCCESS, dbm.Open(
+      path, True, truncate=True, num_shards=4, bloom_filter=True))
+    for i in range(1000):
+      self.assertEqual(Status.SUCCESS, dbm.Set(str(i), str(i)))
+    job = dbm.StartRebuild()
+    self.assertEqual(Status.SUCCESS, job.Get())
+    stats = job.Inspect()
+    self.assertEqual("4", stats["num_parts"])
+    self.assertEqual("4", stats["num_rebuilt_parts"])
+    self.assertEqual("1000", stats["num_scanned_keys"])
+    self.assertEqual("false", stats["cancel_requested"])
+    job = dbm.StartRebuild()
+    canceled = job.Cancel()
+    status = job.Get()
+    self.assertTrue(status in [Status.SUCCESS, Status.CANCELED_ERROR])
+    if not canceled:
+      self.assertEqual(Status.SUCCESS, status)
+    self.assertEqual(1000, dbm.Count())
+    self.assertEqual("999", dbm.GetStr("999"))
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+
+  # Maintenance tests.
+  def testMaintenance(self):
+    path = self._make_tmp_path("casket.tkh")
+    dbm = DBM()
+    self.assertEqual(Status.SUCCESS, dbm.Open(path, True, truncate=True, num_buckets=10))
+    with self.assertRaises(TypeError):
+      dbm.InspectMaintenance()
+    self.assertEqual(Status.PRECONDITION_ERROR, dbm.StopMaintenance())
+    self.assertEqual(Status.INVALID_ARGUMENT_ERROR,
+                     dbm.StartMaintenance(rebuild_window="25:00"))
+    for i in range(1000):
+      self.assertEqual(Status.SUCCESS, dbm.Set(str(i), str(i) * 10))
+    for i in range(0, 1000, 2):
+      self.assertEqual(Status.SUCCESS, dbm.Remove(str(i)))
+    self.assertTrue(dbm.ShouldBeRebuilt())
+    self.assertEqual(Status.SUCCESS, dbm.StartMaintenance(
+      interval=0.01, sync_interval=0.01, rebuild_window="00:00-00:00", num_buckets=2000))
+    stats = dbm.InspectMaintenance()
+    self.assertEqual("0.01", stats["interval"][:4])
+    self.assertFalse("rebuild_window" in stats)
+    deadline = time.time() + 30
+    while time.time() < deadline:
+      stats = dbm.InspectMaintenance()
+      if int(stats["num_rebuilds"]) > 0 and int(stats["num_syncs"]) > 0:
+        break
+      time.sleep(0.01)
+    self.assertTrue(int(stats["num_rebuilds"]) > 0)
+    self.assertTrue(int(stats["num_syncs"]) > 0)
+    self.assertEqual("SUCCESS", stats["last_status"])
+    self.assertFalse(dbm.ShouldBeRebuilt())
+    self.assertEqual("2000", dbm.Inspect()["num_buckets"])
+    self.assertEqual(500, dbm.Count())
+    self.assertEqual(Status.SUCCESS, dbm.StopMaintenance())
+    with self.assertRaises(TypeError):
+      dbm.InspectMaintenance()
+    self.assertEqual(Status.SUCCESS, dbm.StartMaintenance(
+      interval=0.01, rebuild_window="23:00-04:00"))
+    self.assertEqual("23:00-04:00", dbm.InspectMaintenance()["rebuild_window"])
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+    self.assertEqual(Status.SUCCESS, dbm.Open(path, False))
+    self.assertEqual(Status.PRECONDITION_ERROR, dbm.StartMaintenance())
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+    self.assertEqual(Status.SUCCESS, dbm.Open(path, True))
+    self.assertEqual(Status.SUCCESS, dbm.StartMaintenance(interval=0.01, sync_interval=0.01))
+    time.sleep(0.05)
+    del dbm
+
+  # Group commit tests.
+  def testCommit(self):
+    path = self._make_tmp_path("casket.tkh")
+    dbm = DBM()
+    self.assertEqual(Status.SUCCESS, dbm.Open(
+      path, True, truncate=True, num_buckets=1000, commit_delay=0.02))
+    self.assertFalse("num_commit_requests" in dbm.Inspect())
+    num_threads = 8
+    num_iterations = 10
+    results = []
+    def Write(thid):
+      for i in range(num_iterations):
+        key = "{}-{}".format(thid, i)
+        dbm.Set(key, key)
+        results.append(dbm.Commit(i % 2 == 0))
+    threads = [threading.Thread(target=Write, args=(i,)) for i in range(num_threads)]
+    for thread in threads:
+      thread.start()
+    for thread in threads:
+      thread.join()
+    self.assertEqual(num_threads * num_iterations, len(results))
+    for result in results:
+      self.assertEqual(Status.SUCCESS, result)
+    stats = dbm.Inspect()
+    self.assertEqual(str(num_threads * num_iterations), stats["num_commit_requests"])
+    self.assertTrue(int(stats["num_commit_syncs"]) < num_threads * num_iterations)
+    self.assertEqual(Status.SUCCESS, dbm.Commit())
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+    self.assertEqual(Status.SUCCESS, dbm.Open(path, False))
+    self.assertEqual(num_threads * num_iterations, dbm.Count())
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+
+  # Update log tests.
+  def testUpdateLog(self):
+    leader_path = self._make_tmp_path("leader.tkh")
+    follower_path = self._make_tmp_path("follower.tkt")
+    ulog_prefix = self._make_tmp_path("casket-ulog")
+    leader = DBM()
+    self.assertEqual(Status.SUCCESS, leader.Open(
+      leader_path, True, truncate=True, num_buckets=100,
+      ulog_prefix=ulog_prefix, ulog_server_id=1, ulog_dbm_index=2))
+    for i in range(10):
+      self.assertEqual(Status.SUCCESS, leader.Set(i, i * i))
+    self.assertEqual(Status.SUCCESS, leader.Remove(3))
+    reader = UpdateLogReader()
+    self.assertEqual("(unopened)", str(reader))
+    self.assertEqual(Status.SUCCESS, reader.Open(ulog_prefix))
+    self.assertTrue("timestamp=" in repr(reader))
+    op, key, value, server_id, dbm_index = UpdateLogReader.ParseMessage(
+      reader.Read()[0][1])
+    self.assertEqual(("set", b"0", b"0", 1, 2), (op, key, value, server_id, dbm_index))
+    self.assertEqual(Status.SUCCESS, reader.Close())
+    self.assertEqual(Status.SUCCESS, reader.Open(ulog_prefix))
+    follower = DBM()
+    self.assertEqual(Status.SUCCESS, follower.Open(follower_path, True, truncate=True))
+    status = Status()
+    entries = reader.Read(100, 0, status)
+    self.assertEqual(Status.SUCCESS, status)
+    self.assertEqual(11, len(entries))
+    self.assertTrue(reader.GetTimestamp() >= entries[0][0])
+    self.assertEqual(Status.SUCCESS, follower.ApplyUpdateLog(entries, 2))
+    self.assertEqual(0, follower.Count())
+    self.assertEqual(Status.SUCCESS, follower.ApplyUpdateLog(entries, 1, 2))
+    self.assertEqual(9, follower.Count())
+    self.assertEqual("16", follower.GetStr("4"))
+    self.assertEqual(None, follower.GetStr("3"))
+    self.assertEqual(0, len(reader.Read(1, 0, status)))
+    self.assertEqual(Status.INFEASIBLE_ERROR, status)
+    self.assertEqual(Status.SUCCESS, leader.Clear())
+    self.assertEqual(Status.SUCCESS, leader.Set("hello", "world"))
+    entries = reader.Read(100, 1.0)
+    self.assertEqual(2, len(entries))
+    self.assertEqual("clear", UpdateLogReader.ParseMessage(entries[0][1])[0])
+    self.assertEqual(Status.SUCCESS, follower.ApplyUpdateLog(
+      [x[1] for x in entries]))
+    self.assertEqual(1, follower.Count())
+    self.assertEqual("world", follower.GetStr("hello"))
+    with self.assertRaises(StatusException):
+      UpdateLogReader.ParseMessage(b"broken")
+    self.assertEqual(Status.SUCCESS, reader.Close())
+    self.assertEqual(Status.SUCCESS, follower.Close())
+    self.assertEqual(Status.SUCCESS, leader.Close())
+
+  # Snapshot tests.
+  def testSnapshot(self):
+    confs = [
+      {"path": "casket.tkh", "open_params": {"num_buckets": 100}},
+      {"path": "casket.tkt", "open_params": {"num_buckets": 100}},
+      {"path": "casket-shard.tkh", "open_params": {"num_shards": 3}},
+      {"path": "", "open_params": {"dbm": "BabyDBM"}},
+    ]
+    for conf in confs:
+      path = conf["path"]
+      path = self._make_tmp_path(path) if path else ""
+      dbm = DBM()
+      self.assertEqual(Status.SUCCESS, dbm.Open(
+        path, True, truncate=True, **conf["open_params"]))
+      for i in range(100):
+        self.assertEqual(Status.SUCCESS, dbm.Set(str(i), str(i * i)))
+      snapshot = dbm.Snapshot()
+      self.assertEqual(Status.SUCCESS, dbm.Set("0", "zero"))
+      self.assertEqual(Status.SUCCESS, dbm.Set("extra", "extra"))
+      self.assertEqual(Status.SUCCESS, dbm.Remove("1"))
+      self.assertEqual(100, snapshot.Count())
+      self.assertEqual("0", snapshot.GetStr("0"))
+      self.assertEqual("1", snapshot.GetStr("1"))
+      self.assertEqual(None, snapshot.GetStr("extra"))
+      self.assertEqual(100, len(list(snapshot)))
+      snapshot_path = snapshot.GetFilePath()
+      if path:
+        self.assertFalse(snapshot.IsWritable())
+        self.assertNotEqual(path, snapshot_path)
+        self.assertEqual(Status.SUCCESS, snapshot.Close())
+        self.assertEqual(0, len(glob.glob(snapshot_path + "*")))
+        dest_path = self._make_tmp_path("snapshot-" + conf["path"])
+        snapshot = dbm.Snapshot(dest_path)
+        self.assertEqual(dbm.Count(), snapshot.Count())
+        self.assertEqual(Status.SUCCESS, snapshot.Close())
+        self.assertTrue(len(glob.glob(dest_path + "*")) > 0)
+      else:
+        self.assertEqual(Status.SUCCESS, snapshot.Close())
+      self.assertEqual(101, dbm.Count())
+      self.assertEqual(Status.SUCCESS, dbm.Close())
+
+  # Backup tests.
+  def testBackup(self):
+    path = self._make_tmp_path("casket.tkh")
+    dbm = DBM()
+    self.assertEqual(Status.SUCCESS, dbm.Open(path, True, truncate=True, num_buckets=1000))
+    for i in range(1000):
+      self.assertEqual(Status.SUCCESS, dbm.Set(str(i), str(i) * 10))
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+    self.assertEqual(Status.SUCCESS, dbm.Open(path, False))
+    total_size = os.path.getsize(path)
+    backup_path = self._make_tmp_path("casket-backup.tkh")
+    steps = []
+    def Cancel(done, total):
+      steps.append((done, total))
+      return False
+    self.assertEqual(Status.CANCELED_ERROR, dbm.Backup(backup_path, 0, 100000, Cancel))
+    self.assertEqual(1, len(steps))
+    self.assertEqual(10000, steps[0][0])
+    self.assertEqual(total_size, steps[0][1])
+    self.assertEqual(10000, os.path.getsize(backup_path))
+    steps.clear()
+    start_time = time.time()
+    self.assertEqual(Status.SUCCESS, dbm.Backup(
+      backup_path, os.path.getsize(backup_path), 1000000, lambda d, t: steps.append(d)))
+    self.assertTrue(time.time() - start_time >= (total_size - 10000) / 1000000 * 0.9)
+    self.assertEqual(total_size, steps[-1])
+    self.assertEqual(total_size, os.path.getsize(backup_path))
+    file = File()
+    file_path = self._make_tmp_path("casket-backup-file.tkh")
+    self.assertEqual(Status.SUCCESS, file.Open(file_path, True))
+    self.assertEqual(Status.SUCCESS, dbm.Backup(file))
+    self.assertEqual(total_size, file.GetSize())
+    self.assertEqual(Status.SUCCESS, file.Close())
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+    for copy_path in [backup_path, file_path]:
+      with open(path, "rb") as src, open(copy_path, "rb") as dest:
+        self.assertEqual(src.read(), dest.read())
+      copy_dbm = DBM()
+      self.assertEqual(Status.SUCCESS, copy_dbm.Open(copy_path, False))
+      self.assertEqual(1000, copy_dbm.Count())
+      self.assertEqual("999" * 10, copy_dbm.GetStr("999"))
+      self.assertEqual(Status.SUCCESS, copy_dbm.Close())
+    self.assertEqual(Status.SUCCESS, dbm.Open(path, True))
+    self.assertEqual(Status.SUCCESS, dbm.Set("new", "record"))
+    steps.clear()
+    self.assertEqual(Status.SUCCESS, dbm.Backup(
+      backup_path, 0, 0, lambda d, t: steps.append(d), True))
+    self.assertEqual(1, len(steps))
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+    copy_dbm = DBM()
+    self.assertEqual(Status.SUCCESS, copy_dbm.Open(backup_path, False))
+    self.assertEqual(1001, copy_dbm.Count())
+    self.assertEqual("record", copy_dbm.GetStr("new"))
+    self.assertEqual(Status.SUCCESS, copy_dbm.Close())
+    dbm = DBM()
+    self.assertEqual(Status.SUCCESS, dbm.Open("", True))
+    self.assertEqual(Status.PRECONDITION_ERROR, dbm.Backup(backup_path))
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+
   # Search tests.
   def testSearch(self):
     confs = [
@@ -702,6 +1220,81 @@ class TestTkrzw(unittest.TestCase):
       self.assertRaises(file.Search("foo", "00000100", 3))
     self.assertEqual(Status.SUCCESS, file.Close())
 
+  # Parallel export tests.
+  def testParallelExport(self):
+    src_path = self._make_tmp_path("casket.tkh")
+    src_dbm = DBM()
+    self.assertEqual(Status.SUCCESS, src_dbm.Open(
+      src_path, True, truncate=True, num_shards=4, num_buckets=100, concurrent=True))
+    for i in range(1, 101):
+      self.assertEqual(Status.SUCCESS, src_dbm.Set("{:08d}".format(i), str(i)))
+    dest_dbm = DBM()
+    self.assertEqual(Status.SUCCESS, dest_dbm.Open("", True, dbm="BabyDBM", concurrent=True))
+    self.assertEqual(Status.SUCCESS, src_dbm.ParallelExport(dest_dbm))
+    self.assertEqual(100, dest_dbm.Count())
+    self.assertEqual("77", dest_dbm.GetStr("00000077"))
+    with self.assertRaises(TypeError):
+      src_dbm.ParallelExport(src_dbm)
+    files = []
+    for i in range(4):
+      file = File()
+      self.assertEqual(Status.SUCCESS, file.Open(
+        self._make_tmp_path("casket-{}.flat".format(i)), True, truncate=True))
+      files.append(file)
+    with self.assertRaises(TypeError):
+      src_dbm.ParallelExportToFlatRecords(files[:3])
+    with self.assertRaises(TypeError):
+      src_dbm.ParallelExportToFlatRecords([files[0]] * 4)
+    self.assertEqual(Status.SUCCESS, src_dbm.ParallelExportToFlatRecords(files))
+    self.assertTrue(all(file.GetSize() > 0 for file in files))
+    self.assertEqual(Status.SUCCESS, dest_dbm.Clear())
+    self.assertEqual(Status.SUCCESS, dest_dbm.ParallelImportFromFlatRecords(files))
+    self.assertEqual(100, dest_dbm.Count())
+    self.assertEqual("100", dest_dbm.GetStr("00000100"))
+    for file in files:
+      self.assertEqual(Status.SUCCESS, file.Close())
+    self.assertEqual(Status.SUCCESS, dest_dbm.Close())
+    self.assertEqual(Status.SUCCESS, src_dbm.Close())
+
+  # Bulk load tests.
+  def testBulkLoadSorted(self):
+    for ext in ["tkt", "tks"]:
+      path = self._make_tmp_path("casket." + ext)
+      dbm = DBM()
+      self.assertEqual(Status.SUCCESS, dbm.Open(path, True, truncate=True))
+      records = (("{:08d}".format(i), str(i)) for i in range(1, 1001))
+      self.assertEqual(Status.SUCCESS, dbm.BulkLoadSorted(records))
+      self.assertEqual(1000, dbm.Count())
+      self.assertEqual("500", dbm.GetStr("00000500"))
+      self.assertEqual(Status.SUCCESS, dbm.Clear())
+      keys = [(i * 7919) % 1000 for i in range(1000)]
+      records = [("{:08d}".format(k), str(k)) for k in keys]
+      records.append(["00000003", "last"])
+      self.assertEqual(Status.SUCCESS, dbm.BulkLoadSorted(records, 1024))
+      self.assertEqual(1000, dbm.Count())
+      self.assertEqual("999", dbm.GetStr("00000999"))
+      self.assertEqual("last", dbm.GetStr("00000003"))
+      iter = dbm.MakeIterator()
+      iter.First()
+      self.assertEqual("00000000", iter.GetKeyStr())
+      del iter
+      self.assertEqual(Status.SUCCESS, dbm.Clear())
+      records = [("{:08d}".format(i), "upper") for i in range(500, 1000)]
+      records.extend([("{:08d}".format(i), "lower") for i in range(500)])
+      self.assertEqual(Status.SUCCESS, dbm.BulkLoadSorted(records, 1024))
+      self.assertEqual(1000, dbm.Count())
+      self.assertEqual("lower", dbm.GetStr("00000000"))
+      self.assertEqual("upper", dbm.GetStr("00000999"))
+      keys = [key.decode() for key, value in dbm]
+      self.assertEqual(sorted(keys), keys)
+      with self.assertRaises(TypeError):
+        dbm.BulkLoadSorted(["foo"])
+      self.assertEqual(Status.SUCCESS, dbm.Close())
+    dbm = DBM()
+    self.assertEqual(Status.SUCCESS, dbm.Open("", True, dbm="TinyDBM"))
+    self.assertEqual(Status.NOT_IMPLEMENTED_ERROR, dbm.BulkLoadSorted([("a", "b")]))
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+
   # AsyncDBM tests.
   def testAsyncDBM(self):
     dbm = DBM()
@@ -717,6 +1310,8 @@ class TestTkrzw(unittest.TestCase):
     set_future.Wait(0)
     self.assertTrue(set_future.Wait())
     self.assertEqual(Status.SUCCESS, set_future.Get())
+    with self.assertRaises(TypeError):
+      set_future.Get()
     self.assertEqual(Status.DUPLICATION_ERROR, adbm.Set("one", "more", False).Get())
     self.assertEqual(Status.SUCCESS, adbm.Set("two", "step", False).Get())
     self.assertEqual(Status.SUCCESS, adbm.Set("three", "jump", False).Get())
@@ -836,6 +1431,102 @@ class TestTkrzw(unittest.TestCase):
     self.assertEqual(Status.SUCCESS, pop_result[0])
     self.assertEqual(b"\0\0\0\0\0\0\0\0", pop_result[1])
     self.assertEqual(b"foo", pop_result[2])
+    stats = adbm.Inspect()
+    self.assertEqual(4, stats["num_threads"])
+    self.assertEqual(0, stats["max_queue_size"])
+    self.assertTrue(stats["num_done"] > 0)
+    self.assertTrue(stats["wait_time_max"] >= stats["wait_time_mean"])
+    self.assertTrue(0 <= stats["utilization"] <= 1)
+    adbm.Destruct()
+    adbm = AsyncDBM(dbm, 1, max_queue_size=2, overflow="fail")
+    futures = [adbm.Set(str(i), i) for i in range(100)]
+    statuses = [future.Get() for future in futures]
+    self.assertTrue(Status.SUCCESS in statuses)
+    self.assertEqual(adbm.Inspect()["num_rejected"],
+                     statuses.count(Status.INFEASIBLE_ERROR))
+    adbm.Destruct()
+    adbm = AsyncDBM(dbm, 1, max_queue_size=2)
+    futures = [adbm.Set(str(i), i) for i in range(100)]
+    for future in futures:
+      self.assertEqual(Status.SUCCESS, future.Get())
+    self.assertTrue(adbm.Inspect()["queue_size"] <= 2)
+    adbm.Destruct()
+    with self.assertRaises(TypeError):
+      AsyncDBM(dbm, 1, overflow="unknown")
+    block_dbm = DBM()
+    self.assertEqual(Status.SUCCESS, block_dbm.Open("", True, dbm="TinyDBM"))
+    adbm = AsyncDBM(block_dbm, 1)
+    bg_adbm = adbm.WithOptions(AsyncDBM.PRIORITY_BACKGROUND)
+    fg_adbm = adbm.WithOptions(AsyncDBM.PRIORITY_INTERACTIVE)
+    release = self._block_async_worker(block_dbm, adbm)
+    futures = []
+    for i in range(10):
+      futures.append(bg_adbm.Append("order", "b", ""))
+      futures.append(adbm.Append("order", "n", ""))
+      futures.append(fg_adbm.Append("order", "i", ""))
+    expired_future = adbm.WithOptions(AsyncDBM.PRIORITY_INTERACTIVE, 0).Set("late", "x")
+    release()
+    for future in futures:
+      self.assertEqual(Status.SUCCESS, future.Get())
+    self.assertEqual(Status.CANCELED_ERROR, expired_future.Get())
+    self.assertEqual("i" * 10 + "n" * 10 + "b" * 10, block_dbm.GetStr("order"))
+    self.assertEqual(None, block_dbm.GetStr("late"))
+    self.assertEqual(1, adbm.Inspect()["num_expired"])
+    adbm.Destruct()
+    adbm = AsyncDBM(dbm, 1)
+    bg_adbm = adbm.WithOptions(AsyncDBM.PRIORITY_BACKGROUND, 0)
+    self.assertEqual(Status.SUCCESS, bg_adbm.WithOptions(AsyncDBM.PRIORITY_NORMAL).Set(
+      "foo", "bar").Get())
+    with self.assertRaises(TypeError):
+      adbm.WithOptions(3)
+    adbm.Destruct()
+    self.assertEqual(Status.CANCELED_ERROR, bg_adbm.Get("foo").Get()[0])
+    adbm = AsyncDBM(block_dbm, 1, coalesce=True)
+    release = self._block_async_worker(block_dbm, adbm)
+    set_futures = [adbm.Set("hot", i) for i in range(100)]
+    get_futures = [adbm.GetStr("hot") for i in range(100)]
+    self.assertEqual(198, adbm.Inspect()["num_coalesced"])
+    release()
+    for future in set_futures:
+      self.assertEqual(Status.SUCCESS, future.Get())
+    for future in get_futures:
+      status, value = future.Get()
+      self.assertEqual(Status.SUCCESS, status)
+      self.assertEqual("99", value)
+    self.assertEqual(Status.SUCCESS, adbm.Append("hot", "x", "").Get())
+    self.assertEqual(Status.SUCCESS, adbm.Set("hot", "y").Get())
+    self.assertEqual("y", adbm.GetStr("hot").Get()[1])
+    adbm.Destruct()
+    self.assertEqual(Status.SUCCESS, block_dbm.Close())
+    executor = AsyncExecutor(2, pin_cpus=True)
+    self.assertEqual(2, executor.Inspect()["num_threads"])
+    adbms = [AsyncDBM(dbm, executor) for i in range(3)]
+    futures = []
+    for i, adbm in enumerate(adbms):
+      futures.extend([adbm.Set("{}-{}".format(i, j), j) for j in range(50)])
+    for future in futures:
+      self.assertEqual(Status.SUCCESS, future.Get())
+    for adbm in adbms:
+      self.assertEqual(2, adbm.Inspect()["num_threads"])
+      adbm.Destruct()
+    self.assertEqual("49", dbm.GetStr("2-49"))
+    self.assertTrue(executor.Inspect()["num_executed"] >= 150)
+    with self.assertRaises(TypeError):
+      AsyncDBM(dbm, 2, shard_routing=True)
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+    shard_path = self._make_tmp_path("casket-shard.tkh")
+    self.assertEqual(Status.SUCCESS, dbm.Open(
+      shard_path, True, num_shards=4, num_buckets=100, concurrent=True))
+    adbm = AsyncDBM(dbm, 3, shard_routing=True)
+    futures = [adbm.Set(str(i), i) for i in range(100)]
+    for future in futures:
+      self.assertEqual(Status.SUCCESS, future.Get())
+    for i in range(100):
+      self.assertEqual(str(i), adbm.GetStr(str(i)).Get()[1])
+    self.assertEqual(100, dbm.Count())
+    stats = adbm.Inspect()
+    self.assertEqual(4, stats["num_shards"])
+    self.assertEqual(3, stats["num_threads"])
     adbm.Destruct()
     self.assertEqual(Status.SUCCESS, dbm.Close())
     
@@ -868,6 +1559,270 @@ class TestTkrzw(unittest.TestCase):
     self.assertEqual("E12345F", file.ReadStr(4, 7))
     self.assertEqual(Status.SUCCESS, file.Close())
 
+  # File buffer tests.
+  def testFileBuffer(self):
+    path = self._make_tmp_path("casket.txt")
+    file = File()
+    self.assertEqual(Status.SUCCESS, file.Open(path, True, truncate=True))
+    self.assertEqual(Status.SUCCESS, file.Write(0, memoryview(b"0123456789")))
+    self.assertEqual(Status.SUCCESS, file.Write(2, memoryview(b"xxABCxx")[2:5]))
+    status = Status()
+    self.assertEqual(10, file.Append(bytearray(b"abc"), status))
+    self.assertEqual(Status.SUCCESS, status)
+    self.assertEqual(b"01ABC56789abc", file.Read(0, 13))
+    buf = bytearray(5)
+    self.assertEqual(Status.SUCCESS, file.ReadInto(2, buf))
+    self.assertEqual(b"ABC56", buf)
+    buf = bytearray(b"----------")
+    self.assertEqual(Status.SUCCESS, file.ReadInto(10, memoryview(buf)[4:7]))
+    self.assertEqual(b"----abc---", buf)
+    self.assertEqual(Status.INFEASIBLE_ERROR, file.ReadInto(12, bytearray(5)))
+    with self.assertRaises(TypeError):
+      file.ReadInto(0, b"immutable")
+    self.assertEqual(Status.SUCCESS, file.Write(13, memoryview(b"0123456789")[::2]))
+    self.assertEqual(b"02468", file.Read(13, 5))
+    released = memoryview(b"released")
+    released.release()
+    with self.assertRaises(ValueError):
+      file.Write(0, released)
+    with self.assertRaises(ValueError):
+      file.Append(released)
+    self.assertEqual(b"01ABC56789abc02468", file.Read(0, 18))
+    self.assertEqual(Status.SUCCESS, file.Close())
+    dbm = DBM()
+    self.assertEqual(Status.SUCCESS, dbm.Open("", True))
+    key = memoryview(b"key")
+    self.assertEqual(Status.SUCCESS, dbm.Set(key, "value"))
+    self.assertEqual("value", dbm.GetStr(str(key)))
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+
+  # File multiple reading tests.
+  def testFileReadMulti(self):
+    path = self._make_tmp_path("casket.txt")
+    file = File()
+    self.assertEqual(Status.SUCCESS, file.Open(
+      path, True, truncate=True, file="PositionalParallelFile"))
+    data = "".join("{:08d}".format(i) for i in range(1000))
+    self.assertEqual(Status.SUCCESS, file.Write(0, data))
+    ranges = [(8, 8), (0, 8), (4, 8), (100, 0), (16, 3)]
+    self.assertEqual([b"00000001", b"00000000", b"00000000", b"", b"000"],
+                     file.ReadMulti(ranges))
+    buf, offsets = file.ReadMulti(ranges, True)
+    self.assertEqual(b"000000010000000000000000000", buf)
+    self.assertEqual([0, 8, 16, 24, 24], offsets)
+    ranges = [(i * 16 + 8, 8) for i in range(500)]
+    ranges.reverse()
+    records = file.ReadMulti(ranges)
+    self.assertEqual(500, len(records))
+    for (off, size), record in zip(ranges, records):
+      self.assertEqual(data[off:off + size].encode(), record)
+    status = Status()
+    self.assertEqual(None, file.ReadMulti([(0, 8), (len(data), 8)], False, status))
+    self.assertEqual(Status.INFEASIBLE_ERROR, status)
+    self.assertEqual([], file.ReadMulti([]))
+    with self.assertRaises(TypeError):
+      file.ReadMulti([(0, 8, 1)])
+    self.assertEqual(Status.SUCCESS, file.Close())
+
+  # File view tests.
+  def testFileView(self):
+    path = self._make_tmp_path("casket.txt")
+    file = File()
+    self.assertEqual(Status.SUCCESS, file.Open(
+      path, True, truncate=True, file="MemoryMapParallelFile"))
+    self.assertEqual(Status.SUCCESS, file.Write(0, "0123456789"))
+    with file.MakeView(2, 5) as view:
+      self.assertTrue(view.readonly)
+      self.assertEqual(b"23456", view.tobytes())
+      self.assertEqual(Status.SUCCESS, file.Write(0, "ab"))
+      self.assertEqual(b"ab", file.MakeView(0, 2).tobytes())
+      self.assertEqual(Status.PRECONDITION_ERROR, file.Write(9, "xyz"))
+      self.assertEqual(None, file.Append("xyz"))
+      self.assertEqual(Status.PRECONDITION_ERROR, file.Truncate(5))
+      self.assertEqual(Status.PRECONDITION_ERROR, file.Close())
+    with file.MakeView(5, 100, True) as view:
+      self.assertEqual(5, len(view))
+      view[0:2] = b"XY"
+    self.assertEqual(b"ab234XY789", file.Read(0, 10))
+    dbm = DBM()
+    self.assertEqual(Status.SUCCESS, dbm.Open("", True))
+    self.assertEqual(Status.SUCCESS, dbm.Set("one", "first"))
+    with file.MakeView(0, 10) as view:
+      self.assertEqual(Status.PRECONDITION_ERROR, dbm.ExportToFlatRecords(file))
+      self.assertEqual(Status.PRECONDITION_ERROR, dbm.ExportKeysAsLines(file))
+      self.assertEqual(b"ab234XY789", view.tobytes())
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+    self.assertEqual(Status.SUCCESS, file.Advise(0, 10, "sequential"))
+    self.assertEqual(Status.SUCCESS, file.Advise(0, 10, "willneed"))
+    with self.assertRaises(TypeError):
+      file.Advise(0, 10, "unknown")
+    status = Status()
+    self.assertEqual(None, file.MakeView(100, 10, False, status))
+    self.assertEqual(Status.INFEASIBLE_ERROR, status)
+    self.assertEqual(10, file.Append("xyz"))
+    self.assertEqual(Status.SUCCESS, file.Close())
+    self.assertEqual(Status.SUCCESS, file.Open(path, False, file="MemoryMapAtomicFile"))
+    self.assertEqual(b"ab234XY789xyz", bytes(file.MakeView(0, 13)))
+    self.assertEqual(None, file.MakeView(0, 13, True, status))
+    self.assertEqual(Status.PRECONDITION_ERROR, status)
+    self.assertEqual(Status.SUCCESS, file.Close())
+    self.assertEqual(Status.SUCCESS, file.Open(path, False, file="PositionalParallelFile"))
+    self.assertEqual(None, file.MakeView(0, 13, False, status))
+    self.assertEqual(Status.NOT_IMPLEMENTED_ERROR, status)
+    self.assertEqual(Status.NOT_IMPLEMENTED_ERROR, file.Advise(0, 13, "random"))
+    self.assertEqual(Status.SUCCESS, file.Close())
+
+  # File line iterator tests.
+  def testFileIterLines(self):
+    path = self._make_tmp_path("casket.txt")
+    with open(path, "w") as f:
+      for i in range(1000):
+        print("line-{:04d}".format(i), file=f)
+      f.write("last")
+    file = File()
+    self.assertEqual(Status.SUCCESS, file.Open(path, False))
+    batches = list(file.IterLines(batch=300, block_size=64))
+    self.assertEqual([300, 300, 300, 101], [len(x) for x in batches])
+    self.assertEqual(b"line-0000", batches[0][0])
+    self.assertEqual(b"line-0999", batches[3][99])
+    self.assertEqual(b"last", batches[3][100])
+    lines = [line for batch in file.IterLines(str=True) for line in batch]
+    self.assertEqual(1001, len(lines))
+    self.assertEqual("line-0500", lines[500])
+    lines = [line for batch in file.IterLines(mode="contain", pattern="-01")
+             for line in batch]
+    self.assertEqual(100, len(lines))
+    self.assertEqual(b"line-0100", lines[0])
+    lines = [line for batch in file.IterLines(mode="end", pattern="99") for line in batch]
+    self.assertEqual(10, len(lines))
+    lines = [line for batch in file.IterLines(mode="regex", pattern=r"^line-0+1$", str=True)
+             for line in batch]
+    self.assertEqual(["line-0001"], lines)
+    with self.assertRaises(TypeError):
+      file.IterLines(mode="edit", pattern="line")
+    with self.assertRaises(StatusException):
+      LineIterator()
+    shared_iter = file.IterLines(batch=1, block_size=64)
+    shared_lines = []
+    def Consume():
+      for batch in shared_iter:
+        shared_lines.extend(batch)
+    threads = [threading.Thread(target=Consume) for i in range(4)]
+    for thread in threads:
+      thread.start()
+    for thread in threads:
+      thread.join()
+    self.assertEqual(1001, len(set(shared_lines)))
+    iter = file.IterLines()
+    self.assertEqual(Status.SUCCESS, file.Close())
+    with self.assertRaises(TypeError):
+      next(iter)
+    self.assertEqual(Status.SUCCESS, file.Open(path, True, truncate=True))
+    self.assertEqual([], list(file.IterLines()))
+    self.assertEqual(Status.SUCCESS, file.Close())
+
+  # AsyncFile tests.
+  def testAsyncFile(self):
+    path = self._make_tmp_path("casket.txt")
+    file = File()
+    self.assertEqual(Status.SUCCESS, file.Open(
+      path, True, truncate=True, file="PositionalParallelFile"))
+    afile = AsyncFile(file, 4)
+    self.assertTrue("AsyncFile" in repr(afile))
+    futures = [afile.Write(i * 8, "{:08d}".format(i)) for i in range(100)]
+    for future in futures:
+      self.assertEqual(Status.SUCCESS, future.Get())
+    futures = [afile.Read(i * 8, 8) for i in range(100)]
+    for i, future in enumerate(futures):
+      self.assertEqual((Status.SUCCESS, "{:08d}".format(i).encode()), future.Get())
+    self.assertEqual((Status.SUCCESS, "00000042"), afile.ReadStr(42 * 8, 8).Get())
+    status, value = afile.Read(800, 8).Get()
+    self.assertEqual(Status.INFEASIBLE_ERROR, status)
+    self.assertEqual((Status.SUCCESS, 800), afile.Append("tail").Get())
+    self.assertEqual(Status.SUCCESS, afile.Synchronize(False).Get())
+    async def Main():
+      future = afile.ReadStr(800, 4)
+      await future
+      return future.Get()
+    self.assertEqual((Status.SUCCESS, "tail"), asyncio.run(Main()))
+    afile.Destruct()
+    with self.assertRaises(TypeError):
+      afile.Read(0, 1)
+    self.assertEqual(Status.SUCCESS, file.Close())
+    self.assertEqual(804, os.path.getsize(path))
+    self.assertEqual(Status.SUCCESS, file.Open(path, True, file="MemoryMapParallelFile"))
+    afile = AsyncFile(file, 2)
+    view = file.MakeView(0, 8)
+    self.assertEqual(Status.PRECONDITION_ERROR, afile.Append("more").Get()[0])
+    self.assertEqual(Status.PRECONDITION_ERROR, afile.Write(804, "more").Get())
+    self.assertEqual(Status.SUCCESS, afile.Write(0, "00000000").Get())
+    del view
+    self.assertEqual((Status.SUCCESS, 804), afile.Append("more").Get())
+    self.assertEqual(Status.SUCCESS, file.Close())
+    self.assertEqual(Status.PRECONDITION_ERROR, afile.Write(0, "x").Get())
+    del file
+    status, value = afile.Read(0, 8).Get()
+    self.assertEqual(Status.PRECONDITION_ERROR, status)
+    afile.Destruct()
+
+  # Flat record stream tests.
+  def testFlatRecordStream(self):
+    path = self._make_tmp_path("casket.flat")
+    file = File()
+    self.assertEqual(Status.SUCCESS, file.Open(path, True, truncate=True))
+    writer = FlatRecordWriter(file)
+    self.assertEqual(Status.SUCCESS, writer.Write([(str(i), i * i) for i in range(100)]))
+    self.assertEqual(Status.SUCCESS, writer.Write([b"hello", memoryview(b"world")]))
+    self.assertTrue("num_records=202" in repr(writer))
+    reader = FlatRecordReader(file)
+    status = Status()
+    records = reader.ReadPairs(50, status)
+    self.assertEqual(Status.SUCCESS, status)
+    self.assertEqual(50, len(records))
+    self.assertEqual((b"3", b"9"), records[3])
+    self.assertEqual([b"50", b"2500"], reader.Read(2))
+    records = reader.ReadPairs(100, status)
+    self.assertEqual(Status.SUCCESS, status)
+    self.assertEqual(50, len(records))
+    self.assertEqual((b"hello", b"world"), records[-1])
+    self.assertEqual([], reader.Read(10, status))
+    self.assertEqual(Status.NOT_FOUND_ERROR, status)
+    dbm = DBM()
+    self.assertEqual(Status.SUCCESS, dbm.Open("", True, dbm="BabyDBM"))
+    self.assertEqual(Status.SUCCESS, dbm.ImportFromFlatRecords(file))
+    self.assertEqual(101, dbm.Count())
+    self.assertEqual("81", dbm.GetStr("9"))
+    self.assertEqual(Status.SUCCESS, file.Close())
+    with self.assertRaises(TypeError):
+      reader.Read(1)
+    with self.assertRaises(TypeError):
+      writer.Write(["x"])
+    self.assertEqual(Status.SUCCESS, file.Open(path, True, truncate=True))
+    with self.assertRaises(TypeError):
+      reader.Read(1)
+    self.assertEqual(Status.SUCCESS, dbm.ExportToFlatRecords(file))
+    reader = FlatRecordReader(file, 64)
+    records = reader.ReadPairs(1000)
+    self.assertEqual(101, len(records))
+    self.assertEqual(dict(records), {k: v for k, v in dbm})
+    self.assertEqual(Status.SUCCESS, file.Close())
+    self.assertEqual(Status.SUCCESS, file.Open(path, True, truncate=True))
+    writer = FlatRecordWriter(file)
+    def WritePairs(thid):
+      for i in range(50):
+        key = "{}-{}".format(thid, i)
+        self.assertEqual(Status.SUCCESS, writer.Write([(key, key)] * 10))
+    threads = [threading.Thread(target=WritePairs, args=(i,)) for i in range(4)]
+    for thread in threads:
+      thread.start()
+    for thread in threads:
+      thread.join()
+    records = FlatRecordReader(file).ReadPairs(10000)
+    self.assertEqual(2000, len(records))
+    self.assertTrue(all(key == value for key, value in records))
+    self.assertEqual(Status.SUCCESS, file.Close())
+    self.assertEqual(Status.SUCCESS, dbm.Close())
+
   # Index tests.
   def testIndex(self):
     path = self._make_tmp_path("casket.tkt")
@@ -360,6 +360,7 @@ class DBM:
 
   All operations except for Open and Close are thread-safe; Multiple threads can access the same database concurrently.  You can specify a data structure when you call the Open method.  Every opened database must be closed explicitly by the Close method to avoid data corruption.
   This class implements the iterable protocol so an instance is usable with "for-in" loop.
+  In a child process made by fork, databases opened by the parent process are regarded as closed.  Their files are neither written nor closed by the child so that the parent can keep using them.  To access the same database in the child, open it again with the descriptor given by the GetDescriptor method.  The same applies to AsyncDBM, AsyncExecutor, File, and Index objects.  Iterators of databases are abandoned in the child and their methods raise an exception.
   """
 
   ANY_DATA = b"\x00[ANY]\x00"
@@ -460,7 +461,7 @@ class DBM:
       - .tksh : On-memory STL hash database (StdHashDBM)
       - .tkst : On-memory STL tree database (StdTreeDBM)
 
-    The optional parameters can include an option for the concurrency tuning.  By default, database operatins are done under the GIL (Global Interpreter Lock), which means that database operations are not done concurrently even if you use multiple threads.  If the "concurrent" parameter is true, database operations are done outside the GIL, which means that database operations can be done concurrently if you use multiple threads.  However, the downside is that swapping thread data is costly so the actual throughput is often worse in the concurrent mode than in the normal mode.  Therefore, the concurrent mode should be used only if the database is huge and it can cause blocking of threads in multi-thread usage.
+    The optional parameters can include an option for the concurrency tuning.  By default, database operatins are done under the GIL (Global Interpreter Lock), which means that database operations are not done concurrently even if you use multiple threads.  If the "concurrent" parameter is true, database operations are done outside the GIL, which means that database operations can be done concurrently if you use multiple threads.  However, the downside is that swapping thread data is costly so the actual throughput is often worse in the concurrent mode than in the normal mode.  Therefore, the concurrent mode should be used only if the database is huge and it can cause blocking of threads in multi-thread usage.  On the free-threaded build of Python, which has no GIL, operations from multiple threads are done in parallel regardless of this parameter.  Each object guards its own state so that Open and Close wait for running operations on the same object.
 
     The optional parameters can include options for the file opening operation.
       - truncate (bool): True to truncate the file.
@@ -473,6 +474,14 @@ class DBM:
 
     The optional parameter "file" specifies the internal file implementation class.  The default file class is "MemoryMapAtomicFile".  The other supported classes are "StdFile", "MemoryMapAtomicFile", "PositionalParallelFile", and "PositionalAtomicFile".
 
+    If the optional parameter "shared_memory" is true, the database is placed on shared memory so that multiple processes opening the same path share one copy of the data in RAM.  On Linux, a path without a directory is put in "/dev/shm".  On other systems, the path should be on a memory-backed file system.  Unless specified, "dbm" is set to "HashDBM" and "file" is set to "MemoryMapParallelFile", which reads records from the mapped memory without system calls.  As with other database files, a writable process excludes the other processes and read-only processes share the file.  Typically, a loader process builds the data and closes it, and then worker processes open it as read-only.  The data is lost when the system restarts.  Remove the file explicitly to release the memory.
+
+    If the optional parameter "bloom_filter" is true, a Bloom filter of all keys is kept in memory and lookups of missing keys by Get, GetStr, GetMulti, GetMultiStr, GetObject, and the "in" operator return without accessing the database.  The optional parameter "bloom_bits_per_key" sets the number of bits per key, which is 10 by default and gives about 1% of false positives.  The filter is built by scanning all keys when the database is opened.  When the database is closed, the filter is saved in a sidecar file whose path is the database path with the suffix ".bloom".  The sidecar file is loaded instead of scanning the next time if the number of records and the size and the modification time of each database file are unchanged.  The sidecar file is removed while the database is opened as writable, so a process which crashes doesn't leave a stale filter.  The validation assumes that the database is updated only by this module with the Bloom filter enabled.  If another program might update the database without the filter, remove the sidecar file before opening it.  Removing records doesn't remove keys from the filter so false positives increase, until Rebuild or Clear builds the filter again for the current number of records.  PushLast and ImportFromFlatRecords disable the filter until Rebuild is called.  Updates by other processes are not reflected in the filter.
+
+    The optional parameter "commit_delay" sets the seconds for which the Commit method waits before synchronization so that more concurrent callers share it.  It is 0 by default.
+
+    If the optional parameter "ulog_prefix" is set, every update is written to the update log, which is a series of files whose paths begin with the prefix.  The optional parameter "ulog_max_file_size" sets the maximum size of each file, which is 1GiB by default.  The optional parameters "ulog_server_id" and "ulog_dbm_index" set the server ID and the database index recorded in each entry, which are -1 by default.  Another process can read the entries with an UpdateLogReader object and apply them to a replica with the ApplyUpdateLog method.
+
     For HashDBM, these optional parameters are supported.
       - update_mode (string): How to update the database file: "UPDATE_IN_PLACE" for the in-palce or "UPDATE_APPENDING" for the appending mode.
       - record_crc_mode (string): How to add the CRC data to the record: "RECORD_CRC_NONE" to add no CRC to each record, "RECORD_CRC_8" to add CRC-8 to each record, "RECORD_CRC_16" to add CRC-16 to each record, or "RECORD_CRC_32" to add CRC-32 to each record.
@@ -567,6 +576,17 @@ class DBM:
     """
     pass  # native code
 
+  def GetObject(self, key, status=None):
+    """
+    Gets the object decoded from the value of a record of a key, using the cache.
+
+    :param key: The key of the record.
+    :param status: A status object to which the result status is assigned.  It can be omitted.
+    :return: The object decoded from the value of the matching record or None on failure.
+    The cache must be set by the SetObjectCache method beforehand.  If the object of the key is cached, it is returned without accessing the database.  Otherwise, the value is read from the database, decoded by the decoder function, stored in the cache, and returned.  As the same object is returned for the same key, the object should not be modified.
+    """
+    pass  # native code
+
   def GetMulti(self, *keys):
     """
     Gets the values of multiple records of keys.
@@ -827,6 +847,54 @@ class DBM:
     """
     pass  # native code
 
+  def StartRebuild(self, **params):
+    """
+    Starts a job to rebuild the entire database in background.
+
+    :param params: Optional keyword parameters.
+    :return: A RebuildJob object to monitor and control the job.
+
+    The optional parameters are the same as the Rebuild method.  In addition, "delay" (float) sets the seconds to wait before starting, during which the job can be canceled, and "low_priority" (bool) makes the job thread run with a low CPU and I/O priority on Linux, which is true by default.  The lowest best-effort I/O level is used rather than the idle class so that foreground threads waiting for the locks held by the job are not blocked indefinitely.  The job holds the database so that it is not closed while rebuilding; Close waits for the job to finish.
+    """
+    pass  # native code
+
+  def StartMaintenance(self, **params):
+    """
+    Starts a background thread to rebuild and synchronize the database automatically.
+
+    :param params: Optional keyword parameters.
+    :return: The result status.
+
+    The thread checks the database at every interval.  If the database should be rebuilt by the same criteria as the ShouldBeRebuilt method, it is rebuilt with the given parameters, which are the same as the Rebuild method.  The optional parameters can also include the following.
+      - interval (float): The seconds between checks, which is 60 by default.
+      - sync_interval (float): The seconds between soft synchronizations, which is 0 by default to disable them.
+      - rebuild_window (str): The range of the local time when rebuilding is allowed, like "02:00-05:00".  A range over midnight like "23:00-04:00" is also supported.  By default, rebuilding is allowed at any time.
+      - low_priority (bool): If true, the thread runs with a low CPU and I/O priority on Linux.  It is true by default.
+
+    A check is skipped if the database is being closed or reconfigured at the time.  If a maintenance thread is already running, it is replaced.  The thread is stopped when the database is closed.  Only writable databases are supported.
+    """
+    pass  # native code
+
+  def StopMaintenance(self):
+    """
+    Stops the background maintenance thread.
+
+    :return: The result status.  PRECONDITION_ERROR is returned if no maintenance thread is running.
+
+    If a rebuild is in progress, this waits for it to finish.
+    """
+    pass  # native code
+
+  def InspectMaintenance(self):
+    """
+    Inspects the background maintenance.
+
+    :return: A map of property names and their string values.
+
+    The properties include the configuration, "num_checks" for the number of checks, "num_skips" for the number of skipped checks, "num_rebuilds" and "num_syncs" for the numbers of the operations done, "last_rebuild_time" for the UNIX time of the last rebuild, and "last_status" for the status code name of the last check.  An exception is raised if no maintenance thread is running.
+    """
+    pass  # native code
+
   def ShouldBeRebuilt(self):
     """
     Checks whether the database should be rebuilt.
@@ -847,6 +915,30 @@ class DBM:
     """
     pass  # native code
 
+  def ApplyUpdateLog(self, messages, server_id=-1, dbm_index=-1):
+    """
+    Applies update log messages written by another database.
+
+    :param messages: A sequence of messages in bytes, or tuples of the timestamp and the message as returned by the Read method of UpdateLogReader.
+    :param server_id: If it is not negative, messages of the other server IDs are skipped.
+    :param dbm_index: If it is not negative, messages of the other database indices are skipped.
+    :return: The result status.
+
+    The messages are applied in order and the operation stops at the first failure.  Removing a missing record is not an error.  The updates are also written to the update log of this database if any, so that replicas can be chained.
+    """
+    pass  # native code
+
+  def Commit(self, hard=True):
+    """
+    Makes the updates done before the call durable, sharing synchronization with others.
+
+    :param hard: True to do physical synchronization with the hardware or False to do only logical synchronization with the file system.
+    :return: The result status.
+
+    Concurrent callers are grouped.  One of them synchronizes the database once for all the callers which have called before the synchronization starts, and the others wait for it without holding the GIL.  Thus, the throughput of durable writes scales with the number of writer threads instead of being bound by the latency of each synchronization.  See the "commit_delay" parameter of the Open method to gather more callers.  The numbers of the calls and the actual synchronizations are reported as "num_commit_requests" and "num_commit_syncs" by the Inspect method.
+    """
+    pass  # native code
+
   def CopyFileData(self, dest_path, sync_hard=False):
     """
     Copies the content of the database file to another file.
@@ -857,6 +949,32 @@ class DBM:
     """
     pass  # native code
 
+  def Snapshot(self, dest_path=None):
+    """
+    Makes a read-only database handle of a point-in-time copy.
+
+    :param dest_path: A path to the copy of the database file.  If it is None, a unique path is made by appending a suffix to the path of the database.
+    :return: A new DBM object opened as read-only, whose content is frozen at the time of calling.  StatusException is raised on failure.
+
+    The database file is copied by CopyFileData while the database is locked, and the copy is opened with the same parameters.  Then, long-running scans and exports on the returned object neither see later updates nor block writers of this database.  If the destination path is not given, the copy is removed when the returned object is closed or destructed.  A copy at a given destination path is kept, and the caller is responsible for removing it.  For a sharded database, each shard is copied separately.  For an on-memory database, all records are exported to a new on-memory database, which is writable.
+    """
+    pass  # native code
+
+  def Backup(self, dest, offset=0, max_speed=0, progress=None, consistent=False):
+    """
+    Copies the database file to a file or a path, with a rate limit.
+
+    :param dest: A File object opened as writable, or a path to the destination file.
+    :param offset: The offset to resume copying from.  The destination is truncated to this size and the data before it is kept.
+    :param max_speed: The maximum copying speed in bytes per second.  Zero or negative means unlimited.
+    :param progress: A function called after each chunk is copied, with the number of bytes copied so far and the total number of bytes.  If it returns False, copying is stopped and CANCELED_ERROR is returned.
+    :param consistent: If true and the database is writable, the file is copied while the database is locked for synchronization.
+    :return: The result status.
+
+    By default, the database is synchronized and then its file is read in chunks without any database lock, so that foreground operations are not blocked during a long copy.  If copying fails or is canceled, it can be resumed by calling this again with the size of the partial copy as the offset.  If the database is updated during the copy, the copy can be torn and inconsistent.  In that case, recover the records with RestoreDatabase, back up a handle given by Snapshot, or set the consistent parameter.  With the consistent parameter, updates by other threads wait until the whole copy is done, and the progress function is called only once after the copy, so it can't cancel the copy.  Sharded and on-memory databases are not supported.
+    """
+    pass  # native code
+
   def Export(self, dest_dbm):
     """
     Exports all records to another database.
@@ -886,6 +1004,47 @@ class DBM:
     """
     pass  # native code
 
+  def ParallelExport(self, dest_dbm):
+    """
+    Exports all records to another database, using one thread per shard.
+
+    :param dest_dbm: The destination database.  It must not be the source database.
+    :return: The result status.
+    If the database is sharded, each shard is exported by a separate thread, so the destination database should allow concurrent updates.  Otherwise, this is the same as the Export method.
+    """
+    pass  # native code
+
+  def ParallelExportToFlatRecords(self, dest_files):
+    """
+    Exports each shard to its own flat record file in parallel.
+
+    :param dest_files: A list of file objects to write records in.  The number of files must be the same as the number of shards, or one if the database is not sharded.
+    :return: The result status.
+    The i-th shard is written into the i-th file by a separate thread.
+    """
+    pass  # native code
+
+  def ParallelImportFromFlatRecords(self, src_files):
+    """
+    Imports records to a database from flat record files in parallel.
+
+    :param src_files: A list of file objects to read records from.
+    :return: The result status.
+    Each file is read by a separate thread, so the database should allow concurrent updates.  The order of applying records is undefined among files.
+    """
+    pass  # native code
+
+  def BulkLoadSorted(self, records, sort_mem_size=268435456):
+    """
+    Loads records in ascending order of the key, sorting them if necessary.
+
+    :param records: An iterable of pairs of the key and the value.
+    :param sort_mem_size: The memory size in bytes to sort records.  Sorted runs exceeding it are spilled into temporary files and merged at the end.
+    :return: The result status.  If the database is not ordered, NOT_IMPLEMENTED_ERROR is returned.
+    Sorted input is stored as it comes, which keeps the working pages of a TreeDBM hot.  Unsorted input is sorted by an external merge sort before being stored.  Of records with the same key, the last one is stored.  As for SkipDBM, the records are written into temporary files in the sorted order, which are merged into the database by the synchronization at the end without being sorted again.
+    """
+    pass  # native code
+
   def ExportKeysAsLines(self, dest_file):
     """
     Exports the keys of all records as lines to a text file.
@@ -956,6 +1115,45 @@ class DBM:
     """
     pass  # native code
 
+  def SetObjectCache(self, decoder, capacity=67108864):
+    """
+    Sets the cache of objects decoded from record values.
+
+    :param decoder: A function which takes the value of a record as bytes and returns the decoded object, like json.loads or pickle.loads.  If it is None, the cache is removed.
+    :param capacity: The memory budget of the cache in bytes.  The size of each entry is estimated by the sizes of the key and the value.  The least recently used entries are discarded when the total size exceeds the budget.
+    The cache is used by the GetObject method.  Cached objects are invalidated by updating methods of this object, including Set, Remove, Append, and Process, and all of them are discarded by Clear, Close, and methods processing multiple records in a batch.  Updates through Iterator and AsyncDBM objects made from this object invalidate cached objects too, and asynchronous operations on multiple records discard all of them.  Updates by other processes are not detected.  Calling this method again discards all cached objects.
+    """
+    pass  # native code
+
+  def InspectObjectCache(self):
+    """
+    Inspects the cache of decoded objects.
+
+    :return: A map of property names and their values.  "capacity" is the memory budget.  "size" is the estimated total size of the entries.  "count" is the number of entries.  "num_hits" and "num_misses" are the numbers of lookups which have found or missed the cached object.  "num_evictions" is the number of entries discarded for the budget.  "hit_ratio" is the ratio of hits to all lookups.
+    """
+    pass  # native code
+
+  def GetDescriptor(self):
+    """
+    Gets a picklable descriptor to open the database again in another process.
+
+    :return: A dictionary of "path", the path of the database, and "params", a dictionary of the optional parameters given to the Open method.  The parameters exclude options about opening the file such as "truncate" and include "no_wait" set true.  The database is opened as read-only by "dbm.Open(desc["path"], False, **desc["params"])".  If the database is opened as writable by another process, opening fails instead of waiting.  Thus, the database should be opened as read-only by this object too.
+    :raise StatusException: PRECONDITION_ERROR if the database is on-memory.
+    """
+    pass  # native code
+
+  def ParallelMap(self, func, processes=None):
+    """
+    Applies a function to every record in parallel by worker processes.
+
+    :param func: A function which takes the key and the value of a record as bytes.  The function must be picklable, which is satisfied by functions defined at the top level of a module.
+    :param processes: The maximum number of worker processes.  If it is None, the number of CPU cores is used.
+    :return: A list of the values returned by the function, excluding None.  The order is undefined.
+    :raise StatusException: PRECONDITION_ERROR if the database is on-memory or opened as writable.
+    The work is done by a process pool of the multiprocessing module.  Each worker opens the database as read-only with the descriptor given by the GetDescriptor method.  If the database is sharded, each task processes one shard, so as many workers as the shards run at most.  Otherwise, the records are partitioned by the hash of the key into as many tasks as the processes.  Each worker scans the whole database and calls the function only for the records of its task, so the work of the function is spread over the workers.
+    """
+    pass  # native code
+
   @classmethod
   def RestoreDatabase(cls, old_file_path, new_file_path, class_name="",
                       end_offset=-1, cipher_key=None):
@@ -1173,6 +1371,118 @@ class Iterator:
     pass  # native code
 
 
+class RebuildJob:
+  """
+  Job to rebuild a database in background.
+
+  An instance is made by the StartRebuild method of DBM.  The job runs on its own thread so that the calling thread is not blocked.  The rebuilding operation of the native library cannot be interrupted or report its progress inside a database file.  Shards of a sharded database are rebuilt one by one and the Bloom filter is rebuilt after them, so a running job is canceled at those checkpoints and its progress is counted by them.
+  """
+
+  def __init__(self):
+    """
+    The constructor cannot be called directly.  Use DBM#StartRebuild.
+    """
+    pass  # native code
+
+  def __repr__(self):
+    """
+    Returns A string representation of the object.
+
+    :return: The string representation of the object.
+    """
+    pass  # native code
+
+  def __str__(self):
+    """
+    Returns a string representation of the content.
+
+    :return: The string representation of the content.
+    """
+    pass  # native code
+
+  def Wait(self, timeout=-1):
+    """
+    Waits for the job to finish.
+
+    :param timeout: The waiting time in seconds.  If it is negative, no timeout is set.
+    :return: True if the job has finished, or False on timeout.
+    """
+    pass  # native code
+
+  def Get(self):
+    """
+    Waits for the job to finish and gets the result status.
+
+    :return: The result status.  CANCELED_ERROR is returned if the job was canceled.
+    """
+    pass  # native code
+
+  def Cancel(self):
+    """
+    Cancels the job.
+
+    :return: True if the job has not finished, or False otherwise.
+
+    If the job is waiting for the start delay, it is canceled at once.  If the job is running, it stops at the next checkpoint, which is before the next shard or before rebuilding the Bloom filter, and the result status is CANCELED_ERROR.  If no checkpoint remains, the job completes and the result is not affected.
+    """
+    pass  # native code
+
+  def Inspect(self):
+    """
+    Inspects the state and the statistics of the job.
+
+    :return: A map of property names and their string values.
+
+    The properties are "state" for one of "waiting", "running", "done", and "canceled", "status" for the name of the result status code, "low_priority", and "elapsed_time" for the seconds since the job was made.  "running_time" is set after the job starts, with the progress counters: "num_parts" for the number of database files to rebuild, "num_rebuilt_parts" for the number of those rebuilt, "num_scanned_keys" for the number of keys added to the new Bloom filter, and "cancel_requested".  "file_size_before" and "file_size_after" are set after the job finishes.
+    """
+    pass  # native code
+
+
+class AsyncExecutor:
+  """
+  Pool of worker threads shared by asynchronous database adapters.
+
+  Each worker thread has its own deque of tasks and takes tasks from the deques of the other workers when its own deque is empty.  Passing the same executor to the constructors of multiple AsyncDBM objects makes the total number of threads independent of the number of databases.
+  """
+
+  def __init__(self, num_worker_threads=0, **params):
+    """
+    Sets up the worker threads.
+
+    :param num_worker_threads: The number of worker threads.  If it is not positive, the number of CPU cores is used.
+    :param params: Optional keyword parameters.
+
+    The optional parameters can include "pin_cpus" (bool) to bind each worker thread to a CPU core in round-robin among the cores which the process is allowed to run on, which is False by default and effective only on Linux.
+    """
+    pass  # native code
+
+  def __repr__(self):
+    """
+    Returns A string representation of the object.
+
+    :return: The string representation of the object.
+    """
+    pass  # native code
+
+  def __str__(self):
+    """
+    Returns a string representation of the content.
+
+    :return: The string representation of the content.
+    """
+    pass  # native code
+
+  def Inspect(self):
+    """
+    Inspects the worker threads.
+
+    :return: A map of property names and their numeric values.
+
+    The properties are "num_threads" for the number of worker threads, "num_pending" for the number of tasks waiting for a worker, "num_executed" for the number of tasks taken by workers, and "num_stolen" for the number of tasks taken from the deques of other workers.
+    """
+    pass  # native code
+
+
 class AsyncDBM:
   """
   Asynchronous database manager adapter.
@@ -1180,12 +1490,25 @@ class AsyncDBM:
   This class is a wrapper of DBM for asynchronous operations.  A task queue with a thread pool is used inside.  Every method except for the constructor and the destructor is run by a thread in the thread pool and the result is set in the future oject of the return value.  The caller can ignore the future object if it is not necessary.  The Destruct method waits for all tasks to be done.  Therefore, the destructor should be called before the database is closed.
   """
   
-  def __init__(self, dbm, num_worker_threads):
+  def __init__(self, dbm, num_worker_threads, **params):
     """
     Sets up the task queue.
 
     :param dbm: A database object which has been opened.
-    :param num_worker_threads: The number of threads in the internal thread pool.
+    :param num_worker_threads: The number of threads in the internal thread pool, or an AsyncExecutor object whose threads are shared.
+    :param params: Optional keyword parameters.
+
+    The optional parameters can include options to bound the task queue.
+      - max_queue_size (int): The maximum number of pending tasks.  0 means unlimited, which is the default.
+      - overflow (str): The policy when the queue is full.  "block" makes the caller wait for a slot with the GIL released, which is the default.  "fail" makes the future of the new task fail with INFEASIBLE_ERROR immediately.  "drop_read" makes the future of the oldest pending read task (Get, GetStr, GetMulti, GetMultiStr, and Search) fail with CANCELED_ERROR; if there's no pending read task, the caller waits.
+
+    The optional parameters can also include the default scheduling options of tasks submitted via this adapter.
+      - priority (int): The priority class: AsyncDBM.PRIORITY_INTERACTIVE, AsyncDBM.PRIORITY_NORMAL, which is the default, or AsyncDBM.PRIORITY_BACKGROUND.  Pending tasks of a higher class are always started before those of a lower class.
+      - timeout (float): The time in seconds from submission by which each task must start.  If the deadline has passed before the task starts, its future fails with CANCELED_ERROR.  A negative value means unlimited, which is the default.
+
+    The optional parameters can also include "coalesce" (bool) to merge pending tasks on the same key, which is False by default.  If it is true, a Get or GetStr call on a key whose latest pending task is also a read shares the lookup with it and every future gets the same result.  A Set call with overwriting on a key whose latest pending task is also such a Set replaces the value to be stored and both futures get the status of the one write.  Any other operation is a barrier and no task is merged across it.  Tasks are merged only within the same priority class.
+
+    The optional parameters can also include "shard_routing" (bool) to route tasks by shards, which is False by default.  It is available only if the database is opened with the "num_shards" parameter.  Each worker thread owns a subset of the shards and every task on one key (Get, GetStr, Set, Remove, Append, CompareExchange, and Increment) is run by the worker owning the shard of the key, so that workers don't contend on the same shard.  The other tasks are run by any worker.
     """
     pass  # native code
 
@@ -1209,9 +1532,31 @@ class AsyncDBM:
     """
     Destructs the asynchronous database adapter.
 
-    This method waits for all tasks to be done.
+    This method waits for all tasks to be done.  The task queue is stopped also for the adapters made by the WithOptions method.
     """
 
+  def WithOptions(self, priority, timeout=None):
+    """
+    Makes an adapter which shares the task queue and applies the given options.
+
+    :param priority: The priority class of tasks submitted via the new adapter.
+    :param timeout: The time in seconds from submission by which each task must start.  If it is None or negative, there's no deadline.
+    :return: The new adapter object.
+
+    This is useful to run maintenance operations like Rebuild and Export in the background lane while interactive lookups are served first.
+    """
+    pass  # native code
+
+  def Inspect(self):
+    """
+    Inspects the task queue.
+
+    :return: A map of property names and their numeric values.
+
+    The properties are "num_threads" for the number of worker threads, "num_shards" for the number of shards used for routing or 0, "max_queue_size" for the maximum number of pending tasks, "queue_size" for the current number of pending tasks, "num_running" for the number of running tasks, "num_done" for the number of finished tasks, "num_rejected" and "num_dropped" for the number of tasks failed by the overflow policy, "num_expired" for the number of tasks failed by the deadline, "num_coalesced" for the number of tasks merged into pending ones, "wait_time_total", "wait_time_mean", and "wait_time_max" for seconds from enqueuing to starting each task, "busy_time" for seconds the workers spent on tasks, "elapsed_time" for seconds since the queue was set up, and "utilization" for the ratio of the busy time to the capacity of all workers.
+    """
+    pass  # native code
+
   def Get(self, key):
     """
     Gets the value of a record of a key.
@@ -1503,7 +1848,7 @@ class File:
     :param params: Optional keyword parameters.
     :return: The result status.
 
-    The optional parameters can include an option for the concurrency tuning.  By default, database operatins are done under the GIL (Global Interpreter Lock), which means that database operations are not done concurrently even if you use multiple threads.  If the "concurrent" parameter is true, database operations are done outside the GIL, which means that database operations can be done concurrently if you use multiple threads.  However, the downside is that swapping thread data is costly so the actual throughput is often worse in the concurrent mode than in the normal mode.  Therefore, the concurrent mode should be used only if the database is huge and it can cause blocking of threads in multi-thread usage.
+    The optional parameters can include an option for the concurrency tuning.  By default, database operatins are done under the GIL (Global Interpreter Lock), which means that database operations are not done concurrently even if you use multiple threads.  If the "concurrent" parameter is true, database operations are done outside the GIL, which means that database operations can be done concurrently if you use multiple threads.  However, the downside is that swapping thread data is costly so the actual throughput is often worse in the concurrent mode than in the normal mode.  Therefore, the concurrent mode should be used only if the database is huge and it can cause blocking of threads in multi-thread usage.  On the free-threaded build of Python, which has no GIL, operations from multiple threads are done in parallel regardless of this parameter.  Each object guards its own state so that Open and Close wait for running operations on the same object.
 
     The optional parameters can include options for the file opening operation.
       - truncate (bool): True to truncate the file.
@@ -1550,6 +1895,31 @@ class File:
     """
     pass  # native code
 
+  def ReadInto(self, off, buffer):
+    """
+    Reads data into a writable buffer.
+
+    :param off: The offset of a source region.
+    :param buffer: A writable object supporting the contiguous buffer protocol, such as bytearray, memoryview, mmap, and numpy arrays.  The size to be read is the length of the buffer in bytes.
+    :return: The result status.
+
+    The data is read directly into the memory of the buffer without intermediate copies.  Pass a slice of a memoryview to read into a part of a buffer.
+    """
+    pass  # native code
+
+  def ReadMulti(self, ranges, contiguous=False, status=None):
+    """
+    Reads data of multiple ranges at once.
+
+    :param ranges: A sequence of pairs of the offset and the size of each region.
+    :param contiguous: If true, the data is stored in one bytes object.  If false, the data of each range is stored in a separate bytes object.
+    :param status: A status object to which the result status is assigned.  It can be omitted.
+    :return: If contiguous is false, a list of the bytes values of the read data in the order of the ranges.  If contiguous is true, a tuple of the bytes value of all data and a list of the start offset of each range in it.  None is returned on failure.
+
+    All ranges are read in one native call, releasing the GIL only once.  Overlapping and adjacent ranges are merged into one read, and many separated ranges are read by multiple threads in parallel.  If any range can't be read, the whole operation fails.
+    """
+    pass  # native code
+
   def Write(self, off, data):
     """
     Writes data.
@@ -1557,6 +1927,8 @@ class File:
     :param off: The offset of the destination region.
     :param data: The data to write.
     :return: The result status.
+
+    The data can be any object supporting the buffer protocol, such as bytes, bytearray, memoryview, mmap, and numpy arrays.  The content of a contiguous buffer is written without being copied, and a non-contiguous one is copied in the C order.  If the buffer cannot be got, the error of the object is raised.
     """
     pass  # native code
 
@@ -1567,6 +1939,8 @@ class File:
     :param data: The data to write.
     :param status: A status object to which the result status is assigned.  It can be omitted.
     :return: The offset at which the data has been put, or None on failure.
+
+    As with the Write method, buffer-protocol objects are written without being copied.
     """
     pass  # native code
 
@@ -1621,6 +1995,325 @@ class File:
     """
     pass  # native code
 
+  def MakeView(self, off, size, writable=False, status=None):
+    """
+    Makes a memoryview of a region of the memory-mapped file.
+
+    :param off: The offset of the region.
+    :param size: The size of the region.  It is truncated at the end of the file.
+    :param writable: If true, the view is writable and modifications are done directly in the file.  The file must be opened as writable.
+    :param status: A status object to which the result status is assigned.  It can be omitted.
+    :return: The memoryview object of the region or None on failure.
+
+    The file must be opened with "MemoryMapParallelFile" or "MemoryMapAtomicFile" as the "file" parameter.  Otherwise, NOT_IMPLEMENTED_ERROR is set.  The data is accessed in place without copies.  While any view made by this method is alive, operations which may remap the file, namely Write beyond the end of the file, Append, Truncate, Synchronize, and Close, fail with PRECONDITION_ERROR so that the memory of the views stays valid.  So do the tasks of AsyncFile and the methods of DBM and AsyncDBM which write into the file, such as Backup, ExportToFlatRecords, and ExportKeysAsLines.  Call the release method of the view or use the "with" statement to unpin the mapping as soon as possible.  Writing through a view of MemoryMapAtomicFile bypasses its locking.
+    """
+    pass  # native code
+
+  def Advise(self, off, size, advice):
+    """
+    Gives an advice about the access pattern of a region of the memory-mapped file.
+
+    :param off: The offset of the region.
+    :param size: The size of the region.  It is truncated at the end of the file.
+    :param advice: "normal", "sequential", "random", "willneed", or "dontneed".
+    :return: The result status.
+
+    The advice is given to the operating system by posix_madvise.  The file must be opened with a memory-mapped implementation.  Otherwise, NOT_IMPLEMENTED_ERROR is returned.
+    """
+    pass  # native code
+
+  def IterLines(self, **params):
+    """
+    Makes an iterator for batches of lines of the file.
+
+    :param params: Optional keyword parameters.
+    :return: The iterator object, which yields a list of lines for each batch.
+
+    The optional parameter "batch" sets the maximum number of lines in each list, which is 1000 by default.  The optional parameter "block_size" sets the size of each read from the file, which is 1MiB by default.  If the optional parameter "str" is true, lines are strings.  Otherwise, they are bytes.  Lines don't include the trailing newline character.
+
+    The optional parameters "mode" and "pattern" filter lines natively as with the Search method.  The supported modes are "contain", "begin", "end", and "regex".  The edit distance modes are not supported because they rank all lines of the file.
+
+    The file is read in large blocks and newlines are found by a vectorized scan, without the GIL.  Data appended after the iteration starts is also read.  The file must not be closed while the iterator is used.
+    """
+    pass  # native code
+
+
+class UpdateLogReader:
+  """
+  Reader of the update log of a database.
+
+  The update log is written by a database opened with the "ulog_prefix" parameter.  Each entry is a pair of the timestamp in milliseconds and the message which describes one update.  Read entries can be given to the ApplyUpdateLog method of another database to replicate the updates.  All operations except for Open and Close are thread-safe.
+  """
+
+  def __init__(self):
+    """
+    Initializes the reader object.
+    """
+    pass  # native code
+
+  def __repr__(self):
+    """
+    Returns A string representation of the object.
+
+    :return: The string representation of the object.
+    """
+    pass  # native code
+
+  def __str__(self):
+    """
+    Returns A string representation of the content.
+
+    :return: The string representation of the content.
+    """
+    pass  # native code
+
+  def Open(self, prefix, min_timestamp=0):
+    """
+    Opens the update log files of a prefix to read.
+
+    :param prefix: The prefix given as the "ulog_prefix" parameter to the database.
+    :param min_timestamp: The minimum timestamp of entries to read.  Entries before it are skipped.
+    :return: The result status.
+
+    The files are opened as read-only so that the writer can keep appending entries.
+    """
+    pass  # native code
+
+  def Close(self):
+    """
+    Closes the update log files.
+
+    :return: The result status.
+    """
+    pass  # native code
+
+  def Read(self, max_count=1, timeout=0, status=None):
+    """
+    Reads update log entries.
+
+    :param max_count: The maximum number of entries to read.
+    :param timeout: The seconds to wait for the first entry to be written.  Zero means no wait and a negative value means forever.
+    :param status: A status object to which the result status is assigned.  It can be omitted.
+    :return: A list of tuples of the timestamp and the bytes message.
+
+    INFEASIBLE_ERROR is set to the status if no entry is available within the timeout.  The GIL is released while waiting.
+    """
+    pass  # native code
+
+  def GetTimestamp(self):
+    """
+    Gets the timestamp of the last read entry.
+
+    :return: The timestamp in milliseconds.
+    """
+    pass  # native code
+
+  @classmethod
+  def ParseMessage(cls, message):
+    """
+    Parses an update log message.
+
+    :param message: The message in bytes.
+    :return: A tuple of the operation name, the key, the value, the server ID, and the database index.  The operation name is "set", "remove", "clear", or "void".
+
+    StatusException is raised if the message is broken.
+    """
+    pass  # native code
+
+
+class LineIterator:
+  """
+  Iterator for batches of lines of a file.
+
+  An instance is made by the IterLines method of File.  Each iteration returns a list of lines.  This class can't be instantiated directly.
+  """
+
+  def __repr__(self):
+    """
+    Returns A string representation of the object.
+
+    :return: The string representation of the object.
+    """
+    pass  # native code
+
+
+class AsyncFile:
+  """
+  Asynchronous file adapter.
+
+  This class is a wrapper of File for asynchronous operations.  A task queue with a thread pool is used inside.  Every method except for the constructor and the destructor is run by a thread in the thread pool and the result is set in the future object of the return value.  The caller can ignore the future object if it is not necessary.  A single Python thread can keep as many operations in flight as the number of worker threads, and the workers do the I/O without the GIL.  The Destruct method waits for all tasks to be done.  The file object is referred to until then.  If the file is closed or reopened before, later tasks fail with PRECONDITION_ERROR.  While views of a memory-mapped file made by File.MakeView are alive, tasks which may remap the file, such as Append and Write beyond the end of the file, fail with PRECONDITION_ERROR as the methods of File do.
+  """
+
+  def __init__(self, file, num_worker_threads):
+    """
+    Sets up the task queue.
+
+    :param file: A file object which has been opened.
+    :param num_worker_threads: The number of threads in the internal thread pool, or an AsyncExecutor object whose threads are shared.
+
+    Positional files like PositionalParallelFile are the most suitable because their operations on different regions are done in parallel.
+    """
+    pass  # native code
+
+  def __repr__(self):
+    """
+    Returns A string representation of the object.
+
+    :return: The string representation of the object.
+    """
+    pass  # native code
+
+  def __str__(self):
+    """
+    Returns a string representation of the content.
+
+    :return: The string representation of the content.
+    """
+    pass  # native code
+
+  def Destruct():
+    """
+    Destructs the asynchronous file adapter.
+
+    This method waits for all tasks to be done.
+    """
+
+  def Read(self, off, size):
+    """
+    Reads data.
+
+    :param off: The offset of a source region.
+    :param size: The size to be read.
+    :return: The future for the result status and the bytes value of the read data.
+    """
+    pass  # native code
+
+  def ReadStr(self, off, size):
+    """
+    Reads data as a string.
+
+    :param off: The offset of a source region.
+    :param size: The size to be read.
+    :return: The future for the result status and the string value of the read data.
+    """
+    pass  # native code
+
+  def Write(self, off, data):
+    """
+    Writes data.
+
+    :param off: The offset of the destination region.
+    :param data: The data to write.
+    :return: The future for the result status.
+    """
+    pass  # native code
+
+  def Append(self, data):
+    """
+    Appends data at the end of the file.
+
+    :param data: The data to write.
+    :return: The future for the result status and the offset at which the data has been put.
+    """
+    pass  # native code
+
+  def Synchronize(self, hard):
+    """
+    Synchronizes the content of the file to the file system.
+
+    :param hard: True to do physical synchronization with the hardware or False to do only logical synchronization with the file system.
+    :return: The future for the result status.
+    """
+    pass  # native code
+
+
+class FlatRecordWriter:
+  """
+  Writer of a stream of flat records.
+
+  Flat records are the format used by the ExportToFlatRecords and ImportFromFlatRecords methods of DBM.  Each record is a sequence of bytes with native framing.  A database is represented as alternating keys and values.  The records are appended to a File object so that the file can be read by FlatRecordReader or imported into a database.
+  """
+
+  def __init__(self, file):
+    """
+    Sets up the writer.
+
+    :param file: A file object which has been opened as writable.
+
+    The file object is kept referred to by the writer.
+    """
+    pass  # native code
+
+  def __repr__(self):
+    """
+    Returns A string representation of the object.
+
+    :return: The string representation of the object.
+    """
+    pass  # native code
+
+  def Write(self, records):
+    """
+    Writes records.
+
+    :param records: A sequence of records.  Each record is bytes, a string, or any object supporting the buffer protocol.  A tuple of two elements is written as two records of the key and the value.
+    :return: The result status.
+
+    All records are written in one native call without the GIL.
+    """
+    pass  # native code
+
+
+class FlatRecordReader:
+  """
+  Reader of a stream of flat records.
+
+  This reads records written by FlatRecordWriter or the ExportToFlatRecords method of DBM from the beginning of a File object.
+  """
+
+  def __init__(self, file, buffer_size=1048576):
+    """
+    Sets up the reader.
+
+    :param file: A file object which has been opened.
+    :param buffer_size: The size of the buffer to read the file.
+
+    The file object is kept referred to by the reader.  The reader is bound to the current opening of the file and can't be used after the file is closed.
+    """
+    pass  # native code
+
+  def __repr__(self):
+    """
+    Returns A string representation of the object.
+
+    :return: The string representation of the object.
+    """
+    pass  # native code
+
+  def Read(self, max_count=1, status=None):
+    """
+    Reads records.
+
+    :param max_count: The maximum number of records to read.
+    :param status: A status object to which the result status is assigned.  It can be omitted.
+    :return: A list of the bytes values of the read records.
+
+    All records are read in one native call without the GIL.  NOT_FOUND_ERROR is set to the status if there's no more record.  Metadata records are skipped.
+    """
+    pass  # native code
+
+  def ReadPairs(self, max_count=1, status=None):
+    """
+    Reads pairs of records as keys and values.
+
+    :param max_count: The maximum number of pairs to read.
+    :param status: A status object to which the result status is assigned.  It can be omitted.
+    :return: A list of tuples of the bytes key and the bytes value.
+
+    This is useful to read records exported from a database.  NOT_FOUND_ERROR is set to the status if there's no more record.  BROKEN_DATA_ERROR is set if the last key has no value.
+    """
+    pass  # native code
+
 
 class Index:
   """
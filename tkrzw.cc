@@ -11,2018 +11,6791 @@
  * and limitations under the License.
  *************************************************************************************************/
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <list>
 #include <string>
 #include <string_view>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <queue>
+#include <regex>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <ctime>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <sys/mman.h>
+#endif
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 #include "tkrzw_cmd_util.h"
 #include "tkrzw_dbm.h"
 #include "tkrzw_dbm_common_impl.h"
 #include "tkrzw_dbm_poly.h"
 #include "tkrzw_dbm_shard.h"
+#include "tkrzw_dbm_skip.h"
+#include "tkrzw_dbm_ulog.h"
 #include "tkrzw_file.h"
 #include "tkrzw_file_mmap.h"
 #include "tkrzw_file_poly.h"
 #include "tkrzw_file_util.h"
 #include "tkrzw_key_comparators.h"
 #include "tkrzw_lib_common.h"
+#include "tkrzw_message_queue.h"
 #include "tkrzw_str_util.h"
 
-extern "C" {
+// Pool of worker threads which can be shared by task queues of multiple AsyncDBMs.
+class AsyncExecutor final {
+ public:
+  // Interface of a producer of work units.
+  class Source {
+   public:
+    virtual ~Source() = default;
+    // Does one unit of work posted by Post with the same affinity.
+    virtual void RunOne(int32_t affinity) = 0;
+  };
 
-#undef _POSIX_C_SOURCE
-#undef _XOPEN_SOURCE
-#include "Python.h"
-#include "structmember.h"
+  // Statistics of the executor.
+  struct Stats {
+    int32_t num_threads = 0;
+    int64_t num_pending = 0;
+    int64_t num_executed = 0;
+    int64_t num_stolen = 0;
+  };
 
-// Global variables.
-PyObject* mod_tkrzw;
-PyObject* cls_utility;
-PyObject* cls_status;
-PyObject* cls_expt;
-PyObject* cls_future;
-PyObject* cls_dbm;
-PyObject* cls_iter;
-PyObject* cls_asyncdbm;
-PyObject* cls_file;
-PyObject* cls_index;
-PyObject* cls_indexiter;
-PyObject* obj_dbm_any_data;
+  AsyncExecutor(int32_t num_threads, bool pin_cpus)
+      : stopped_(false), num_shared_(0), next_worker_(0), num_executed_(0), num_stolen_(0) {
+    num_threads = std::max(num_threads, 1);
+    for (int32_t i = 0; i < num_threads; i++) {
+      workers_.emplace_back(std::make_unique<Worker>());
+    }
+    for (int32_t i = 0; i < num_threads; i++) {
+      workers_[i]->thread = std::thread([this, i, pin_cpus]() {
+        if (pin_cpus) {
+          PinCPU(i);
+        }
+        Work(i);
+      });
+    }
+  }
 
-// Python object of Utility.
-struct PyUtility {
-  PyObject_HEAD
-};
+  ~AsyncExecutor() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+    }
+    for (auto& worker : workers_) {
+      worker->cond.notify_one();
+    }
+    for (auto& worker : workers_) {
+      worker->thread.join();
+    }
+  }
 
-// Python object of Status.
-struct PyTkStatus {
-  PyObject_HEAD
-  tkrzw::Status* status;
-};
+  // Gets the number of worker threads.
+  int32_t GetNumThreads() const {
+    return workers_.size();
+  }
 
-// Python object of Future.
-struct PyFuture {
-  PyObject_HEAD
-  tkrzw::StatusFuture* future;
-  bool concurrent;
-  bool is_str;
-};
+  // Posts a unit of work.  If the affinity is negative, the unit is put to the deque of a
+  // worker in round-robin and any worker can run it.  Otherwise, only the worker of the index
+  // of the affinity modulo the number of workers runs it.  Only one idle worker which can run
+  // the unit is woken up.
+  void Post(Source* source, int32_t affinity = -1) {
+    const bool pinned = affinity >= 0;
+    Worker* worker =
+        workers_[(pinned ? affinity : next_worker_.fetch_add(1)) % workers_.size()].get();
+    {
+      std::lock_guard<std::mutex> lock(worker->mutex);
+      worker->units.emplace_back(Unit{source, affinity});
+    }
+    Worker* wakee = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (pinned) {
+        worker->num_pinned++;
+        if (worker->idle) {
+          wakee = worker;
+        }
+      } else {
+        num_shared_++;
+        if (worker->idle) {
+          wakee = worker;
+        } else {
+          for (auto& other : workers_) {
+            if (other->idle) {
+              wakee = other.get();
+              break;
+            }
+          }
+        }
+      }
+      if (wakee != nullptr) {
+        wakee->idle = false;
+      }
+    }
+    if (wakee != nullptr) {
+      wakee->cond.notify_one();
+    }
+  }
 
-// Python ofject of StatusException.
-struct PyException {
-  PyException_HEAD
-  PyObject* pystatus;
-};
+  // Gets the statistics.
+  Stats GetStats() {
+    Stats stats;
+    stats.num_threads = workers_.size();
+    int64_t num_pending = num_shared_.load();
+    for (const auto& worker : workers_) {
+      num_pending += worker->num_pinned.load();
+    }
+    stats.num_pending = std::max<int64_t>(num_pending, 0);
+    stats.num_executed = num_executed_.load();
+    stats.num_stolen = num_stolen_.load();
+    return stats;
+  }
 
-// Python object of DBM.
-struct PyDBM {
-  PyObject_HEAD
-  tkrzw::ParamDBM* dbm;
-  bool concurrent;
-};
+ private:
+  // Unit of work.
+  struct Unit {
+    Source* source;
+    int32_t affinity;
+  };
 
-// Python object of Iterator.
-struct PyIterator {
-  PyObject_HEAD
-  tkrzw::DBM::Iterator* iter;
-  bool concurrent;
-};
+  // Worker thread with its own deque of work units.  The condition variable and the idle flag
+  // are guarded by the mutex of the executor.
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Unit> units;
+    std::atomic<int64_t> num_pinned{0};
+    std::condition_variable cond;
+    bool idle = false;
+    std::thread thread;
+  };
 
-// Python object of AsyncDBM.
-struct PyAsyncDBM {
-  PyObject_HEAD
-  tkrzw::AsyncDBM* async;
-  bool concurrent;
-};
+  // Binds the calling thread to a CPU.  The CPU is chosen among the ones which the thread is
+  // allowed to run on, as the process can be restricted by taskset or cgroups.
+  static void PinCPU(int32_t id) {
+#if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+      return;
+    }
+    const int32_t num_allowed = CPU_COUNT(&allowed);
+    if (num_allowed < 1) {
+      return;
+    }
+    int32_t rank = id % num_allowed;
+    for (int32_t cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (!CPU_ISSET(cpu, &allowed) || rank-- > 0) {
+        continue;
+      }
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      CPU_SET(cpu, &cpus);
+      pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+      return;
+    }
+#endif
+  }
 
-// Python object of File.
-struct PyFile {
-  PyObject_HEAD
-  tkrzw::PolyFile* file;
-  bool concurrent;
-};
+  // Takes a work unit from the front of the own deque or the back of another one.  Units with
+  // affinity are never taken from another deque.
+  bool Take(int32_t id, Unit* unit) {
+    {
+      Worker* worker = workers_[id].get();
+      std::lock_guard<std::mutex> lock(worker->mutex);
+      if (!worker->units.empty()) {
+        *unit = worker->units.front();
+        worker->units.pop_front();
+        if (unit->affinity >= 0) {
+          worker->num_pinned--;
+        } else {
+          num_shared_--;
+        }
+        return true;
+      }
+    }
+    const int32_t num_workers = workers_.size();
+    for (int32_t i = 1; i < num_workers; i++) {
+      Worker* victim = workers_[(id + i) % num_workers].get();
+      std::lock_guard<std::mutex> lock(victim->mutex);
+      for (auto it = victim->units.rbegin(); it != victim->units.rend(); ++it) {
+        if (it->affinity < 0) {
+          *unit = *it;
+          victim->units.erase(std::next(it).base());
+          num_shared_--;
+          num_stolen_++;
+          return true;
+        }
+      }
+    }
+    return false;
+  }
 
-// Python object of Index.
-struct PyIndex {
-  PyObject_HEAD
-  tkrzw::PolyIndex* index;
-  bool concurrent;
-};
+  // Main routine of the worker threads.  After a failed steal, the worker sleeps until a unit
+  // which it can run is counted.  The counters are updated after a unit is put to a deque, so a
+  // positive count means that the unit can be taken.
+  void Work(int32_t id) {
+    Worker* worker = workers_[id].get();
+    while (true) {
+      Unit unit;
+      if (!Take(id, &unit)) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const auto has_work = [&]() { return num_shared_ > 0 || worker->num_pinned > 0; };
+        if (!has_work() && stopped_) {
+          break;
+        }
+        while (!has_work() && !stopped_) {
+          worker->idle = true;
+          worker->cond.wait(lock);
+        }
+        worker->idle = false;
+        continue;
+      }
+      unit.source->RunOne(unit.affinity);
+      num_executed_++;
+    }
+  }
 
-// Python object of IndexIterator.
-struct PyIndexIterator {
-  PyObject_HEAD
-  tkrzw::PolyIndex::Iterator* iter;
-  bool concurrent;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  bool stopped_;
+  std::atomic<int64_t> num_shared_;
+  std::atomic<uint32_t> next_worker_;
+  std::atomic<int64_t> num_executed_;
+  std::atomic<int64_t> num_stolen_;
+  std::mutex mutex_;
 };
 
-// Creates a new string of Python.
-static PyObject* CreatePyString(std::string_view str) {
-  return PyUnicode_DecodeUTF8(str.data(), str.size(), "replace");
-}
-
-// Creatse a new byte array of Python.
-static PyObject* CreatePyBytes(std::string_view str) {
-  return PyBytes_FromStringAndSize(str.data(), str.size());
-}
-
-// Creates a status object of Python.
-static PyObject* CreatePyTkStatus(const tkrzw::Status& status) {
-  PyTypeObject* pytype = (PyTypeObject*)cls_status;
-  PyTkStatus* obj = (PyTkStatus*)pytype->tp_alloc(pytype, 0);
-  if (!obj) return nullptr;
-  obj->status = new tkrzw::Status(status);
-  return (PyObject*)obj;
-}
+// Task queue of AsyncDBM, with a bounded depth, run by an executor.
+class AsyncQueue final : public AsyncExecutor::Source {
+ public:
+  // Policies to apply when the queue is full.
+  enum OverflowPolicy : int32_t {
+    // Blocks the submitter until a slot becomes available.
+    OVERFLOW_BLOCK = 0,
+    // Fails the new task immediately.
+    OVERFLOW_FAIL = 1,
+    // Drops the oldest pending read task, or blocks if there is none.
+    OVERFLOW_DROP_READ = 2,
+  };
 
-// Creates a status object of Python, in moving context.
-static PyObject* CreatePyTkStatusMove(tkrzw::Status&& status) {
-  PyTypeObject* pytype = (PyTypeObject*)cls_status;
-  PyTkStatus* obj = (PyTkStatus*)pytype->tp_alloc(pytype, 0);
-  if (!obj) return nullptr;
-  obj->status = new tkrzw::Status(std::move(status));
-  return (PyObject*)obj;
-}
+  // Priority classes of tasks, in the order of preference.
+  enum Priority : int32_t {
+    // Latency-critical operations.
+    PRIORITY_INTERACTIVE = 0,
+    // Ordinary operations.
+    PRIORITY_NORMAL = 1,
+    // Maintenance operations.
+    PRIORITY_BACKGROUND = 2,
+  };
 
-// Creates a status future object of Python, in moving context.
-static PyObject* CreatePyFutureMove(
-    tkrzw::StatusFuture&& future, bool concurrent, bool is_str = false) {
-  PyTypeObject* pytype = (PyTypeObject*)cls_future;
-  PyFuture* obj = (PyFuture*)pytype->tp_alloc(pytype, 0);
-  if (!obj) return nullptr;
-  obj->future = new tkrzw::StatusFuture(std::move(future));
-  obj->concurrent = concurrent;
-  obj->is_str = is_str;
-  return (PyObject*)obj;
-}
+  // The number of priority classes.
+  static constexpr int32_t NUM_PRIORITIES = 3;
+
+  // Kinds of coalescing of tasks on the same key.
+  enum CoalesceMode : int32_t {
+    // The task is never merged and no earlier task is merged across it.
+    COALESCE_NONE = 0,
+    // Identical pending reads share one operation.
+    COALESCE_READ = 1,
+    // A pending write is superseded by a later one.
+    COALESCE_WRITE = 2,
+  };
 
-// Throws an invalid argument error.
-static void ThrowInvalidArguments(std::string_view message) {
-  PyErr_SetString(PyExc_TypeError, tkrzw::StrCat("invalid arguments: ", message).c_str());
-}
+  // Interface of a task.
+  class Task {
+   public:
+    virtual ~Task() = default;
+    // Does the operation and sets the result.
+    virtual void Run() = 0;
+    // Sets an error result without doing the operation.
+    virtual void Cancel(const tkrzw::Status& status) = 0;
+    // Merges a later task of the same kind so that its result is set together.
+    virtual bool Absorb(Task* later) {
+      return false;
+    }
+    // Sets the key of the record if the task operates on only one record.
+    void SetKey(std::string_view record_key) {
+      key = record_key;
+      has_key = true;
+    }
+    // The kind of coalescing.
+    CoalesceMode coalesce = COALESCE_NONE;
+    // The key of the record, which is used for coalescing and routing.
+    std::string key;
+    // True if the key is set.
+    bool has_key = false;
+    // The index of the worker to run the task, or -1 for any worker.
+    int32_t route = -1;
+    // True if the operation only reads records.
+    bool readonly = false;
+    // The priority class.
+    Priority priority = PRIORITY_NORMAL;
+    // The time by which the task must start.
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    // The time when the task was added to the queue.
+    std::chrono::steady_clock::time_point enqueue_time;
+    // The function called after the operation is done, before the result is set.
+    std::function<void()> on_done;
+  };
 
-// Throws a status error.
-static void ThrowStatusException(const tkrzw::Status& status) {
-  PyObject* pystatus = CreatePyTkStatus(status);
-  PyErr_SetObject(cls_expt, pystatus);
-  Py_DECREF(pystatus);
-}
+  // Statistics of the queue.
+  struct Stats {
+    int32_t num_threads = 0;
+    int32_t num_shards = 0;
+    int64_t max_size = 0;
+    int64_t queue_size = 0;
+    int32_t num_running = 0;
+    int64_t num_done = 0;
+    int64_t num_rejected = 0;
+    int64_t num_dropped = 0;
+    int64_t num_expired = 0;
+    int64_t num_coalesced = 0;
+    double wait_time_total = 0;
+    double wait_time_max = 0;
+    double busy_time = 0;
+    double elapsed_time = 0;
+  };
 
-// Locking device to call a nagive function.
-class NativeLock final {
- public:
-  NativeLock(bool concurrent) : thstate_(nullptr) {
-    if (concurrent) {
-      thstate_ = PyEval_SaveThread();
+  // If num_shards is positive, each task on a key is routed to the worker which owns the shard
+  // of the key, by the same hash function as ShardDBM.
+  AsyncQueue(std::shared_ptr<AsyncExecutor> executor, int64_t max_size, OverflowPolicy policy,
+             bool coalesce, int32_t num_shards)
+      : executor_(std::move(executor)), max_size_(max_size), policy_(policy),
+        coalesce_(coalesce), num_shards_(std::max(num_shards, 0)), stopped_(false),
+        size_(0), num_units_(0), routes_(num_shards > 0 ? executor_->GetNumThreads() + 1 : 1),
+        start_time_(std::chrono::steady_clock::now()) {}
+
+  ~AsyncQueue() {
+    Stop();
+  }
+
+  // Adds a task.  If the queue is full and the task must wait for a slot, false is returned
+  // without consuming the task unless blocking is true.  Otherwise, true is returned.
+  bool Add(std::unique_ptr<Task>&& task, bool blocking) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!stopped_ && Coalesce(task.get())) {
+      return true;
+    }
+    while (!stopped_ && max_size_ > 0 && size_ >= max_size_) {
+      if (policy_ == OVERFLOW_FAIL) {
+        stats_.num_rejected++;
+        lock.unlock();
+        task->Cancel(tkrzw::Status(tkrzw::Status::INFEASIBLE_ERROR, "the task queue is full"));
+        return true;
+      }
+      if (policy_ == OVERFLOW_DROP_READ) {
+        bool dropped = false;
+        for (int32_t priority = NUM_PRIORITIES - 1; !dropped && priority >= 0; priority--) {
+          for (auto& route : routes_) {
+            auto& lane = route.lanes[priority];
+            auto it = std::find_if(lane.begin(), lane.end(),
+                                   [](const std::unique_ptr<Task>& t) { return t->readonly; });
+            if (it != lane.end()) {
+              std::unique_ptr<Task> victim = std::move(*it);
+              lane.erase(it);
+              Unindex(victim.get());
+              size_--;
+              stats_.num_dropped++;
+              victim->Cancel(tkrzw::Status(
+                  tkrzw::Status::CANCELED_ERROR, "dropped by overflow of the task queue"));
+              dropped = true;
+              break;
+            }
+          }
+        }
+        if (dropped) {
+          continue;
+        }
+      }
+      if (!blocking) {
+        return false;
+      }
+      space_cond_.wait(lock);
+    }
+    if (stopped_) {
+      lock.unlock();
+      task->Cancel(tkrzw::Status(tkrzw::Status::CANCELED_ERROR, "the task queue is stopped"));
+      return true;
+    }
+    if (Coalesce(task.get())) {
+      return true;
+    }
+    Index(task.get());
+    if (num_shards_ > 0 && task->has_key) {
+      task->route = tkrzw::SecondaryHash(task->key, num_shards_) % (routes_.size() - 1);
+    }
+    const int32_t route = task->route;
+    task->enqueue_time = std::chrono::steady_clock::now();
+    routes_[route + 1].lanes[task->priority].emplace_back(std::move(task));
+    size_++;
+    num_units_++;
+    lock.unlock();
+    executor_->Post(this, route);
+    return true;
+  }
+
+  // Waits for all tasks to be done and stops accepting new ones.
+  void Stop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    stopped_ = true;
+    space_cond_.notify_all();
+    while (num_units_ > 0) {
+      idle_cond_.wait(lock);
     }
   }
 
-  ~NativeLock() {
-    if (thstate_) {
-      PyEval_RestoreThread(thstate_);
+  // Runs the first task of the most preferred lane of the route.
+  void RunOne(int32_t affinity) override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::unique_ptr<Task> task;
+    for (auto& lane : routes_[affinity + 1].lanes) {
+      if (!lane.empty()) {
+        task = std::move(lane.front());
+        lane.pop_front();
+        break;
+      }
+    }
+    if (task != nullptr) {
+      Unindex(task.get());
+      size_--;
+      space_cond_.notify_one();
+      const auto run_start = std::chrono::steady_clock::now();
+      if (run_start > task->deadline) {
+        stats_.num_expired++;
+        lock.unlock();
+        task->Cancel(tkrzw::Status(tkrzw::Status::CANCELED_ERROR, "the deadline has passed"));
+        task.reset();
+        lock.lock();
+      } else {
+        const double wait_time =
+            std::chrono::duration<double>(run_start - task->enqueue_time).count();
+        stats_.wait_time_total += wait_time;
+        stats_.wait_time_max = std::max(stats_.wait_time_max, wait_time);
+        stats_.num_running++;
+        lock.unlock();
+        task->Run();
+        task.reset();
+        const double busy_time = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - run_start).count();
+        lock.lock();
+        stats_.num_running--;
+        stats_.num_done++;
+        stats_.busy_time += busy_time;
+      }
+    }
+    num_units_--;
+    if (num_units_ == 0) {
+      idle_cond_.notify_all();
     }
   }
 
-  void Release() {
-    if (thstate_) {
-      PyEval_RestoreThread(thstate_);
-    }
-    thstate_ = nullptr;
+  // Gets the statistics.
+  Stats GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.num_threads = executor_->GetNumThreads();
+    stats.num_shards = num_shards_;
+    stats.max_size = max_size_;
+    stats.queue_size = size_;
+    stats.elapsed_time = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start_time_).count();
+    return stats;
   }
 
  private:
-  PyThreadState* thstate_;
-};
+  // Pending tasks to be run by a worker, with a deque per priority class.
+  struct Route {
+    std::deque<std::unique_ptr<Task>> lanes[NUM_PRIORITIES];
+  };
 
-// Wrapper to treat a Python string as a C++ string_view.
-class SoftString final {
- public:
-  explicit SoftString(PyObject* pyobj) :
-    pyobj_(pyobj), pystr_(nullptr), pybytes_(nullptr), ptr_(nullptr), size_(0) {
-    Py_INCREF(pyobj_);
-    if (PyUnicode_Check(pyobj_)) {
-      pybytes_ = PyUnicode_AsUTF8String(pyobj_);
-      if (pybytes_) {
-        ptr_ = PyBytes_AS_STRING(pybytes_);
-        size_ = PyBytes_GET_SIZE(pybytes_);
-      } else {
-        PyErr_Clear();
-        ptr_ = "";
-        size_ = 0;
-      }
-    } else if (PyBytes_Check(pyobj_)) {
-      ptr_ = PyBytes_AS_STRING(pyobj_);
-      size_ = PyBytes_GET_SIZE(pyobj_);
-    } else if (PyByteArray_Check(pyobj_)) {
-      ptr_ = PyByteArray_AS_STRING(pyobj_);
-      size_ = PyByteArray_GET_SIZE(pyobj_);
-    } else if (pyobj_ == Py_None) {
-      ptr_ = "";
-      size_ = 0;
-    } else {
-      pystr_ = PyObject_Str(pyobj_);
-      if (pystr_) {
-        pybytes_ = PyUnicode_AsUTF8String(pystr_);
-        if (pybytes_) {
-          ptr_ = PyBytes_AS_STRING(pybytes_);
-          size_ = PyBytes_GET_SIZE(pybytes_);
-        } else {
-          PyErr_Clear();
-          ptr_ = "";
-          size_ = 0;
-        }
-      } else {
-        ptr_ = "(unknown)";
-        size_ = std::strlen(ptr_);
-      }
+  // Merges a task into the latest pending task on the same key if possible.
+  bool Coalesce(Task* task) {
+    if (!coalesce_ || task->coalesce == COALESCE_NONE) {
+      return false;
+    }
+    const auto it = index_.find(task->key);
+    if (it == index_.end()) {
+      return false;
     }
+    Task* pending = it->second;
+    if (pending->coalesce != task->coalesce || pending->priority != task->priority ||
+        !pending->Absorb(task)) {
+      return false;
+    }
+    pending->deadline = std::max(pending->deadline, task->deadline);
+    stats_.num_coalesced++;
+    return true;
   }
 
-  ~SoftString() {
-    if (pybytes_) Py_DECREF(pybytes_);
-    if (pystr_) Py_DECREF(pystr_);
-    Py_DECREF(pyobj_);
+  // Registers a task as the latest pending one on its key.
+  void Index(Task* task) {
+    if (!coalesce_) {
+      return;
+    }
+    if (task->coalesce == COALESCE_NONE) {
+      index_.clear();
+      return;
+    }
+    index_[task->key] = task;
   }
-  
-  std::string_view Get() const {
-    return std::string_view(ptr_, size_);
+
+  // Unregisters a task which is leaving the queue.
+  void Unindex(Task* task) {
+    if (!coalesce_ || task->coalesce == COALESCE_NONE) {
+      return;
+    }
+    const auto it = index_.find(task->key);
+    if (it != index_.end() && it->second == task) {
+      index_.erase(it);
+    }
   }
 
- private:
-  PyObject* pyobj_;
-  PyObject* pystr_;
-  PyObject* pybytes_;
-  const char* ptr_;
-  size_t size_;
+  std::shared_ptr<AsyncExecutor> executor_;
+  int64_t max_size_;
+  OverflowPolicy policy_;
+  bool coalesce_;
+  int32_t num_shards_;
+  bool stopped_;
+  int64_t size_;
+  int64_t num_units_;
+  std::vector<Route> routes_;
+  std::chrono::steady_clock::time_point start_time_;
+  std::unordered_map<std::string, Task*> index_;
+  Stats stats_;
+  std::mutex mutex_;
+  std::condition_variable space_cond_;
+  std::condition_variable idle_cond_;
 };
 
-// Converts a numeric parameter to an integer.
-static int64_t PyObjToInt(PyObject* pyobj) {
-  if (PyLong_Check(pyobj)) {
-    return PyLong_AsLong(pyobj);
-  } else if (PyFloat_Check(pyobj)) {
-    return (int64_t)PyFloat_AsDouble(pyobj);
-  } else if (PyUnicode_Check(pyobj) || PyBytes_Check(pyobj)) {
-    SoftString str(pyobj);
-    return tkrzw::StrToInt(str.Get());
-  } else if (pyobj != Py_None) {
-    int64_t num = 0;
-    PyObject* pylong = PyNumber_Long(pyobj);
-    if (pylong) {
-      num = PyLong_AsLong(pylong);
-      Py_DECREF(pylong);
-    }
-    return num;
+// Makes the result of an asynchronous operation which has failed without being done.
+template <typename RESULT>
+struct AsyncFailure final {
+  static RESULT Make(const tkrzw::Status& status) {
+    return RESULT(status, typename RESULT::second_type());
   }
-  return 0;
-}
+};
 
-// Converts a numeric parameter to a double.
-static double PyObjToDouble(PyObject* pyobj) {
-  if (PyLong_Check(pyobj)) {
-    return PyLong_AsLong(pyobj);
-  } else if (PyFloat_Check(pyobj)) {
-    return PyFloat_AsDouble(pyobj);
-  } else if (PyUnicode_Check(pyobj) || PyBytes_Check(pyobj)) {
-    SoftString str(pyobj);
-    return tkrzw::StrToDouble(str.Get());
-  } else if (pyobj != Py_None) {
-    double num = 0;
-    PyObject* pyfloat = PyNumber_Float(pyobj);
-    if (pyfloat) {
-      num = PyFloat_AsDouble(pyfloat);
-      Py_DECREF(pyfloat);
+// Makes the result of an asynchronous operation which returns only the status.
+template <>
+struct AsyncFailure<tkrzw::Status> final {
+  static tkrzw::Status Make(const tkrzw::Status& status) {
+    return status;
+  }
+};
+
+// Task of AsyncDBM whose result is set to a promise.
+template <typename RESULT>
+class AsyncTask final : public AsyncQueue::Task {
+ public:
+  AsyncTask(std::function<RESULT()> func, bool readonly) : func_(std::move(func)) {
+    this->readonly = readonly;
+  }
+
+  void Run() override {
+    const RESULT result = func_();
+    if (on_done) {
+      on_done();
+    }
+    for (auto& promise : promises_) {
+      promise.set_value(result);
     }
-    return num;
   }
-  return 0;
-}
 
-// Converts a Python Unicode object into a UCS-4 vector.
-std::vector<uint32_t> PyUnicodeToUCS4(PyObject* pyuni) {
-  const int32_t kind = PyUnicode_KIND(pyuni);
-  void* data = PyUnicode_DATA(pyuni);
-  const int32_t len = PyUnicode_GET_LENGTH(pyuni);
-  std::vector<uint32_t> ucs;
-  ucs.reserve(len);
-  for (int32_t i = 0; i < len; i++) {
-    ucs.emplace_back(PyUnicode_READ(kind, data, i));
+  void Cancel(const tkrzw::Status& status) override {
+    const RESULT result = AsyncFailure<RESULT>::Make(status);
+    for (auto& promise : promises_) {
+      promise.set_value(result);
+    }
   }
-  return ucs;
-}
 
-// Sets a constant of long integer.
-static bool SetConstLong(PyObject* pyobj, const char* name, int64_t value) {
-  PyObject* pyname = PyUnicode_FromString(name);
-  PyObject* pyvalue = PyLong_FromLongLong(value);
-  return PyObject_GenericSetAttr(pyobj, pyname, pyvalue) == 0;
-}
+  bool Absorb(AsyncQueue::Task* later) override {
+    AsyncTask* task = dynamic_cast<AsyncTask*>(later);
+    if (task == nullptr) {
+      return false;
+    }
+    if (coalesce == AsyncQueue::COALESCE_WRITE) {
+      func_ = std::move(task->func_);
+    }
+    for (auto& promise : task->promises_) {
+      promises_.emplace_back(std::move(promise));
+    }
+    task->promises_.clear();
+    return true;
+  }
 
-// Sets a constant of unsigned long integer.
-static bool SetConstUnsignedLong(PyObject* pyobj, const char* name, uint64_t value) {
-  PyObject* pyname = PyUnicode_FromString(name);
-  PyObject* pyvalue = PyLong_FromUnsignedLongLong(value);
-  return PyObject_GenericSetAttr(pyobj, pyname, pyvalue) == 0;
-}
+  // Gets the future object of the result.
+  std::future<RESULT> GetFuture() {
+    return promises_.front().get_future();
+  }
 
-// Sets a constant of string.
-static bool SetConstStr(PyObject* pyobj, const char* name, const char* value) {
-  PyObject* pyname = PyUnicode_FromString(name);
-  PyObject* pyvalue = PyUnicode_FromString(value);
-  return PyObject_GenericSetAttr(pyobj, pyname, pyvalue) == 0;
-}
+ private:
+  std::function<RESULT()> func_;
+  std::vector<std::promise<RESULT>> promises_{1};
+};
 
-// Maps keyword arguments into C++ map.
-static std::map<std::string, std::string> MapKeywords(PyObject* pykwds) {
-  std::map<std::string, std::string> map;
-  PyObject* pykwlist = PyMapping_Items(pykwds);
-  const int32_t kwnum = PyList_GET_SIZE(pykwlist);
-  for (int32_t i = 0; i < kwnum; i++) {
-    PyObject* pyrec = PyList_GET_ITEM(pykwlist, i);
-    if (PyTuple_GET_SIZE(pyrec) == 2) {
-      PyObject* pykey = PyTuple_GET_ITEM(pyrec, 0);
-      PyObject* pyvalue = PyTuple_GET_ITEM(pyrec, 1);
-      SoftString key(pykey);
-      SoftString value(pyvalue);
-      map.emplace(std::string(key.Get()), std::string(value.Get()));
+// Blocked Bloom filter of the keys of a database.  All bits of a key are in one 64-bit word so
+// that a check touches only one cache line.  While a filter is replaced by a rebuilt one, keys
+// added to the old one are forwarded to the successor so that they are not lost.
+class BloomFilter final {
+ public:
+  BloomFilter(int64_t num_keys, int32_t bits_per_key)
+      : BloomFilter(std::max<int64_t>(1, (num_keys + num_keys / 2 + 1024) * bits_per_key / 64),
+                    std::min(8, std::max(1, bits_per_key * 69 / 100)), bits_per_key) {}
+
+  // Adds a key.  It should be called after the record is stored.
+  void Add(std::string_view key) {
+    const uint64_t hash = tkrzw::PrimaryHash(key);
+    for (BloomFilter* filter = this; filter != nullptr;
+         filter = filter->successor_.load(std::memory_order_acquire)) {
+      filter->words_[hash % filter->num_words_].fetch_or(
+          filter->MakeMask(hash), std::memory_order_release);
     }
   }
-  Py_DECREF(pykwlist);
-  return map;
-}
 
-
-// Extracts a list of pairs of string views and functions from a sequence object.
-std::vector<std::pair<std::string, std::shared_ptr<tkrzw::DBM::RecordProcessor>>> ExtractKFPairs(
-    PyObject* pyseq) {
-  std::vector<std::pair<std::string, std::shared_ptr<tkrzw::DBM::RecordProcessor>>> result;
-  const size_t size = PySequence_Size(pyseq);
-  result.reserve(size);
-  for (size_t i = 0; i < size; i++) {
-    PyObject* pypair = PySequence_GetItem(pyseq, i);
-    if (PySequence_Check(pypair) && PySequence_Size(pypair) >= 2) {
-      PyObject* pykey = PySequence_GetItem(pypair, 0);
-      PyObject* pyfunc = PySequence_GetItem(pypair, 1);
-      if (PyCallable_Check(pyfunc)) {
-        SoftString key(pykey);
-        class Processor final : public tkrzw::DBM::RecordProcessor {
-         public:
-          Processor(PyObject* pyfunc) : pyfunc_(pyfunc) {
-            Py_INCREF(pyfunc_);
-          }
-          ~Processor() {
-            Py_DECREF(pyfunc_);
-          }
-          std::string_view ProcessFull(std::string_view key, std::string_view value) override {
-            PyObject* pyfuncargs = PyTuple_New(2);
-            PyTuple_SET_ITEM(pyfuncargs, 0, CreatePyBytes(key));
-            PyTuple_SET_ITEM(pyfuncargs, 1, CreatePyBytes(value));
-            PyObject* pyfuncrv = PyObject_CallObject(pyfunc_, pyfuncargs);
-            std::string_view funcrv = tkrzw::DBM::RecordProcessor::NOOP;
-            if (pyfuncrv != nullptr) {
-              if (pyfuncrv == Py_None) {
-                funcrv = tkrzw::DBM::RecordProcessor::NOOP;
-              } else if (pyfuncrv == Py_False) {
-                funcrv = tkrzw::DBM::RecordProcessor::REMOVE;
-              } else {
-                funcrvstr_ = std::make_unique<SoftString>(pyfuncrv);
-                funcrv = funcrvstr_->Get();
-              }
-              Py_DECREF(pyfuncrv);
-            }
-            Py_DECREF(pyfuncargs);
-            return funcrv;
-          }
-          std::string_view ProcessEmpty(std::string_view key) override {
-            PyObject* pyfuncargs = PyTuple_New(2);
-            PyTuple_SET_ITEM(pyfuncargs, 0, CreatePyBytes(key));
-            Py_INCREF(Py_None);
-            PyTuple_SET_ITEM(pyfuncargs, 1, Py_None);
-            PyObject* pyfuncrv = PyObject_CallObject(pyfunc_, pyfuncargs);
-            std::string_view funcrv = tkrzw::DBM::RecordProcessor::NOOP;
-            if (pyfuncrv != nullptr) {
-              if (pyfuncrv == Py_None) {
-                funcrv = tkrzw::DBM::RecordProcessor::NOOP;
-              } else if (pyfuncrv == Py_False) {
-                funcrv = tkrzw::DBM::RecordProcessor::REMOVE;
-              } else {
-                funcrvstr_ = std::make_unique<SoftString>(pyfuncrv);
-                funcrv = funcrvstr_->Get();
-              }
-              Py_DECREF(pyfuncrv);
-            }
-            Py_DECREF(pyfuncargs);
-            return funcrv;
-          }
-         private:
-          PyObject* pyfunc_;
-          std::unique_ptr<SoftString> funcrvstr_;
-        };
-        auto proc = std::make_shared<Processor>(pyfunc);
-        result.emplace_back(std::make_pair(key.Get(), proc));
+  // Checks whether a key may exist.  False means that the key surely does not exist.
+  bool MayContain(std::string_view key) const {
+    if (!enabled_.load(std::memory_order_acquire)) {
+      return true;
+    }
+    const uint64_t hash = tkrzw::PrimaryHash(key);
+    const uint64_t mask = MakeMask(hash);
+    return (words_[hash % num_words_].load(std::memory_order_acquire) & mask) == mask;
+  }
+
+  // Adds all keys of a database.
+  tkrzw::Status AddAllKeys(tkrzw::DBM* dbm, std::atomic<int64_t>* num_scanned = nullptr) {
+    std::unique_ptr<tkrzw::DBM::Iterator> iter = dbm->MakeIterator();
+    tkrzw::Status status = iter->First();
+    std::string key;
+    while (status == tkrzw::Status::SUCCESS) {
+      status = iter->Get(&key);
+      if (status != tkrzw::Status::SUCCESS) {
+        break;
       }
-      Py_DECREF(pyfunc);
-      Py_DECREF(pykey);
+      Add(key);
+      if (num_scanned != nullptr) {
+        num_scanned->fetch_add(1, std::memory_order_relaxed);
+      }
+      status = iter->Next();
     }
-    Py_DECREF(pypair);
+    return status == tkrzw::Status::NOT_FOUND_ERROR ? tkrzw::Status(tkrzw::Status::SUCCESS) :
+        status;
   }
-  return result;
-}
 
+  // Makes every check positive until the filter is replaced.
+  void Disable() {
+    enabled_.store(false, std::memory_order_release);
+  }
 
-// Extracts a list of pairs of string views from a sequence object.
-static std::vector<std::pair<std::string_view, std::string_view>> ExtractSVPairs(
-    PyObject* pyseq, std::vector<std::string>* placeholder) {
-  std::vector<std::pair<std::string_view, std::string_view>> result;
-  const size_t size = PySequence_Size(pyseq);
-  result.reserve(size);
-  placeholder->reserve(size * 2);
-  for (size_t i = 0; i < size; i++) {
-    PyObject* pypair = PySequence_GetItem(pyseq, i);
-    if (PySequence_Check(pypair) && PySequence_Size(pypair) >= 2) {
-      PyObject* pykey = PySequence_GetItem(pypair, 0);
-      PyObject* pyvalue = PySequence_GetItem(pypair, 1);
-      {
-        SoftString key(pykey);
-        placeholder->emplace_back(std::string(key.Get()));
-        std::string_view key_view = placeholder->back();
-        std::string_view value_view;
-        if (pyvalue != Py_None) {
-          if (pyvalue == obj_dbm_any_data) {
-            value_view = tkrzw::DBM::ANY_DATA;
-          } else {
-            SoftString value(pyvalue);
-            placeholder->emplace_back(std::string(value.Get()));
-            value_view = placeholder->back();
-          }
-        }
-        result.emplace_back(std::make_pair(key_view, value_view));
-      }
-      Py_DECREF(pyvalue);
-      Py_DECREF(pykey);
-    }
-    Py_DECREF(pypair);
+  bool IsEnabled() const {
+    return enabled_.load(std::memory_order_acquire);
   }
-  return result;
-}
 
-// Defines the module.
-static bool DefineModule() {
-  static PyModuleDef module_def = {PyModuleDef_HEAD_INIT};
-  const size_t zoff = offsetof(PyModuleDef, m_name);
-  std::memset((char*)&module_def + zoff, 0, sizeof(module_def) - zoff);
-  module_def.m_name = "tkrzw";
-  module_def.m_doc = "a set of implementations of DBM";
-  module_def.m_size = -1;
-  static PyMethodDef methods[] = {
-    {nullptr, nullptr, 0, nullptr},
-  };
-  module_def.m_methods = methods;
-  mod_tkrzw = PyModule_Create(&module_def);
-  return true;
-}
+  int32_t GetBitsPerKey() const {
+    return bits_per_key_;
+  }
 
-// Implementation of Utility.GetMemoryCapacity.
-static PyObject* utility_GetMemoryCapacity(PyObject* self) {
-  return PyLong_FromLongLong(tkrzw::GetMemoryCapacity());
-}
+  // Sets the filter to which later additions are forwarded.
+  void SetSuccessor(std::shared_ptr<BloomFilter> successor) {
+    successor_holder_ = std::move(successor);
+    successor_.store(successor_holder_.get(), std::memory_order_release);
+  }
 
-// Implementation of Utility.GetMemoryUsage.
-static PyObject* utility_GetMemoryUsage(PyObject* self) {
-  return PyLong_FromLongLong(tkrzw::GetMemoryUsage());
-}
+  // Saves the filter in a file with the fingerprint of the database.
+  tkrzw::Status Save(const std::string& path, std::string_view fingerprint) const {
+    const uint64_t header[] = {MAGIC, static_cast<uint64_t>(num_words_),
+                               static_cast<uint64_t>(num_hashes_),
+                               static_cast<uint64_t>(bits_per_key_), fingerprint.size()};
+    std::string data;
+    data.reserve(sizeof(header) + fingerprint.size() + num_words_ * sizeof(uint64_t));
+    data.append(reinterpret_cast<const char*>(header), sizeof(header));
+    data.append(fingerprint);
+    for (int64_t i = 0; i < num_words_; i++) {
+      const uint64_t word = words_[i].load(std::memory_order_relaxed);
+      data.append(reinterpret_cast<const char*>(&word), sizeof(word));
+    }
+    return tkrzw::WriteFileAtomic(path, data);
+  }
 
-// Implementation of Utility.PrimaryHash.
-static PyObject* utility_PrimaryHash(PyObject* self, PyObject* pyargs) {
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 1 || argc > 2) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
-    return nullptr;
+  // Loads the filter from a file if it was saved with the same fingerprint.
+  static std::shared_ptr<BloomFilter> Load(
+      const std::string& path, std::string_view fingerprint) {
+    std::string data;
+    uint64_t header[5];
+    if (tkrzw::ReadFile(path, &data, tkrzw::INT64MAX) != tkrzw::Status::SUCCESS ||
+        data.size() < sizeof(header)) {
+      return nullptr;
+    }
+    std::memcpy(header, data.data(), sizeof(header));
+    const int64_t num_words = header[1];
+    const int32_t num_hashes = header[2];
+    const int32_t bits_per_key = header[3];
+    if (header[0] != MAGIC || num_words < 1 || num_hashes < 1 || num_hashes > 8 ||
+        header[4] != fingerprint.size() ||
+        data.size() != sizeof(header) + fingerprint.size() + num_words * sizeof(uint64_t) ||
+        std::string_view(data).substr(sizeof(header), fingerprint.size()) != fingerprint) {
+      return nullptr;
+    }
+    std::shared_ptr<BloomFilter> filter(new BloomFilter(num_words, num_hashes, bits_per_key));
+    const char* rp = data.data() + sizeof(header) + fingerprint.size();
+    for (int64_t i = 0; i < num_words; i++) {
+      uint64_t word = 0;
+      std::memcpy(&word, rp, sizeof(word));
+      filter->words_[i].store(word, std::memory_order_relaxed);
+      rp += sizeof(word);
+    }
+    return filter;
   }
-  PyObject* pydata = PyTuple_GET_ITEM(pyargs, 0);
-  SoftString data(pydata);
-  uint64_t num_buckets = 0;
-  if (argc > 1) {
-    PyObject* pynum = PyTuple_GET_ITEM(pyargs, 1);
-    num_buckets = PyObjToInt(pynum);
+
+ private:
+  // Magic data to identify the file, which also detects a different byte order.
+  static constexpr uint64_t MAGIC = 0x544B42464C545231ULL;
+
+  BloomFilter(int64_t num_words, int32_t num_hashes, int32_t bits_per_key)
+      : num_words_(num_words), num_hashes_(num_hashes), bits_per_key_(bits_per_key),
+        words_(new std::atomic<uint64_t>[num_words]) {
+    for (int64_t i = 0; i < num_words_; i++) {
+      words_[i].store(0, std::memory_order_relaxed);
+    }
   }
-  if (num_buckets == 0) {
-    num_buckets = tkrzw::UINT64MAX;
+
+  uint64_t MakeMask(uint64_t hash) const {
+    const uint64_t mix = hash * 0x9E3779B97F4A7C15ULL;
+    uint64_t mask = 0;
+    for (int32_t i = 0; i < num_hashes_; i++) {
+      mask |= 1ULL << ((mix >> (58 - i * 6)) & 63);
+    }
+    return mask;
   }
-  return PyLong_FromUnsignedLongLong(tkrzw::PrimaryHash(data.Get(), num_buckets));
-}
 
-// Implementation of Utility.SecondaryHash.
+  const int64_t num_words_;
+  const int32_t num_hashes_;
+  const int32_t bits_per_key_;
+  std::unique_ptr<std::atomic<uint64_t>[]> words_;
+  std::atomic<bool> enabled_{true};
+  std::shared_ptr<BloomFilter> successor_holder_;
+  std::atomic<BloomFilter*> successor_{nullptr};
+};
+
+// Lowers the CPU and I/O priority of the calling thread.  The thread takes locks of the database
+// which foreground threads wait for, so the idle I/O class and the weakest nice value, under
+// which the thread can starve indefinitely, are avoided.  The lowest level of the best-effort
+// I/O class is still served under load.
+static void LowerThreadPriority() {
+#if defined(__linux__)
+  constexpr int32_t ioprio_who_process = 1;
+  constexpr int32_t ioprio_class_be = 2;
+  constexpr int32_t ioprio_class_shift = 13;
+  constexpr int32_t ioprio_be_lowest = 7;
+  setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+  syscall(SYS_ioprio_set, ioprio_who_process, 0,
+          (ioprio_class_be << ioprio_class_shift) | ioprio_be_lowest);
+#endif
+}
+
+// Job to rebuild a database on a dedicated thread.  The rebuilding function is called after the
+// start delay.  The native rebuilding of a database file cannot be interrupted, so a running job
+// is canceled only at the checkpoints which the rebuilding function checks, namely between the
+// shards and before rebuilding the Bloom filter.  The progress is reported by the counters.
+class RebuildJob final {
+ public:
+  // States of the job.
+  enum State : int32_t {
+    STATE_WAITING = 0,
+    STATE_RUNNING = 1,
+    STATE_DONE = 2,
+    STATE_CANCELED = 3,
+  };
+
+  // Progress of a running job, shared with the rebuilding function.
+  struct Progress {
+    std::atomic<int64_t> num_parts{0};
+    std::atomic<int64_t> num_rebuilt_parts{0};
+    std::atomic<int64_t> num_scanned_keys{0};
+    std::atomic<bool> canceled{false};
+  };
+
+  // Function to rebuild, which sets the file sizes before and after the rebuilding.
+  typedef std::function<tkrzw::Status(
+      Progress* progress, int64_t* size_before, int64_t* size_after)> Rebuilder;
+
+  RebuildJob(Rebuilder rebuilder, double delay, bool low_priority)
+      : rebuilder_(std::move(rebuilder)), delay_(std::max(delay, 0.0)),
+        low_priority_(low_priority), state_(STATE_WAITING),
+        status_(tkrzw::Status::SUCCESS), create_time_(tkrzw::GetWallTime()),
+        start_time_(0), end_time_(0), size_before_(-1), size_after_(-1) {
+    thread_ = std::thread([this]() { Run(); });
+  }
+
+  ~RebuildJob() {
+    Cancel();
+    thread_.join();
+  }
+
+  // Cancels the job.  A running job stops at the next checkpoint.  Returns true if the job has
+  // not finished.
+  bool Cancel() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_ == STATE_RUNNING) {
+      progress_.canceled.store(true);
+      return true;
+    }
+    if (state_ != STATE_WAITING) {
+      return false;
+    }
+    state_ = STATE_CANCELED;
+    status_ = tkrzw::Status(tkrzw::Status::CANCELED_ERROR, "canceled before start");
+    end_time_ = tkrzw::GetWallTime();
+    cond_.notify_all();
+    return true;
+  }
+
+  // Waits for the job to finish.  Returns false on timeout.
+  bool Wait(double timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const auto finished = [&]() { return state_ == STATE_DONE || state_ == STATE_CANCELED; };
+    if (timeout < 0) {
+      cond_.wait(lock, finished);
+      return true;
+    }
+    return cond_.wait_for(
+        lock, std::chrono::microseconds(static_cast<int64_t>(timeout * 1000000)), finished);
+  }
+
+  // Gets the current state.
+  State GetState() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return state_;
+  }
+
+  // Gets the name of a state.
+  static const char* GetStateName(State state) {
+    static const char* const names[] = {"waiting", "running", "done", "canceled"};
+    return names[state];
+  }
+
+  // Gets the result status, which is valid after the job finishes.
+  tkrzw::Status GetStatus() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return status_;
+  }
+
+  // Gets the properties for inspection.
+  std::vector<std::pair<std::string, std::string>> Inspect() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const double now = tkrzw::GetWallTime();
+    std::vector<std::pair<std::string, std::string>> props;
+    props.emplace_back("state", GetStateName(state_));
+    props.emplace_back("status", tkrzw::Status::CodeName(status_.GetCode()));
+    props.emplace_back("low_priority", low_priority_ ? "true" : "false");
+    props.emplace_back("elapsed_time", tkrzw::ToString(
+        (end_time_ > 0 ? end_time_ : now) - create_time_));
+    if (start_time_ > 0) {
+      props.emplace_back("running_time", tkrzw::ToString(
+          (end_time_ > 0 ? end_time_ : now) - start_time_));
+      props.emplace_back("num_parts", tkrzw::ToString(progress_.num_parts.load()));
+      props.emplace_back("num_rebuilt_parts",
+                         tkrzw::ToString(progress_.num_rebuilt_parts.load()));
+      props.emplace_back("num_scanned_keys",
+                         tkrzw::ToString(progress_.num_scanned_keys.load()));
+      props.emplace_back("cancel_requested", progress_.canceled.load() ? "true" : "false");
+    }
+    if (size_before_ >= 0) {
+      props.emplace_back("file_size_before", tkrzw::ToString(size_before_));
+    }
+    if (size_after_ >= 0) {
+      props.emplace_back("file_size_after", tkrzw::ToString(size_after_));
+    }
+    return props;
+  }
+
+ private:
+  // Runs the job on the dedicated thread.
+  void Run() {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait_for(lock, std::chrono::microseconds(static_cast<int64_t>(delay_ * 1000000)),
+                     [&]() { return state_ != STATE_WAITING; });
+      if (state_ != STATE_WAITING) {
+        return;
+      }
+      state_ = STATE_RUNNING;
+      start_time_ = tkrzw::GetWallTime();
+    }
+    if (low_priority_) {
+      LowerThreadPriority();
+    }
+    int64_t size_before = -1;
+    int64_t size_after = -1;
+    tkrzw::Status status = rebuilder_(&progress_, &size_before, &size_after);
+    std::lock_guard<std::mutex> lock(mutex_);
+    state_ = STATE_DONE;
+    status_ = std::move(status);
+    size_before_ = size_before;
+    size_after_ = size_after;
+    end_time_ = tkrzw::GetWallTime();
+    cond_.notify_all();
+  }
+
+  Rebuilder rebuilder_;
+  const double delay_;
+  const bool low_priority_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  State state_;
+  tkrzw::Status status_;
+  const double create_time_;
+  double start_time_;
+  double end_time_;
+  int64_t size_before_;
+  int64_t size_after_;
+  Progress progress_;
+  std::thread thread_;
+};
+
+// Thread to maintain a database periodically.  At each check, the database is rebuilt if it
+// should be and the local time is within the rebuild window, and it is synchronized softly if
+// the synchronization interval has passed.
+class Maintainer final {
+ public:
+  // Configuration of the maintenance.
+  struct Config {
+    double interval = 60;
+    double sync_interval = 0;
+    int32_t window_begin = 0;
+    int32_t window_end = 0;
+    bool low_priority = true;
+  };
+
+  // Result of a check.
+  struct Result {
+    bool checked = false;
+    bool rebuilt = false;
+    bool synced = false;
+    tkrzw::Status status;
+  };
+
+  // Function to do a check.  The check should be skipped if the database is busy.
+  typedef std::function<Result(bool may_rebuild, bool should_sync)> Checker;
+
+  // Statistics of the maintenance.
+  struct Stats {
+    int64_t num_checks = 0;
+    int64_t num_skips = 0;
+    int64_t num_rebuilds = 0;
+    int64_t num_syncs = 0;
+    double last_rebuild_time = 0;
+    tkrzw::Status last_status;
+  };
+
+  Maintainer(Checker checker, const Config& config)
+      : checker_(std::move(checker)), config_(config), stopped_(false) {
+    thread_ = std::thread([this]() { Run(); });
+  }
+
+  ~Maintainer() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+    }
+    cond_.notify_all();
+    thread_.join();
+  }
+
+  // Gets the configuration.
+  const Config& GetConfig() const {
+    return config_;
+  }
+
+  // Gets the statistics.
+  Stats GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+  // Parses a window expression like "02:00-05:00" into minutes of the day.
+  static bool ParseWindow(std::string_view expr, int32_t* begin, int32_t* end) {
+    int32_t begin_hour = 0, begin_minute = 0, end_hour = 0, end_minute = 0;
+    if (std::sscanf(std::string(expr).c_str(), "%d:%d-%d:%d",
+                    &begin_hour, &begin_minute, &end_hour, &end_minute) != 4 ||
+        begin_hour < 0 || begin_hour > 24 || begin_minute < 0 || begin_minute > 59 ||
+        end_hour < 0 || end_hour > 24 || end_minute < 0 || end_minute > 59) {
+      return false;
+    }
+    *begin = begin_hour * 60 + begin_minute;
+    *end = end_hour * 60 + end_minute;
+    return true;
+  }
+
+ private:
+  // Gets the current minute of the day in the local time.
+  static int32_t GetLocalMinuteOfDay() {
+    const std::time_t now = std::time(nullptr);
+    std::tm local = {};
+#if defined(_WIN32)
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
+    return local.tm_hour * 60 + local.tm_min;
+  }
+
+  // Checks whether the current time is within the rebuild window.
+  bool IsInWindow() const {
+    if (config_.window_begin == config_.window_end) {
+      return true;
+    }
+    const int32_t minute = GetLocalMinuteOfDay();
+    if (config_.window_begin < config_.window_end) {
+      return minute >= config_.window_begin && minute < config_.window_end;
+    }
+    return minute >= config_.window_begin || minute < config_.window_end;
+  }
+
+  // Runs the checks on the dedicated thread.
+  void Run() {
+    if (config_.low_priority) {
+      LowerThreadPriority();
+    }
+    const auto interval =
+        std::chrono::microseconds(static_cast<int64_t>(config_.interval * 1000000));
+    double last_sync_time = tkrzw::GetWallTime();
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      cond_.wait_for(lock, interval, [&]() { return stopped_; });
+      if (stopped_) {
+        break;
+      }
+      lock.unlock();
+      const double now = tkrzw::GetWallTime();
+      const bool should_sync =
+          config_.sync_interval > 0 && now - last_sync_time >= config_.sync_interval;
+      const Result result = checker_(IsInWindow(), should_sync);
+      lock.lock();
+      if (!result.checked) {
+        stats_.num_skips++;
+        continue;
+      }
+      stats_.num_checks++;
+      if (result.rebuilt) {
+        stats_.num_rebuilds++;
+        stats_.last_rebuild_time = now;
+      }
+      if (result.synced) {
+        stats_.num_syncs++;
+        last_sync_time = now;
+      }
+      stats_.last_status = result.status;
+    }
+  }
+
+  Checker checker_;
+  const Config config_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  bool stopped_;
+  Stats stats_;
+  std::thread thread_;
+};
+
+// File processor which calls a function with the path of the database file.
+class FunctionFileProcessor final : public tkrzw::DBM::FileProcessor {
+ public:
+  explicit FunctionFileProcessor(std::function<void(const std::string&)> func)
+      : func_(std::move(func)) {}
+
+  void Process(const std::string& path) override {
+    func_(path);
+  }
+
+ private:
+  std::function<void(const std::string&)> func_;
+};
+
+// Group commit of synchronization requests from concurrent threads.  A caller becomes the
+// leader if no synchronization is running, and one synchronization by the leader covers all
+// requests made before it starts.  The other callers wait for a synchronization covering them.
+class GroupCommitter final {
+ public:
+  // Function to synchronize the database.
+  typedef std::function<tkrzw::Status(bool hard)> Synchronizer;
+
+  GroupCommitter(Synchronizer synchronizer, double delay)
+      : synchronizer_(std::move(synchronizer)), delay_(std::max(delay, 0.0)),
+        running_(false), num_requests_(0), max_hard_ticket_(0),
+        synced_ticket_(0), hard_synced_ticket_(0), failed_ticket_(0), num_syncs_(0) {}
+
+  // Makes the updates done before the call durable.  If hard is true, physical synchronization
+  // with the hardware is done.
+  tkrzw::Status Commit(bool hard) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const int64_t ticket = ++num_requests_;
+    if (hard) {
+      max_hard_ticket_ = ticket;
+    }
+    while (true) {
+      if ((hard ? hard_synced_ticket_ : synced_ticket_) >= ticket) {
+        return tkrzw::Status(tkrzw::Status::SUCCESS);
+      }
+      if (failed_ticket_ >= ticket) {
+        return failure_status_;
+      }
+      if (running_) {
+        cond_.wait(lock);
+        continue;
+      }
+      running_ = true;
+      if (delay_ > 0) {
+        lock.unlock();
+        tkrzw::Sleep(delay_);
+        lock.lock();
+      }
+      const int64_t target = num_requests_;
+      const bool round_hard = max_hard_ticket_ > hard_synced_ticket_;
+      lock.unlock();
+      tkrzw::Status status = synchronizer_(round_hard);
+      lock.lock();
+      if (status == tkrzw::Status::SUCCESS) {
+        synced_ticket_ = target;
+        if (round_hard) {
+          hard_synced_ticket_ = target;
+        }
+      } else {
+        failed_ticket_ = target;
+        failure_status_ = std::move(status);
+      }
+      num_syncs_++;
+      running_ = false;
+      cond_.notify_all();
+    }
+  }
+
+  // Gets the number of commit requests.
+  int64_t GetNumRequests() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return num_requests_;
+  }
+
+  // Gets the number of synchronizations done.
+  int64_t GetNumSyncs() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return num_syncs_;
+  }
+
+ private:
+  Synchronizer synchronizer_;
+  const double delay_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  bool running_;
+  int64_t num_requests_;
+  int64_t max_hard_ticket_;
+  int64_t synced_ticket_;
+  int64_t hard_synced_ticket_;
+  int64_t failed_ticket_;
+  tkrzw::Status failure_status_;
+  int64_t num_syncs_;
+};
+
+// Scanner of lines of a file.  Data is read in large blocks and newlines are located by memchr,
+// which is vectorized by the C library.  Lines of a batch refer to the buffer, which is
+// compacted only when the next batch starts.
+class LineScanner final {
+ public:
+  // Function to check whether a line should be extracted.
+  typedef std::function<bool(std::string_view line)> Matcher;
+
+  LineScanner(int64_t block_size, Matcher matcher)
+      : block_size_(std::max<int64_t>(block_size, 1)), matcher_(std::move(matcher)),
+        file_off_(0), pos_(0), eof_(false) {}
+
+  // Scans the next batch of lines.  The start and the end positions in the buffer are stored.
+  tkrzw::Status Scan(tkrzw::File* file, int64_t batch,
+                     std::vector<std::pair<size_t, size_t>>* lines) {
+    lines->clear();
+    buf_.erase(0, pos_);
+    pos_ = 0;
+    size_t scan_pos = 0;
+    while (static_cast<int64_t>(lines->size()) < batch) {
+      const char* start = buf_.data() + pos_;
+      scan_pos = std::max(scan_pos, pos_);
+      const char* nl = static_cast<const char*>(
+          std::memchr(buf_.data() + scan_pos, '\n', buf_.size() - scan_pos));
+      if (nl != nullptr) {
+        const size_t end = nl - buf_.data();
+        if (matcher_ == nullptr || matcher_(std::string_view(start, end - pos_))) {
+          lines->emplace_back(pos_, end);
+        }
+        pos_ = end + 1;
+        continue;
+      }
+      if (eof_) {
+        if (pos_ < buf_.size()) {
+          if (matcher_ == nullptr || matcher_(std::string_view(start, buf_.size() - pos_))) {
+            lines->emplace_back(pos_, buf_.size());
+          }
+          pos_ = buf_.size();
+        }
+        break;
+      }
+      int64_t file_size = 0;
+      tkrzw::Status status = file->GetSize(&file_size);
+      if (status != tkrzw::Status::SUCCESS) {
+        return status;
+      }
+      const int64_t read_size = std::min(block_size_, file_size - file_off_);
+      if (read_size <= 0) {
+        eof_ = true;
+        continue;
+      }
+      const size_t old_size = buf_.size();
+      scan_pos = old_size;
+      buf_.resize(old_size + read_size);
+      status = file->Read(file_off_, buf_.data() + old_size, read_size);
+      if (status != tkrzw::Status::SUCCESS) {
+        buf_.resize(old_size);
+        return status;
+      }
+      file_off_ += read_size;
+    }
+    return tkrzw::Status(tkrzw::Status::SUCCESS);
+  }
+
+  // Gets the buffer which the positions of lines refer to.
+  const std::string& GetBuffer() const {
+    return buf_;
+  }
+
+  // Checks whether all lines have been scanned.
+  bool IsEnd() const {
+    return eof_ && pos_ >= buf_.size();
+  }
+
+ private:
+  const int64_t block_size_;
+  Matcher matcher_;
+  int64_t file_off_;
+  std::string buf_;
+  size_t pos_;
+  bool eof_;
+};
+
+// Loader to store records in ascending order of the key.  Sorted input is stored as it comes.
+// Otherwise, records are sorted in memory and the runs overflowing the memory are spilled into
+// temporary flat record files, which are merged at the end.  Of the records with the same key,
+// the last one in the input is stored.
+class BulkLoader final {
+ public:
+  // Pair of the key and the value.
+  typedef std::pair<std::string, std::string> Record;
+
+  // Function to store a record.
+  typedef std::function<tkrzw::Status(std::string_view key, std::string_view value)> Storer;
+
+  BulkLoader(Storer storer, int64_t sort_mem_size)
+      : storer_(std::move(storer)), sort_mem_size_(std::max<int64_t>(sort_mem_size, 1)),
+        buffer_size_(0), sorted_(true) {}
+
+  BulkLoader(tkrzw::DBM* dbm, int64_t sort_mem_size)
+      : BulkLoader([dbm](std::string_view key, std::string_view value) {
+          return dbm->Set(key, value);
+        }, sort_mem_size) {}
+
+  // Adds records, whose strings are moved.
+  tkrzw::Status Add(std::vector<Record>* records) {
+    for (auto& record : *records) {
+      if (sorted_) {
+        const std::string& last_key = buffer_.empty() ? last_key_ : buffer_.back().first;
+        sorted_ = record.first >= last_key;
+      }
+      buffer_size_ += record.first.size() + record.second.size() + sizeof(Record);
+      buffer_.emplace_back(std::move(record));
+      if (buffer_size_ >= sort_mem_size_) {
+        const tkrzw::Status status = FlushBuffer();
+        if (status != tkrzw::Status::SUCCESS) {
+          return status;
+        }
+      }
+    }
+    records->clear();
+    return tkrzw::Status(tkrzw::Status::SUCCESS);
+  }
+
+  // Stores all remaining records.
+  tkrzw::Status Finish() {
+    if (!sorted_) {
+      std::stable_sort(buffer_.begin(), buffer_.end(), CompareRecords);
+    }
+    if (runs_.empty()) {
+      const tkrzw::Status status = StoreRecords();
+      buffer_.clear();
+      buffer_size_ = 0;
+      return status;
+    }
+    std::vector<std::unique_ptr<tkrzw::FlatRecordReader>> readers;
+    for (const auto& run : runs_) {
+      readers.emplace_back(std::make_unique<tkrzw::FlatRecordReader>(run.get()));
+    }
+    const size_t buffer_index = runs_.size();
+    size_t buffer_pos = 0;
+    std::vector<Record> heads(buffer_index + 1);
+    auto fetch = [&](size_t index, bool* hit) {
+      *hit = false;
+      if (index == buffer_index) {
+        if (buffer_pos < buffer_.size()) {
+          heads[index] = std::move(buffer_[buffer_pos++]);
+          *hit = true;
+        }
+        return tkrzw::Status(tkrzw::Status::SUCCESS);
+      }
+      std::string_view data;
+      tkrzw::Status status = readers[index]->Read(&data);
+      if (status == tkrzw::Status::NOT_FOUND_ERROR) {
+        return tkrzw::Status(tkrzw::Status::SUCCESS);
+      }
+      if (status != tkrzw::Status::SUCCESS) {
+        return status;
+      }
+      heads[index].first = data;
+      status = readers[index]->Read(&data);
+      if (status != tkrzw::Status::SUCCESS) {
+        return status == tkrzw::Status::NOT_FOUND_ERROR ?
+            tkrzw::Status(tkrzw::Status::BROKEN_DATA_ERROR, "missing value") : status;
+      }
+      heads[index].second = data;
+      *hit = true;
+      return status;
+    };
+    auto later = [&](size_t a, size_t b) {
+      const int32_t cmp = heads[a].first.compare(heads[b].first);
+      return cmp > 0 || (cmp == 0 && a > b);
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(later)> queue(later);
+    for (size_t i = 0; i < heads.size(); i++) {
+      bool hit = false;
+      const tkrzw::Status status = fetch(i, &hit);
+      if (status != tkrzw::Status::SUCCESS) {
+        return status;
+      }
+      if (hit) {
+        queue.emplace(i);
+      }
+    }
+    while (!queue.empty()) {
+      const size_t index = queue.top();
+      queue.pop();
+      tkrzw::Status status = storer_(heads[index].first, heads[index].second);
+      if (status != tkrzw::Status::SUCCESS) {
+        return status;
+      }
+      bool hit = false;
+      status = fetch(index, &hit);
+      if (status != tkrzw::Status::SUCCESS) {
+        return status;
+      }
+      if (hit) {
+        queue.emplace(index);
+      }
+    }
+    buffer_.clear();
+    buffer_size_ = 0;
+    return tkrzw::Status(tkrzw::Status::SUCCESS);
+  }
+
+ private:
+  // Compares records by the key.
+  static bool CompareRecords(const Record& a, const Record& b) {
+    return a.first < b.first;
+  }
+
+  // Stores the buffered records into the database directly if they are sorted.  Otherwise,
+  // spills them into a new run file.
+  tkrzw::Status FlushBuffer() {
+    tkrzw::Status status(tkrzw::Status::SUCCESS);
+    if (sorted_) {
+      status = StoreRecords();
+      last_key_ = buffer_.back().first;
+    } else {
+      std::stable_sort(buffer_.begin(), buffer_.end(), CompareRecords);
+      status = SpillRecords();
+    }
+    buffer_.clear();
+    buffer_size_ = 0;
+    return status;
+  }
+
+  // Stores the buffered records into the database.
+  tkrzw::Status StoreRecords() {
+    for (const auto& record : buffer_) {
+      const tkrzw::Status status = storer_(record.first, record.second);
+      if (status != tkrzw::Status::SUCCESS) {
+        return status;
+      }
+    }
+    return tkrzw::Status(tkrzw::Status::SUCCESS);
+  }
+
+  // Writes the buffered records into a new run file.
+  tkrzw::Status SpillRecords() {
+    if (tmp_dir_ == nullptr) {
+      tmp_dir_ = std::make_unique<tkrzw::TemporaryDirectory>(true, "tkrzw-bulk-");
+    }
+    auto file = std::make_unique<tkrzw::PositionalParallelFile>();
+    tkrzw::Status status = file->Open(
+        tmp_dir_->MakeUniquePath("run-", ".flat"), true, tkrzw::File::OPEN_TRUNCATE);
+    if (status != tkrzw::Status::SUCCESS) {
+      return status;
+    }
+    tkrzw::FlatRecord rec(file.get());
+    for (const auto& record : buffer_) {
+      status = rec.Write(record.first);
+      status |= rec.Write(record.second);
+      if (status != tkrzw::Status::SUCCESS) {
+        return status;
+      }
+    }
+    runs_.emplace_back(std::move(file));
+    return status;
+  }
+
+  Storer storer_;
+  const int64_t sort_mem_size_;
+  std::vector<Record> buffer_;
+  int64_t buffer_size_;
+  std::string last_key_;
+  bool sorted_;
+  std::unique_ptr<tkrzw::TemporaryDirectory> tmp_dir_;
+  std::vector<std::unique_ptr<tkrzw::File>> runs_;
+};
+
+// Writer to store records given in ascending order of the key into a SkipDBM.  The records are
+// written into temporary SkipDBM files with the insert_in_order tuning, which needs no sorting.
+// A new file is started whenever a key is out of order.  The files are merged into the database
+// as sorted sources by the next synchronization, so the records are not sorted again.  Of the
+// adjacent records with the same key, the last one is stored.
+class SkipDBMBulkWriter final {
+ public:
+  explicit SkipDBMBulkWriter(tkrzw::SkipDBM* dbm) : dbm_(dbm), has_pending_(false) {}
+
+  // Adds a record.
+  tkrzw::Status Set(std::string_view key, std::string_view value) {
+    if (has_pending_) {
+      if (key == pending_key_) {
+        pending_value_ = value;
+        return tkrzw::Status(tkrzw::Status::SUCCESS);
+      }
+      tkrzw::Status status = WritePending();
+      if (status == tkrzw::Status::SUCCESS && key < pending_key_) {
+        status = CloseFile();
+      }
+      if (status != tkrzw::Status::SUCCESS) {
+        return status;
+      }
+    }
+    pending_key_ = key;
+    pending_value_ = value;
+    has_pending_ = true;
+    return tkrzw::Status(tkrzw::Status::SUCCESS);
+  }
+
+  // Closes the temporary files and registers them to be merged into the database.  The writer
+  // must be alive until the database is synchronized.
+  tkrzw::Status Finish() {
+    tkrzw::Status status(tkrzw::Status::SUCCESS);
+    if (has_pending_) {
+      status = WritePending();
+    }
+    if (status == tkrzw::Status::SUCCESS && file_dbm_ != nullptr) {
+      status = CloseFile();
+    }
+    for (const auto& path : paths_) {
+      if (status != tkrzw::Status::SUCCESS) {
+        break;
+      }
+      status = dbm_->MergeSkipDatabase(path);
+    }
+    return status;
+  }
+
+ private:
+  // Writes the pending record into the current file, which is opened if necessary.
+  tkrzw::Status WritePending() {
+    has_pending_ = false;
+    if (file_dbm_ == nullptr) {
+      if (tmp_dir_ == nullptr) {
+        tmp_dir_ = std::make_unique<tkrzw::TemporaryDirectory>(true, "tkrzw-bulk-");
+      }
+      file_path_ = tmp_dir_->MakeUniquePath("skip-", ".tks");
+      tkrzw::SkipDBM::TuningParameters tuning_params;
+      tuning_params.insert_in_order = true;
+      auto file_dbm = std::make_unique<tkrzw::SkipDBM>();
+      const tkrzw::Status status = file_dbm->OpenAdvanced(
+          file_path_, true, tkrzw::File::OPEN_TRUNCATE, tuning_params);
+      if (status != tkrzw::Status::SUCCESS) {
+        return status;
+      }
+      file_dbm_ = std::move(file_dbm);
+    }
+    return file_dbm_->Set(pending_key_, pending_value_);
+  }
+
+  // Closes the current file.
+  tkrzw::Status CloseFile() {
+    const tkrzw::Status status = file_dbm_->Close();
+    file_dbm_.reset();
+    paths_.emplace_back(file_path_);
+    return status;
+  }
+
+  tkrzw::SkipDBM* dbm_;
+  std::string pending_key_;
+  std::string pending_value_;
+  bool has_pending_;
+  std::unique_ptr<tkrzw::TemporaryDirectory> tmp_dir_;
+  std::unique_ptr<tkrzw::SkipDBM> file_dbm_;
+  std::string file_path_;
+  std::vector<std::string> paths_;
+};
+
+extern "C" {
+
+#undef _POSIX_C_SOURCE
+#undef _XOPEN_SOURCE
+#include "Python.h"
+#include "structmember.h"
+
+// Python 3.10 provides the lookup of the module by the definition as a private function.
+#if PY_VERSION_HEX < 0x030B0000
+#define PyType_GetModuleByDef _PyType_GetModuleByDef
+#endif
+
+// State of the module, which is separated for each module object.
+struct ModuleState {
+  PyObject* cls_utility;
+  PyObject* cls_status;
+  PyObject* cls_expt;
+  PyObject* cls_future;
+  PyObject* cls_dbm;
+  PyObject* cls_iter;
+  PyObject* cls_rebuildjob;
+  PyObject* cls_asyncdbm;
+  PyObject* cls_asyncexecutor;
+  PyObject* cls_file;
+  PyObject* cls_fileregion;
+  PyObject* cls_lineiter;
+  PyObject* cls_asyncfile;
+  PyObject* cls_flatwriter;
+  PyObject* cls_flatreader;
+  PyObject* cls_index;
+  PyObject* cls_indexiter;
+  PyObject* cls_ulogreader;
+  PyObject* obj_dbm_any_data;
+};
+
+// Gets the definition of the module.
+static PyModuleDef* GetModuleDef();
+
+// Gets the module state from the context, which is an object or a type of the module, or the
+// module itself.  Any Python object structure can be given as the context.
+static ModuleState* GetModuleState(const void* pyctx) {
+  PyObject* pyobj = (PyObject*)pyctx;
+  PyObject* module = pyobj;
+  if (!PyModule_Check(pyobj)) {
+    PyTypeObject* pytype = PyType_Check(pyobj) ? (PyTypeObject*)pyobj : Py_TYPE(pyobj);
+    module = PyType_GetModuleByDef(pytype, GetModuleDef());
+  }
+  return (ModuleState*)PyModule_GetState(module);
+}
+
+// LRU cache of objects decoded from record values.  The size of each entry is estimated by the
+// sizes of the key and the value.  Invalidation advances the epoch so that an object decoded
+// from a value read before the invalidation is not stored.  The cache lives as long as the DBM
+// object and is shared with its iterators and asynchronous adapters.  Invalidation can be done
+// without the GIL, in which case dropped objects are released by the next call with the GIL.
+class ObjectCache final {
+ public:
+  // Statistics of the cache.
+  struct Stats {
+    int64_t capacity;
+    int64_t size;
+    int64_t count;
+    int64_t num_hits;
+    int64_t num_misses;
+    int64_t num_evictions;
+  };
+
+  // The owner must call Configure(nullptr, 0) with the GIL before releasing the cache so that
+  // no Python object is left to the destructor, which may run on a native thread.
+  ~ObjectCache() = default;
+
+  // Sets the decoder and the capacity and drops all entries.  A null decoder disables the cache.
+  // It must be called with the GIL.
+  void Configure(PyObject* decoder, int64_t capacity) {
+    std::vector<PyObject*> dropped;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      epoch_++;
+      ClearImpl(&dropped);
+      dropped.insert(dropped.end(), garbage_.begin(), garbage_.end());
+      garbage_.clear();
+      if (decoder_ != nullptr) {
+        dropped.emplace_back(decoder_);
+      }
+      Py_XINCREF(decoder);
+      decoder_ = decoder;
+      capacity_ = capacity;
+      num_hits_ = 0;
+      num_misses_ = 0;
+      num_evictions_ = 0;
+    }
+    ReleaseObjects(dropped);
+  }
+
+  bool IsEnabled() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return decoder_ != nullptr;
+  }
+
+  // Gets a new reference to the decoder, or nullptr if the cache is disabled.
+  PyObject* GetDecoder() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Py_XINCREF(decoder_);
+    return decoder_;
+  }
+
+  uint64_t GetEpoch() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return epoch_;
+  }
+
+  PyObject* Get(std::string_view key) {
+    ReleaseGarbage();
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = index_.find(key);
+    if (it == index_.end()) {
+      num_misses_++;
+      return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    num_hits_++;
+    Py_INCREF(it->second->object);
+    return it->second->object;
+  }
+
+  void Put(std::string_view key, PyObject* object, int64_t size, uint64_t epoch) {
+    std::vector<PyObject*> dropped;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      dropped.swap(garbage_);
+      if (epoch == epoch_ && decoder_ != nullptr && size <= capacity_) {
+        EraseImpl(key, &dropped);
+        Py_INCREF(object);
+        entries_.emplace_front(Entry{std::string(key), object, size});
+        index_.emplace(entries_.front().key, entries_.begin());
+        size_ += size;
+        while (size_ > capacity_) {
+          EraseImpl(entries_.back().key, &dropped);
+          num_evictions_++;
+        }
+      }
+    }
+    ReleaseObjects(dropped);
+  }
+
+  // Removes the entry of a key.  It can be called without the GIL.
+  void Remove(std::string_view key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    epoch_++;
+    EraseImpl(key, &garbage_);
+  }
+
+  // Removes all entries.  It can be called without the GIL.
+  void Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    epoch_++;
+    ClearImpl(&garbage_);
+  }
+
+  // Releases the objects dropped by calls without the GIL.  It must be called with the GIL.
+  void ReleaseGarbage() {
+    std::vector<PyObject*> dropped;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      dropped.swap(garbage_);
+    }
+    ReleaseObjects(dropped);
+  }
+
+  Stats GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.capacity = capacity_;
+    stats.size = size_;
+    stats.count = entries_.size();
+    stats.num_hits = num_hits_;
+    stats.num_misses = num_misses_;
+    stats.num_evictions = num_evictions_;
+    return stats;
+  }
+
+ private:
+  struct Entry {
+    std::string key;
+    PyObject* object;
+    int64_t size;
+  };
+
+  void EraseImpl(std::string_view key, std::vector<PyObject*>* dropped) {
+    const auto it = index_.find(key);
+    if (it == index_.end()) {
+      return;
+    }
+    const auto entry = it->second;
+    index_.erase(it);
+    dropped->emplace_back(entry->object);
+    size_ -= entry->size;
+    entries_.erase(entry);
+  }
+
+  void ClearImpl(std::vector<PyObject*>* dropped) {
+    index_.clear();
+    for (auto& entry : entries_) {
+      dropped->emplace_back(entry.object);
+    }
+    entries_.clear();
+    size_ = 0;
+  }
+
+  static void ReleaseObjects(const std::vector<PyObject*>& objects) {
+    for (PyObject* pyobj : objects) {
+      Py_DECREF(pyobj);
+    }
+  }
+
+  PyObject* decoder_ = nullptr;
+  int64_t capacity_ = 0;
+  std::mutex mutex_;
+  std::list<Entry> entries_;
+  std::unordered_map<std::string_view, std::list<Entry>::iterator> index_;
+  std::vector<PyObject*> garbage_;
+  int64_t size_ = 0;
+  uint64_t epoch_ = 0;
+  int64_t num_hits_ = 0;
+  int64_t num_misses_ = 0;
+  int64_t num_evictions_ = 0;
+};
+
+// Python object of Utility.
+struct PyUtility {
+  PyObject_HEAD
+};
+
+// Python object of Status.
+struct PyTkStatus {
+  PyObject_HEAD
+  tkrzw::Status* status;
+};
+
+// Python object of Future.
+struct PyFuture {
+  PyObject_HEAD
+  tkrzw::StatusFuture* future;
+  std::shared_mutex* mutex;
+  bool concurrent;
+  bool is_str;
+};
+
+// Python ofject of StatusException.
+struct PyException {
+  PyException_HEAD
+  PyObject* pystatus;
+};
+
+// Python object of DBM.
+struct PyDBM {
+  PyObject_HEAD
+  tkrzw::ParamDBM* dbm;
+  std::shared_mutex* mutex;
+  std::string* open_path;
+  std::map<std::string, std::string>* open_params;
+  std::shared_ptr<ObjectCache> object_cache;
+  std::shared_ptr<BloomFilter> bloom_filter;
+  std::mutex* bloom_rebuild_mutex;
+  Maintainer* maintainer;
+  GroupCommitter* committer;
+  tkrzw::MessageQueue* ulog_mq;
+  tkrzw::DBMUpdateLoggerMQ* ulog;
+  int32_t num_shards;
+  bool has_bloom_filter;
+  bool is_snapshot;
+  bool concurrent;
+};
+
+// Python object of RebuildJob.
+struct PyRebuildJob {
+  PyObject_HEAD
+  RebuildJob* job;
+  PyObject* pydbm;
+};
+
+// Python object of UpdateLogReader.
+struct PyUpdateLogReader {
+  PyObject_HEAD
+  tkrzw::MessageQueue* mq;
+  tkrzw::MessageQueue::Reader* reader;
+  std::shared_mutex* mutex;
+};
+
+// Python object of Iterator.
+struct PyIterator {
+  PyObject_HEAD
+  tkrzw::DBM::Iterator* iter;
+  std::shared_ptr<ObjectCache> object_cache;
+  std::shared_mutex* mutex;
+  bool concurrent;
+};
+
+// Python object of AsyncExecutor.
+struct PyAsyncExecutor {
+  PyObject_HEAD
+  std::shared_ptr<AsyncExecutor> executor;
+};
+
+// Python object of AsyncDBM.
+struct PyAsyncDBM {
+  PyObject_HEAD
+  tkrzw::ParamDBM* dbm;
+  std::shared_ptr<AsyncQueue> queue;
+  std::shared_ptr<BloomFilter> bloom_filter;
+  std::shared_ptr<ObjectCache> object_cache;
+  std::shared_mutex* mutex;
+  AsyncQueue::Priority priority;
+  double timeout;
+  bool concurrent;
+};
+
+// Python object of File.
+struct PyFile {
+  PyObject_HEAD
+  tkrzw::PolyFile* file;
+  std::shared_mutex* mutex;
+  int64_t generation;
+  bool concurrent;
+  bool writable;
+  std::atomic<int64_t> num_views;
+  std::atomic<int64_t> num_remaps;
+  std::mutex remap_mutex;
+  std::condition_variable remap_cond;
+};
+
+// Python object of FileRegion.
+struct PyFileRegion {
+  PyObject_HEAD
+  PyObject* pyfile;
+  char* ptr;
+  int64_t size;
+  bool writable;
+};
+
+// Python object of LineIterator.
+struct PyLineIterator {
+  PyObject_HEAD
+  PyObject* pyfile;
+  LineScanner* scanner;
+  std::shared_mutex* mutex;
+  int64_t batch;
+  bool is_str;
+};
+
+// Python object of FlatRecordWriter.
+struct PyFlatRecordWriter {
+  PyObject_HEAD
+  PyObject* pyfile;
+  std::shared_mutex* mutex;
+  int64_t num_records;
+};
+
+// Python object of FlatRecordReader.
+struct PyFlatRecordReader {
+  PyObject_HEAD
+  PyObject* pyfile;
+  int64_t file_generation;
+  tkrzw::FlatRecordReader* reader;
+  std::shared_mutex* mutex;
+  int64_t num_records;
+};
+
+// Python object of AsyncFile.
+struct PyAsyncFile {
+  PyObject_HEAD
+  PyObject* pyfile;
+  int64_t file_generation;
+  std::shared_ptr<AsyncQueue> queue;
+  std::shared_mutex* mutex;
+  bool concurrent;
+};
+
+// Python object of Index.
+struct PyIndex {
+  PyObject_HEAD
+  tkrzw::PolyIndex* index;
+  std::shared_mutex* mutex;
+  bool concurrent;
+};
+
+// Python object of IndexIterator.
+struct PyIndexIterator {
+  PyObject_HEAD
+  tkrzw::PolyIndex::Iterator* iter;
+  std::shared_mutex* mutex;
+  bool concurrent;
+};
+
+// Makes a mutex to guard the native handle of an object.  As the GIL serializes methods of the
+// same object unless the build is free-threaded, the mutex is made only in that case.
+static std::shared_mutex* NewHandleMutex() {
+#if defined(Py_GIL_DISABLED)
+  return new std::shared_mutex();
+#else
+  return nullptr;
+#endif
+}
+
+// Scoped lock of the native handle of an object.  Operations using the handle take a shared
+// lock and operations replacing the handle take an exclusive lock.
+class HandleLock final {
+ public:
+  HandleLock(std::shared_mutex* mutex, bool exclusive) : mutex_(mutex), exclusive_(exclusive) {
+    if (mutex_ == nullptr) {
+      return;
+    }
+    if (exclusive_ ? mutex_->try_lock() : mutex_->try_lock_shared()) {
+      return;
+    }
+    PyThreadState* thstate = PyEval_SaveThread();
+    if (exclusive_) {
+      mutex_->lock();
+    } else {
+      mutex_->lock_shared();
+    }
+    PyEval_RestoreThread(thstate);
+  }
+
+  ~HandleLock() {
+    if (mutex_ == nullptr) {
+      return;
+    }
+    if (exclusive_) {
+      mutex_->unlock();
+    } else {
+      mutex_->unlock_shared();
+    }
+  }
+
+ private:
+  std::shared_mutex* mutex_;
+  bool exclusive_;
+};
+
+// Scoped critical section on a small object whose methods never block.  It is effective only
+// in free-threaded builds.
+class ObjectLock final {
+ public:
+  explicit ObjectLock(PyObject* pyobj) {
+#if defined(Py_GIL_DISABLED)
+    PyCriticalSection_Begin(&section_, pyobj);
+#endif
+  }
+
+  ~ObjectLock() {
+#if defined(Py_GIL_DISABLED)
+    PyCriticalSection_End(&section_);
+#endif
+  }
+
+ private:
+#if defined(Py_GIL_DISABLED)
+  PyCriticalSection section_;
+#endif
+};
+
+// Guard of an operation which may remap a memory-mapped file.  The operation is refused while
+// views of the mapping are alive because remapping would invalidate their memory.  Makers of
+// views waiting for the operation are woken up when the last guard is released.
+class FileRemapGuard final {
+ public:
+  explicit FileRemapGuard(PyFile* pyfile) : pyfile_(pyfile) {
+    pyfile_->num_remaps.fetch_add(1);
+    ok_ = pyfile_->num_views.load() == 0;
+  }
+
+  ~FileRemapGuard() {
+    if (pyfile_->num_remaps.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> lock(pyfile_->remap_mutex);
+      pyfile_->remap_cond.notify_all();
+    }
+  }
+
+  // Gets the status to stop the operation if views are alive.
+  tkrzw::Status GetStatus() const {
+    return ok_ ? tkrzw::Status(tkrzw::Status::SUCCESS) :
+        tkrzw::Status(tkrzw::Status::PRECONDITION_ERROR, "views of the file are alive");
+  }
+
+ private:
+  PyFile* pyfile_;
+  bool ok_;
+};
+
+// Objects whose native handles are abandoned in the child process after fork.
+static std::mutex fork_handles_mutex;
+static std::unordered_map<PyObject*, void (*)(PyObject*)> fork_handles;
+
+// Locks the registry of fork handles before fork.
+static void LockForkHandles() {
+  fork_handles_mutex.lock();
+}
+
+// Unlocks the registry of fork handles in the parent process after fork.
+static void UnlockForkHandles() {
+  fork_handles_mutex.unlock();
+}
+
+// Abandons the native handles in the child process after fork.  The files and the threads
+// belong to the parent process so the handles are leaked without being closed.
+static void AbandonForkHandles() {
+  for (const auto& handle : fork_handles) {
+    handle.second(handle.first);
+  }
+  fork_handles.clear();
+  fork_handles_mutex.unlock();
+}
+
+// Registers an object whose native handle is abandoned in the child process after fork.
+static void RegisterForkHandle(PyObject* pyobj, void (*abandon)(PyObject*)) {
+#if defined(__unix__) || defined(__APPLE__)
+  static std::once_flag once;
+  std::call_once(once, []() {
+    pthread_atfork(LockForkHandles, UnlockForkHandles, AbandonForkHandles);
+  });
+#endif
+  std::lock_guard<std::mutex> lock(fork_handles_mutex);
+  fork_handles.emplace(pyobj, abandon);
+}
+
+// Unregisters an object whose native handle is abandoned in the child process after fork.
+static void UnregisterForkHandle(PyObject* pyobj) {
+  std::lock_guard<std::mutex> lock(fork_handles_mutex);
+  fork_handles.erase(pyobj);
+}
+
+// Abandons the native handle of a DBM object.
+static void AbandonDBMHandle(PyObject* pyobj) {
+  PyDBM* self = (PyDBM*)pyobj;
+  self->dbm = nullptr;
+  self->mutex = new std::shared_mutex();
+  self->bloom_rebuild_mutex = new std::mutex();
+  self->maintainer = nullptr;
+  self->committer = nullptr;
+  self->ulog_mq = nullptr;
+  self->ulog = nullptr;
+  self->num_shards = 0;
+  self->is_snapshot = false;
+}
+
+// Abandons the native handle of an Iterator object, which belongs to the abandoned database.
+static void AbandonIteratorHandle(PyObject* pyobj) {
+  PyIterator* self = (PyIterator*)pyobj;
+  self->iter = nullptr;
+  self->mutex = NewHandleMutex();
+}
+
+// Abandons the native handle of an AsyncExecutor object.
+static void AbandonAsyncExecutorHandle(PyObject* pyobj) {
+  PyAsyncExecutor* self = (PyAsyncExecutor*)pyobj;
+  new std::shared_ptr<AsyncExecutor>(std::move(self->executor));
+}
+
+// Abandons the native handle of an AsyncDBM object.
+static void AbandonAsyncDBMHandle(PyObject* pyobj) {
+  PyAsyncDBM* self = (PyAsyncDBM*)pyobj;
+  new std::shared_ptr<AsyncQueue>(std::move(self->queue));
+  self->dbm = nullptr;
+  self->mutex = NewHandleMutex();
+}
+
+// Abandons the native handle of a File object.
+static void AbandonFileHandle(PyObject* pyobj) {
+  PyFile* self = (PyFile*)pyobj;
+  self->file = nullptr;
+  self->mutex = new std::shared_mutex();
+  new (&self->remap_mutex) std::mutex();
+  new (&self->remap_cond) std::condition_variable();
+}
+
+// Abandons the native handle of a LineIterator object.
+static void AbandonLineIteratorHandle(PyObject* pyobj) {
+  PyLineIterator* self = (PyLineIterator*)pyobj;
+  self->mutex = new std::shared_mutex();
+}
+
+// Abandons the native handle of a FlatRecordWriter object.
+static void AbandonFlatRecordWriterHandle(PyObject* pyobj) {
+  PyFlatRecordWriter* self = (PyFlatRecordWriter*)pyobj;
+  self->mutex = new std::shared_mutex();
+}
+
+// Abandons the native handle of a FlatRecordReader object.
+static void AbandonFlatRecordReaderHandle(PyObject* pyobj) {
+  PyFlatRecordReader* self = (PyFlatRecordReader*)pyobj;
+  self->mutex = new std::shared_mutex();
+}
+
+// Abandons the native handle of an AsyncFile object, whose threads don't exist in the child.
+static void AbandonAsyncFileHandle(PyObject* pyobj) {
+  PyAsyncFile* self = (PyAsyncFile*)pyobj;
+  new std::shared_ptr<AsyncQueue>(std::move(self->queue));
+  self->pyfile = nullptr;
+  self->mutex = NewHandleMutex();
+}
+
+// Abandons the native handle of an Index object.
+static void AbandonIndexHandle(PyObject* pyobj) {
+  PyIndex* self = (PyIndex*)pyobj;
+  self->index = nullptr;
+  self->mutex = NewHandleMutex();
+}
+
+// Abandons the native handle of an UpdateLogReader object.
+static void AbandonUpdateLogReaderHandle(PyObject* pyobj) {
+  PyUpdateLogReader* self = (PyUpdateLogReader*)pyobj;
+  self->mq = nullptr;
+  self->reader = nullptr;
+  self->mutex = NewHandleMutex();
+}
+
+// Abandons the native handle of a RebuildJob object, whose thread doesn't exist in the child.
+static void AbandonRebuildJobHandle(PyObject* pyobj) {
+  PyRebuildJob* self = (PyRebuildJob*)pyobj;
+  self->job = nullptr;
+}
+
+// Invalidates the cached object of a record of a DBM object.
+static void InvalidateObjectCache(PyDBM* self, std::string_view key) {
+  self->object_cache->Remove(key);
+  self->object_cache->ReleaseGarbage();
+}
+
+// Clears all cached objects of a DBM object.
+static void ClearObjectCache(PyDBM* self) {
+  self->object_cache->Clear();
+  self->object_cache->ReleaseGarbage();
+}
+
+// Invalidates the cached object of the record which an Iterator object has updated.
+static void InvalidateIteratorRecord(PyIterator* self, std::string_view key) {
+  if (self->object_cache != nullptr) {
+    self->object_cache->Remove(key);
+    self->object_cache->ReleaseGarbage();
+  }
+}
+
+// Adds a key to the Bloom filter of a DBM object, after the record is stored.
+static void AddToBloomFilter(PyDBM* self, std::string_view key) {
+  if (self->has_bloom_filter) {
+    std::atomic_load(&self->bloom_filter)->Add(key);
+  }
+}
+
+// Checks whether a key may exist by the Bloom filter of a DBM object.
+static bool MayContainByBloomFilter(PyDBM* self, std::string_view key) {
+  return !self->has_bloom_filter || std::atomic_load(&self->bloom_filter)->MayContain(key);
+}
+
+// Disables the Bloom filter of a DBM object until it is rebuilt.
+static void DisableBloomFilter(PyDBM* self) {
+  if (self->has_bloom_filter) {
+    std::atomic_load(&self->bloom_filter)->Disable();
+  }
+}
+
+// Rebuilds the Bloom filter of a DBM object by scanning all keys.  Keys added during the scan
+// are forwarded from the old filter.  Rebuilds of the same database are serialized by its own
+// mutex while other databases are not blocked.  The GIL should be released while it is running.
+static tkrzw::Status RebuildBloomFilter(
+    PyDBM* self, std::atomic<int64_t>* num_scanned = nullptr) {
+  if (!self->has_bloom_filter) {
+    return tkrzw::Status(tkrzw::Status::SUCCESS);
+  }
+  std::lock_guard<std::mutex> lock(*self->bloom_rebuild_mutex);
+  std::shared_ptr<BloomFilter> old_filter = std::atomic_load(&self->bloom_filter);
+  auto filter = std::make_shared<BloomFilter>(
+      self->dbm->CountSimple(), old_filter->GetBitsPerKey());
+  old_filter->SetSuccessor(filter);
+  const tkrzw::Status status = filter->AddAllKeys(self->dbm, num_scanned);
+  if (status != tkrzw::Status::SUCCESS) {
+    filter->Disable();
+  }
+  std::atomic_store(&self->bloom_filter, filter);
+  return status;
+}
+
+// Makes a fingerprint of the database files to validate the saved Bloom filter.  The modification
+// time is taken in the finest resolution of the file system.  An empty string is returned if a
+// file doesn't exist.
+static std::string MakeBloomFilterFingerprint(const std::string& path, int32_t num_shards) {
+  std::vector<std::string> paths;
+  if (num_shards > 0) {
+    for (int32_t i = 0; i < num_shards; i++) {
+      paths.emplace_back(tkrzw::SPrintF("%s-%05d-of-%05d", path.c_str(), i, num_shards));
+    }
+  } else {
+    paths.emplace_back(path);
+  }
+  std::string fingerprint;
+  for (const auto& file_path : paths) {
+    tkrzw::FileStatus fstats;
+    if (tkrzw::ReadFileStatus(file_path, &fstats) != tkrzw::Status::SUCCESS) {
+      return "";
+    }
+    std::error_code ec;
+    const auto modified_time = std::filesystem::last_write_time(file_path, ec);
+    if (ec) {
+      return "";
+    }
+    fingerprint += tkrzw::StrCat(":", fstats.file_size, ":",
+                                 modified_time.time_since_epoch().count());
+  }
+  return fingerprint;
+}
+
+// Makes a unique path of a snapshot file next to the database file.
+static std::string MakeSnapshotPath(const std::string& path) {
+  static std::atomic<int64_t> count(0);
+  return tkrzw::SPrintF("%s.snapshot-%lld-%lld", path.c_str(),
+                        (long long)tkrzw::GetProcessID(), (long long)count.fetch_add(1));
+}
+
+// Removes the files of a snapshot database.
+static void RemoveSnapshotFiles(const std::string& path, int32_t num_shards) {
+  if (path.empty()) {
+    return;
+  }
+  if (num_shards > 0) {
+    for (int32_t i = 0; i < num_shards; i++) {
+      tkrzw::RemoveFile(tkrzw::SPrintF("%s-%05d-of-%05d", path.c_str(), i, num_shards));
+    }
+  } else {
+    tkrzw::RemoveFile(path);
+  }
+}
+
+// Creates a new string of Python.
+static PyObject* CreatePyString(std::string_view str) {
+  return PyUnicode_DecodeUTF8(str.data(), str.size(), "replace");
+}
+
+// Creatse a new byte array of Python.
+static PyObject* CreatePyBytes(std::string_view str) {
+  return PyBytes_FromStringAndSize(str.data(), str.size());
+}
+
+// Creates a status object of Python.
+static PyObject* CreatePyTkStatus(const void* pyctx, const tkrzw::Status& status) {
+  PyTypeObject* pytype = (PyTypeObject*)GetModuleState(pyctx)->cls_status;
+  PyTkStatus* obj = (PyTkStatus*)pytype->tp_alloc(pytype, 0);
+  if (!obj) return nullptr;
+  obj->status = new tkrzw::Status(status);
+  return (PyObject*)obj;
+}
+
+// Creates a status object of Python, in moving context.
+static PyObject* CreatePyTkStatusMove(const void* pyctx, tkrzw::Status&& status) {
+  PyTypeObject* pytype = (PyTypeObject*)GetModuleState(pyctx)->cls_status;
+  PyTkStatus* obj = (PyTkStatus*)pytype->tp_alloc(pytype, 0);
+  if (!obj) return nullptr;
+  obj->status = new tkrzw::Status(std::move(status));
+  return (PyObject*)obj;
+}
+
+// Creates a status future object of Python, in moving context.
+static PyObject* CreatePyFutureMove(
+    const void* pyctx, tkrzw::StatusFuture&& future, bool concurrent, bool is_str = false) {
+  PyTypeObject* pytype = (PyTypeObject*)GetModuleState(pyctx)->cls_future;
+  PyFuture* obj = (PyFuture*)pytype->tp_alloc(pytype, 0);
+  if (!obj) return nullptr;
+  obj->mutex = NewHandleMutex();
+  obj->future = new tkrzw::StatusFuture(std::move(future));
+  obj->concurrent = concurrent;
+  obj->is_str = is_str;
+  return (PyObject*)obj;
+}
+
+// Throws an invalid argument error.
+static void ThrowInvalidArguments(std::string_view message) {
+  PyErr_SetString(PyExc_TypeError, tkrzw::StrCat("invalid arguments: ", message).c_str());
+}
+
+// Throws a status error.
+static void ThrowStatusException(const void* pyctx, const tkrzw::Status& status) {
+  PyObject* pystatus = CreatePyTkStatus(pyctx, status);
+  PyErr_SetObject(GetModuleState(pyctx)->cls_expt, pystatus);
+  Py_DECREF(pystatus);
+}
+
+// Locking device to call a nagive function.
+class NativeLock final {
+ public:
+  NativeLock(bool concurrent) : thstate_(nullptr) {
+    if (concurrent) {
+      thstate_ = PyEval_SaveThread();
+    }
+  }
+
+  ~NativeLock() {
+    if (thstate_) {
+      PyEval_RestoreThread(thstate_);
+    }
+  }
+
+  void Release() {
+    if (thstate_) {
+      PyEval_RestoreThread(thstate_);
+    }
+    thstate_ = nullptr;
+  }
+
+ private:
+  PyThreadState* thstate_;
+};
+
+// Stops the maintenance thread of a DBM object.  The thread skips checks while the handle is
+// locked exclusively, so this can be called with the exclusive lock.
+static void StopMaintainer(PyDBM* self) {
+  if (self->maintainer != nullptr) {
+    NativeLock lock(true);
+    delete self->maintainer;
+    self->maintainer = nullptr;
+  }
+}
+
+// Wrapper to treat a Python string as a C++ string_view.
+class SoftString final {
+ public:
+  explicit SoftString(PyObject* pyobj) :
+    pyobj_(pyobj), pystr_(nullptr), pybytes_(nullptr), ptr_(nullptr), size_(0) {
+    Py_INCREF(pyobj_);
+    if (PyUnicode_Check(pyobj_)) {
+      pybytes_ = PyUnicode_AsUTF8String(pyobj_);
+      if (pybytes_) {
+        ptr_ = PyBytes_AS_STRING(pybytes_);
+        size_ = PyBytes_GET_SIZE(pybytes_);
+      } else {
+        PyErr_Clear();
+        ptr_ = "";
+        size_ = 0;
+      }
+    } else if (PyBytes_Check(pyobj_)) {
+      ptr_ = PyBytes_AS_STRING(pyobj_);
+      size_ = PyBytes_GET_SIZE(pyobj_);
+    } else if (PyByteArray_Check(pyobj_)) {
+      ptr_ = PyByteArray_AS_STRING(pyobj_);
+      size_ = PyByteArray_GET_SIZE(pyobj_);
+    } else if (pyobj_ == Py_None) {
+      ptr_ = "";
+      size_ = 0;
+    } else {
+      pystr_ = PyObject_Str(pyobj_);
+      if (pystr_) {
+        pybytes_ = PyUnicode_AsUTF8String(pystr_);
+        if (pybytes_) {
+          ptr_ = PyBytes_AS_STRING(pybytes_);
+          size_ = PyBytes_GET_SIZE(pybytes_);
+        } else {
+          PyErr_Clear();
+          ptr_ = "";
+          size_ = 0;
+        }
+      } else {
+        ptr_ = "(unknown)";
+        size_ = std::strlen(ptr_);
+      }
+    }
+  }
+
+  ~SoftString() {
+    if (pybytes_) Py_DECREF(pybytes_);
+    if (pystr_) Py_DECREF(pystr_);
+    Py_DECREF(pyobj_);
+  }
+  
+  std::string_view Get() const {
+    return std::string_view(ptr_, size_);
+  }
+
+ private:
+  PyObject* pyobj_;
+  PyObject* pystr_;
+  PyObject* pybytes_;
+  const char* ptr_;
+  size_t size_;
+};
+
+// Wrapper to treat the data of a Python object as a C++ string_view.  The memory of an object
+// supporting the buffer protocol, like memoryview, is referred to without copying if it is
+// contiguous, or copied otherwise.  The other objects are converted as with SoftString.
+class BufferString final {
+ public:
+  explicit BufferString(PyObject* pyobj) : has_view_(false), valid_(true) {
+    if (!PyUnicode_Check(pyobj) && !PyBytes_Check(pyobj) && !PyByteArray_Check(pyobj) &&
+        PyObject_CheckBuffer(pyobj)) {
+      if (PyObject_GetBuffer(pyobj, &view_, PyBUF_SIMPLE) == 0) {
+        has_view_ = true;
+        return;
+      }
+      PyErr_Clear();
+      // A non-contiguous buffer is copied in the C order.  The error is kept on failure.
+      Py_buffer view;
+      if (PyObject_GetBuffer(pyobj, &view, PyBUF_FULL_RO) != 0) {
+        valid_ = false;
+        return;
+      }
+      copy_.resize(view.len);
+      valid_ = PyBuffer_ToContiguous(copy_.data(), &view, view.len, 'C') == 0;
+      PyBuffer_Release(&view);
+      return;
+    }
+    str_ = std::make_unique<SoftString>(pyobj);
+  }
+
+  ~BufferString() {
+    if (has_view_) PyBuffer_Release(&view_);
+  }
+
+  // Returns false if the buffer couldn't be got, with the Python error set.
+  bool IsValid() const {
+    return valid_;
+  }
+
+  std::string_view Get() const {
+    if (has_view_) {
+      return std::string_view(static_cast<const char*>(view_.buf), view_.len);
+    }
+    if (str_ == nullptr) {
+      return copy_;
+    }
+    return str_->Get();
+  }
+
+ private:
+  std::unique_ptr<SoftString> str_;
+  std::string copy_;
+  Py_buffer view_;
+  bool has_view_;
+  bool valid_;
+};
+
+// Converts a numeric parameter to an integer.
+static int64_t PyObjToInt(PyObject* pyobj) {
+  if (PyLong_Check(pyobj)) {
+    return PyLong_AsLong(pyobj);
+  } else if (PyFloat_Check(pyobj)) {
+    return (int64_t)PyFloat_AsDouble(pyobj);
+  } else if (PyUnicode_Check(pyobj) || PyBytes_Check(pyobj)) {
+    SoftString str(pyobj);
+    return tkrzw::StrToInt(str.Get());
+  } else if (pyobj != Py_None) {
+    int64_t num = 0;
+    PyObject* pylong = PyNumber_Long(pyobj);
+    if (pylong) {
+      num = PyLong_AsLong(pylong);
+      Py_DECREF(pylong);
+    }
+    return num;
+  }
+  return 0;
+}
+
+// Converts a numeric parameter to a double.
+static double PyObjToDouble(PyObject* pyobj) {
+  if (PyLong_Check(pyobj)) {
+    return PyLong_AsLong(pyobj);
+  } else if (PyFloat_Check(pyobj)) {
+    return PyFloat_AsDouble(pyobj);
+  } else if (PyUnicode_Check(pyobj) || PyBytes_Check(pyobj)) {
+    SoftString str(pyobj);
+    return tkrzw::StrToDouble(str.Get());
+  } else if (pyobj != Py_None) {
+    double num = 0;
+    PyObject* pyfloat = PyNumber_Float(pyobj);
+    if (pyfloat) {
+      num = PyFloat_AsDouble(pyfloat);
+      Py_DECREF(pyfloat);
+    }
+    return num;
+  }
+  return 0;
+}
+
+// Converts a Python Unicode object into a UCS-4 vector.
+std::vector<uint32_t> PyUnicodeToUCS4(PyObject* pyuni) {
+  const int32_t kind = PyUnicode_KIND(pyuni);
+  void* data = PyUnicode_DATA(pyuni);
+  const int32_t len = PyUnicode_GET_LENGTH(pyuni);
+  std::vector<uint32_t> ucs;
+  ucs.reserve(len);
+  for (int32_t i = 0; i < len; i++) {
+    ucs.emplace_back(PyUnicode_READ(kind, data, i));
+  }
+  return ucs;
+}
+
+// Sets a constant of long integer.
+static bool SetConstLong(PyObject* pyobj, const char* name, int64_t value) {
+  PyObject* pyname = PyUnicode_FromString(name);
+  PyObject* pyvalue = PyLong_FromLongLong(value);
+  return PyObject_GenericSetAttr(pyobj, pyname, pyvalue) == 0;
+}
+
+// Sets a constant of unsigned long integer.
+static bool SetConstUnsignedLong(PyObject* pyobj, const char* name, uint64_t value) {
+  PyObject* pyname = PyUnicode_FromString(name);
+  PyObject* pyvalue = PyLong_FromUnsignedLongLong(value);
+  return PyObject_GenericSetAttr(pyobj, pyname, pyvalue) == 0;
+}
+
+// Sets a constant of string.
+static bool SetConstStr(PyObject* pyobj, const char* name, const char* value) {
+  PyObject* pyname = PyUnicode_FromString(name);
+  PyObject* pyvalue = PyUnicode_FromString(value);
+  return PyObject_GenericSetAttr(pyobj, pyname, pyvalue) == 0;
+}
+
+// Maps keyword arguments into C++ map.
+static std::map<std::string, std::string> MapKeywords(PyObject* pykwds) {
+  std::map<std::string, std::string> map;
+  PyObject* pykwlist = PyMapping_Items(pykwds);
+  const int32_t kwnum = PyList_GET_SIZE(pykwlist);
+  for (int32_t i = 0; i < kwnum; i++) {
+    PyObject* pyrec = PyList_GET_ITEM(pykwlist, i);
+    if (PyTuple_GET_SIZE(pyrec) == 2) {
+      PyObject* pykey = PyTuple_GET_ITEM(pyrec, 0);
+      PyObject* pyvalue = PyTuple_GET_ITEM(pyrec, 1);
+      SoftString key(pykey);
+      SoftString value(pyvalue);
+      map.emplace(std::string(key.Get()), std::string(value.Get()));
+    }
+  }
+  Py_DECREF(pykwlist);
+  return map;
+}
+
+// Gets the path of a database on shared memory.  A bare file name is put in the directory of
+// shared memory so that processes opening the same name map the same pages.
+static std::string GetSharedMemoryPath(const std::string& path) {
+#if defined(__linux__)
+  if (path.find('/') == std::string::npos) {
+    return tkrzw::JoinPath("/dev/shm", path);
+  }
+#endif
+  return path;
+}
+
+// Extracts the options to open files from parameters, which are removed from the parameters.
+static int32_t ExtractOpenOptions(std::map<std::string, std::string>* params) {
+  int32_t open_options = 0;
+  if (tkrzw::StrToBool(tkrzw::SearchMap(*params, "truncate", "false"))) {
+    open_options |= tkrzw::File::OPEN_TRUNCATE;
+  }
+  if (tkrzw::StrToBool(tkrzw::SearchMap(*params, "no_create", "false"))) {
+    open_options |= tkrzw::File::OPEN_NO_CREATE;
+  }
+  if (tkrzw::StrToBool(tkrzw::SearchMap(*params, "no_wait", "false"))) {
+    open_options |= tkrzw::File::OPEN_NO_WAIT;
+  }
+  if (tkrzw::StrToBool(tkrzw::SearchMap(*params, "no_lock", "false"))) {
+    open_options |= tkrzw::File::OPEN_NO_LOCK;
+  }
+  if (tkrzw::StrToBool(tkrzw::SearchMap(*params, "sync_hard", "false"))) {
+    open_options |= tkrzw::File::OPEN_SYNC_HARD;
+  }
+  params->erase("truncate");
+  params->erase("no_create");
+  params->erase("no_wait");
+  params->erase("no_lock");
+  params->erase("sync_hard");
+  return open_options;
+}
+
+
+// Extracts a list of pairs of string views and functions from a sequence object.
+std::vector<std::pair<std::string, std::shared_ptr<tkrzw::DBM::RecordProcessor>>> ExtractKFPairs(
+    PyObject* pyseq) {
+  std::vector<std::pair<std::string, std::shared_ptr<tkrzw::DBM::RecordProcessor>>> result;
+  const size_t size = PySequence_Size(pyseq);
+  result.reserve(size);
+  for (size_t i = 0; i < size; i++) {
+    PyObject* pypair = PySequence_GetItem(pyseq, i);
+    if (PySequence_Check(pypair) && PySequence_Size(pypair) >= 2) {
+      PyObject* pykey = PySequence_GetItem(pypair, 0);
+      PyObject* pyfunc = PySequence_GetItem(pypair, 1);
+      if (PyCallable_Check(pyfunc)) {
+        SoftString key(pykey);
+        class Processor final : public tkrzw::DBM::RecordProcessor {
+         public:
+          Processor(PyObject* pyfunc) : pyfunc_(pyfunc) {
+            Py_INCREF(pyfunc_);
+          }
+          ~Processor() {
+            Py_DECREF(pyfunc_);
+          }
+          std::string_view ProcessFull(std::string_view key, std::string_view value) override {
+            PyObject* pyfuncargs = PyTuple_New(2);
+            PyTuple_SET_ITEM(pyfuncargs, 0, CreatePyBytes(key));
+            PyTuple_SET_ITEM(pyfuncargs, 1, CreatePyBytes(value));
+            PyObject* pyfuncrv = PyObject_CallObject(pyfunc_, pyfuncargs);
+            std::string_view funcrv = tkrzw::DBM::RecordProcessor::NOOP;
+            if (pyfuncrv != nullptr) {
+              if (pyfuncrv == Py_None) {
+                funcrv = tkrzw::DBM::RecordProcessor::NOOP;
+              } else if (pyfuncrv == Py_False) {
+                funcrv = tkrzw::DBM::RecordProcessor::REMOVE;
+              } else {
+                funcrvstr_ = std::make_unique<SoftString>(pyfuncrv);
+                funcrv = funcrvstr_->Get();
+              }
+              Py_DECREF(pyfuncrv);
+            }
+            Py_DECREF(pyfuncargs);
+            return funcrv;
+          }
+          std::string_view ProcessEmpty(std::string_view key) override {
+            PyObject* pyfuncargs = PyTuple_New(2);
+            PyTuple_SET_ITEM(pyfuncargs, 0, CreatePyBytes(key));
+            Py_INCREF(Py_None);
+            PyTuple_SET_ITEM(pyfuncargs, 1, Py_None);
+            PyObject* pyfuncrv = PyObject_CallObject(pyfunc_, pyfuncargs);
+            std::string_view funcrv = tkrzw::DBM::RecordProcessor::NOOP;
+            if (pyfuncrv != nullptr) {
+              if (pyfuncrv == Py_None) {
+                funcrv = tkrzw::DBM::RecordProcessor::NOOP;
+              } else if (pyfuncrv == Py_False) {
+                funcrv = tkrzw::DBM::RecordProcessor::REMOVE;
+              } else {
+                funcrvstr_ = std::make_unique<SoftString>(pyfuncrv);
+                funcrv = funcrvstr_->Get();
+              }
+              Py_DECREF(pyfuncrv);
+            }
+            Py_DECREF(pyfuncargs);
+            return funcrv;
+          }
+         private:
+          PyObject* pyfunc_;
+          std::unique_ptr<SoftString> funcrvstr_;
+        };
+        auto proc = std::make_shared<Processor>(pyfunc);
+        result.emplace_back(std::make_pair(key.Get(), proc));
+      }
+      Py_DECREF(pyfunc);
+      Py_DECREF(pykey);
+    }
+    Py_DECREF(pypair);
+  }
+  return result;
+}
+
+
+// Extracts a list of pairs of string views from a sequence object.
+static std::vector<std::pair<std::string_view, std::string_view>> ExtractSVPairs(
+    const void* pyctx, PyObject* pyseq, std::vector<std::string>* placeholder) {
+  std::vector<std::pair<std::string_view, std::string_view>> result;
+  const size_t size = PySequence_Size(pyseq);
+  result.reserve(size);
+  placeholder->reserve(size * 2);
+  for (size_t i = 0; i < size; i++) {
+    PyObject* pypair = PySequence_GetItem(pyseq, i);
+    if (PySequence_Check(pypair) && PySequence_Size(pypair) >= 2) {
+      PyObject* pykey = PySequence_GetItem(pypair, 0);
+      PyObject* pyvalue = PySequence_GetItem(pypair, 1);
+      {
+        SoftString key(pykey);
+        placeholder->emplace_back(std::string(key.Get()));
+        std::string_view key_view = placeholder->back();
+        std::string_view value_view;
+        if (pyvalue != Py_None) {
+          if (pyvalue == GetModuleState(pyctx)->obj_dbm_any_data) {
+            value_view = tkrzw::DBM::ANY_DATA;
+          } else {
+            SoftString value(pyvalue);
+            placeholder->emplace_back(std::string(value.Get()));
+            value_view = placeholder->back();
+          }
+        }
+        result.emplace_back(std::make_pair(key_view, value_view));
+      }
+      Py_DECREF(pyvalue);
+      Py_DECREF(pykey);
+    }
+    Py_DECREF(pypair);
+  }
+  return result;
+}
+
+
+// Implementation of Utility.GetMemoryCapacity.
+static PyObject* utility_GetMemoryCapacity(PyObject* self) {
+  return PyLong_FromLongLong(tkrzw::GetMemoryCapacity());
+}
+
+// Implementation of Utility.GetMemoryUsage.
+static PyObject* utility_GetMemoryUsage(PyObject* self) {
+  return PyLong_FromLongLong(tkrzw::GetMemoryUsage());
+}
+
+// Implementation of Utility.PrimaryHash.
+static PyObject* utility_PrimaryHash(PyObject* self, PyObject* pyargs) {
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc < 1 || argc > 2) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pydata = PyTuple_GET_ITEM(pyargs, 0);
+  SoftString data(pydata);
+  uint64_t num_buckets = 0;
+  if (argc > 1) {
+    PyObject* pynum = PyTuple_GET_ITEM(pyargs, 1);
+    num_buckets = PyObjToInt(pynum);
+  }
+  if (num_buckets == 0) {
+    num_buckets = tkrzw::UINT64MAX;
+  }
+  return PyLong_FromUnsignedLongLong(tkrzw::PrimaryHash(data.Get(), num_buckets));
+}
+
+// Implementation of Utility.SecondaryHash.
 static PyObject* utility_SecondaryHash(PyObject* self, PyObject* pyargs) {
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 1 || argc > 2) {
+  if (argc < 1 || argc > 2) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pydata = PyTuple_GET_ITEM(pyargs, 0);
+  SoftString data(pydata);
+  uint64_t num_shards = tkrzw::UINT64MAX;
+  if (argc > 1) {
+    PyObject* pynum = PyTuple_GET_ITEM(pyargs, 1);
+    num_shards = PyObjToInt(pynum);
+  }
+  if (num_shards == 0) {
+    num_shards = tkrzw::UINT64MAX;
+  }
+  return PyLong_FromUnsignedLongLong(tkrzw::SecondaryHash(data.Get(), num_shards));
+}
+
+// Implementation of Utility.EditDistanceLev.
+static PyObject* utility_EditDistanceLev(PyObject* self, PyObject* pyargs) {
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 2) {
+    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pyucsa = PyTuple_GET_ITEM(pyargs, 0);
+  PyObject* pyucsb = PyTuple_GET_ITEM(pyargs, 1);
+  if (!PyUnicode_Check(pyucsa) || PyUnicode_READY(pyucsa) != 0 || 
+      !PyUnicode_Check(pyucsb) || PyUnicode_READY(pyucsb) != 0) {
+    ThrowInvalidArguments("not Unicode arguments");
+    return nullptr;
+  }
+  const std::vector<uint32_t>& ucsa = PyUnicodeToUCS4(pyucsa);
+  const std::vector<uint32_t>& ucsb = PyUnicodeToUCS4(pyucsb);
+  return PyLong_FromLong(tkrzw::EditDistanceLev<std::vector<uint32_t>>(ucsa, ucsb));
+}
+
+// Implementation of Utility.SerializeInt.
+static PyObject* utility_SerializeInt(PyObject* self, PyObject* pyargs) {
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pynum = PyTuple_GET_ITEM(pyargs, 0);
+  const int64_t num = PyObjToInt(pynum);
+  const std::string str = tkrzw::IntToStrBigEndian(num, sizeof(int64_t));
+  return CreatePyBytes(str);
+}
+
+// Implementation of Utility.DeserializeInt.
+static PyObject* utility_DeserializeInt(PyObject* self, PyObject* pyargs) {
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pydata = PyTuple_GET_ITEM(pyargs, 0);
+  SoftString data(pydata);
+  const int64_t num = tkrzw::StrToIntBigEndian(data.Get());
+  return PyLong_FromLongLong(num);
+}
+
+// Implementation of Utility.SerializeFloat.
+static PyObject* utility_SerializeFloat(PyObject* self, PyObject* pyargs) {
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pynum = PyTuple_GET_ITEM(pyargs, 0);
+  const double num = PyObjToDouble(pynum);
+  const std::string str = tkrzw::FloatToStrBigEndian(num, sizeof(double));
+  return CreatePyBytes(str);
+}
+
+// Implementation of Utility.DeserializeFloat.
+static PyObject* utility_DeserializeFloat(PyObject* self, PyObject* pyargs) {
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pydata = PyTuple_GET_ITEM(pyargs, 0);
+  SoftString data(pydata);
+  const double num = tkrzw::StrToFloatBigEndian(data.Get());
+  return PyFloat_FromDouble(num);
+}
+
+// Defines the Utility class.
+static bool DefineUtility(PyObject* module, ModuleState* state) {
+  static PyMethodDef methods[] = {
+    {"GetMemoryCapacity", (PyCFunction)utility_GetMemoryCapacity, METH_CLASS | METH_NOARGS,
+     "Gets the memory capacity of the platform."},
+    {"GetMemoryUsage", (PyCFunction)utility_GetMemoryUsage, METH_CLASS | METH_NOARGS,
+     "Gets the current memory usage of the process."},
+    {"PrimaryHash", (PyCFunction)utility_PrimaryHash, METH_CLASS | METH_VARARGS,
+     "Primary hash function for the hash database."},
+    {"SecondaryHash", (PyCFunction)utility_SecondaryHash, METH_CLASS | METH_VARARGS,
+     "Secondary hash function for sharding."},
+    {"EditDistanceLev", (PyCFunction)utility_EditDistanceLev, METH_CLASS | METH_VARARGS,
+     "Gets the Levenshtein edit distance of two Unicode strings."},
+    {"SerializeInt", (PyCFunction)utility_SerializeInt, METH_CLASS | METH_VARARGS,
+     "Serializes an integer into a big-endian binary sequence."},
+    {"DeserializeInt", (PyCFunction)utility_DeserializeInt, METH_CLASS | METH_VARARGS,
+     "Deserializes a big-endian binary sequence into an integer."},
+    {"SerializeFloat", (PyCFunction)utility_SerializeFloat, METH_CLASS | METH_VARARGS,
+     "Serializes a floating-point number into a big-endian binary sequence."},
+    {"DeserializeFloat", (PyCFunction)utility_DeserializeFloat, METH_CLASS | METH_VARARGS,
+     "Deserializes a big-endian binary sequence into a floating-point number."},
+    {nullptr, nullptr, 0, nullptr},
+  };
+  static PyType_Slot slots[] = {
+    {Py_tp_doc, (void*)"Library utilities."},
+    {Py_tp_methods, (void*)methods},
+    {0, nullptr},
+  };
+  static PyType_Spec spec = {
+    "tkrzw.Utility", sizeof(PyUtility), 0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_DISALLOW_INSTANTIATION, slots};
+  state->cls_utility = PyType_FromModuleAndSpec(module, &spec, nullptr);
+  if (state->cls_utility == nullptr) return false;
+  if (!SetConstStr(state->cls_utility, "VERSION", tkrzw::PACKAGE_VERSION)) return false;
+  if (!SetConstStr(state->cls_utility, "OS_NAME", tkrzw::OS_NAME)) return false;
+  if (!SetConstLong(state->cls_utility, "PAGE_SIZE", tkrzw::PAGE_SIZE)) return false;
+  if (!SetConstLong(state->cls_utility, "INT32MIN", (int64_t)tkrzw::INT32MIN)) return false;
+  if (!SetConstLong(state->cls_utility, "INT32MAX", (int64_t)tkrzw::INT32MAX)) return false;
+  if (!SetConstUnsignedLong(state->cls_utility, "UINT32MAX", (uint64_t)tkrzw::UINT32MAX)) {
+    return false;
+  }
+  if (!SetConstLong(state->cls_utility, "INT64MIN", (int64_t)tkrzw::INT64MIN)) return false;
+  if (!SetConstLong(state->cls_utility, "INT64MAX", (int64_t)tkrzw::INT64MAX)) return false;
+  if (!SetConstUnsignedLong(state->cls_utility, "UINT64MAX", (uint64_t)tkrzw::UINT64MAX)) {
+    return false;
+  }
+  if (PyModule_AddObjectRef(module, "Utility", state->cls_utility) != 0) return false;
+  return true;
+}
+
+// Implementation of Status.new.
+static PyObject* status_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
+  PyTkStatus* self = (PyTkStatus*)pytype->tp_alloc(pytype, 0);
+  if (!self) return nullptr;
+  self->status = new tkrzw::Status();
+  return (PyObject*)self;
+}
+
+// Implementation of Status#dealloc.
+static void status_dealloc(PyTkStatus* self) {
+  delete self->status;
+  PyTypeObject* pytype = Py_TYPE(self);
+  pytype->tp_free((PyObject*)self);
+  Py_DECREF(pytype);
+}
+
+// Implementation of Status#__init__.
+static int status_init(PyTkStatus* self, PyObject* pyargs, PyObject* pykwds) {
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc > 2) {
+    ThrowInvalidArguments("too many arguments");
+    return -1;
+  }
+  tkrzw::Status::Code code = tkrzw::Status::SUCCESS;
+  if (argc > 0) {
+    PyObject* pycode = PyTuple_GET_ITEM(pyargs, 0);
+    code = (tkrzw::Status::Code)PyLong_AsLong(pycode);
+  }
+  if (argc > 1) {
+    PyObject* pymessage = PyTuple_GET_ITEM(pyargs, 1);
+    SoftString str(pymessage);
+    self->status->Set(code, str.Get());
+  } else {
+    self->status->Set(code);
+  }
+  return 0;
+}
+
+// Implementation of Status#__repr__.
+static PyObject* status_repr(PyTkStatus* self) {
+  ObjectLock object_lock((PyObject*)self);
+  return CreatePyString(tkrzw::StrCat("<tkrzw.Status: ", *self->status, ">"));
+}
+
+// Implementation of Status#__str__.
+static PyObject* status_str(PyTkStatus* self) {
+  ObjectLock object_lock((PyObject*)self);
+  return CreatePyString(tkrzw::ToString(*self->status));
+}
+
+// Implementation of Status#__richcmp__.
+static PyObject* status_richcmp(PyTkStatus* self, PyObject* pyrhs, int op) {
+  ObjectLock object_lock((PyObject*)self);
+  bool rv = false;
+  int32_t code = (int32_t)self->status->GetCode();
+  int32_t rcode = 0;
+  if (PyObject_IsInstance(pyrhs, GetModuleState(self)->cls_status)) {
+    PyTkStatus* pyrhs_status = (PyTkStatus*)pyrhs;
+    rcode = (int32_t)pyrhs_status->status->GetCode();
+  } else if (PyLong_Check(pyrhs)) {
+    rcode = (int32_t)PyLong_AsLong(pyrhs);
+  } else {
+    rcode = tkrzw::INT32MAX;
+  }
+  switch (op) {
+    case Py_LT: rv = code < rcode; break;
+    case Py_LE: rv = code <= rcode; break;
+    case Py_EQ: rv = code == rcode; break;
+    case Py_NE: rv = code != rcode; break;
+    case Py_GT: rv = code > rcode; break;
+    case Py_GE: rv = code >= rcode; break;
+    default: rv = false; break;
+  }
+  if (rv) {
+    Py_RETURN_TRUE;
+  }
+  Py_RETURN_FALSE;
+}
+
+// Implementation of Status#Set.
+static PyObject* status_Set(PyTkStatus* self, PyObject* pyargs) {
+  ObjectLock object_lock((PyObject*)self);
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc > 2) {
+    ThrowInvalidArguments("too many arguments");
+    return nullptr;
+  }
+  tkrzw::Status::Code code = tkrzw::Status::SUCCESS;
+  if (argc > 0) {
+    PyObject* pycode = PyTuple_GET_ITEM(pyargs, 0);
+    code = (tkrzw::Status::Code)PyLong_AsLong(pycode);
+  }
+  if (argc > 1) {
+    PyObject* pymessage = PyTuple_GET_ITEM(pyargs, 1);
+    SoftString str(pymessage);
+    self->status->Set(code, str.Get());
+  } else {
+    self->status->Set(code);
+  }
+  Py_RETURN_NONE;
+}
+
+// Implementation of Status#Join.
+static PyObject* status_Join(PyTkStatus* self, PyObject* pyargs) {
+  ObjectLock object_lock((PyObject*)self);
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pyrht = PyTuple_GET_ITEM(pyargs, 0);
+  if (!PyObject_IsInstance(pyrht, GetModuleState(self)->cls_status)) {
+    ThrowInvalidArguments("the argument is not a Status");
+    return nullptr;
+  }
+  PyTkStatus* rht = (PyTkStatus*)pyrht;
+  (*self->status) |= (*rht->status);
+  Py_RETURN_NONE;
+}
+
+// Implementation of Status#GetCode.
+static PyObject* status_GetCode(PyTkStatus* self) {
+  ObjectLock object_lock((PyObject*)self);
+  return PyLong_FromLongLong(self->status->GetCode());
+}
+
+// Implementation of Status#GetMessage.
+static PyObject* status_GetMessage(PyTkStatus* self) {
+  ObjectLock object_lock((PyObject*)self);
+  return PyUnicode_FromString(self->status->GetMessage().c_str());
+}
+
+// Implementation of Status#IsOK.
+static PyObject* status_IsOK(PyTkStatus* self) {
+  ObjectLock object_lock((PyObject*)self);
+  if (*self->status == tkrzw::Status::SUCCESS) {
+    Py_RETURN_TRUE;
+  }
+  Py_RETURN_FALSE;
+}
+
+// Implementation of Status#OrDie.
+static PyObject* status_OrDie(PyTkStatus* self) {
+  ObjectLock object_lock((PyObject*)self);
+  if (*self->status != tkrzw::Status::SUCCESS) {
+    ThrowStatusException(self, *self->status);    
+    return nullptr;
+  }
+  Py_RETURN_NONE;
+}
+
+// Implementation of Status.CodeName.
+static PyObject* status_CodeName(PyObject* self, PyObject* pyargs) {
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pycode = PyTuple_GET_ITEM(pyargs, 0);
+  const tkrzw::Status::Code code = (tkrzw::Status::Code)PyLong_AsLong(pycode);
+  return CreatePyString(tkrzw::ToString(tkrzw::Status::CodeName(code)));
+}
+
+// Defines the Status class.
+static bool DefineStatus(PyObject* module, ModuleState* state) {
+  static PyMethodDef methods[] = {
+    {"Set", (PyCFunction)status_Set, METH_VARARGS,
+     "Set the code and the message."},
+    {"Join", (PyCFunction)status_Join, METH_VARARGS,
+     "Assigns the internal state only if the current state is success."},
+    {"GetCode", (PyCFunction)status_GetCode, METH_NOARGS,
+     "Gets the status code.."},
+    {"GetMessage", (PyCFunction)status_GetMessage, METH_NOARGS,
+     "Gets the status message."},
+    {"IsOK", (PyCFunction)status_IsOK, METH_NOARGS,
+     "Returns true if the status is success."},
+    {"OrDie", (PyCFunction)status_OrDie, METH_NOARGS,
+     "Raises a runtime error if the status is not success."},
+    {"CodeName", (PyCFunction)status_CodeName, METH_CLASS | METH_VARARGS,
+     "Gets the string name of a status code."},
+    {nullptr, nullptr, 0, nullptr},
+  };
+  static PyType_Slot slots[] = {
+    {Py_tp_doc, (void*)"Status of operations."},
+    {Py_tp_new, (void*)status_new},
+    {Py_tp_dealloc, (void*)status_dealloc},
+    {Py_tp_init, (void*)status_init},
+    {Py_tp_repr, (void*)status_repr},
+    {Py_tp_str, (void*)status_str},
+    {Py_tp_richcompare, (void*)status_richcmp},
+    {Py_tp_methods, (void*)methods},
+    {0, nullptr},
+  };
+  static PyType_Spec spec = {
+    "tkrzw.Status", sizeof(PyTkStatus), 0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, slots};
+  state->cls_status = PyType_FromModuleAndSpec(module, &spec, nullptr);
+  if (state->cls_status == nullptr) return false;
+  if (!SetConstLong(state->cls_status, "SUCCESS",
+                    (int64_t)tkrzw::Status::SUCCESS)) return false;
+  if (!SetConstLong(state->cls_status, "UNKNOWN_ERROR",
+                    (int64_t)tkrzw::Status::UNKNOWN_ERROR)) return false;
+  if (!SetConstLong(state->cls_status, "SYSTEM_ERROR",
+                    (int64_t)tkrzw::Status::SYSTEM_ERROR)) return false;
+  if (!SetConstLong(state->cls_status, "NOT_IMPLEMENTED_ERROR",
+                    (int64_t)tkrzw::Status::NOT_IMPLEMENTED_ERROR)) return false;
+  if (!SetConstLong(state->cls_status, "PRECONDITION_ERROR",
+                    (int64_t)tkrzw::Status::PRECONDITION_ERROR)) return false;
+  if (!SetConstLong(state->cls_status, "INVALID_ARGUMENT_ERROR",
+                    (int64_t)tkrzw::Status::INVALID_ARGUMENT_ERROR)) return false;
+  if (!SetConstLong(state->cls_status, "CANCELED_ERROR",
+                    (int64_t)tkrzw::Status::CANCELED_ERROR)) return false;
+  if (!SetConstLong(state->cls_status, "NOT_FOUND_ERROR",
+                    (int64_t)tkrzw::Status::NOT_FOUND_ERROR)) return false;
+  if (!SetConstLong(state->cls_status, "PERMISSION_ERROR",
+                    (int64_t)tkrzw::Status::PERMISSION_ERROR)) return false;
+  if (!SetConstLong(state->cls_status, "INFEASIBLE_ERROR",
+                    (int64_t)tkrzw::Status::INFEASIBLE_ERROR)) return false;
+  if (!SetConstLong(state->cls_status, "DUPLICATION_ERROR",
+                    (int64_t)tkrzw::Status::DUPLICATION_ERROR)) return false;
+  if (!SetConstLong(state->cls_status, "BROKEN_DATA_ERROR",
+                    (int64_t)tkrzw::Status::BROKEN_DATA_ERROR)) return false;
+  if (!SetConstLong(state->cls_status, "NETWORK_ERROR",
+                    (int64_t)tkrzw::Status::NETWORK_ERROR)) return false;
+  if (!SetConstLong(state->cls_status, "APPLICATION_ERROR",
+                    (int64_t)tkrzw::Status::APPLICATION_ERROR)) return false;
+  if (PyModule_AddObjectRef(module, "Status", state->cls_status) != 0) return false;
+  return true;
+}
+
+// Implementation of StatusException.new.
+static PyObject* expt_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
+  PyException* self = (PyException*)pytype->tp_alloc(pytype, 0);
+  if (!self) return nullptr;
+  self->pystatus = nullptr;
+  return (PyObject*)self;
+}
+
+// Implementation of StatusException#dealloc.
+static void expt_dealloc(PyException* self) {
+  if (self->pystatus) Py_DECREF(self->pystatus);
+  PyTypeObject* pytype = Py_TYPE(self);
+  pytype->tp_free((PyObject*)self);
+  Py_DECREF(pytype);
+}
+
+// Implementation of StatusException#__init__.
+static int expt_init(PyException* self, PyObject* pyargs, PyObject* pykwds) {
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return -1;
+  }
+  PyObject* pystatus = PyTuple_GET_ITEM(pyargs, 0);
+  if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
+    ThrowInvalidArguments("the argument is not a status");
+    return -1;
+  }
+  Py_INCREF(pystatus);
+  self->pystatus = pystatus;
+  return 0;
+}
+
+// Implementation of StatusException#__repr__.
+static PyObject* expt_repr(PyException* self) {
+  const tkrzw::Status* status = ((PyTkStatus*)self->pystatus)->status;
+  return CreatePyString(tkrzw::StrCat("<tkrzw.StatusException: ", *status, ">"));
+}
+
+// Implementation of StatusException#__str__.
+static PyObject* expt_str(PyException* self) {
+  const tkrzw::Status* status = ((PyTkStatus*)self->pystatus)->status;
+  return CreatePyString(tkrzw::ToString(*status));
+}
+
+// Implementation of StatusException#GetStatus.
+static PyObject* expt_GetStatus(PyException* self) {
+  Py_INCREF(self->pystatus);
+  return self->pystatus;
+}
+
+// Defines the StatusException class.
+static bool DefineStatusException(PyObject* module, ModuleState* state) {
+  static PyMethodDef methods[] = {
+    {"GetStatus", (PyCFunction)expt_GetStatus, METH_NOARGS,
+     "Get the status object." },
+    {nullptr, nullptr, 0, nullptr}
+  };
+  static PyType_Slot slots[] = {
+    {Py_tp_doc, (void*)"Exception to convey the status of operations."},
+    {Py_tp_new, (void*)expt_new},
+    {Py_tp_dealloc, (void*)expt_dealloc},
+    {Py_tp_init, (void*)expt_init},
+    {Py_tp_repr, (void*)expt_repr},
+    {Py_tp_str, (void*)expt_str},
+    {Py_tp_methods, (void*)methods},
+    {0, nullptr},
+  };
+  static PyType_Spec spec = {
+    "tkrzw.StatusException", sizeof(PyException), 0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, slots};
+  state->cls_expt = PyType_FromModuleAndSpec(module, &spec, PyExc_RuntimeError);
+  if (state->cls_expt == nullptr) return false;
+  if (PyModule_AddObjectRef(module, "StatusException", state->cls_expt) != 0) return false;
+  return true;
+}
+
+// Implementation of Future.new.
+static PyObject* future_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
+  PyFuture* self = (PyFuture*)pytype->tp_alloc(pytype, 0);
+  if (!self) return nullptr;
+  self->mutex = NewHandleMutex();
+  self->future = nullptr;
+  self->concurrent = false;
+  self->is_str = false;
+  return (PyObject*)self;
+}
+
+// Implementation of Future#dealloc.
+static void future_dealloc(PyFuture* self) {
+  delete self->future;
+  delete self->mutex;
+  PyTypeObject* pytype = Py_TYPE(self);
+  pytype->tp_free((PyObject*)self);
+  Py_DECREF(pytype);
+}
+
+// Implementation of Future#__init__.
+static int future_init(PyFuture* self, PyObject* pyargs, PyObject* pykwds) {
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 0) {
+    ThrowInvalidArguments("too many arguments");
+    return -1;
+  }
+  ThrowStatusException(self, tkrzw::Status(tkrzw::Status::NOT_IMPLEMENTED_ERROR));
+  return -1;
+}
+
+// Implementation of Future#__repr__.
+static PyObject* future_repr(PyFuture* self) {
+  HandleLock handle_lock(self->mutex, false);
+  const std::string& str = tkrzw::SPrintF("<tkrzw.Future: %p>", (void*)self->future);
+  return CreatePyString(str);
+}
+
+// Implementation of Future#__str__.
+static PyObject* future_str(PyFuture* self) {
+  HandleLock handle_lock(self->mutex, false);
+  const std::string& str = tkrzw::SPrintF("Future:%p", (void*)self->future);
+  return CreatePyString(str);
+}
+
+// Implementation of Future#__iter__.
+static PyObject* future_iter(PyFuture* self) {
+  Py_INCREF(self);  
+  return (PyObject*)self;
+}
+
+// Implementation of Future#__next__.
+static PyObject* future_iternext(PyFuture* self) {
+  PyErr_SetString(PyExc_StopIteration, "end of iteration");
+  return nullptr;
+}
+
+// Implementation of Future#__await__.
+static PyObject* future_await(PyFuture* self) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->future == nullptr) {
+    ThrowInvalidArguments("consumed future");
+    return nullptr;
+  }
+  {
+    NativeLock lock(self->concurrent);
+    self->future->Wait();
+  }
+  self->concurrent = false;
+  Py_INCREF(self);  
+  return (PyObject*)self;
+}
+
+// Implementation of Future#Wait.
+static PyObject* future_Wait(PyFuture* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->future == nullptr) {
+    ThrowInvalidArguments("consumed future");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc > 1) {
+    ThrowInvalidArguments("too many arguments");
+    return nullptr;
+  }
+  const double timeout = argc > 0 ? PyObjToDouble(PyTuple_GET_ITEM(pyargs, 0)) : -1.0;
+  bool ok = false;
+  {
+    NativeLock lock(self->concurrent);
+    ok = self->future->Wait(timeout);
+  }
+  if (ok) {
+    self->concurrent = false;
+    Py_RETURN_TRUE;
+  }
+  Py_RETURN_FALSE;
+}
+
+// Implementation of Future#Get.
+static PyObject* future_Get(PyFuture* self) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->future == nullptr) {
+    ThrowInvalidArguments("consumed future");
+    return nullptr;
+  }
+  const auto& type = self->future->GetExtraType();
+  if (type == typeid(tkrzw::Status)) {
+    NativeLock lock(self->concurrent);
+    tkrzw::Status status = self->future->Get();
+    lock.Release();
+    delete self->future;
+    self->future = nullptr;
+    return CreatePyTkStatusMove(self, std::move(status));
+  }
+  if (type == typeid(std::pair<tkrzw::Status, std::string>)) {
+    NativeLock lock(self->concurrent);
+    const auto& result = self->future->GetString();
+    lock.Release();
+    delete self->future;
+    self->future = nullptr;
+    PyObject* pyrv = PyTuple_New(2);
+    PyTuple_SET_ITEM(pyrv, 0, CreatePyTkStatus(self, std::move(result.first)));
+    if (self->is_str) {
+      PyTuple_SET_ITEM(pyrv, 1, CreatePyString(result.second));
+    } else {
+      PyTuple_SET_ITEM(pyrv, 1, CreatePyBytes(result.second));
+    }
+    return pyrv;
+  }
+  if (type == typeid(std::pair<tkrzw::Status, std::pair<std::string, std::string>>)) {
+    NativeLock lock(self->concurrent);
+    const auto& result = self->future->GetStringPair();
+    lock.Release();
+    delete self->future;
+    self->future = nullptr;
+    PyObject* pyrv = PyTuple_New(3);
+    PyTuple_SET_ITEM(pyrv, 0, CreatePyTkStatus(self, std::move(result.first)));
+    if (self->is_str) {
+      PyTuple_SET_ITEM(pyrv, 1, CreatePyString(result.second.first));
+      PyTuple_SET_ITEM(pyrv, 2, CreatePyString(result.second.second));
+    } else {
+      PyTuple_SET_ITEM(pyrv, 1, CreatePyBytes(result.second.first));
+      PyTuple_SET_ITEM(pyrv, 2, CreatePyBytes(result.second.second));
+    }
+    return pyrv;
+  }
+  if (type == typeid(std::pair<tkrzw::Status, std::vector<std::string>>)) {
+    NativeLock lock(self->concurrent);
+    const auto& result = self->future->GetStringVector();
+    lock.Release();
+    delete self->future;
+    self->future = nullptr;
+    PyObject* pyrv = PyTuple_New(2);
+    PyTuple_SET_ITEM(pyrv, 0, CreatePyTkStatus(self, std::move(result.first)));
+    PyObject* pylist = PyTuple_New(result.second.size());
+    for (size_t i = 0; i < result.second.size(); i++) {
+      if (self->is_str) {
+        PyTuple_SET_ITEM(pylist, i, CreatePyString(result.second[i]));
+      } else {
+        PyTuple_SET_ITEM(pylist, i, CreatePyBytes(result.second[i]));
+      }
+    }
+    PyTuple_SET_ITEM(pyrv, 1, pylist);
+    return pyrv;
+  }
+  if (type == typeid(std::pair<tkrzw::Status, std::map<std::string, std::string>>)) {
+    NativeLock lock(self->concurrent);
+    const auto& result = self->future->GetStringMap();
+    lock.Release();
+    delete self->future;
+    self->future = nullptr;
+    PyObject* pyrv = PyTuple_New(2);
+    PyTuple_SET_ITEM(pyrv, 0, CreatePyTkStatus(self, std::move(result.first)));
+    PyObject* pydict = PyDict_New();
+    for (const auto& rec : result.second) {
+      if (self->is_str) {
+        PyObject* pykey = CreatePyString(rec.first);
+        PyObject* pyvalue = CreatePyString(rec.second);
+        PyDict_SetItem(pydict, pykey, pyvalue);
+        Py_DECREF(pyvalue);
+        Py_DECREF(pykey);
+      } else {
+        PyObject* pykey = CreatePyBytes(rec.first);
+        PyObject* pyvalue = CreatePyBytes(rec.second);
+        PyDict_SetItem(pydict, pykey, pyvalue);
+        Py_DECREF(pyvalue);
+        Py_DECREF(pykey);
+      }
+    }
+    PyTuple_SET_ITEM(pyrv, 1, pydict);
+    return pyrv;
+  }
+  if (type == typeid(std::pair<tkrzw::Status, int64_t>)) {
+    NativeLock lock(self->concurrent);
+    const auto& result = self->future->GetInteger();
+    lock.Release();
+    delete self->future;
+    self->future = nullptr;
+    PyObject* pyrv = PyTuple_New(2);
+    PyTuple_SET_ITEM(pyrv, 0, CreatePyTkStatus(self, std::move(result.first)));
+    PyTuple_SET_ITEM(pyrv, 1, PyLong_FromLongLong(result.second));
+    return pyrv;
+  }
+  ThrowStatusException(self, tkrzw::Status(tkrzw::Status::NOT_IMPLEMENTED_ERROR));
+  return nullptr;
+}
+
+// Defines the Future class.
+static bool DefineFuture(PyObject* module, ModuleState* state) {
+  static PyMethodDef methods[] = {
+    {"Wait", (PyCFunction)future_Wait, METH_VARARGS,
+     "Waits for the operation to be done."},
+    {"Get", (PyCFunction)future_Get, METH_NOARGS,
+     "Waits for the operation to be done and gets the result status." },
+    {nullptr, nullptr, 0, nullptr}
+  };
+  static PyType_Slot slots[] = {
+    {Py_tp_doc, (void*)"Future to monitor the result of asynchronous operations."},
+    {Py_tp_new, (void*)future_new},
+    {Py_tp_dealloc, (void*)future_dealloc},
+    {Py_tp_init, (void*)future_init},
+    {Py_tp_repr, (void*)future_repr},
+    {Py_tp_str, (void*)future_str},
+    {Py_tp_methods, (void*)methods},
+    {Py_am_await, (void*)future_await},
+    {Py_tp_iter, (void*)future_iter},
+    {Py_tp_iternext, (void*)future_iternext},
+    {0, nullptr},
+  };
+  static PyType_Spec spec = {
+    "tkrzw.Future", sizeof(PyFuture), 0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, slots};
+  state->cls_future = PyType_FromModuleAndSpec(module, &spec, nullptr);
+  if (state->cls_future == nullptr) return false;
+  if (PyModule_AddObjectRef(module, "Future", state->cls_future) != 0) return false;
+  return true;
+}
+
+// Implementation of DBM.new.
+static PyObject* dbm_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
+  PyDBM* self = (PyDBM*)pytype->tp_alloc(pytype, 0);
+  if (!self) return nullptr;
+  // Background jobs use the handle on native threads without the GIL, so the mutex is made on
+  // every build.
+  self->mutex = new std::shared_mutex();
+  self->dbm = nullptr;
+  self->open_path = nullptr;
+  self->open_params = nullptr;
+  new (&self->object_cache) std::shared_ptr<ObjectCache>(std::make_shared<ObjectCache>());
+  new (&self->bloom_filter) std::shared_ptr<BloomFilter>();
+  self->bloom_rebuild_mutex = new std::mutex();
+  self->maintainer = nullptr;
+  self->committer = nullptr;
+  self->ulog_mq = nullptr;
+  self->ulog = nullptr;
+  self->num_shards = 0;
+  self->has_bloom_filter = false;
+  self->is_snapshot = false;
+  self->concurrent = false;
+  RegisterForkHandle((PyObject*)self, AbandonDBMHandle);
+  return (PyObject*)self;
+}
+
+// Implementation of DBM#dealloc.
+static void dbm_dealloc(PyDBM* self) {
+  UnregisterForkHandle((PyObject*)self);
+  StopMaintainer(self);
+  const bool removes_snapshot = self->is_snapshot && self->dbm != nullptr;
+  delete self->committer;
+  delete self->dbm;
+  delete self->ulog;
+  delete self->ulog_mq;
+  if (removes_snapshot) {
+    RemoveSnapshotFiles(*self->open_path, self->num_shards);
+  }
+  delete self->open_path;
+  delete self->open_params;
+  self->object_cache->Configure(nullptr, 0);
+  self->object_cache.~shared_ptr();
+  self->bloom_filter.~shared_ptr();
+  delete self->bloom_rebuild_mutex;
+  delete self->mutex;
+  PyTypeObject* pytype = Py_TYPE(self);
+  pytype->tp_free((PyObject*)self);
+  Py_DECREF(pytype);
+}
+
+// Implementation of DBM#__init__.
+static int dbm_init(PyDBM* self, PyObject* pyargs, PyObject* pykwds) {
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 0) {
+    ThrowInvalidArguments("too many arguments");
+    return -1;
+  }
+  return 0;
+}
+
+// Implementation of DBM#__repr__.
+static PyObject* dbm_repr(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  std::string class_name = "unknown";
+  std::string path = "-";
+  int64_t num_records = -1;
+  if (self->dbm != nullptr) {
+    NativeLock lock(self->concurrent);
+    for (const auto& rec : self->dbm->Inspect()) {
+      if (rec.first == "class") {
+        class_name = rec.second;
+      } else if (rec.first == "path") {
+        path = rec.second;
+      }
+    }   
+    num_records = self->dbm->CountSimple();
+  }
+  const std::string& str = tkrzw::StrCat(
+      "<tkrzw.DBM: class=", class_name,
+      " path=", tkrzw::StrEscapeC(path, true), " num_records=", num_records, ">");
+  return CreatePyString(str);
+}
+
+// Implementation of DBM#__str__.
+static PyObject* dbm_str(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  std::string class_name = "unknown";
+  std::string path = "-";
+  int64_t num_records = -1;
+  if (self->dbm != nullptr) {
+    NativeLock lock(self->concurrent);
+    for (const auto& rec : self->dbm->Inspect()) {
+      if (rec.first == "class") {
+        class_name = rec.second;
+      } else if (rec.first == "path") {
+        path = rec.second;
+      }
+    }
+    num_records = self->dbm->CountSimple();
+  }
+  const std::string& str = tkrzw::StrCat(
+      class_name, ":", tkrzw::StrEscapeC(path, true), ":", num_records);
+  return CreatePyString(str);
+}
+
+// Implementation of DBM#Open.
+static PyObject* dbm_Open(PyDBM* self, PyObject* pyargs, PyObject* pykwds) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->dbm != nullptr) {
+    ThrowInvalidArguments("opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 2) {
+    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pypath = PyTuple_GET_ITEM(pyargs, 0);
+  PyObject* pywritable = PyTuple_GET_ITEM(pyargs, 1);
+  std::string path(SoftString(pypath).Get());
+  const bool writable = PyObject_IsTrue(pywritable);
+  int32_t num_shards = -1;
+  bool concurrent = false;
+  bool bloom_filter = false;
+  int32_t bloom_bits_per_key = 10;
+  double commit_delay = 0;
+  std::string ulog_prefix;
+  int64_t ulog_max_file_size = 1LL << 30;
+  int32_t ulog_server_id = -1;
+  int32_t ulog_dbm_index = -1;
+  int32_t open_options = 0;
+  std::map<std::string, std::string> params;
+  if (pykwds != nullptr) {
+    params = MapKeywords(pykwds);
+    num_shards = tkrzw::StrToInt(tkrzw::SearchMap(params, "num_shards", "-1"));
+    bloom_filter = tkrzw::StrToBool(tkrzw::SearchMap(params, "bloom_filter", "false"));
+    bloom_bits_per_key = std::max<int32_t>(
+        1, tkrzw::StrToInt(tkrzw::SearchMap(params, "bloom_bits_per_key", "10")));
+    commit_delay = tkrzw::StrToDouble(tkrzw::SearchMap(params, "commit_delay", "0"));
+    ulog_prefix = tkrzw::SearchMap(params, "ulog_prefix", "");
+    ulog_max_file_size = tkrzw::StrToIntMetric(
+        tkrzw::SearchMap(params, "ulog_max_file_size", "1Gi"));
+    ulog_server_id = tkrzw::StrToInt(tkrzw::SearchMap(params, "ulog_server_id", "-1"));
+    ulog_dbm_index = tkrzw::StrToInt(tkrzw::SearchMap(params, "ulog_dbm_index", "-1"));
+    if (tkrzw::StrToBool(tkrzw::SearchMap(params, "concurrent", "false"))) {
+      concurrent = true;
+    }
+    if (tkrzw::StrToBool(tkrzw::SearchMap(params, "shared_memory", "false"))) {
+      path = GetSharedMemoryPath(path);
+      params.emplace("dbm", "HashDBM");
+      params.emplace("file", "MemoryMapParallelFile");
+    }
+    params.erase("concurrent");
+    params.erase("shared_memory");
+    params.erase("bloom_filter");
+    params.erase("bloom_bits_per_key");
+    params.erase("commit_delay");
+    params.erase("ulog_prefix");
+    params.erase("ulog_max_file_size");
+    params.erase("ulog_server_id");
+    params.erase("ulog_dbm_index");
+    open_options = ExtractOpenOptions(&params);
+  }
+  std::string bloom_fingerprint;
+  if (bloom_filter) {
+    int32_t num_shard_files = 0;
+    if (num_shards < 0 ||
+        tkrzw::ShardDBM::GetNumberOfShards(path, &num_shard_files) == tkrzw::Status::SUCCESS) {
+      bloom_fingerprint = MakeBloomFilterFingerprint(path, num_shard_files);
+    }
+  }
+  if (num_shards >= 0) {
+    self->dbm = new tkrzw::ShardDBM();
+  } else {
+    self->dbm = new tkrzw::PolyDBM();
+  }
+  self->concurrent = concurrent;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->OpenAdvanced(path, writable, open_options, params);
+  }
+  if (status != tkrzw::Status::SUCCESS) {
+    delete self->dbm;
+    self->dbm = nullptr;
+    return CreatePyTkStatusMove(self, std::move(status));
+  }
+  if (num_shards >= 0) {
+    if (tkrzw::ShardDBM::GetNumberOfShards(path, &self->num_shards) !=
+        tkrzw::Status::SUCCESS) {
+      self->num_shards = std::max(num_shards, 1);
+    }
+  }
+  if (bloom_filter) {
+    NativeLock lock(self->concurrent);
+    std::shared_ptr<BloomFilter> filter;
+    if (!bloom_fingerprint.empty()) {
+      bloom_fingerprint = tkrzw::StrCat(self->dbm->CountSimple(), bloom_fingerprint);
+      filter = BloomFilter::Load(path + ".bloom", bloom_fingerprint);
+    }
+    if (writable && !path.empty()) {
+      // The sidecar file is valid only until the database is updated, so it is removed while
+      // the database is opened as writable and saved again by Close.
+      tkrzw::RemoveFile(path + ".bloom");
+    }
+    if (filter == nullptr) {
+      filter = std::make_shared<BloomFilter>(self->dbm->CountSimple(), bloom_bits_per_key);
+      status = filter->AddAllKeys(self->dbm);
+    }
+    if (status != tkrzw::Status::SUCCESS) {
+      self->dbm->Close();
+      delete self->dbm;
+      self->dbm = nullptr;
+      self->num_shards = 0;
+      return CreatePyTkStatusMove(self, std::move(status));
+    }
+    self->bloom_filter = std::move(filter);
+    self->has_bloom_filter = true;
+  }
+  if (!ulog_prefix.empty()) {
+    NativeLock lock(self->concurrent);
+    auto mq = std::make_unique<tkrzw::MessageQueue>();
+    status = mq->Open(ulog_prefix, ulog_max_file_size);
+    if (status != tkrzw::Status::SUCCESS) {
+      self->dbm->Close();
+      delete self->dbm;
+      self->dbm = nullptr;
+      self->bloom_filter.reset();
+      self->has_bloom_filter = false;
+      self->num_shards = 0;
+      return CreatePyTkStatusMove(self, std::move(status));
+    }
+    self->ulog_mq = mq.release();
+    self->ulog = new tkrzw::DBMUpdateLoggerMQ(self->ulog_mq, ulog_server_id, ulog_dbm_index);
+    self->dbm->SetUpdateLogger(self->ulog);
+  }
+  tkrzw::ParamDBM* dbm = self->dbm;
+  self->committer = new GroupCommitter(
+      [dbm](bool hard) { return dbm->Synchronize(hard); }, commit_delay);
+  self->open_path = new std::string(path);
+  self->open_params = new std::map<std::string, std::string>(std::move(params));
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of DBM#Close.
+static PyObject* dbm_Close(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  StopMaintainer(self);
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    const int64_t num_records = self->has_bloom_filter ? self->dbm->CountSimple() : -1;
+    status = self->dbm->Close();
+    if (self->has_bloom_filter && !self->open_path->empty()) {
+      const std::string bloom_path = *self->open_path + ".bloom";
+      const std::string fingerprint = MakeBloomFilterFingerprint(
+          *self->open_path, self->open_params->count("num_shards") > 0 ? self->num_shards : 0);
+      if (status == tkrzw::Status::SUCCESS && self->bloom_filter->IsEnabled() &&
+          !fingerprint.empty()) {
+        self->bloom_filter->Save(bloom_path, tkrzw::StrCat(num_records, fingerprint));
+      } else {
+        tkrzw::RemoveFile(bloom_path);
+      }
+    }
+    if (self->ulog_mq != nullptr) {
+      status |= self->ulog_mq->Close();
+    }
+  }
+  delete self->committer;
+  self->committer = nullptr;
+  delete self->dbm;
+  self->dbm = nullptr;
+  delete self->ulog;
+  self->ulog = nullptr;
+  delete self->ulog_mq;
+  self->ulog_mq = nullptr;
+  if (self->is_snapshot) {
+    RemoveSnapshotFiles(*self->open_path, self->num_shards);
+    self->is_snapshot = false;
+  }
+  self->bloom_filter.reset();
+  self->has_bloom_filter = false;
+  ClearObjectCache(self);
+  delete self->open_path;
+  self->open_path = nullptr;
+  delete self->open_params;
+  self->open_params = nullptr;
+  self->num_shards = 0;
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of DBM#Process.
+static PyObject* dbm_Process(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  if (self->concurrent) {
+    return CreatePyTkStatusMove(self, tkrzw::Status(
+        tkrzw::Status::PRECONDITION_ERROR, "the concurrent mode is not supported"));
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 3) {
+    ThrowInvalidArguments(argc < 3 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
+  PyObject* pyfunc = PyTuple_GET_ITEM(pyargs, 1);
+  const bool writable = PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 2));
+  if (!PyCallable_Check(pyfunc)) {
+    ThrowInvalidArguments("non callable is given");
+    return nullptr;
+  }
+  SoftString key(pykey);
+  std::unique_ptr<SoftString> funcrvstr;
+  auto func = [&](std::string_view k, std::string_view v) -> std::string_view {
+    PyObject* pyfuncargs = PyTuple_New(2);
+    PyTuple_SET_ITEM(pyfuncargs, 0, CreatePyBytes(k));
+    if (v.data() == tkrzw::DBM::RecordProcessor::NOOP.data()) {
+      Py_INCREF(Py_None);
+      PyTuple_SET_ITEM(pyfuncargs, 1, Py_None);
+    } else {
+      PyTuple_SET_ITEM(pyfuncargs, 1, CreatePyBytes(v));
+    }
+    PyObject* pyfuncrv = PyObject_CallObject(pyfunc, pyfuncargs);
+    std::string_view funcrv = tkrzw::DBM::RecordProcessor::NOOP;
+    if (pyfuncrv != nullptr) {
+      if (pyfuncrv == Py_None) {
+        funcrv = tkrzw::DBM::RecordProcessor::NOOP;
+      } else if (pyfuncrv == Py_False) {
+        funcrv = tkrzw::DBM::RecordProcessor::REMOVE;
+      } else {
+        funcrvstr = std::make_unique<SoftString>(pyfuncrv);
+        funcrv = funcrvstr->Get();
+      }
+      Py_DECREF(pyfuncrv);
+    }
+    Py_DECREF(pyfuncargs);
+    return funcrv;
+  };
+  tkrzw::Status status = self->dbm->Process(key.Get(), func, writable);
+  InvalidateObjectCache(self, key.Get());
+  if (writable) {
+    AddToBloomFilter(self, key.Get());
+  }
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of DBM#Get.
+static PyObject* dbm_Get(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc < 1 || argc > 2) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
+  SoftString key(pykey);
+  PyObject* pystatus = nullptr;
+  if (argc > 1) {
+    pystatus = PyTuple_GET_ITEM(pyargs, 1);
+    if (pystatus == Py_None) {
+      pystatus = nullptr;
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
+      ThrowInvalidArguments("not a status object");
+      return nullptr;
+    }
+  }
+  std::string value;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  if (MayContainByBloomFilter(self, key.Get())) {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->Get(key.Get(), &value);
+  } else {
+    status.Set(tkrzw::Status::NOT_FOUND_ERROR);
+  }
+  if (pystatus != nullptr) {
+    *((PyTkStatus*)pystatus)->status = status;
+  }
+  if (status != tkrzw::Status::SUCCESS) {
+    Py_RETURN_NONE;
+  }
+  return CreatePyBytes(value);
+}
+
+// Implementation of DBM#GetStr.
+static PyObject* dbm_GetStr(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc < 1 || argc > 2) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
+  SoftString key(pykey);
+  PyObject* pystatus = nullptr;
+  if (argc > 1) {
+    pystatus = PyTuple_GET_ITEM(pyargs, 1);
+    if (pystatus == Py_None) {
+      pystatus = nullptr;
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
+      ThrowInvalidArguments("not a status object");
+      return nullptr;
+    }
+  }
+  std::string value;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  if (MayContainByBloomFilter(self, key.Get())) {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->Get(key.Get(), &value);
+  } else {
+    status.Set(tkrzw::Status::NOT_FOUND_ERROR);
+  }
+  if (pystatus != nullptr) {
+    *((PyTkStatus*)pystatus)->status = status;
+  }
+  if (status != tkrzw::Status::SUCCESS) {
+    Py_RETURN_NONE;
+  }
+  return CreatePyString(value);
+}
+
+// Implementation of DBM#GetObject.
+static PyObject* dbm_GetObject(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const std::shared_ptr<ObjectCache> cache = self->object_cache;
+  if (!cache->IsEnabled()) {
+    ThrowInvalidArguments("no object cache");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc < 1 || argc > 2) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
+  SoftString key(pykey);
+  PyObject* pystatus = nullptr;
+  if (argc > 1) {
+    pystatus = PyTuple_GET_ITEM(pyargs, 1);
+    if (pystatus == Py_None) {
+      pystatus = nullptr;
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
+      ThrowInvalidArguments("not a status object");
+      return nullptr;
+    }
+  }
+  PyObject* pyobj = cache->Get(key.Get());
+  if (pyobj != nullptr) {
+    if (pystatus != nullptr) {
+      ((PyTkStatus*)pystatus)->status->Set(tkrzw::Status::SUCCESS);
+    }
+    return pyobj;
+  }
+  const uint64_t epoch = cache->GetEpoch();
+  std::string value;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  if (MayContainByBloomFilter(self, key.Get())) {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->Get(key.Get(), &value);
+  } else {
+    status.Set(tkrzw::Status::NOT_FOUND_ERROR);
+  }
+  if (pystatus != nullptr) {
+    *((PyTkStatus*)pystatus)->status = status;
+  }
+  if (status != tkrzw::Status::SUCCESS) {
+    Py_RETURN_NONE;
+  }
+  // The decoder can reconfigure the cache, so it is referred to by the local pointers only.
+  PyObject* pydecoder = cache->GetDecoder();
+  if (pydecoder == nullptr) {
+    ThrowInvalidArguments("no object cache");
+    return nullptr;
+  }
+  PyObject* pyvalue = CreatePyBytes(value);
+  pyobj = PyObject_CallFunctionObjArgs(pydecoder, pyvalue, nullptr);
+  Py_DECREF(pyvalue);
+  Py_DECREF(pydecoder);
+  if (pyobj == nullptr) {
+    return nullptr;
+  }
+  cache->Put(key.Get(), pyobj, key.Get().size() + value.size(), epoch);
+  return pyobj;
+}
+
+// Implementation of DBM#GetMulti.
+static PyObject* dbm_GetMulti(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  std::vector<std::string> keys;
+  for (int32_t i = 0; i < argc; i++) {
+    PyObject* pykey = PyTuple_GET_ITEM(pyargs, i);
+    SoftString key(pykey);
+    if (MayContainByBloomFilter(self, key.Get())) {
+      keys.emplace_back(std::string(key.Get()));
+    }
+  }
+  std::vector<std::string_view> key_views(keys.begin(), keys.end());
+  std::map<std::string, std::string> records;
+  if (!key_views.empty()) {
+    NativeLock lock(self->concurrent);
+    self->dbm->GetMulti(key_views, &records);
+  }
+  PyObject* pyrv = PyDict_New();
+  for (const auto& rec : records) {
+    PyObject* pyname = CreatePyBytes(rec.first);
+    PyObject* pyvalue = CreatePyBytes(rec.second);
+    PyDict_SetItem(pyrv, pyname, pyvalue);
+    Py_DECREF(pyvalue);
+    Py_DECREF(pyname);
+  }
+  return pyrv;
+}
+
+// Implementation of DBM#GetMultiStr.
+static PyObject* dbm_GetMultiStr(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  std::vector<std::string> keys;
+  for (int32_t i = 0; i < argc; i++) {
+    PyObject* pykey = PyTuple_GET_ITEM(pyargs, i);
+    SoftString key(pykey);
+    if (MayContainByBloomFilter(self, key.Get())) {
+      keys.emplace_back(std::string(key.Get()));
+    }
+  }
+  std::vector<std::string_view> key_views(keys.begin(), keys.end());
+  std::map<std::string, std::string> records;
+  if (!key_views.empty()) {
+    NativeLock lock(self->concurrent);
+    self->dbm->GetMulti(key_views, &records);
+  }
+  PyObject* pyrv = PyDict_New();
+  for (const auto& rec : records) {
+    PyObject* pyname = CreatePyString(rec.first);
+    PyObject* pyvalue = CreatePyString(rec.second);
+    PyDict_SetItem(pyrv, pyname, pyvalue);
+    Py_DECREF(pyvalue);
+    Py_DECREF(pyname);
+  }
+  return pyrv;
+}
+
+// Implementation of DBM#Set.
+static PyObject* dbm_Set(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc < 2 || argc > 3) {
+    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
+  PyObject* pyvalue = PyTuple_GET_ITEM(pyargs, 1);
+  const bool overwrite = argc > 2 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 2)) : true;
+  SoftString key(pykey);
+  SoftString value(pyvalue);
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->Set(key.Get(), value.Get(), overwrite);
+  }
+  InvalidateObjectCache(self, key.Get());
+  AddToBloomFilter(self, key.Get());
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of DBM#SetMulti.
+static PyObject* dbm_SetMulti(PyDBM* self, PyObject* pyargs, PyObject* pykwds) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc > 1) {
+    ThrowInvalidArguments("too many arguments");
+    return nullptr;
+  }
+  PyObject* pyoverwrite = argc > 0 ? PyTuple_GET_ITEM(pyargs, 0) : Py_True;
+  const bool overwrite = PyObject_IsTrue(pyoverwrite);
+  std::map<std::string, std::string> records;
+  if (pykwds != nullptr) {
+    records = MapKeywords(pykwds);
+  }
+  std::map<std::string_view, std::string_view> record_views;
+  for (const auto& record : records) {
+    record_views.emplace(std::make_pair(
+        std::string_view(record.first), std::string_view(record.second)));
+  }
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->SetMulti(record_views, overwrite);
+  }
+  for (const auto& record : record_views) {
+    InvalidateObjectCache(self, record.first);
+    AddToBloomFilter(self, record.first);
+  }
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of DBM#SetAndGet.
+static PyObject* dbm_SetAndGet(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc < 2 || argc > 3) {
+    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
+  PyObject* pyvalue = PyTuple_GET_ITEM(pyargs, 1);
+  const bool overwrite = argc > 2 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 2)) : true;
+  SoftString key(pykey);
+  SoftString value(pyvalue);
+  tkrzw::Status impl_status(tkrzw::Status::SUCCESS);
+  std::string old_value;
+  bool hit = false;
+  class Processor final : public tkrzw::DBM::RecordProcessor {
+   public:
+    Processor(tkrzw::Status* status, std::string_view value, bool overwrite,
+              std::string* old_value, bool* hit)
+        : status_(status), value_(value), overwrite_(overwrite),
+          old_value_(old_value), hit_(hit) {}
+    std::string_view ProcessFull(std::string_view key, std::string_view value) override {
+      *old_value_ = value;
+      *hit_ = true;
+      if (overwrite_) {
+        return value_;
+      }
+      status_->Set(tkrzw::Status::DUPLICATION_ERROR);
+      return NOOP;
+    }
+    std::string_view ProcessEmpty(std::string_view key) override {
+      return value_;
+    }
+   private:
+    tkrzw::Status* status_;
+    std::string_view value_;
+    bool overwrite_;
+    std::string* old_value_;
+    bool* hit_;
+  };
+  Processor proc(&impl_status, value.Get(), overwrite, &old_value, &hit);
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->Process(key.Get(), &proc, true);
+  }
+  InvalidateObjectCache(self, key.Get());
+  AddToBloomFilter(self, key.Get());
+  status |= impl_status;
+  PyObject* pytuple = PyTuple_New(2);
+  PyTuple_SET_ITEM(pytuple, 0, CreatePyTkStatusMove(self, std::move(status)));
+  if (hit) {
+    PyObject* pyold_value = PyUnicode_Check(pyvalue) ?
+        CreatePyString(old_value) : CreatePyBytes(old_value);
+    PyTuple_SET_ITEM(pytuple, 1, pyold_value);
+  } else {
+    Py_INCREF(Py_None);
+    PyTuple_SET_ITEM(pytuple, 1, Py_None);
+  }
+  return pytuple;
+}
+
+// Implementation of DBM#Remove.
+static PyObject* dbm_Remove(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
+  SoftString key(pykey);
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->Remove(key.Get());
+  }
+  InvalidateObjectCache(self, key.Get());
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of DBM#RemoveMulti.
+static PyObject* dbm_RemoveMulti(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  std::vector<std::string> keys;
+  for (int32_t i = 0; i < argc; i++) {
+    PyObject* pykey = PyTuple_GET_ITEM(pyargs, i);
+    SoftString key(pykey);
+    keys.emplace_back(std::string(key.Get()));
+  }
+  std::vector<std::string_view> key_views(keys.begin(), keys.end());
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->RemoveMulti(key_views);
+  }
+  for (const auto& key : key_views) {
+    InvalidateObjectCache(self, key);
+  }
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of DBM#RemoveAndGet.
+static PyObject* dbm_RemoveAndGet(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
+  SoftString key(pykey);
+  tkrzw::Status impl_status(tkrzw::Status::SUCCESS);
+  std::string old_value;
+  class Processor final : public tkrzw::DBM::RecordProcessor {
+   public:
+    Processor(tkrzw::Status* status, std::string* old_value)
+        : status_(status), old_value_(old_value) {}
+    std::string_view ProcessFull(std::string_view key, std::string_view value) override {
+      *old_value_ = value;
+      return REMOVE;
+    }
+    std::string_view ProcessEmpty(std::string_view key) override {
+      status_->Set(tkrzw::Status::NOT_FOUND_ERROR);
+      return NOOP;
+    }
+   private:
+    tkrzw::Status* status_;
+    std::string* old_value_;
+  };
+  Processor proc(&impl_status, &old_value);
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->Process(key.Get(), &proc, true);
+  }
+  InvalidateObjectCache(self, key.Get());
+  status |= impl_status;
+  PyObject* pytuple = PyTuple_New(2);
+  const bool success = status == tkrzw::Status::SUCCESS;
+  PyTuple_SET_ITEM(pytuple, 0, CreatePyTkStatusMove(self, std::move(status)));
+  if (success) {
+    PyObject* pyold_value = PyUnicode_Check(pykey) ?
+        CreatePyString(old_value) : CreatePyBytes(old_value);
+    PyTuple_SET_ITEM(pytuple, 1, pyold_value);
+  } else {
+    Py_INCREF(Py_None);
+    PyTuple_SET_ITEM(pytuple, 1, Py_None);
+  }
+  return pytuple;
+}
+
+// Implementation of DBM#Append.
+static PyObject* dbm_Append(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc < 2 || argc > 3) {
+    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
+  PyObject* pyvalue = PyTuple_GET_ITEM(pyargs, 1);
+  PyObject* pydelim = argc > 2 ? PyTuple_GET_ITEM(pyargs, 2) : nullptr;
+  SoftString key(pykey);
+  SoftString value(pyvalue);
+  SoftString delim(pydelim == nullptr ? Py_None : pydelim);
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->Append(key.Get(), value.Get(), delim.Get());
+  }
+  InvalidateObjectCache(self, key.Get());
+  AddToBloomFilter(self, key.Get());
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of DBM#AppendMulti.
+static PyObject* dbm_AppendMulti(PyDBM* self, PyObject* pyargs, PyObject* pykwds) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc > 1) {
+    ThrowInvalidArguments("too many arguments");
+    return nullptr;
+  }
+  PyObject* pydelim = argc > 0 ? PyTuple_GET_ITEM(pyargs, 0) : nullptr;
+  SoftString delim(pydelim == nullptr ? Py_None : pydelim);
+  std::map<std::string, std::string> records;
+  if (pykwds != nullptr) {
+    records = MapKeywords(pykwds);
+  }
+  std::map<std::string_view, std::string_view> record_views;
+  for (const auto& record : records) {
+    record_views.emplace(std::make_pair(
+        std::string_view(record.first), std::string_view(record.second)));
+  }
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->AppendMulti(record_views, delim.Get());
+  }
+  for (const auto& record : record_views) {
+    InvalidateObjectCache(self, record.first);
+    AddToBloomFilter(self, record.first);
+  }
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of DBM#CompareExchange.
+static PyObject* dbm_CompareExchange(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 3) {
+    ThrowInvalidArguments(argc < 3 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
+  PyObject* pyexpected = PyTuple_GET_ITEM(pyargs, 1);
+  PyObject* pydesired = PyTuple_GET_ITEM(pyargs, 2);
+  SoftString key(pykey);
+  std::unique_ptr<SoftString> expected;
+  std::string_view expected_view;
+  if (pyexpected != Py_None) {
+    if (pyexpected == GetModuleState(self)->obj_dbm_any_data) {
+      expected_view = tkrzw::DBM::ANY_DATA;
+    } else {
+      expected = std::make_unique<SoftString>(pyexpected);
+      expected_view = expected->Get();
+    }
+  }
+  std::unique_ptr<SoftString> desired;
+  std::string_view desired_view;
+  if (pydesired != Py_None) {
+    if (pydesired == GetModuleState(self)->obj_dbm_any_data) {
+      desired_view = tkrzw::DBM::ANY_DATA;
+    } else {
+      desired = std::make_unique<SoftString>(pydesired);
+      desired_view = desired->Get();
+    }
+  }
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->CompareExchange(key.Get(), expected_view, desired_view);
+  }
+  InvalidateObjectCache(self, key.Get());
+  AddToBloomFilter(self, key.Get());
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of DBM#CompareExchangeAndGet.
+static PyObject* dbm_CompareExchangeAndGet(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 3) {
+    ThrowInvalidArguments(argc < 3 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
+  PyObject* pyexpected = PyTuple_GET_ITEM(pyargs, 1);
+  PyObject* pydesired = PyTuple_GET_ITEM(pyargs, 2);
+  SoftString key(pykey);
+  std::unique_ptr<SoftString> expected;
+  std::string_view expected_view;
+  if (pyexpected != Py_None) {
+    if (pyexpected == GetModuleState(self)->obj_dbm_any_data) {
+      expected_view = tkrzw::DBM::ANY_DATA;
+    } else {
+      expected = std::make_unique<SoftString>(pyexpected);
+      expected_view = expected->Get();
+    }
+  }
+  std::unique_ptr<SoftString> desired;
+  std::string_view desired_view;
+  if (pydesired != Py_None) {
+    if (pydesired == GetModuleState(self)->obj_dbm_any_data) {
+      desired_view = tkrzw::DBM::ANY_DATA;
+    } else {
+      desired = std::make_unique<SoftString>(pydesired);
+      desired_view = desired->Get();
+    }
+  }
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  std::string actual;
+  bool found = false;
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->CompareExchange(key.Get(), expected_view, desired_view, &actual, &found);
+  }
+  InvalidateObjectCache(self, key.Get());
+  AddToBloomFilter(self, key.Get());
+  PyObject* pytuple = PyTuple_New(2);
+  PyTuple_SET_ITEM(pytuple, 0, CreatePyTkStatusMove(self, std::move(status)));
+  if (found) {
+    PyObject* pyactual = PyUnicode_Check(pyexpected) || PyUnicode_Check(pydesired) ?
+        CreatePyString(actual) : CreatePyBytes(actual);
+    PyTuple_SET_ITEM(pytuple, 1, pyactual);
+  } else {
+    Py_INCREF(Py_None);
+    PyTuple_SET_ITEM(pytuple, 1, Py_None);
+  }
+  return pytuple;
+}
+
+// Implementation of DBM#Increment.
+static PyObject* dbm_Increment(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc < 1 || argc > 4) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
+  SoftString key(pykey);
+  int64_t inc = 1;
+  if (argc > 1) {
+    PyObject* pyinc = PyTuple_GET_ITEM(pyargs, 1);
+    inc = PyObjToInt(pyinc);
+  }
+  int64_t init = 0;
+  if (argc > 2) {
+    PyObject* pyinit = PyTuple_GET_ITEM(pyargs, 2);
+    init = PyObjToInt(pyinit);
+  }
+  PyObject* pystatus = nullptr;
+  if (argc > 3) {
+    pystatus = PyTuple_GET_ITEM(pyargs, 3);
+    if (pystatus == Py_None) {
+      pystatus = nullptr;
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
+      ThrowInvalidArguments("not a status object");
+      return nullptr;
+    }
+  }
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  int64_t current = 0;
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->Increment(key.Get(), inc, &current, init);
+  }
+  InvalidateObjectCache(self, key.Get());
+  AddToBloomFilter(self, key.Get());
+  if (pystatus != nullptr) {
+    *((PyTkStatus*)pystatus)->status = status;
+  }
+  if (status == tkrzw::Status::SUCCESS) {
+    return PyLong_FromLongLong(current);
+  }
+  Py_RETURN_NONE;
+}
+
+
+// Implementation of DBM#ProcessMulti.
+static PyObject* dbm_ProcessMulti(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  if (self->concurrent) {
+    return CreatePyTkStatusMove(self, tkrzw::Status(
+        tkrzw::Status::PRECONDITION_ERROR, "the concurrent mode is not supported"));
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 2) {
+    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pykfpairs = PyTuple_GET_ITEM(pyargs, 0);
+  const bool writable = PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 1));
+  if (!PySequence_Check(pykfpairs)) {
+    ThrowInvalidArguments("parameters must be sequences of tuples and strings and functions");
+    return nullptr;
+  }
+  const auto& kfpairs_ph = ExtractKFPairs(pykfpairs);
+  std::vector<std::pair<std::string_view, tkrzw::DBM::RecordProcessor*>> kfpairs;
+  kfpairs.reserve(kfpairs_ph.size());
+  for (const auto& key_proc : kfpairs_ph) {
+    auto kfpair = std::make_pair(std::string_view(key_proc.first), key_proc.second.get());
+    kfpairs.emplace_back(std::move(kfpair));
+  }
+  tkrzw::Status status = self->dbm->ProcessMulti(kfpairs, writable);
+  ClearObjectCache(self);
+  if (writable) {
+    for (const auto& kfpair : kfpairs) {
+      AddToBloomFilter(self, kfpair.first);
+    }
+  }
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of DBM#CompareExchangeMulti.
+static PyObject* dbm_CompareExchangeMulti(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 2) {
+    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pyexpected = PyTuple_GET_ITEM(pyargs, 0);
+  PyObject* pydesired = PyTuple_GET_ITEM(pyargs, 1);
+  if (!PySequence_Check(pyexpected) || !PySequence_Check(pydesired)) {
+    ThrowInvalidArguments("parameters must be sequences of strings");
+    return nullptr;
+  }
+  std::vector<std::string> expected_ph;
+  const auto& expected = ExtractSVPairs(self, pyexpected, &expected_ph);
+  std::vector<std::string> desired_ph;
+  const auto& desired = ExtractSVPairs(self, pydesired, &desired_ph);
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->CompareExchangeMulti(expected, desired);
+  }
+  ClearObjectCache(self);
+  for (const auto& record : desired) {
+    AddToBloomFilter(self, record.first);
+  }
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of DBM#Rekey.
+static PyObject* dbm_Rekey(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc < 2 || argc > 4) {
+    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pyold_key = PyTuple_GET_ITEM(pyargs, 0);
+  PyObject* pynew_key = PyTuple_GET_ITEM(pyargs, 1);
+  const bool overwrite = argc > 2 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 2)) : true;
+  const bool copying = argc > 3 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 3)) : false;
+  SoftString old_key(pyold_key);
+  SoftString new_key(pynew_key);
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->Rekey(old_key.Get(), new_key.Get(), overwrite, copying);
+  }
+  InvalidateObjectCache(self, old_key.Get());
+  InvalidateObjectCache(self, new_key.Get());
+  AddToBloomFilter(self, new_key.Get());
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of DBM#PopFirst.
+static PyObject* dbm_PopFirst(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc > 1) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pydata = PyTuple_GET_ITEM(pyargs, 0);
-  SoftString data(pydata);
-  uint64_t num_shards = tkrzw::UINT64MAX;
+  PyObject* pystatus = nullptr;
+  if (argc > 0) {
+    pystatus = PyTuple_GET_ITEM(pyargs, 0);
+    if (pystatus == Py_None) {
+      pystatus = nullptr;
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
+      ThrowInvalidArguments("not a status object");
+      return nullptr;
+    }
+  }  
+  std::string key, value;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->PopFirst(&key, &value);
+  }
+  InvalidateObjectCache(self, key);
+  if (pystatus != nullptr) {
+    *((PyTkStatus*)pystatus)->status = status;
+  }
+  if (status == tkrzw::Status::SUCCESS) {
+    PyObject* pykey = CreatePyBytes(key);
+    PyObject* pyvalue = CreatePyBytes(value);
+    PyObject * pyrv = PyTuple_Pack(2, pykey, pyvalue);
+    Py_DECREF(pyvalue);
+    Py_DECREF(pykey);
+    return pyrv;
+  }
+  Py_RETURN_NONE;
+}
+
+// Implementation of DBM#PopFirstStr.
+static PyObject* dbm_PopFirstStr(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
   if (argc > 1) {
-    PyObject* pynum = PyTuple_GET_ITEM(pyargs, 1);
-    num_shards = PyObjToInt(pynum);
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pystatus = nullptr;
+  if (argc > 0) {
+    pystatus = PyTuple_GET_ITEM(pyargs, 0);
+    if (pystatus == Py_None) {
+      pystatus = nullptr;
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
+      ThrowInvalidArguments("not a status object");
+      return nullptr;
+    }
+  }  
+  std::string key, value;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->PopFirst(&key, &value);
+  }
+  InvalidateObjectCache(self, key);
+  if (pystatus != nullptr) {
+    *((PyTkStatus*)pystatus)->status = status;
+  }
+  if (status == tkrzw::Status::SUCCESS) {
+    PyObject* pykey = CreatePyString(key);
+    PyObject* pyvalue = CreatePyString(value);
+    PyObject * pyrv = PyTuple_Pack(2, pykey, pyvalue);
+    Py_DECREF(pyvalue);
+    Py_DECREF(pykey);
+    return pyrv;
+  }
+  Py_RETURN_NONE;
+}
+
+// Implementation of DBM#PushLast.
+static PyObject* dbm_PushLast(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc < 1 || argc > 2) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pyvalue = PyTuple_GET_ITEM(pyargs, 0);
+  const double wtime = argc > 1 ? PyObjToDouble(PyTuple_GET_ITEM(pyargs, 1)) : -1;
+  SoftString value(pyvalue);
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->PushLast(value.Get(), wtime);
+  }
+  DisableBloomFilter(self);
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of DBM#ProcessEach.
+static PyObject* dbm_ProcessEach(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  if (self->concurrent) {
+    return CreatePyTkStatusMove(self, tkrzw::Status(
+        tkrzw::Status::PRECONDITION_ERROR, "the concurrent mode is not supported"));
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 2) {
+    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pyfunc = PyTuple_GET_ITEM(pyargs, 0);
+  const bool writable = PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 1));
+  if (!PyCallable_Check(pyfunc)) {
+    ThrowInvalidArguments("non callable is given");
+    return nullptr;
+  }
+  std::unique_ptr<SoftString> funcrvstr;
+  auto func = [&](std::string_view k, std::string_view v) -> std::string_view {
+    PyObject* pyfuncargs = PyTuple_New(2);
+    if (k.data() == tkrzw::DBM::RecordProcessor::NOOP.data()) {
+      Py_INCREF(Py_None);
+      PyTuple_SET_ITEM(pyfuncargs, 0, Py_None);
+    } else {
+      PyTuple_SET_ITEM(pyfuncargs, 0, CreatePyBytes(k));
+    }
+    if (v.data() == tkrzw::DBM::RecordProcessor::NOOP.data()) {
+      Py_INCREF(Py_None);
+      PyTuple_SET_ITEM(pyfuncargs, 1, Py_None);
+    } else {
+      PyTuple_SET_ITEM(pyfuncargs, 1, CreatePyBytes(v));
+    }
+    PyObject* pyfuncrv = PyObject_CallObject(pyfunc, pyfuncargs);
+    std::string_view funcrv = tkrzw::DBM::RecordProcessor::NOOP;
+    if (pyfuncrv != nullptr) {
+      if (pyfuncrv == Py_None) {
+        funcrv = tkrzw::DBM::RecordProcessor::NOOP;
+      } else if (pyfuncrv == Py_False) {
+        funcrv = tkrzw::DBM::RecordProcessor::REMOVE;
+      } else {
+        funcrvstr = std::make_unique<SoftString>(pyfuncrv);
+        funcrv = funcrvstr->Get();
+      }
+      Py_DECREF(pyfuncrv);
+    }
+    Py_DECREF(pyfuncargs);
+    return funcrv;
+  };
+  tkrzw::Status status = self->dbm->ProcessEach(func, writable);
+  ClearObjectCache(self);
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of DBM#Count.
+static PyObject* dbm_Count(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  int64_t count = -1;
+  {
+    NativeLock lock(self->concurrent);
+    count = self->dbm->CountSimple();
+  }
+  if (count >= 0) {
+    return PyLong_FromLongLong(count);
+  }
+  Py_RETURN_NONE;
+}
+
+// Implementation of DBM#GetFileSize.
+static PyObject* dbm_GetFileSize(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  int64_t file_size = -1;
+  {
+    NativeLock lock(self->concurrent);
+    file_size = self->dbm->GetFileSizeSimple();
+  }
+  if (file_size >= 0) {
+    return PyLong_FromLongLong(file_size);
+  }
+  Py_RETURN_NONE;
+}
+
+// Implementation of DBM#GetFilePath.
+static PyObject* dbm_GetFilePath(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  std::string path;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->GetFilePath(&path);
+  }
+  if (status == tkrzw::Status::SUCCESS) {
+    return CreatePyString(path);
+  }
+  Py_RETURN_NONE;
+}
+
+// Implementation of DBM#GetTimestamp.
+static PyObject* dbm_GetTimestamp(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  double timestamp = -1;
+  {
+    NativeLock lock(self->concurrent);
+    timestamp = self->dbm->GetTimestampSimple();
   }
-  if (num_shards == 0) {
-    num_shards = tkrzw::UINT64MAX;
+  if (timestamp >= 0) {
+    return PyFloat_FromDouble(timestamp);
   }
-  return PyLong_FromUnsignedLongLong(tkrzw::SecondaryHash(data.Get(), num_shards));
+  Py_RETURN_NONE;
 }
 
-// Implementation of Utility.EditDistanceLev.
-static PyObject* utility_EditDistanceLev(PyObject* self, PyObject* pyargs) {
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 2) {
-    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
+// Implementation of DBM#Clear.
+static PyObject* dbm_Clear(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
     return nullptr;
   }
-  PyObject* pyucsa = PyTuple_GET_ITEM(pyargs, 0);
-  PyObject* pyucsb = PyTuple_GET_ITEM(pyargs, 1);
-  if (!PyUnicode_Check(pyucsa) || PyUnicode_READY(pyucsa) != 0 || 
-      !PyUnicode_Check(pyucsb) || PyUnicode_READY(pyucsb) != 0) {
-    ThrowInvalidArguments("not Unicode arguments");
-    return nullptr;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->Clear();
+    status |= RebuildBloomFilter(self);
   }
-  const std::vector<uint32_t>& ucsa = PyUnicodeToUCS4(pyucsa);
-  const std::vector<uint32_t>& ucsb = PyUnicodeToUCS4(pyucsb);
-  return PyLong_FromLong(tkrzw::EditDistanceLev<std::vector<uint32_t>>(ucsa, ucsb));
+  ClearObjectCache(self);
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of Utility.SerializeInt.
-static PyObject* utility_SerializeInt(PyObject* self, PyObject* pyargs) {
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 1) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+// Implementation of DBM#Rebuild.
+static PyObject* dbm_Rebuild(PyDBM* self, PyObject* pyargs, PyObject* pykwds) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
     return nullptr;
   }
-  PyObject* pynum = PyTuple_GET_ITEM(pyargs, 0);
-  const int64_t num = PyObjToInt(pynum);
-  const std::string str = tkrzw::IntToStrBigEndian(num, sizeof(int64_t));
-  return CreatePyBytes(str);
-}
-
-// Implementation of Utility.DeserializeInt.
-static PyObject* utility_DeserializeInt(PyObject* self, PyObject* pyargs) {
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 1) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+  if (argc != 0) {
+    ThrowInvalidArguments("too many arguments");
     return nullptr;
   }
-  PyObject* pydata = PyTuple_GET_ITEM(pyargs, 0);
-  SoftString data(pydata);
-  const int64_t num = tkrzw::StrToIntBigEndian(data.Get());
-  return PyLong_FromLongLong(num);
+  std::map<std::string, std::string> params;
+  if (pykwds != nullptr) {
+    params = MapKeywords(pykwds);
+  }
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->RebuildAdvanced(params);
+    status |= RebuildBloomFilter(self);
+  }
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of Utility.SerializeFloat.
-static PyObject* utility_SerializeFloat(PyObject* self, PyObject* pyargs) {
+// Implementation of DBM#StartRebuild.
+static PyObject* dbm_StartRebuild(PyDBM* self, PyObject* pyargs, PyObject* pykwds) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 1) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+  if (argc != 0) {
+    ThrowInvalidArguments("too many arguments");
     return nullptr;
   }
-  PyObject* pynum = PyTuple_GET_ITEM(pyargs, 0);
-  const double num = PyObjToDouble(pynum);
-  const std::string str = tkrzw::FloatToStrBigEndian(num, sizeof(double));
-  return CreatePyBytes(str);
+  std::map<std::string, std::string> params;
+  double delay = 0;
+  bool low_priority = true;
+  if (pykwds != nullptr) {
+    params = MapKeywords(pykwds);
+    delay = tkrzw::StrToDouble(tkrzw::SearchMap(params, "delay", "0"));
+    low_priority = tkrzw::StrToBool(tkrzw::SearchMap(params, "low_priority", "true"));
+    params.erase("delay");
+    params.erase("low_priority");
+  }
+  PyTypeObject* pyjobtype = (PyTypeObject*)GetModuleState(self)->cls_rebuildjob;
+  PyRebuildJob* pyjob = (PyRebuildJob*)pyjobtype->tp_new(pyjobtype, nullptr, nullptr);
+  if (!pyjob) return nullptr;
+  Py_INCREF(self);
+  pyjob->pydbm = (PyObject*)self;
+  // The job keeps a reference to the database so the handle outlives the thread.  Close waits
+  // for the rebuilding with the exclusive lock.
+  // Shards are rebuilt one by one so that the job can be canceled between them.  The old Bloom
+  // filter stays valid after rebuilding, so it is kept if the job is canceled before its scan.
+  auto rebuilder = [self, params](
+      RebuildJob::Progress* progress, int64_t* size_before, int64_t* size_after) {
+    std::shared_lock<std::shared_mutex> lock(*self->mutex);
+    if (self->dbm == nullptr) {
+      return tkrzw::Status(tkrzw::Status::PRECONDITION_ERROR, "not opened database");
+    }
+    *size_before = self->dbm->GetFileSizeSimple();
+    const tkrzw::Status canceled(tkrzw::Status::CANCELED_ERROR, "canceled while running");
+    tkrzw::Status status(tkrzw::Status::SUCCESS);
+    if (self->num_shards > 0) {
+      tkrzw::ShardDBM* shard_dbm = static_cast<tkrzw::ShardDBM*>(self->dbm);
+      progress->num_parts.store(self->num_shards);
+      for (int32_t i = 0; i < self->num_shards && status == tkrzw::Status::SUCCESS; i++) {
+        if (progress->canceled.load()) {
+          status = canceled;
+          break;
+        }
+        status = shard_dbm->GetInternalDBM(i)->RebuildAdvanced(params);
+        progress->num_rebuilt_parts.fetch_add(1);
+      }
+    } else {
+      progress->num_parts.store(1);
+      status = self->dbm->RebuildAdvanced(params);
+      progress->num_rebuilt_parts.store(1);
+    }
+    if (status == tkrzw::Status::SUCCESS) {
+      if (progress->canceled.load()) {
+        status = canceled;
+      } else {
+        status = RebuildBloomFilter(self, &progress->num_scanned_keys);
+      }
+    }
+    *size_after = self->dbm->GetFileSizeSimple();
+    return status;
+  };
+  pyjob->job = new RebuildJob(std::move(rebuilder), delay, low_priority);
+  return (PyObject*)pyjob;
 }
 
-// Implementation of Utility.DeserializeFloat.
-static PyObject* utility_DeserializeFloat(PyObject* self, PyObject* pyargs) {
+// Implementation of DBM#StartMaintenance.
+static PyObject* dbm_StartMaintenance(PyDBM* self, PyObject* pyargs, PyObject* pykwds) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 1) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+  if (argc != 0) {
+    ThrowInvalidArguments("too many arguments");
     return nullptr;
   }
-  PyObject* pydata = PyTuple_GET_ITEM(pyargs, 0);
-  SoftString data(pydata);
-  const double num = tkrzw::StrToFloatBigEndian(data.Get());
-  return PyFloat_FromDouble(num);
-}
-
-// Defines the Utility class.
-static bool DefineUtility() {
-  static PyTypeObject pytype = {PyVarObject_HEAD_INIT(nullptr, 0)};
-  const size_t zoff = offsetof(PyTypeObject, tp_name);
-  std::memset((char*)&pytype + zoff, 0, sizeof(pytype) - zoff);
-  pytype.tp_name = "tkrzw.Utility";
-  pytype.tp_basicsize = sizeof(PyUtility);
-  pytype.tp_itemsize = 0;
-  pytype.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
-  pytype.tp_doc = "Library utilities.";
-  static PyMethodDef methods[] = {
-    {"GetMemoryCapacity", (PyCFunction)utility_GetMemoryCapacity, METH_CLASS | METH_NOARGS,
-     "Gets the memory capacity of the platform."},
-    {"GetMemoryUsage", (PyCFunction)utility_GetMemoryUsage, METH_CLASS | METH_NOARGS,
-     "Gets the current memory usage of the process."},
-    {"PrimaryHash", (PyCFunction)utility_PrimaryHash, METH_CLASS | METH_VARARGS,
-     "Primary hash function for the hash database."},
-    {"SecondaryHash", (PyCFunction)utility_SecondaryHash, METH_CLASS | METH_VARARGS,
-     "Secondary hash function for sharding."},
-    {"EditDistanceLev", (PyCFunction)utility_EditDistanceLev, METH_CLASS | METH_VARARGS,
-     "Gets the Levenshtein edit distance of two Unicode strings."},
-    {"SerializeInt", (PyCFunction)utility_SerializeInt, METH_CLASS | METH_VARARGS,
-     "Serializes an integer into a big-endian binary sequence."},
-    {"DeserializeInt", (PyCFunction)utility_DeserializeInt, METH_CLASS | METH_VARARGS,
-     "Deserializes a big-endian binary sequence into an integer."},
-    {"SerializeFloat", (PyCFunction)utility_SerializeFloat, METH_CLASS | METH_VARARGS,
-     "Serializes a floating-point number into a big-endian binary sequence."},
-    {"DeserializeFloat", (PyCFunction)utility_DeserializeFloat, METH_CLASS | METH_VARARGS,
-     "Deserializes a big-endian binary sequence into a floating-point number."},
-    {nullptr, nullptr, 0, nullptr},
+  std::map<std::string, std::string> params;
+  Maintainer::Config config;
+  if (pykwds != nullptr) {
+    params = MapKeywords(pykwds);
+    config.interval = tkrzw::StrToDouble(tkrzw::SearchMap(params, "interval", "60"));
+    config.sync_interval = tkrzw::StrToDouble(tkrzw::SearchMap(params, "sync_interval", "0"));
+    config.low_priority = tkrzw::StrToBool(tkrzw::SearchMap(params, "low_priority", "true"));
+    const std::string& window = tkrzw::SearchMap(params, "rebuild_window", "");
+    if (!window.empty() &&
+        !Maintainer::ParseWindow(window, &config.window_begin, &config.window_end)) {
+      return CreatePyTkStatusMove(self, tkrzw::Status(
+          tkrzw::Status::INVALID_ARGUMENT_ERROR, "invalid rebuild window"));
+    }
+    params.erase("interval");
+    params.erase("sync_interval");
+    params.erase("low_priority");
+    params.erase("rebuild_window");
+  }
+  if (config.interval <= 0) {
+    return CreatePyTkStatusMove(self, tkrzw::Status(
+        tkrzw::Status::INVALID_ARGUMENT_ERROR, "invalid interval"));
+  }
+  if (!self->dbm->IsWritable()) {
+    return CreatePyTkStatusMove(self, tkrzw::Status(
+        tkrzw::Status::PRECONDITION_ERROR, "not writable database"));
+  }
+  StopMaintainer(self);
+  // Close and dealloc stop the maintainer before the handle is deleted.  A check is skipped while
+  // Close holds the exclusive lock, so joining the thread never waits for the lock.
+  auto checker = [self, params](bool may_rebuild, bool should_sync) {
+    Maintainer::Result result;
+    if (!self->mutex->try_lock_shared()) {
+      return result;
+    }
+    std::shared_lock<std::shared_mutex> lock(*self->mutex, std::adopt_lock);
+    if (self->dbm == nullptr) {
+      return result;
+    }
+    result.checked = true;
+    if (may_rebuild && self->dbm->ShouldBeRebuiltSimple()) {
+      result.status |= self->dbm->RebuildAdvanced(params);
+      result.status |= RebuildBloomFilter(self);
+      result.rebuilt = true;
+    }
+    if (should_sync) {
+      result.status |= self->dbm->Synchronize(false);
+      result.synced = true;
+    }
+    return result;
   };
-  pytype.tp_methods = methods;
-  if (PyType_Ready(&pytype) != 0) return false;
-  cls_utility = (PyObject*)&pytype;
-  Py_INCREF(cls_utility);
-  if (!SetConstStr(cls_utility, "VERSION", tkrzw::PACKAGE_VERSION)) return false;
-  if (!SetConstStr(cls_utility, "OS_NAME", tkrzw::OS_NAME)) return false;
-  if (!SetConstLong(cls_utility, "PAGE_SIZE", tkrzw::PAGE_SIZE)) return false;
-  if (!SetConstLong(cls_utility, "INT32MIN", (int64_t)tkrzw::INT32MIN)) return false;
-  if (!SetConstLong(cls_utility, "INT32MAX", (int64_t)tkrzw::INT32MAX)) return false;
-  if (!SetConstUnsignedLong(cls_utility, "UINT32MAX", (uint64_t)tkrzw::UINT32MAX)) return false;
-  if (!SetConstLong(cls_utility, "INT64MIN", (int64_t)tkrzw::INT64MIN)) return false;
-  if (!SetConstLong(cls_utility, "INT64MAX", (int64_t)tkrzw::INT64MAX)) return false;
-  if (!SetConstUnsignedLong(cls_utility, "UINT64MAX", (uint64_t)tkrzw::UINT64MAX)) return false;
-  if (PyModule_AddObject(mod_tkrzw, "Utility", cls_utility) != 0) return false;
-  return true;
-}
-
-// Implementation of Status.new.
-static PyObject* status_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
-  PyTkStatus* self = (PyTkStatus*)pytype->tp_alloc(pytype, 0);
-  if (!self) return nullptr;
-  self->status = new tkrzw::Status();
-  return (PyObject*)self;
+  self->maintainer = new Maintainer(std::move(checker), config);
+  return CreatePyTkStatusMove(self, tkrzw::Status(tkrzw::Status::SUCCESS));
 }
 
-// Implementation of Status#dealloc.
-static void status_dealloc(PyTkStatus* self) {
-  delete self->status;
-  Py_TYPE(self)->tp_free((PyObject*)self);
+// Implementation of DBM#StopMaintenance.
+static PyObject* dbm_StopMaintenance(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->maintainer == nullptr) {
+    return CreatePyTkStatusMove(self, tkrzw::Status(
+        tkrzw::Status::PRECONDITION_ERROR, "no maintenance"));
+  }
+  StopMaintainer(self);
+  return CreatePyTkStatusMove(self, tkrzw::Status(tkrzw::Status::SUCCESS));
 }
 
-// Implementation of Status#__init__.
-static int status_init(PyTkStatus* self, PyObject* pyargs, PyObject* pykwds) {
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc > 2) {
-    ThrowInvalidArguments("too many arguments");
-    return -1;
-  }
-  tkrzw::Status::Code code = tkrzw::Status::SUCCESS;
-  if (argc > 0) {
-    PyObject* pycode = PyTuple_GET_ITEM(pyargs, 0);
-    code = (tkrzw::Status::Code)PyLong_AsLong(pycode);
+// Implementation of DBM#InspectMaintenance.
+static PyObject* dbm_InspectMaintenance(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->maintainer == nullptr) {
+    ThrowInvalidArguments("no maintenance");
+    return nullptr;
   }
-  if (argc > 1) {
-    PyObject* pymessage = PyTuple_GET_ITEM(pyargs, 1);
-    SoftString str(pymessage);
-    self->status->Set(code, str.Get());
-  } else {
-    self->status->Set(code);
+  const Maintainer::Config& config = self->maintainer->GetConfig();
+  const Maintainer::Stats stats = self->maintainer->GetStats();
+  std::vector<std::pair<std::string, std::string>> records;
+  records.emplace_back("interval", tkrzw::ToString(config.interval));
+  records.emplace_back("sync_interval", tkrzw::ToString(config.sync_interval));
+  if (config.window_begin != config.window_end) {
+    records.emplace_back("rebuild_window", tkrzw::SPrintF(
+        "%02d:%02d-%02d:%02d", config.window_begin / 60, config.window_begin % 60,
+        config.window_end / 60, config.window_end % 60));
+  }
+  records.emplace_back("low_priority", config.low_priority ? "true" : "false");
+  records.emplace_back("num_checks", tkrzw::ToString(stats.num_checks));
+  records.emplace_back("num_skips", tkrzw::ToString(stats.num_skips));
+  records.emplace_back("num_rebuilds", tkrzw::ToString(stats.num_rebuilds));
+  records.emplace_back("num_syncs", tkrzw::ToString(stats.num_syncs));
+  if (stats.last_rebuild_time > 0) {
+    records.emplace_back("last_rebuild_time", tkrzw::ToString(stats.last_rebuild_time));
+  }
+  records.emplace_back("last_status", tkrzw::Status::CodeName(stats.last_status.GetCode()));
+  PyObject* pyrv = PyDict_New();
+  for (const auto& record : records) {
+    PyObject* pyname = CreatePyString(record.first);
+    PyObject* pyvalue = CreatePyString(record.second);
+    PyDict_SetItem(pyrv, pyname, pyvalue);
+    Py_DECREF(pyvalue);
+    Py_DECREF(pyname);
   }
-  return 0;
-}
-
-// Implementation of Status#__repr__.
-static PyObject* status_repr(PyTkStatus* self) {
-  return CreatePyString(tkrzw::StrCat("<tkrzw.Status: ", *self->status, ">"));
+  return pyrv;
 }
 
-// Implementation of Status#__str__.
-static PyObject* status_str(PyTkStatus* self) {
-  return CreatePyString(tkrzw::ToString(*self->status));
+// Implementation of DBM#ShouldBeRebuilt.
+static PyObject* dbm_ShouldBeRebuilt(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  bool tobe = false;
+  {
+    NativeLock lock(self->concurrent);
+    tobe = self->dbm->ShouldBeRebuiltSimple();
+  }
+  return PyBool_FromLong(tobe);
 }
 
-// Implementation of Status#__richcmp__.
-static PyObject* status_richcmp(PyTkStatus* self, PyObject* pyrhs, int op) {
-  bool rv = false;
-  int32_t code = (int32_t)self->status->GetCode();
-  int32_t rcode = 0;
-  if (PyObject_IsInstance(pyrhs, cls_status)) {
-    PyTkStatus* pyrhs_status = (PyTkStatus*)pyrhs;
-    rcode = (int32_t)pyrhs_status->status->GetCode();
-  } else if (PyLong_Check(pyrhs)) {
-    rcode = (int32_t)PyLong_AsLong(pyrhs);
-  } else {
-    rcode = tkrzw::INT32MAX;
+// Implementation of DBM#Synchronize.
+static PyObject* dbm_Synchronize(PyDBM* self, PyObject* pyargs, PyObject* pykwds) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
   }
-  switch (op) {
-    case Py_LT: rv = code < rcode; break;
-    case Py_LE: rv = code <= rcode; break;
-    case Py_EQ: rv = code == rcode; break;
-    case Py_NE: rv = code != rcode; break;
-    case Py_GT: rv = code > rcode; break;
-    case Py_GE: rv = code >= rcode; break;
-    default: rv = false; break;
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
   }
-  if (rv) {
-    Py_RETURN_TRUE;
+  PyObject* pyhard = PyTuple_GET_ITEM(pyargs, 0);
+  const bool hard = PyObject_IsTrue(pyhard);
+  std::map<std::string, std::string> params;
+  if (pykwds != nullptr) {
+    params = MapKeywords(pykwds);
   }
-  Py_RETURN_FALSE;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->SynchronizeAdvanced(hard, nullptr, params);
+  }
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of Status#Set.
-static PyObject* status_Set(PyTkStatus* self, PyObject* pyargs) {
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc > 2) {
-    ThrowInvalidArguments("too many arguments");
+// Implementation of DBM#Commit.
+static PyObject* dbm_Commit(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
     return nullptr;
   }
-  tkrzw::Status::Code code = tkrzw::Status::SUCCESS;
-  if (argc > 0) {
-    PyObject* pycode = PyTuple_GET_ITEM(pyargs, 0);
-    code = (tkrzw::Status::Code)PyLong_AsLong(pycode);
-  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
   if (argc > 1) {
-    PyObject* pymessage = PyTuple_GET_ITEM(pyargs, 1);
-    SoftString str(pymessage);
-    self->status->Set(code, str.Get());
-  } else {
-    self->status->Set(code);
+    ThrowInvalidArguments("too many arguments");
+    return nullptr;
   }
-  Py_RETURN_NONE;
+  const bool hard = argc > 0 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 0)) : true;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(true);
+    status = self->committer->Commit(hard);
+  }
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of Status#Join.
-static PyObject* status_Join(PyTkStatus* self, PyObject* pyargs) {
+// Implementation of DBM#ApplyUpdateLog.
+static PyObject* dbm_ApplyUpdateLog(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 1) {
+  if (argc < 1 || argc > 3) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pyrht = PyTuple_GET_ITEM(pyargs, 0);
-  if (!PyObject_IsInstance(pyrht, cls_status)) {
-    ThrowInvalidArguments("the argument is not a Status");
+  PyObject* pymessages = PyTuple_GET_ITEM(pyargs, 0);
+  const int32_t server_id = argc > 1 ? PyObjToInt(PyTuple_GET_ITEM(pyargs, 1)) : -1;
+  const int32_t dbm_index = argc > 2 ? PyObjToInt(PyTuple_GET_ITEM(pyargs, 2)) : -1;
+  if (!PySequence_Check(pymessages)) {
+    ThrowInvalidArguments("messages must be a sequence");
     return nullptr;
   }
-  PyTkStatus* rht = (PyTkStatus*)pyrht;
-  (*self->status) |= (*rht->status);
-  Py_RETURN_NONE;
-}
-
-// Implementation of Status#GetCode.
-static PyObject* status_GetCode(PyTkStatus* self) {
-  return PyLong_FromLongLong(self->status->GetCode());
-}
-
-// Implementation of Status#GetMessage.
-static PyObject* status_GetMessage(PyTkStatus* self) {
-  return PyUnicode_FromString(self->status->GetMessage().c_str());
-}
-
-// Implementation of Status#IsOK.
-static PyObject* status_IsOK(PyTkStatus* self) {
-  if (*self->status == tkrzw::Status::SUCCESS) {
-    Py_RETURN_TRUE;
+  PyObject* pymsgseq = PySequence_Fast(pymessages, "");
+  if (pymsgseq == nullptr) {
+    return nullptr;
   }
-  Py_RETURN_FALSE;
+  std::vector<std::string> messages;
+  const int32_t num_messages = PySequence_Fast_GET_SIZE(pymsgseq);
+  messages.reserve(num_messages);
+  PyObject** pymsgitems = PySequence_Fast_ITEMS(pymsgseq);
+  for (int32_t i = 0; i < num_messages; i++) {
+    PyObject* pymsg = pymsgitems[i];
+    if (PyTuple_Check(pymsg) && PyTuple_GET_SIZE(pymsg) == 2) {
+      pymsg = PyTuple_GET_ITEM(pymsg, 1);
+    }
+    SoftString message(pymsg);
+    messages.emplace_back(std::string(message.Get()));
+  }
+  Py_DECREF(pymsgseq);
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    for (const auto& message : messages) {
+      tkrzw::DBMUpdateLoggerMQ::UpdateLog op;
+      status = tkrzw::DBMUpdateLoggerMQ::ParseUpdateLog(message, &op);
+      if (status != tkrzw::Status::SUCCESS) {
+        break;
+      }
+      if ((server_id >= 0 && op.server_id != server_id) ||
+          (dbm_index >= 0 && op.dbm_index != dbm_index)) {
+        continue;
+      }
+      switch (op.op_type) {
+        case tkrzw::DBMUpdateLoggerMQ::OP_SET:
+          status = self->dbm->Set(op.key, op.value);
+          AddToBloomFilter(self, op.key);
+          break;
+        case tkrzw::DBMUpdateLoggerMQ::OP_REMOVE:
+          status = self->dbm->Remove(op.key);
+          if (status == tkrzw::Status::NOT_FOUND_ERROR) {
+            status.Set(tkrzw::Status::SUCCESS);
+          }
+          break;
+        case tkrzw::DBMUpdateLoggerMQ::OP_CLEAR:
+          status = self->dbm->Clear();
+          status |= RebuildBloomFilter(self);
+          break;
+        default:
+          break;
+      }
+      if (status != tkrzw::Status::SUCCESS) {
+        break;
+      }
+    }
+  }
+  ClearObjectCache(self);
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of Status#OrDie.
-static PyObject* status_OrDie(PyTkStatus* self) {
-  if (*self->status != tkrzw::Status::SUCCESS) {
-    ThrowStatusException(*self->status);    
+// Implementation of DBM#CopyFileData.
+static PyObject* dbm_CopyFileData(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
     return nullptr;
   }
-  Py_RETURN_NONE;
-}
-
-// Implementation of Status.CodeName.
-static PyObject* status_CodeName(PyObject* self, PyObject* pyargs) {
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 1) {
+  if (argc < 1 || argc > 2) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pycode = PyTuple_GET_ITEM(pyargs, 0);
-  const tkrzw::Status::Code code = (tkrzw::Status::Code)PyLong_AsLong(pycode);
-  return CreatePyString(tkrzw::ToString(tkrzw::Status::CodeName(code)));
-}
-
-// Defines the Status class.
-static bool DefineStatus() {
-  static PyTypeObject pytype = {PyVarObject_HEAD_INIT(nullptr, 0)};
-  const size_t zoff = offsetof(PyTypeObject, tp_name);
-  std::memset((char*)&pytype + zoff, 0, sizeof(pytype) - zoff);
-  pytype.tp_name = "tkrzw.Status";
-  pytype.tp_basicsize = sizeof(PyTkStatus);
-  pytype.tp_itemsize = 0;
-  pytype.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
-  pytype.tp_doc = "Status of operations.";
-  pytype.tp_new = status_new;
-  pytype.tp_dealloc = (destructor)status_dealloc;
-  pytype.tp_init = (initproc)status_init;
-  pytype.tp_repr = (unaryfunc)status_repr;
-  pytype.tp_str = (unaryfunc)status_str;
-  pytype.tp_richcompare = (richcmpfunc)status_richcmp;
-  static PyMethodDef methods[] = {
-    {"Set", (PyCFunction)status_Set, METH_VARARGS,
-     "Set the code and the message."},
-    {"Join", (PyCFunction)status_Join, METH_VARARGS,
-     "Assigns the internal state only if the current state is success."},
-    {"GetCode", (PyCFunction)status_GetCode, METH_NOARGS,
-     "Gets the status code.."},
-    {"GetMessage", (PyCFunction)status_GetMessage, METH_NOARGS,
-     "Gets the status message."},
-    {"IsOK", (PyCFunction)status_IsOK, METH_NOARGS,
-     "Returns true if the status is success."},
-    {"OrDie", (PyCFunction)status_OrDie, METH_NOARGS,
-     "Raises a runtime error if the status is not success."},
-    {"CodeName", (PyCFunction)status_CodeName, METH_CLASS | METH_VARARGS,
-     "Gets the string name of a status code."},
-    {nullptr, nullptr, 0, nullptr},
-  };
-  pytype.tp_methods = methods;
-  if (PyType_Ready(&pytype) != 0) return false;
-  cls_status = (PyObject*)&pytype;
-  Py_INCREF(cls_status);
-  if (!SetConstLong(cls_status, "SUCCESS",
-                    (int64_t)tkrzw::Status::SUCCESS)) return false;
-  if (!SetConstLong(cls_status, "UNKNOWN_ERROR",
-                    (int64_t)tkrzw::Status::UNKNOWN_ERROR)) return false;
-  if (!SetConstLong(cls_status, "SYSTEM_ERROR",
-                    (int64_t)tkrzw::Status::SYSTEM_ERROR)) return false;
-  if (!SetConstLong(cls_status, "NOT_IMPLEMENTED_ERROR",
-                    (int64_t)tkrzw::Status::NOT_IMPLEMENTED_ERROR)) return false;
-  if (!SetConstLong(cls_status, "PRECONDITION_ERROR",
-                    (int64_t)tkrzw::Status::PRECONDITION_ERROR)) return false;
-  if (!SetConstLong(cls_status, "INVALID_ARGUMENT_ERROR",
-                    (int64_t)tkrzw::Status::INVALID_ARGUMENT_ERROR)) return false;
-  if (!SetConstLong(cls_status, "CANCELED_ERROR",
-                    (int64_t)tkrzw::Status::CANCELED_ERROR)) return false;
-  if (!SetConstLong(cls_status, "NOT_FOUND_ERROR",
-                    (int64_t)tkrzw::Status::NOT_FOUND_ERROR)) return false;
-  if (!SetConstLong(cls_status, "PERMISSION_ERROR",
-                    (int64_t)tkrzw::Status::PERMISSION_ERROR)) return false;
-  if (!SetConstLong(cls_status, "INFEASIBLE_ERROR",
-                    (int64_t)tkrzw::Status::INFEASIBLE_ERROR)) return false;
-  if (!SetConstLong(cls_status, "DUPLICATION_ERROR",
-                    (int64_t)tkrzw::Status::DUPLICATION_ERROR)) return false;
-  if (!SetConstLong(cls_status, "BROKEN_DATA_ERROR",
-                    (int64_t)tkrzw::Status::BROKEN_DATA_ERROR)) return false;
-  if (!SetConstLong(cls_status, "NETWORK_ERROR",
-                    (int64_t)tkrzw::Status::NETWORK_ERROR)) return false;
-  if (!SetConstLong(cls_status, "APPLICATION_ERROR",
-                    (int64_t)tkrzw::Status::APPLICATION_ERROR)) return false;
-  if (PyModule_AddObject(mod_tkrzw, "Status", cls_status) != 0) return false;
-  return true;
-}
-
-// Implementation of StatusException.new.
-static PyObject* expt_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
-  PyException* self = (PyException*)pytype->tp_alloc(pytype, 0);
-  if (!self) return nullptr;
-  self->pystatus = nullptr;
-  return (PyObject*)self;
+  PyObject* pydest = PyTuple_GET_ITEM(pyargs, 0);
+  bool sync_hard = false;
+  if (argc > 1) {
+    PyObject* pysync_hard = PyTuple_GET_ITEM(pyargs, 1);
+    sync_hard = PyObject_IsTrue(pysync_hard);
+  }
+  SoftString dest(pydest);
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->dbm->CopyFileData(std::string(dest.Get()), sync_hard);
+  }
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of StatusException#dealloc.
-static void expt_dealloc(PyException* self) {
-  if (self->pystatus) Py_DECREF(self->pystatus);
-  Py_TYPE(self)->tp_free((PyObject*)self);
+// Implementation of DBM#Snapshot.
+static PyObject* dbm_Snapshot(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc > 1) {
+    ThrowInvalidArguments("too many arguments");
+    return nullptr;
+  }
+  PyObject* pydest = argc > 0 ? PyTuple_GET_ITEM(pyargs, 0) : Py_None;
+  const bool is_file = !self->open_path->empty();
+  std::string dest_path;
+  if (is_file) {
+    dest_path = pydest == Py_None ?
+        MakeSnapshotPath(*self->open_path) : std::string(SoftString(pydest).Get());
+  }
+  PyDBM* snapshot = (PyDBM*)dbm_new((PyTypeObject*)GetModuleState(self)->cls_dbm, nullptr, nullptr);
+  if (!snapshot) return nullptr;
+  const bool sharded = self->open_params->count("num_shards") > 0;
+  if (sharded) {
+    snapshot->dbm = new tkrzw::ShardDBM();
+  } else {
+    snapshot->dbm = new tkrzw::PolyDBM();
+  }
+  snapshot->concurrent = self->concurrent;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    if (is_file) {
+      status = self->dbm->CopyFileData(dest_path, false);
+      if (status == tkrzw::Status::SUCCESS) {
+        status = snapshot->dbm->OpenAdvanced(
+            dest_path, false, tkrzw::File::OPEN_DEFAULT, *self->open_params);
+        if (status != tkrzw::Status::SUCCESS) {
+          RemoveSnapshotFiles(dest_path, sharded ? self->num_shards : 0);
+        }
+      }
+    } else {
+      status = snapshot->dbm->OpenAdvanced(
+          "", true, tkrzw::File::OPEN_DEFAULT, *self->open_params);
+      if (status == tkrzw::Status::SUCCESS) {
+        status = self->dbm->Export(snapshot->dbm);
+      }
+    }
+  }
+  if (status != tkrzw::Status::SUCCESS) {
+    Py_DECREF(snapshot);
+    ThrowStatusException(self, status);
+    return nullptr;
+  }
+  if (sharded && tkrzw::ShardDBM::GetNumberOfShards(dest_path, &snapshot->num_shards) !=
+      tkrzw::Status::SUCCESS) {
+    snapshot->num_shards = self->num_shards;
+  }
+  tkrzw::ParamDBM* snapshot_dbm = snapshot->dbm;
+  snapshot->committer = new GroupCommitter(
+      [snapshot_dbm](bool hard) { return snapshot_dbm->Synchronize(hard); }, 0);
+  // Only a copy at the path made by this method is removed when the handle is closed.
+  snapshot->is_snapshot = is_file && pydest == Py_None;
+  snapshot->open_path = new std::string(dest_path);
+  snapshot->open_params = new std::map<std::string, std::string>(*self->open_params);
+  return (PyObject*)snapshot;
 }
 
-// Implementation of StatusException#__init__.
-static int expt_init(PyException* self, PyObject* pyargs, PyObject* pykwds) {
+// Implementation of DBM#Backup.
+static PyObject* dbm_Backup(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 1) {
+  if (argc < 1 || argc > 5) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
-    return -1;
+    return nullptr;
   }
-  PyObject* pystatus = PyTuple_GET_ITEM(pyargs, 0);
-  if (!PyObject_IsInstance(pystatus, cls_status)) {
-    ThrowInvalidArguments("the argument is not a status");
-    return -1;
+  PyObject* pydest = PyTuple_GET_ITEM(pyargs, 0);
+  int64_t offset = argc > 1 ? std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 1))) : 0;
+  const double max_speed = argc > 2 ? PyObjToDouble(PyTuple_GET_ITEM(pyargs, 2)) : 0;
+  PyObject* pyprogress = argc > 3 ? PyTuple_GET_ITEM(pyargs, 3) : Py_None;
+  if (pyprogress != Py_None && !PyCallable_Check(pyprogress)) {
+    ThrowInvalidArguments("non callable is given");
+    return nullptr;
   }
-  Py_INCREF(pystatus);
-  self->pystatus = pystatus;
-  return 0;
-}
-
-// Implementation of StatusException#__repr__.
-static PyObject* expt_repr(PyException* self) {
-  const tkrzw::Status* status = ((PyTkStatus*)self->pystatus)->status;
-  return CreatePyString(tkrzw::StrCat("<tkrzw.StatusException: ", *status, ">"));
-}
-
-// Implementation of StatusException#__str__.
-static PyObject* expt_str(PyException* self) {
-  const tkrzw::Status* status = ((PyTkStatus*)self->pystatus)->status;
-  return CreatePyString(tkrzw::ToString(*status));
-}
-
-// Implementation of StatusException#GetStatus.
-static PyObject* expt_GetStatus(PyException* self) {
-  Py_INCREF(self->pystatus);
-  return self->pystatus;
-}
-
-// Defines the StatusException class.
-static bool DefineStatusException() {
-  static PyTypeObject pytype = {PyVarObject_HEAD_INIT(nullptr, 0)};
-  const size_t zoff = offsetof(PyTypeObject, tp_name);
-  std::memset((char*)&pytype + zoff, 0, sizeof(pytype) - zoff);
-  pytype.tp_name = "tkrzw.StatusException";
-  pytype.tp_basicsize = sizeof(PyException);
-  pytype.tp_itemsize = 0;
-  pytype.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
-  pytype.tp_doc = "Exception to convey the status of operations.";
-  pytype.tp_new = expt_new;
-  pytype.tp_dealloc = (destructor)expt_dealloc;
-  pytype.tp_init = (initproc)expt_init;
-  pytype.tp_repr = (unaryfunc)expt_repr;
-  pytype.tp_str = (unaryfunc)expt_str;
-  static PyMethodDef methods[] = {
-    {"GetStatus", (PyCFunction)expt_GetStatus, METH_NOARGS,
-     "Get the status object." },
-    {nullptr, nullptr, 0, nullptr}
+  const bool consistent = argc > 4 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 4)) : false;
+  PyFile* dest_pyfile = nullptr;
+  if (PyObject_IsInstance(pydest, GetModuleState(self)->cls_file)) {
+    dest_pyfile = (PyFile*)pydest;
+  }
+  HandleLock dest_lock(dest_pyfile == nullptr ? nullptr : dest_pyfile->mutex, false);
+  if (dest_pyfile != nullptr && dest_pyfile->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
+    return nullptr;
+  }
+  std::unique_ptr<FileRemapGuard> dest_remap_guard;
+  if (dest_pyfile != nullptr) {
+    dest_remap_guard = std::make_unique<FileRemapGuard>(dest_pyfile);
+    if (dest_remap_guard->GetStatus() != tkrzw::Status::SUCCESS) {
+      return CreatePyTkStatus(self, dest_remap_guard->GetStatus());
+    }
+  }
+  if (self->open_path->empty() || self->open_params->count("num_shards") > 0) {
+    return CreatePyTkStatusMove(self, tkrzw::Status(
+        tkrzw::Status::PRECONDITION_ERROR, "not a single file database"));
+  }
+  std::unique_ptr<tkrzw::File> dest_file_ph;
+  tkrzw::File* dest_file = nullptr;
+  if (dest_pyfile == nullptr) {
+    dest_file_ph = std::make_unique<tkrzw::PositionalParallelFile>();
+    dest_file = dest_file_ph.get();
+  } else {
+    dest_file = dest_pyfile->file;
+  }
+  std::string dest_path;
+  if (dest_pyfile == nullptr) {
+    dest_path = SoftString(pydest).Get();
+  }
+  auto src_file = std::make_unique<tkrzw::PositionalParallelFile>();
+  const int64_t chunk_size = max_speed > 0 ?
+      std::clamp<int64_t>(max_speed / 10, 4096, 1 << 20) : 1 << 20;
+  std::string buffer(chunk_size, 0);
+  int64_t total_size = 0;
+  int64_t done_size = offset;
+  double start_time = 0;
+  // These are called without the GIL.
+  const auto open_files = [&](const std::string& src_path) {
+    tkrzw::Status status = src_file->Open(src_path, false, tkrzw::File::OPEN_NO_LOCK);
+    if (status == tkrzw::Status::SUCCESS) {
+      status = src_file->GetSize(&total_size);
+      offset = std::min(offset, total_size);
+      done_size = offset;
+    }
+    if (status == tkrzw::Status::SUCCESS && dest_file_ph != nullptr) {
+      status = dest_file->Open(dest_path, true,
+                               offset > 0 ? tkrzw::File::OPEN_DEFAULT : tkrzw::File::OPEN_TRUNCATE);
+    }
+    if (status == tkrzw::Status::SUCCESS) {
+      status = dest_file->Truncate(offset);
+    }
+    start_time = tkrzw::GetWallTime();
+    return status;
   };
-  pytype.tp_methods = methods;
-  pytype.tp_base = (PyTypeObject*)PyExc_RuntimeError;
-  if (PyType_Ready(&pytype) != 0) return false;
-  cls_expt = (PyObject*)&pytype;
-  Py_INCREF(cls_expt);
-  if (PyModule_AddObject(mod_tkrzw, "StatusException", cls_expt) != 0) return false;
-  return true;
-}
-
-// Implementation of Future.new.
-static PyObject* future_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
-  PyFuture* self = (PyFuture*)pytype->tp_alloc(pytype, 0);
-  if (!self) return nullptr;
-  self->future = nullptr;
-  self->concurrent = false;
-  self->is_str = false;
-  return (PyObject*)self;
-}
-
-// Implementation of Future#dealloc.
-static void future_dealloc(PyFuture* self) {
-  delete self->future;
-  Py_TYPE(self)->tp_free((PyObject*)self);
-}
-
-// Implementation of Future#__init__.
-static int future_init(PyFuture* self, PyObject* pyargs, PyObject* pykwds) {
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 0) {
-    ThrowInvalidArguments("too many arguments");
-    return -1;
+  const auto copy_chunk = [&]() {
+    const int64_t size = std::min(chunk_size, total_size - done_size);
+    tkrzw::Status status = src_file->Read(done_size, buffer.data(), size);
+    if (status == tkrzw::Status::SUCCESS) {
+      status = dest_file->Write(done_size, buffer.data(), size);
+    }
+    if (status == tkrzw::Status::SUCCESS && max_speed > 0) {
+      const double wait_time =
+          (done_size + size - offset) / max_speed - (tkrzw::GetWallTime() - start_time);
+      if (wait_time > 0) {
+        tkrzw::Sleep(wait_time);
+      }
+    }
+    if (status == tkrzw::Status::SUCCESS) {
+      done_size += size;
+    }
+    return status;
+  };
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  if (consistent && self->dbm->IsWritable()) {
+    // The whole file is copied while the database is locked by synchronization, so that the copy
+    // is consistent.  Python code is not called there because other threads waiting for the
+    // database lock may hold the GIL.
+    FunctionFileProcessor proc([&](const std::string& path) {
+      status = open_files(path);
+      while (status == tkrzw::Status::SUCCESS && done_size < total_size) {
+        status = copy_chunk();
+      }
+    });
+    NativeLock lock(true);
+    status |= self->dbm->SynchronizeAdvanced(false, &proc);
+  } else {
+    NativeLock lock(true);
+    if (self->dbm->IsWritable()) {
+      status = self->dbm->Synchronize(false);
+    }
+    if (status == tkrzw::Status::SUCCESS) {
+      status = open_files(*self->open_path);
+    }
+  }
+  while (status == tkrzw::Status::SUCCESS && done_size < total_size) {
+    {
+      NativeLock lock(true);
+      status = copy_chunk();
+    }
+    if (status != tkrzw::Status::SUCCESS) {
+      break;
+    }
+    if (PyErr_CheckSignals() != 0) {
+      return nullptr;
+    }
+    if (pyprogress != Py_None) {
+      PyObject* pyrv = PyObject_CallFunction(
+          pyprogress, "LL", (long long)done_size, (long long)total_size);
+      if (pyrv == nullptr) {
+        return nullptr;
+      }
+      if (pyrv == Py_False) {
+        status = tkrzw::Status(tkrzw::Status::CANCELED_ERROR, "canceled by the progress function");
+      }
+      Py_DECREF(pyrv);
+    }
+  }
+  if (consistent && status == tkrzw::Status::SUCCESS && pyprogress != Py_None) {
+    PyObject* pyrv = PyObject_CallFunction(
+        pyprogress, "LL", (long long)done_size, (long long)total_size);
+    if (pyrv == nullptr) {
+      return nullptr;
+    }
+    Py_DECREF(pyrv);
+  }
+  {
+    NativeLock lock(true);
+    if (src_file->IsOpen()) {
+      status |= src_file->Close();
+    }
+    if (dest_file_ph != nullptr && dest_file->IsOpen()) {
+      status |= dest_file->Close();
+    }
   }
-  ThrowStatusException(tkrzw::Status(tkrzw::Status::NOT_IMPLEMENTED_ERROR));
-  return -1;
-}
-
-// Implementation of Future#__repr__.
-static PyObject* future_repr(PyFuture* self) {
-  const std::string& str = tkrzw::SPrintF("<tkrzw.Future: %p>", (void*)self->future);
-  return CreatePyString(str);
-}
-
-// Implementation of Future#__str__.
-static PyObject* future_str(PyFuture* self) {
-  const std::string& str = tkrzw::SPrintF("Future:%p", (void*)self->future);
-  return CreatePyString(str);
-}
-
-// Implementation of Future#__iter__.
-static PyObject* future_iter(PyFuture* self) {
-  Py_INCREF(self);  
-  return (PyObject*)self;
-}
-
-// Implementation of Future#__next__.
-static PyObject* future_iternext(PyFuture* self) {
-  PyErr_SetString(PyExc_StopIteration, "end of iteration");
-  return nullptr;
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of Future#__await__.
-static PyObject* future_await(PyFuture* self) {
+// Implementation of DBM#Export.
+static PyObject* dbm_Export(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pydest = PyTuple_GET_ITEM(pyargs, 0);
+  if (!PyObject_IsInstance(pydest, GetModuleState(self)->cls_dbm)) {
+    ThrowInvalidArguments("the argument is not a DBM");
+    return nullptr;
+  }
+  PyDBM* dest = (PyDBM*)pydest;
+  HandleLock dest_lock(dest == self ? nullptr : dest->mutex, false);
+  if (dest->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
     NativeLock lock(self->concurrent);
-    self->future->Wait();
+    status = self->dbm->Export(dest->dbm);
+    status |= RebuildBloomFilter(dest);
   }
-  self->concurrent = false;
-  Py_INCREF(self);  
-  return (PyObject*)self;
+  ClearObjectCache(dest);
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of Future#Wait.
-static PyObject* future_Wait(PyFuture* self, PyObject* pyargs) {
+// Implementation of DBM#ExportToFlatRecords.
+static PyObject* dbm_ExportToFlatRecords(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc > 1) {
-    ThrowInvalidArguments("too many arguments");
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  const double timeout = argc > 0 ? PyObjToDouble(PyTuple_GET_ITEM(pyargs, 0)) : -1.0;
-  bool ok = false;
-  {
-    NativeLock lock(self->concurrent);
-    ok = self->future->Wait(timeout);
+  PyObject* pydest_file = PyTuple_GET_ITEM(pyargs, 0);
+  if (!PyObject_IsInstance(pydest_file, GetModuleState(self)->cls_file)) {
+    ThrowInvalidArguments("the argument is not a File");
+    return nullptr;
   }
-  if (ok) {
-    self->concurrent = false;
-    Py_RETURN_TRUE;
+  PyFile* dest_file = (PyFile*)pydest_file;
+  HandleLock dest_lock(dest_file->mutex, false);
+  if (dest_file->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
+    return nullptr;
   }
-  Py_RETURN_FALSE;
-}
-
-// Implementation of Future#Get.
-static PyObject* future_Get(PyFuture* self) {
-  const auto& type = self->future->GetExtraType();
-  if (type == typeid(tkrzw::Status)) {
+  FileRemapGuard remap_guard(dest_file);
+  tkrzw::Status status = remap_guard.GetStatus();
+  if (status == tkrzw::Status::SUCCESS) {
     NativeLock lock(self->concurrent);
-    tkrzw::Status status = self->future->Get();
-    lock.Release();
-    delete self->future;
-    self->future = nullptr;
-    return CreatePyTkStatusMove(std::move(status));
+    status = tkrzw::ExportDBMToFlatRecords(self->dbm, dest_file->file);
   }
-  if (type == typeid(std::pair<tkrzw::Status, std::string>)) {
-    NativeLock lock(self->concurrent);
-    const auto& result = self->future->GetString();
-    lock.Release();
-    delete self->future;
-    self->future = nullptr;
-    PyObject* pyrv = PyTuple_New(2);
-    PyTuple_SET_ITEM(pyrv, 0, CreatePyTkStatus(std::move(result.first)));
-    if (self->is_str) {
-      PyTuple_SET_ITEM(pyrv, 1, CreatePyString(result.second));
-    } else {
-      PyTuple_SET_ITEM(pyrv, 1, CreatePyBytes(result.second));
-    }
-    return pyrv;
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of DBM#ImportFromFlatRecords.
+static PyObject* dbm_ImportFromFlatRecords(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
   }
-  if (type == typeid(std::pair<tkrzw::Status, std::pair<std::string, std::string>>)) {
-    NativeLock lock(self->concurrent);
-    const auto& result = self->future->GetStringPair();
-    lock.Release();
-    delete self->future;
-    self->future = nullptr;
-    PyObject* pyrv = PyTuple_New(3);
-    PyTuple_SET_ITEM(pyrv, 0, CreatePyTkStatus(std::move(result.first)));
-    if (self->is_str) {
-      PyTuple_SET_ITEM(pyrv, 1, CreatePyString(result.second.first));
-      PyTuple_SET_ITEM(pyrv, 2, CreatePyString(result.second.second));
-    } else {
-      PyTuple_SET_ITEM(pyrv, 1, CreatePyBytes(result.second.first));
-      PyTuple_SET_ITEM(pyrv, 2, CreatePyBytes(result.second.second));
-    }
-    return pyrv;
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
   }
-  if (type == typeid(std::pair<tkrzw::Status, std::vector<std::string>>)) {
-    NativeLock lock(self->concurrent);
-    const auto& result = self->future->GetStringVector();
-    lock.Release();
-    delete self->future;
-    self->future = nullptr;
-    PyObject* pyrv = PyTuple_New(2);
-    PyTuple_SET_ITEM(pyrv, 0, CreatePyTkStatus(std::move(result.first)));
-    PyObject* pylist = PyTuple_New(result.second.size());
-    for (size_t i = 0; i < result.second.size(); i++) {
-      if (self->is_str) {
-        PyTuple_SET_ITEM(pylist, i, CreatePyString(result.second[i]));
-      } else {
-        PyTuple_SET_ITEM(pylist, i, CreatePyBytes(result.second[i]));
-      }
-    }
-    PyTuple_SET_ITEM(pyrv, 1, pylist);
-    return pyrv;
+  PyObject* pysrc_file = PyTuple_GET_ITEM(pyargs, 0);
+  if (!PyObject_IsInstance(pysrc_file, GetModuleState(self)->cls_file)) {
+    ThrowInvalidArguments("the argument is not a File");
+    return nullptr;
   }
-  if (type == typeid(std::pair<tkrzw::Status, std::map<std::string, std::string>>)) {
-    NativeLock lock(self->concurrent);
-    const auto& result = self->future->GetStringMap();
-    lock.Release();
-    delete self->future;
-    self->future = nullptr;
-    PyObject* pyrv = PyTuple_New(2);
-    PyTuple_SET_ITEM(pyrv, 0, CreatePyTkStatus(std::move(result.first)));
-    PyObject* pydict = PyDict_New();
-    for (const auto& rec : result.second) {
-      if (self->is_str) {
-        PyObject* pykey = CreatePyString(rec.first);
-        PyObject* pyvalue = CreatePyString(rec.second);
-        PyDict_SetItem(pydict, pykey, pyvalue);
-        Py_DECREF(pyvalue);
-        Py_DECREF(pykey);
-      } else {
-        PyObject* pykey = CreatePyBytes(rec.first);
-        PyObject* pyvalue = CreatePyBytes(rec.second);
-        PyDict_SetItem(pydict, pykey, pyvalue);
-        Py_DECREF(pyvalue);
-        Py_DECREF(pykey);
-      }
-    }
-    PyTuple_SET_ITEM(pyrv, 1, pydict);
-    return pyrv;
+  PyFile* src_file = (PyFile*)pysrc_file;
+  HandleLock src_lock(src_file->mutex, false);
+  if (src_file->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
+    return nullptr;
   }
-  if (type == typeid(std::pair<tkrzw::Status, int64_t>)) {
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
     NativeLock lock(self->concurrent);
-    const auto& result = self->future->GetInteger();
-    lock.Release();
-    delete self->future;
-    self->future = nullptr;
-    PyObject* pyrv = PyTuple_New(2);
-    PyTuple_SET_ITEM(pyrv, 0, CreatePyTkStatus(std::move(result.first)));
-    PyTuple_SET_ITEM(pyrv, 1, PyLong_FromLongLong(result.second));
-    return pyrv;
+    status = tkrzw::ImportDBMFromFlatRecords(self->dbm, src_file->file);
+    status |= RebuildBloomFilter(self);
   }
-  ThrowStatusException(tkrzw::Status(tkrzw::Status::NOT_IMPLEMENTED_ERROR));
-  return nullptr;
-}
-
-// Defines the Future class.
-static bool DefineFuture() {
-  static PyTypeObject pytype = {PyVarObject_HEAD_INIT(nullptr, 0)};
-  const size_t zoff = offsetof(PyTypeObject, tp_name);
-  std::memset((char*)&pytype + zoff, 0, sizeof(pytype) - zoff);
-  pytype.tp_name = "tkrzw.Future";
-  pytype.tp_basicsize = sizeof(PyFuture);
-  pytype.tp_itemsize = 0;
-  pytype.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
-  pytype.tp_doc = "Future to monitor the result of asynchronous operations.";
-  pytype.tp_new = future_new;
-  pytype.tp_dealloc = (destructor)future_dealloc;
-  pytype.tp_init = (initproc)future_init;
-  pytype.tp_repr = (unaryfunc)future_repr;
-  pytype.tp_str = (unaryfunc)future_str;
-  static PyMethodDef methods[] = {
-    {"Wait", (PyCFunction)future_Wait, METH_VARARGS,
-     "Waits for the operation to be done."},
-    {"Get", (PyCFunction)future_Get, METH_NOARGS,
-     "Waits for the operation to be done and gets the result status." },
-    {nullptr, nullptr, 0, nullptr}
-  };
-  pytype.tp_methods = methods;
-  static PyAsyncMethods async_methods;
-  std::memset(&async_methods, 0, sizeof(async_methods));
-  async_methods.am_await = (unaryfunc)future_await;
-  pytype.tp_as_async = &async_methods;
-  static PyMappingMethods map_methods;
-  std::memset(&map_methods, 0, sizeof(map_methods));
-  pytype.tp_iter = (getiterfunc)future_iter;
-  pytype.tp_iternext = (iternextfunc)future_iternext;
-  pytype.tp_as_mapping = &map_methods;
-  if (PyType_Ready(&pytype) != 0) return false;
-  cls_future = (PyObject*)&pytype;
-  Py_INCREF(cls_future);
-  if (PyModule_AddObject(mod_tkrzw, "Future", cls_future) != 0) return false;
-  return true;
+  ClearObjectCache(self);
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of DBM.new.
-static PyObject* dbm_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
-  PyDBM* self = (PyDBM*)pytype->tp_alloc(pytype, 0);
-  if (!self) return nullptr;
-  self->dbm = nullptr;
-  self->concurrent = false;
-  return (PyObject*)self;
+// Runs tasks on separate threads and merges their statuses.
+static tkrzw::Status RunParallelTasks(
+    int32_t num_tasks, const std::function<tkrzw::Status(int32_t)>& task) {
+  if (num_tasks == 1) {
+    return task(0);
+  }
+  std::vector<tkrzw::Status> statuses(num_tasks);
+  std::vector<std::thread> threads;
+  threads.reserve(num_tasks);
+  for (int32_t i = 0; i < num_tasks; i++) {
+    threads.emplace_back([&, i]() { statuses[i] = task(i); });
+  }
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  for (int32_t i = 0; i < num_tasks; i++) {
+    threads[i].join();
+    status |= statuses[i];
+  }
+  return status;
 }
 
-// Implementation of DBM#dealloc.
-static void dbm_dealloc(PyDBM* self) {
-  delete self->dbm;
-  Py_TYPE(self)->tp_free((PyObject*)self);
+// Collects distinct opened files from a sequence and locks them in shared mode.
+// Returns the fast sequence holding the files, which the caller must release.
+static PyObject* CollectOpenedFiles(
+    const void* pyctx, PyObject* pyfiles, std::vector<PyFile*>* files,
+    std::vector<std::unique_ptr<HandleLock>>* locks) {
+  if (!PySequence_Check(pyfiles)) {
+    ThrowInvalidArguments("files must be a sequence");
+    return nullptr;
+  }
+  PyObject* pyfileseq = PySequence_Fast(pyfiles, "");
+  if (pyfileseq == nullptr) {
+    return nullptr;
+  }
+  const int32_t num_files = PySequence_Fast_GET_SIZE(pyfileseq);
+  PyObject** pyfileitems = PySequence_Fast_ITEMS(pyfileseq);
+  const char* error = nullptr;
+  for (int32_t i = 0; i < num_files; i++) {
+    PyObject* pyfile = pyfileitems[i];
+    if (!PyObject_IsInstance(pyfile, GetModuleState(pyctx)->cls_file)) {
+      error = "an element is not a File";
+      break;
+    }
+    PyFile* file = (PyFile*)pyfile;
+    if (std::find(files->begin(), files->end(), file) != files->end()) {
+      error = "duplicated files";
+      break;
+    }
+    locks->emplace_back(std::make_unique<HandleLock>(file->mutex, false));
+    if (file->file == nullptr) {
+      error = "not opened file";
+      break;
+    }
+    files->emplace_back(file);
+  }
+  if (error != nullptr) {
+    locks->clear();
+    Py_DECREF(pyfileseq);
+    ThrowInvalidArguments(error);
+    return nullptr;
+  }
+  return pyfileseq;
 }
 
-// Implementation of DBM#__init__.
-static int dbm_init(PyDBM* self, PyObject* pyargs, PyObject* pykwds) {
+// Implementation of DBM#ParallelExport.
+static PyObject* dbm_ParallelExport(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 0) {
-    ThrowInvalidArguments("too many arguments");
-    return -1;
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pydest = PyTuple_GET_ITEM(pyargs, 0);
+  if (!PyObject_IsInstance(pydest, GetModuleState(self)->cls_dbm)) {
+    ThrowInvalidArguments("the argument is not a DBM");
+    return nullptr;
+  }
+  PyDBM* dest = (PyDBM*)pydest;
+  if (dest == self) {
+    ThrowInvalidArguments("the destination is the source database");
+    return nullptr;
+  }
+  HandleLock dest_lock(dest->mutex, false);
+  if (dest->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    if (self->num_shards > 0) {
+      tkrzw::ShardDBM* shard_dbm = static_cast<tkrzw::ShardDBM*>(self->dbm);
+      status = RunParallelTasks(self->num_shards, [&](int32_t index) {
+        return shard_dbm->GetInternalDBM(index)->Export(dest->dbm);
+      });
+    } else {
+      status = self->dbm->Export(dest->dbm);
+    }
+    status |= RebuildBloomFilter(dest);
   }
-  return 0;
+  ClearObjectCache(dest);
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of DBM#__repr__.
-static PyObject* dbm_repr(PyDBM* self) {
-  std::string class_name = "unknown";
-  std::string path = "-";
-  int64_t num_records = -1;
-  if (self->dbm != nullptr) {
+// Implementation of DBM#ParallelExportToFlatRecords.
+static PyObject* dbm_ParallelExportToFlatRecords(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  std::vector<PyFile*> dest_files;
+  std::vector<std::unique_ptr<HandleLock>> dest_locks;
+  PyObject* pyfileseq =
+      CollectOpenedFiles(self, PyTuple_GET_ITEM(pyargs, 0), &dest_files, &dest_locks);
+  if (pyfileseq == nullptr) {
+    return nullptr;
+  }
+  const int32_t num_parts = std::max(self->num_shards, 1);
+  if (static_cast<int32_t>(dest_files.size()) != num_parts) {
+    dest_locks.clear();
+    Py_DECREF(pyfileseq);
+    ThrowInvalidArguments("the number of files doesn't match the number of shards");
+    return nullptr;
+  }
+  std::vector<std::unique_ptr<FileRemapGuard>> remap_guards;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  for (PyFile* dest_file : dest_files) {
+    remap_guards.emplace_back(std::make_unique<FileRemapGuard>(dest_file));
+    status |= remap_guards.back()->GetStatus();
+  }
+  if (status == tkrzw::Status::SUCCESS) {
     NativeLock lock(self->concurrent);
-    for (const auto& rec : self->dbm->Inspect()) {
-      if (rec.first == "class") {
-        class_name = rec.second;
-      } else if (rec.first == "path") {
-        path = rec.second;
-      }
-    }   
-    num_records = self->dbm->CountSimple();
+    status = RunParallelTasks(num_parts, [&](int32_t index) {
+      tkrzw::DBM* part = self->num_shards > 0 ?
+          static_cast<tkrzw::ShardDBM*>(self->dbm)->GetInternalDBM(index) : self->dbm;
+      return tkrzw::ExportDBMToFlatRecords(part, dest_files[index]->file);
+    });
   }
-  const std::string& str = tkrzw::StrCat(
-      "<tkrzw.DBM: class=", class_name,
-      " path=", tkrzw::StrEscapeC(path, true), " num_records=", num_records, ">");
-  return CreatePyString(str);
+  remap_guards.clear();
+  dest_locks.clear();
+  Py_DECREF(pyfileseq);
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of DBM#__str__.
-static PyObject* dbm_str(PyDBM* self) {
-  std::string class_name = "unknown";
-  std::string path = "-";
-  int64_t num_records = -1;
-  if (self->dbm != nullptr) {
+// Implementation of DBM#ParallelImportFromFlatRecords.
+static PyObject* dbm_ParallelImportFromFlatRecords(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  std::vector<PyFile*> src_files;
+  std::vector<std::unique_ptr<HandleLock>> src_locks;
+  PyObject* pyfileseq =
+      CollectOpenedFiles(self, PyTuple_GET_ITEM(pyargs, 0), &src_files, &src_locks);
+  if (pyfileseq == nullptr) {
+    return nullptr;
+  }
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
     NativeLock lock(self->concurrent);
-    for (const auto& rec : self->dbm->Inspect()) {
-      if (rec.first == "class") {
-        class_name = rec.second;
-      } else if (rec.first == "path") {
-        path = rec.second;
-      }
+    if (!src_files.empty()) {
+      status = RunParallelTasks(static_cast<int32_t>(src_files.size()), [&](int32_t index) {
+        return tkrzw::ImportDBMFromFlatRecords(self->dbm, src_files[index]->file);
+      });
     }
-    num_records = self->dbm->CountSimple();
+    status |= RebuildBloomFilter(self);
   }
-  const std::string& str = tkrzw::StrCat(
-      class_name, ":", tkrzw::StrEscapeC(path, true), ":", num_records);
-  return CreatePyString(str);
+  src_locks.clear();
+  Py_DECREF(pyfileseq);
+  ClearObjectCache(self);
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of DBM#Open.
-static PyObject* dbm_Open(PyDBM* self, PyObject* pyargs, PyObject* pykwds) {
-  if (self->dbm != nullptr) {
-    ThrowInvalidArguments("opened database");
+// Checks whether the database is a SkipDBM or consists of shards of SkipDBM.
+static bool IsSkipDBM(PyDBM* self) {
+  tkrzw::PolyDBM* poly_dbm = self->num_shards > 0 ?
+      static_cast<tkrzw::ShardDBM*>(self->dbm)->GetInternalDBM(0) :
+      static_cast<tkrzw::PolyDBM*>(self->dbm);
+  tkrzw::DBM* internal_dbm = poly_dbm->GetInternalDBM();
+  return internal_dbm != nullptr && internal_dbm->GetType() == typeid(tkrzw::SkipDBM);
+}
+
+// Implementation of DBM#BulkLoadSorted.
+static PyObject* dbm_BulkLoadSorted(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 2) {
-    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
+  if (argc < 1 || argc > 2) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pypath = PyTuple_GET_ITEM(pyargs, 0);
-  PyObject* pywritable = PyTuple_GET_ITEM(pyargs, 1);
-  SoftString path(pypath);
-  const bool writable = PyObject_IsTrue(pywritable);
-  int32_t num_shards = -1;
-  bool concurrent = false;
-  int32_t open_options = 0;
-  std::map<std::string, std::string> params;
-  if (pykwds != nullptr) {
-    params = MapKeywords(pykwds);
-    num_shards = tkrzw::StrToInt(tkrzw::SearchMap(params, "num_shards", "-1"));
-    if (tkrzw::StrToBool(tkrzw::SearchMap(params, "concurrent", "false"))) {
-      concurrent = true;
-    }
-    if (tkrzw::StrToBool(tkrzw::SearchMap(params, "truncate", "false"))) {
-      open_options |= tkrzw::File::OPEN_TRUNCATE;
-    }
-    if (tkrzw::StrToBool(tkrzw::SearchMap(params, "no_create", "false"))) {
-      open_options |= tkrzw::File::OPEN_NO_CREATE;
-    }
-    if (tkrzw::StrToBool(tkrzw::SearchMap(params, "no_wait", "false"))) {
-      open_options |= tkrzw::File::OPEN_NO_WAIT;
+  PyObject* pyrecords = PyTuple_GET_ITEM(pyargs, 0);
+  const int64_t sort_mem_size =
+      argc > 1 ? PyObjToInt(PyTuple_GET_ITEM(pyargs, 1)) : 256LL * 1024 * 1024;
+  if (!self->dbm->IsOrdered()) {
+    return CreatePyTkStatusMove(self, tkrzw::Status(
+        tkrzw::Status::NOT_IMPLEMENTED_ERROR, "the database is not ordered"));
+  }
+  PyObject* pyiter = PyObject_GetIter(pyrecords);
+  if (pyiter == nullptr) {
+    return nullptr;
+  }
+  constexpr size_t batch_size = 4096;
+  // An unsharded SkipDBM takes the sorted output through temporary files so that it doesn't
+  // sort the records again at the synchronization.
+  tkrzw::SkipDBM* skip_dbm = self->num_shards > 0 ? nullptr : dynamic_cast<tkrzw::SkipDBM*>(
+      static_cast<tkrzw::PolyDBM*>(self->dbm)->GetInternalDBM());
+  std::unique_ptr<SkipDBMBulkWriter> skip_writer;
+  std::unique_ptr<BulkLoader> loader_holder;
+  if (skip_dbm != nullptr) {
+    skip_writer = std::make_unique<SkipDBMBulkWriter>(skip_dbm);
+    SkipDBMBulkWriter* writer = skip_writer.get();
+    loader_holder = std::make_unique<BulkLoader>(
+        [writer](std::string_view key, std::string_view value) {
+          return writer->Set(key, value);
+        }, sort_mem_size);
+  } else {
+    loader_holder = std::make_unique<BulkLoader>(self->dbm, sort_mem_size);
+  }
+  BulkLoader& loader = *loader_holder;
+  std::vector<BulkLoader::Record> batch;
+  batch.reserve(batch_size);
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  bool error = false;
+  while (status == tkrzw::Status::SUCCESS) {
+    PyObject* pyrec = PyIter_Next(pyiter);
+    if (pyrec == nullptr) {
+      error = PyErr_Occurred() != nullptr;
+      break;
     }
-    if (tkrzw::StrToBool(tkrzw::SearchMap(params, "no_lock", "false"))) {
-      open_options |= tkrzw::File::OPEN_NO_LOCK;
+    if (!(PyTuple_Check(pyrec) || PyList_Check(pyrec)) || PySequence_Fast_GET_SIZE(pyrec) != 2) {
+      Py_DECREF(pyrec);
+      ThrowInvalidArguments("a record must be a pair of the key and the value");
+      error = true;
+      break;
     }
-    if (tkrzw::StrToBool(tkrzw::SearchMap(params, "sync_hard", "false"))) {
-      open_options |= tkrzw::File::OPEN_SYNC_HARD;
+    PyObject** pyrecitems = PySequence_Fast_ITEMS(pyrec);
+    SoftString key(pyrecitems[0]);
+    SoftString value(pyrecitems[1]);
+    batch.emplace_back(std::string(key.Get()), std::string(value.Get()));
+    Py_DECREF(pyrec);
+    if (batch.size() >= batch_size) {
+      NativeLock lock(self->concurrent);
+      status = loader.Add(&batch);
     }
-    params.erase("concurrent");
-    params.erase("truncate");
-    params.erase("no_create");
-    params.erase("no_wait");
-    params.erase("no_lock");
-    params.erase("sync_hard");
-  }
-  if (num_shards >= 0) {
-    self->dbm = new tkrzw::ShardDBM();
-  } else {
-    self->dbm = new tkrzw::PolyDBM();
   }
-  self->concurrent = concurrent;
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  Py_DECREF(pyiter);
   {
     NativeLock lock(self->concurrent);
-    status = self->dbm->OpenAdvanced(std::string(path.Get()), writable, open_options, params);
+    if (!error && status == tkrzw::Status::SUCCESS) {
+      status = loader.Add(&batch);
+      if (status == tkrzw::Status::SUCCESS) {
+        status = loader.Finish();
+      }
+      if (status == tkrzw::Status::SUCCESS && skip_writer != nullptr) {
+        status = skip_writer->Finish();
+      }
+      if (status == tkrzw::Status::SUCCESS && IsSkipDBM(self)) {
+        status = self->dbm->Synchronize(false);
+      }
+    }
+    status |= RebuildBloomFilter(self);
   }
-  if (status != tkrzw::Status::SUCCESS) {
-    delete self->dbm;
-    self->dbm = nullptr;
+  ClearObjectCache(self);
+  if (error) {
+    return nullptr;
   }
-  return CreatePyTkStatusMove(std::move(status));
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of DBM#Close.
-static PyObject* dbm_Close(PyDBM* self) {
+// Implementation of DBM#ExportKeysAsLines.
+static PyObject* dbm_ExportKeysAsLines(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->dbm == nullptr) {
     ThrowInvalidArguments("not opened database");
     return nullptr;
   }
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pydest_file = PyTuple_GET_ITEM(pyargs, 0);
+  if (!PyObject_IsInstance(pydest_file, GetModuleState(self)->cls_file)) {
+    ThrowInvalidArguments("the argument is not a File");
+    return nullptr;
+  }
+  PyFile* dest_file = (PyFile*)pydest_file;
+  HandleLock dest_lock(dest_file->mutex, false);
+  if (dest_file->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
+    return nullptr;
+  }
+  FileRemapGuard remap_guard(dest_file);
+  tkrzw::Status status = remap_guard.GetStatus();
+  if (status == tkrzw::Status::SUCCESS) {
+    NativeLock lock(self->concurrent);
+    status = tkrzw::ExportDBMKeysAsLines(self->dbm, dest_file->file);
+  }
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of DBM#Inspect.
+static PyObject* dbm_Inspect(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  std::vector<std::pair<std::string, std::string>> records;
   {
     NativeLock lock(self->concurrent);
-    status = self->dbm->Close();
+    records = self->dbm->Inspect();
   }
-  delete self->dbm;
-  self->dbm = nullptr;
-  return CreatePyTkStatusMove(std::move(status));
+  const int64_t num_commit_requests = self->committer->GetNumRequests();
+  if (num_commit_requests > 0) {
+    records.emplace_back("num_commit_requests", tkrzw::ToString(num_commit_requests));
+    records.emplace_back("num_commit_syncs", tkrzw::ToString(self->committer->GetNumSyncs()));
+  }
+  PyObject* pyrv = PyDict_New();
+  for (const auto& rec : records) {
+    PyObject* pyname = CreatePyString(rec.first);
+    PyObject* pyvalue = CreatePyString(rec.second);
+    PyDict_SetItem(pyrv, pyname, pyvalue);
+    Py_DECREF(pyvalue);
+    Py_DECREF(pyname);
+  }
+  return pyrv;
 }
 
-// Implementation of DBM#Process.
-static PyObject* dbm_Process(PyDBM* self, PyObject* pyargs) {
+// Implementation of DBM#IsOpen.
+static PyObject* dbm_IsOpen(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    Py_RETURN_FALSE;
+  }
+  Py_RETURN_TRUE;  
+}
+
+// Implementation of DBM#IsWritable.
+static PyObject* dbm_IsWritable(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->dbm == nullptr) {
     ThrowInvalidArguments("not opened database");
     return nullptr;
   }
-  if (self->concurrent) {
-    return CreatePyTkStatusMove(tkrzw::Status(
-        tkrzw::Status::PRECONDITION_ERROR, "the concurrent mode is not supported"));
+  const bool writable = self->dbm->IsWritable();
+  if (writable) {
+    Py_RETURN_TRUE;
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 3) {
-    ThrowInvalidArguments(argc < 3 ? "too few arguments" : "too many arguments");
+  Py_RETURN_FALSE;
+}
+
+// Implementation of DBM#IsHealthy.
+static PyObject* dbm_IsHealthy(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
     return nullptr;
   }
-  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
-  PyObject* pyfunc = PyTuple_GET_ITEM(pyargs, 1);
-  const bool writable = PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 2));
-  if (!PyCallable_Check(pyfunc)) {
-    ThrowInvalidArguments("non callable is given");
+  const bool healthy = self->dbm->IsHealthy();
+  if (healthy) {
+    Py_RETURN_TRUE;
+  }
+  Py_RETURN_FALSE;
+}
+
+// Implementation of DBM#IsOrdered.
+static PyObject* dbm_IsOrdered(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
     return nullptr;
   }
-  SoftString key(pykey);
-  std::unique_ptr<SoftString> funcrvstr;
-  auto func = [&](std::string_view k, std::string_view v) -> std::string_view {
-    PyObject* pyfuncargs = PyTuple_New(2);
-    PyTuple_SET_ITEM(pyfuncargs, 0, CreatePyBytes(k));
-    if (v.data() == tkrzw::DBM::RecordProcessor::NOOP.data()) {
-      Py_INCREF(Py_None);
-      PyTuple_SET_ITEM(pyfuncargs, 1, Py_None);
-    } else {
-      PyTuple_SET_ITEM(pyfuncargs, 1, CreatePyBytes(v));
-    }
-    PyObject* pyfuncrv = PyObject_CallObject(pyfunc, pyfuncargs);
-    std::string_view funcrv = tkrzw::DBM::RecordProcessor::NOOP;
-    if (pyfuncrv != nullptr) {
-      if (pyfuncrv == Py_None) {
-        funcrv = tkrzw::DBM::RecordProcessor::NOOP;
-      } else if (pyfuncrv == Py_False) {
-        funcrv = tkrzw::DBM::RecordProcessor::REMOVE;
-      } else {
-        funcrvstr = std::make_unique<SoftString>(pyfuncrv);
-        funcrv = funcrvstr->Get();
-      }
-      Py_DECREF(pyfuncrv);
-    }
-    Py_DECREF(pyfuncargs);
-    return funcrv;
-  };
-  tkrzw::Status status = self->dbm->Process(key.Get(), func, writable);
-  return CreatePyTkStatusMove(std::move(status));
+  const bool ordered = self->dbm->IsOrdered();
+  if (ordered) {
+    Py_RETURN_TRUE;
+  }
+  Py_RETURN_FALSE;
 }
 
-// Implementation of DBM#Get.
-static PyObject* dbm_Get(PyDBM* self, PyObject* pyargs) {
+// Implementation of DBM#Search.
+static PyObject* dbm_Search(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->dbm == nullptr) {
     ThrowInvalidArguments("not opened database");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 1 || argc > 2) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+  if (argc < 2 || argc > 3) {
+    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
-  SoftString key(pykey);
-  PyObject* pystatus = nullptr;
-  if (argc > 1) {
-    pystatus = PyTuple_GET_ITEM(pyargs, 1);
-    if (pystatus == Py_None) {
-      pystatus = nullptr;
-    } else if (!PyObject_IsInstance(pystatus, cls_status)) {
-      ThrowInvalidArguments("not a status object");
-      return nullptr;
-    }
+  PyObject* pymode = PyTuple_GET_ITEM(pyargs, 0);
+  PyObject* pypattern = PyTuple_GET_ITEM(pyargs, 1);
+  int32_t capacity = 0;
+  if (argc > 2) {
+    capacity = PyObjToInt(PyTuple_GET_ITEM(pyargs, 2));
   }
-  std::string value;
+  SoftString pattern(pypattern);
+  SoftString mode(pymode);
+  std::vector<std::string> keys;
   tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
     NativeLock lock(self->concurrent);
-    status = self->dbm->Get(key.Get(), &value);
-  }
-  if (pystatus != nullptr) {
-    *((PyTkStatus*)pystatus)->status = status;
+    status = tkrzw::SearchDBMModal(self->dbm, mode.Get(), pattern.Get(), &keys, capacity);
   }
   if (status != tkrzw::Status::SUCCESS) {
-    Py_RETURN_NONE;
+    ThrowStatusException(self, status);    
+    return nullptr;
   }
-  return CreatePyBytes(value);
+  PyObject* pyrv = PyList_New(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    PyList_SET_ITEM(pyrv, i, CreatePyString(keys[i]));
+  }
+  return pyrv;
 }
 
-// Implementation of DBM#GetStr.
-static PyObject* dbm_GetStr(PyDBM* self, PyObject* pyargs) {
+// Implementation of DBM#MakeIterator.
+static PyObject* dbm_MakeIterator(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->dbm == nullptr) {
     ThrowInvalidArguments("not opened database");
     return nullptr;
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 1 || argc > 2) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
-    return nullptr;
-  }
-  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
-  SoftString key(pykey);
-  PyObject* pystatus = nullptr;
-  if (argc > 1) {
-    pystatus = PyTuple_GET_ITEM(pyargs, 1);
-    if (pystatus == Py_None) {
-      pystatus = nullptr;
-    } else if (!PyObject_IsInstance(pystatus, cls_status)) {
-      ThrowInvalidArguments("not a status object");
-      return nullptr;
-    }
-  }
-  std::string value;
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  PyTypeObject* pyitertype = (PyTypeObject*)GetModuleState(self)->cls_iter;
+  PyIterator* pyiter = (PyIterator*)pyitertype->tp_alloc(pyitertype, 0);
+  if (!pyiter) return nullptr;
+  pyiter->mutex = NewHandleMutex();
+  new (&pyiter->object_cache) std::shared_ptr<ObjectCache>(self->object_cache);
   {
     NativeLock lock(self->concurrent);
-    status = self->dbm->Get(key.Get(), &value);
-  }
-  if (pystatus != nullptr) {
-    *((PyTkStatus*)pystatus)->status = status;
-  }
-  if (status != tkrzw::Status::SUCCESS) {
-    Py_RETURN_NONE;
+    pyiter->iter = self->dbm->MakeIterator().release();
   }
-  return CreatePyString(value);
+  pyiter->concurrent = self->concurrent;
+  RegisterForkHandle((PyObject*)pyiter, AbandonIteratorHandle);
+  return (PyObject*)pyiter;
 }
 
-// Implementation of DBM#GetMulti.
-static PyObject* dbm_GetMulti(PyDBM* self, PyObject* pyargs) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+// Implementation of DBM#SetObjectCache.
+static PyObject* dbm_SetObjectCache(PyDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc < 1 || argc > 2) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  std::vector<std::string> keys;
-  for (int32_t i = 0; i < argc; i++) {
-    PyObject* pykey = PyTuple_GET_ITEM(pyargs, i);
-    SoftString key(pykey);
-    keys.emplace_back(std::string(key.Get()));
+  PyObject* pydecoder = PyTuple_GET_ITEM(pyargs, 0);
+  const int64_t capacity = argc > 1 ? PyObjToInt(PyTuple_GET_ITEM(pyargs, 1)) : 1LL << 26;
+  if (pydecoder != Py_None && !PyCallable_Check(pydecoder)) {
+    ThrowInvalidArguments("the decoder is not callable");
+    return nullptr;
   }
-  std::vector<std::string_view> key_views(keys.begin(), keys.end());
-  std::map<std::string, std::string> records;
-  {
-    NativeLock lock(self->concurrent);
-    self->dbm->GetMulti(key_views, &records);
+  if (capacity < 1) {
+    ThrowInvalidArguments("invalid capacity");
+    return nullptr;
   }
+  self->object_cache->Configure(pydecoder == Py_None ? nullptr : pydecoder, capacity);
+  Py_RETURN_NONE;
+}
+
+// Implementation of DBM#InspectObjectCache.
+static PyObject* dbm_InspectObjectCache(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (!self->object_cache->IsEnabled()) {
+    ThrowInvalidArguments("no object cache");
+    return nullptr;
+  }
+  const ObjectCache::Stats stats = self->object_cache->GetStats();
+  const int64_t num_lookups = stats.num_hits + stats.num_misses;
+  const double hit_ratio = num_lookups > 0 ? stats.num_hits / (double)num_lookups : 0.0;
+  const std::vector<std::pair<const char*, PyObject*>> records = {
+    {"capacity", PyLong_FromLongLong(stats.capacity)},
+    {"size", PyLong_FromLongLong(stats.size)},
+    {"count", PyLong_FromLongLong(stats.count)},
+    {"num_hits", PyLong_FromLongLong(stats.num_hits)},
+    {"num_misses", PyLong_FromLongLong(stats.num_misses)},
+    {"num_evictions", PyLong_FromLongLong(stats.num_evictions)},
+    {"hit_ratio", PyFloat_FromDouble(hit_ratio)},
+  };
   PyObject* pyrv = PyDict_New();
   for (const auto& rec : records) {
-    PyObject* pyname = CreatePyBytes(rec.first);
-    PyObject* pyvalue = CreatePyBytes(rec.second);
-    PyDict_SetItem(pyrv, pyname, pyvalue);
-    Py_DECREF(pyvalue);
-    Py_DECREF(pyname);
+    PyDict_SetItemString(pyrv, rec.first, rec.second);
+    Py_DECREF(rec.second);
   }
   return pyrv;
 }
 
-// Implementation of DBM#GetMultiStr.
-static PyObject* dbm_GetMultiStr(PyDBM* self, PyObject* pyargs) {
+// Implementation of DBM#GetDescriptor.
+static PyObject* dbm_GetDescriptor(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->dbm == nullptr) {
     ThrowInvalidArguments("not opened database");
     return nullptr;
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  std::vector<std::string> keys;
-  for (int32_t i = 0; i < argc; i++) {
-    PyObject* pykey = PyTuple_GET_ITEM(pyargs, i);
-    SoftString key(pykey);
-    keys.emplace_back(std::string(key.Get()));
-  }
-  std::vector<std::string_view> key_views(keys.begin(), keys.end());
-  std::map<std::string, std::string> records;
-  {
-    NativeLock lock(self->concurrent);
-    self->dbm->GetMulti(key_views, &records);
+  if (self->open_path->empty()) {
+    ThrowStatusException(self, tkrzw::Status(
+        tkrzw::Status::PRECONDITION_ERROR, "on-memory database"));
+    return nullptr;
   }
-  PyObject* pyrv = PyDict_New();
-  for (const auto& rec : records) {
-    PyObject* pyname = CreatePyString(rec.first);
-    PyObject* pyvalue = CreatePyString(rec.second);
-    PyDict_SetItem(pyrv, pyname, pyvalue);
+  PyObject* pyparams = PyDict_New();
+  for (const auto& param : *self->open_params) {
+    PyObject* pyvalue = CreatePyString(param.second);
+    PyDict_SetItemString(pyparams, param.first.c_str(), pyvalue);
     Py_DECREF(pyvalue);
-    Py_DECREF(pyname);
   }
+  PyDict_SetItemString(pyparams, "no_wait", Py_True);
+  PyObject* pypath = CreatePyString(*self->open_path);
+  PyObject* pyrv = PyDict_New();
+  PyDict_SetItemString(pyrv, "path", pypath);
+  PyDict_SetItemString(pyrv, "params", pyparams);
+  Py_DECREF(pypath);
+  Py_DECREF(pyparams);
   return pyrv;
 }
 
-// Implementation of DBM#Set.
-static PyObject* dbm_Set(PyDBM* self, PyObject* pyargs) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+// Implementation of DBM#ParallelMap.
+static PyObject* dbm_ParallelMap(PyDBM* self, PyObject* pyargs) {
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc < 1 || argc > 2) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 2 || argc > 3) {
-    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
+  PyObject* pyfunc = PyTuple_GET_ITEM(pyargs, 0);
+  PyObject* pyprocesses = argc > 1 ? PyTuple_GET_ITEM(pyargs, 1) : Py_None;
+  if (!PyCallable_Check(pyfunc)) {
+    ThrowInvalidArguments("the function is not callable");
     return nullptr;
   }
-  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
-  PyObject* pyvalue = PyTuple_GET_ITEM(pyargs, 1);
-  const bool overwrite = argc > 2 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 2)) : true;
-  SoftString key(pykey);
-  SoftString value(pyvalue);
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->dbm->Set(key.Get(), value.Get(), overwrite);
+  const int32_t num_processes = pyprocesses == Py_None ?
+      std::max<int32_t>(1, std::thread::hardware_concurrency()) : PyObjToInt(pyprocesses);
+  if (num_processes < 1) {
+    ThrowInvalidArguments("invalid number of processes");
+    return nullptr;
   }
-  return CreatePyTkStatusMove(std::move(status));
+  int32_t num_parts = 1;
+  {
+    HandleLock handle_lock(self->mutex, false);
+    if (self->dbm == nullptr) {
+      ThrowInvalidArguments("not opened database");
+      return nullptr;
+    }
+    if (self->dbm->IsWritable()) {
+      ThrowStatusException(self, tkrzw::Status(
+          tkrzw::Status::PRECONDITION_ERROR, "writable database"));
+      return nullptr;
+    }
+    // Shards are assigned to the workers as they are.  Otherwise, each worker takes the records
+    // whose key hash falls in its part.
+    num_parts = self->num_shards > 0 ? self->num_shards : num_processes;
+  }
+  PyObject* pydesc = dbm_GetDescriptor(self);
+  if (pydesc == nullptr) {
+    return nullptr;
+  }
+  PyObject* pyworker = PyObject_GetAttrString(GetModuleState(self)->cls_dbm, "_MapPart");
+  if (pyworker == nullptr || !PyCallable_Check(pyworker)) {
+    Py_XDECREF(pyworker);
+    Py_DECREF(pydesc);
+    PyErr_Clear();
+    ThrowInvalidArguments("the worker function is not available");
+    return nullptr;
+  }
+  PyObject* pytasks = PyList_New(num_parts);
+  for (int32_t i = 0; i < num_parts; i++) {
+    PyList_SET_ITEM(pytasks, i, Py_BuildValue("(OOii)", pydesc, pyfunc, i, num_parts));
+  }
+  Py_DECREF(pydesc);
+  PyObject* pymp = PyImport_ImportModule("multiprocessing");
+  PyObject* pypool = nullptr;
+  if (pymp != nullptr) {
+    pypool = PyObject_CallMethod(pymp, "Pool", "i", std::min(num_processes, num_parts));
+    Py_DECREF(pymp);
+  }
+  PyObject* pyparts = nullptr;
+  if (pypool != nullptr) {
+    pyparts = PyObject_CallMethod(pypool, "starmap", "OO", pyworker, pytasks);
+    PyObject *pyexc_type = nullptr, *pyexc_value = nullptr, *pyexc_tb = nullptr;
+    PyErr_Fetch(&pyexc_type, &pyexc_value, &pyexc_tb);
+    Py_XDECREF(PyObject_CallMethod(pypool, pyparts == nullptr ? "terminate" : "close", nullptr));
+    Py_XDECREF(PyObject_CallMethod(pypool, "join", nullptr));
+    PyErr_Clear();
+    PyErr_Restore(pyexc_type, pyexc_value, pyexc_tb);
+    Py_DECREF(pypool);
+  }
+  Py_DECREF(pytasks);
+  Py_DECREF(pyworker);
+  if (pyparts == nullptr) {
+    return nullptr;
+  }
+  PyObject* pyrv = PyList_New(0);
+  const int32_t num_results = PyList_GET_SIZE(pyparts);
+  for (int32_t i = 0; i < num_results; i++) {
+    PyObject* pypart = PyList_GET_ITEM(pyparts, i);
+    PyList_SetSlice(pyrv, PY_SSIZE_T_MAX, PY_SSIZE_T_MAX, pypart);
+  }
+  Py_DECREF(pyparts);
+  return pyrv;
 }
 
-// Implementation of DBM#SetMulti.
-static PyObject* dbm_SetMulti(PyDBM* self, PyObject* pyargs, PyObject* pykwds) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+// Implementation of DBM._MapPart, which runs in a worker process of DBM#ParallelMap.
+static PyObject* dbm_MapPart(PyObject* self, PyObject* pyargs) {
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 4) {
+    ThrowInvalidArguments(argc < 4 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc > 1) {
-    ThrowInvalidArguments("too many arguments");
+  PyObject* pydesc = PyTuple_GET_ITEM(pyargs, 0);
+  PyObject* pyfunc = PyTuple_GET_ITEM(pyargs, 1);
+  const int32_t part = PyObjToInt(PyTuple_GET_ITEM(pyargs, 2));
+  const int32_t num_parts = PyObjToInt(PyTuple_GET_ITEM(pyargs, 3));
+  PyObject* pypath = PyDict_Check(pydesc) ? PyDict_GetItemString(pydesc, "path") : nullptr;
+  PyObject* pyparams = PyDict_Check(pydesc) ? PyDict_GetItemString(pydesc, "params") : nullptr;
+  if (pypath == nullptr || pyparams == nullptr || !PyDict_Check(pyparams)) {
+    ThrowInvalidArguments("invalid descriptor");
     return nullptr;
   }
-  PyObject* pyoverwrite = argc > 0 ? PyTuple_GET_ITEM(pyargs, 0) : Py_True;
-  const bool overwrite = PyObject_IsTrue(pyoverwrite);
-  std::map<std::string, std::string> records;
-  if (pykwds != nullptr) {
-    records = MapKeywords(pykwds);
+  if (num_parts < 1 || part < 0 || part >= num_parts) {
+    ThrowInvalidArguments("invalid part");
+    return nullptr;
   }
-  std::map<std::string_view, std::string_view> record_views;
-  for (const auto& record : records) {
-    record_views.emplace(std::make_pair(
-        std::string_view(record.first), std::string_view(record.second)));
+  const std::string path(SoftString(pypath).Get());
+  std::map<std::string, std::string> params = MapKeywords(pyparams);
+  const int32_t open_options = ExtractOpenOptions(&params);
+  const bool sharded = tkrzw::StrToInt(tkrzw::SearchMap(params, "num_shards", "-1")) >= 0;
+  std::unique_ptr<tkrzw::ParamDBM> dbm;
+  if (sharded) {
+    dbm = std::make_unique<tkrzw::ShardDBM>();
+  } else {
+    dbm = std::make_unique<tkrzw::PolyDBM>();
   }
   tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
-    NativeLock lock(self->concurrent);
-    status = self->dbm->SetMulti(record_views, overwrite);
+    NativeLock lock(true);
+    status = dbm->OpenAdvanced(path, false, open_options, params);
   }
-  return CreatePyTkStatusMove(std::move(status));
-}
-
-// Implementation of DBM#SetAndGet.
-static PyObject* dbm_SetAndGet(PyDBM* self, PyObject* pyargs) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+  if (status != tkrzw::Status::SUCCESS) {
+    ThrowStatusException(self, status);
+    return nullptr;
+  }
+  tkrzw::DBM* target = dbm.get();
+  int32_t num_filter_parts = num_parts;
+  int32_t num_shards = 0;
+  if (sharded && tkrzw::ShardDBM::GetNumberOfShards(path, &num_shards) ==
+      tkrzw::Status::SUCCESS && num_shards == num_parts) {
+    target = static_cast<tkrzw::ShardDBM*>(dbm.get())->GetInternalDBM(part);
+    num_filter_parts = 1;
+  }
+  PyObject* pyrv = PyList_New(0);
+  std::unique_ptr<tkrzw::DBM::Iterator> iter = target->MakeIterator();
+  std::string key, value;
+  status = iter->First();
+  while (status == tkrzw::Status::SUCCESS) {
+    status = iter->Get(&key, &value);
+    if (status != tkrzw::Status::SUCCESS) {
+      break;
+    }
+    if (num_filter_parts < 2 ||
+        tkrzw::SecondaryHash(key, num_filter_parts) % num_filter_parts == (uint64_t)part) {
+      PyObject* pykey = CreatePyBytes(key);
+      PyObject* pyvalue = CreatePyBytes(value);
+      PyObject* pyresult = PyObject_CallFunctionObjArgs(pyfunc, pykey, pyvalue, nullptr);
+      Py_DECREF(pyvalue);
+      Py_DECREF(pykey);
+      if (pyresult == nullptr) {
+        Py_DECREF(pyrv);
+        return nullptr;
+      }
+      if (pyresult != Py_None) {
+        PyList_Append(pyrv, pyresult);
+      }
+      Py_DECREF(pyresult);
+    }
+    status = iter->Next();
+  }
+  iter.reset();
+  if (status != tkrzw::Status::NOT_FOUND_ERROR) {
+    Py_DECREF(pyrv);
+    ThrowStatusException(self, status);
+    return nullptr;
+  }
+  {
+    NativeLock lock(true);
+    status = dbm->Close();
+  }
+  if (status != tkrzw::Status::SUCCESS) {
+    Py_DECREF(pyrv);
+    ThrowStatusException(self, status);
     return nullptr;
   }
+  return pyrv;
+}
+
+// Implementation of DBM.RestoreDatabase.
+static PyObject* dbm_RestoreDatabase(PyObject* self, PyObject* pyargs) {
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 2 || argc > 3) {
+  if (argc < 2 || argc > 5) {
     ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
-  PyObject* pyvalue = PyTuple_GET_ITEM(pyargs, 1);
-  const bool overwrite = argc > 2 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 2)) : true;
-  SoftString key(pykey);
-  SoftString value(pyvalue);
-  tkrzw::Status impl_status(tkrzw::Status::SUCCESS);
-  std::string old_value;
-  bool hit = false;
-  class Processor final : public tkrzw::DBM::RecordProcessor {
-   public:
-    Processor(tkrzw::Status* status, std::string_view value, bool overwrite,
-              std::string* old_value, bool* hit)
-        : status_(status), value_(value), overwrite_(overwrite),
-          old_value_(old_value), hit_(hit) {}
-    std::string_view ProcessFull(std::string_view key, std::string_view value) override {
-      *old_value_ = value;
-      *hit_ = true;
-      if (overwrite_) {
-        return value_;
-      }
-      status_->Set(tkrzw::Status::DUPLICATION_ERROR);
-      return NOOP;
-    }
-    std::string_view ProcessEmpty(std::string_view key) override {
-      return value_;
-    }
-   private:
-    tkrzw::Status* status_;
-    std::string_view value_;
-    bool overwrite_;
-    std::string* old_value_;
-    bool* hit_;
-  };
-  Processor proc(&impl_status, value.Get(), overwrite, &old_value, &hit);
+  SoftString old_file_path(PyTuple_GET_ITEM(pyargs, 0));
+  SoftString new_file_path(PyTuple_GET_ITEM(pyargs, 1));
+  SoftString class_name(argc > 2 ? PyTuple_GET_ITEM(pyargs, 2) : Py_None);
+  const int64_t end_offset = argc > 3 ? PyObjToInt(PyTuple_GET_ITEM(pyargs, 3)) : -1;
+  SoftString cipher_key(argc > 4 ? PyTuple_GET_ITEM(pyargs, 4) : Py_None);
   tkrzw::Status status(tkrzw::Status::SUCCESS);
+  int32_t num_shards = 0;
+  if (tkrzw::ShardDBM::GetNumberOfShards(std::string(old_file_path.Get()), &num_shards) ==
+      tkrzw::Status::SUCCESS) {
+    NativeLock lock(true);
+    status = tkrzw::ShardDBM::RestoreDatabase(
+        std::string(old_file_path.Get()), std::string(new_file_path.Get()),
+        std::string(class_name.Get()), end_offset, cipher_key.Get());
+  } else {
+    NativeLock lock(true);
+    status = tkrzw::PolyDBM::RestoreDatabase(
+        std::string(old_file_path.Get()), std::string(new_file_path.Get()),
+        std::string(class_name.Get()), end_offset, cipher_key.Get());
+  }
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of DBM#__len__.
+static Py_ssize_t dbm_len(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    return 0;
+  }
+  int64_t count = -1;
   {
     NativeLock lock(self->concurrent);
-    status = self->dbm->Process(key.Get(), &proc, true);
-  }
-  status |= impl_status;
-  PyObject* pytuple = PyTuple_New(2);
-  PyTuple_SET_ITEM(pytuple, 0, CreatePyTkStatusMove(std::move(status)));
-  if (hit) {
-    PyObject* pyold_value = PyUnicode_Check(pyvalue) ?
-        CreatePyString(old_value) : CreatePyBytes(old_value);
-    PyTuple_SET_ITEM(pytuple, 1, pyold_value);
-  } else {
-    Py_INCREF(Py_None);
-    PyTuple_SET_ITEM(pytuple, 1, Py_None);
+    count = self->dbm->CountSimple();
   }
-  return pytuple;
+  return std::max<int64_t>(count, 0);
 }
 
-// Implementation of DBM#Remove.
-static PyObject* dbm_Remove(PyDBM* self, PyObject* pyargs) {
+// Implementation of DBM#__getitem__.
+static PyObject* dbm_getitem(PyDBM* self, PyObject* pykey) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->dbm == nullptr) {
     ThrowInvalidArguments("not opened database");
     return nullptr;
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 1) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
-    return nullptr;
-  }
-  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
+  const bool is_unicode = PyUnicode_Check(pykey);
   SoftString key(pykey);
   tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
+  std::string value;
+  if (MayContainByBloomFilter(self, key.Get())) {
     NativeLock lock(self->concurrent);
-    status = self->dbm->Remove(key.Get());
+    status = self->dbm->Get(key.Get(), &value);
+  } else {
+    status.Set(tkrzw::Status::NOT_FOUND_ERROR);
   }
-  return CreatePyTkStatusMove(std::move(status));
+  if (status != tkrzw::Status::SUCCESS) {
+    ThrowStatusException(self, status);
+    return nullptr;
+  }
+  if (is_unicode) {
+    return CreatePyString(value);
+  }
+  return CreatePyBytes(value);
 }
 
-// Implementation of DBM#RemoveMulti.
-static PyObject* dbm_RemoveMulti(PyDBM* self, PyObject* pyargs) {
+// Implementation of DBM#__contains__.
+static int dbm_contains(PyDBM* self, PyObject* pykey) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->dbm == nullptr) {
     ThrowInvalidArguments("not opened database");
-    return nullptr;
+    return -1;
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  std::vector<std::string> keys;
-  for (int32_t i = 0; i < argc; i++) {
-    PyObject* pykey = PyTuple_GET_ITEM(pyargs, i);
-    SoftString key(pykey);
-    keys.emplace_back(std::string(key.Get()));
+  SoftString key(pykey);
+  if (!MayContainByBloomFilter(self, key.Get())) {
+    return 0;
   }
-  std::vector<std::string_view> key_views(keys.begin(), keys.end());
   tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
     NativeLock lock(self->concurrent);
-    status = self->dbm->RemoveMulti(key_views);
+    status = self->dbm->Get(key.Get());
   }
-  return CreatePyTkStatusMove(std::move(status));
+  if (status == tkrzw::Status::SUCCESS) {
+    return 1;
+  }
+  if (status == tkrzw::Status::NOT_FOUND_ERROR) {
+    return 0;
+  }
+  return -1;
 }
 
-// Implementation of DBM#RemoveAndGet.
-static PyObject* dbm_RemoveAndGet(PyDBM* self, PyObject* pyargs) {
+// Implementation of DBM#__setitem__ and DBM#__delitem__.
+static int dbm_setitem(PyDBM* self, PyObject* pykey, PyObject* pyvalue) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->dbm == nullptr) {
     ThrowInvalidArguments("not opened database");
-    return nullptr;
-  }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 1) {
-    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
-    return nullptr;
+    return -1;
   }
-  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
-  SoftString key(pykey);
-  tkrzw::Status impl_status(tkrzw::Status::SUCCESS);
-  std::string old_value;
-  class Processor final : public tkrzw::DBM::RecordProcessor {
-   public:
-    Processor(tkrzw::Status* status, std::string* old_value)
-        : status_(status), old_value_(old_value) {}
-    std::string_view ProcessFull(std::string_view key, std::string_view value) override {
-      *old_value_ = value;
-      return REMOVE;
+  if (pyvalue) {
+    SoftString key(pykey);
+    SoftString value(pyvalue);
+    tkrzw::Status status(tkrzw::Status::SUCCESS);
+    {
+      NativeLock lock(self->concurrent);
+      status = self->dbm->Set(key.Get(), value.Get());
     }
-    std::string_view ProcessEmpty(std::string_view key) override {
-      status_->Set(tkrzw::Status::NOT_FOUND_ERROR);
-      return NOOP;
+    InvalidateObjectCache(self, key.Get());
+    AddToBloomFilter(self, key.Get());
+    if (status != tkrzw::Status::SUCCESS) {
+      ThrowStatusException(self, status);
+      return -1;
     }
-   private:
-    tkrzw::Status* status_;
-    std::string* old_value_;
+  } else {
+    SoftString key(pykey);
+    tkrzw::Status status(tkrzw::Status::SUCCESS);
+    {
+      NativeLock lock(self->concurrent);
+      status = self->dbm->Remove(key.Get());
+    }
+    InvalidateObjectCache(self, key.Get());
+    if (status != tkrzw::Status::SUCCESS) {
+      ThrowStatusException(self, status);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// Implementation of DBM#__iter__.
+static PyObject* dbm_iter(PyDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
+  }
+  PyTypeObject* pyitertype = (PyTypeObject*)GetModuleState(self)->cls_iter;
+  PyIterator* pyiter = (PyIterator*)pyitertype->tp_alloc(pyitertype, 0);
+  if (!pyiter) return nullptr;
+  pyiter->mutex = NewHandleMutex();
+  new (&pyiter->object_cache) std::shared_ptr<ObjectCache>(self->object_cache);
+  {
+    NativeLock lock(self->concurrent);
+    pyiter->iter = self->dbm->MakeIterator().release();
+    pyiter->concurrent = self->concurrent;
+    pyiter->iter->First();
+  }
+  RegisterForkHandle((PyObject*)pyiter, AbandonIteratorHandle);
+  return (PyObject*)pyiter;
+}
+
+// Defines the DBM class.
+static bool DefineDBM(PyObject* module, ModuleState* state) {
+  static PyMethodDef methods[] = {
+    {"Open", (PyCFunction)dbm_Open, METH_VARARGS | METH_KEYWORDS,
+     "Opens a database file."},
+    {"Close", (PyCFunction)dbm_Close, METH_NOARGS,
+     "Closes the database file."},
+    {"Process", (PyCFunction)dbm_Process, METH_VARARGS,
+     "Processes a record with an arbitrary function."},
+    {"Get", (PyCFunction)dbm_Get, METH_VARARGS,
+     "Gets the value of a record of a key."},
+    {"GetStr", (PyCFunction)dbm_GetStr, METH_VARARGS,
+     "Gets the value of a record of a key, as a string."},
+    {"GetObject", (PyCFunction)dbm_GetObject, METH_VARARGS,
+     "Gets the object decoded from the value of a record of a key, using the cache."},
+    {"GetMulti", (PyCFunction)dbm_GetMulti, METH_VARARGS,
+     "Gets the values of multiple records of keys."},
+    {"GetMultiStr", (PyCFunction)dbm_GetMultiStr, METH_VARARGS,
+     "Gets the values of multiple records of keys, as strings."},
+    {"Set", (PyCFunction)dbm_Set, METH_VARARGS,
+     "Sets a record of a key and a value."},
+    {"SetMulti", (PyCFunction)dbm_SetMulti, METH_VARARGS | METH_KEYWORDS,
+     "Sets multiple records specified by an initializer list of pairs of strings."},
+    {"SetAndGet", (PyCFunction)dbm_SetAndGet, METH_VARARGS,
+     "Sets a record and get the old value."},
+    {"Remove", (PyCFunction)dbm_Remove, METH_VARARGS,
+     "Removes a record of a key."},
+    {"RemoveMulti", (PyCFunction)dbm_RemoveMulti, METH_VARARGS,
+     "Removes records of keys."},
+    {"RemoveAndGet", (PyCFunction)dbm_RemoveAndGet, METH_VARARGS,
+     "Removes a record and get the value."},
+    {"Append", (PyCFunction)dbm_Append, METH_VARARGS,
+     "Appends data at the end of a record of a key."},
+    {"AppendMulti", (PyCFunction)dbm_AppendMulti, METH_VARARGS | METH_KEYWORDS,
+     "Appends data to multiple records of the keyword arguments."},
+    {"CompareExchange", (PyCFunction)dbm_CompareExchange, METH_VARARGS,
+     "Compares the value of a record and exchanges if the condition meets."},
+    {"CompareExchangeAndGet", (PyCFunction)dbm_CompareExchangeAndGet, METH_VARARGS,
+     "Does compare-and-exchange and/or gets the old value of the record."},
+    {"Increment", (PyCFunction)dbm_Increment, METH_VARARGS,
+     "Increments the numeric value of a record."},
+    {"ProcessMulti", (PyCFunction)dbm_ProcessMulti, METH_VARARGS,
+     "Processes multiple records with arbitrary functions."},
+    {"CompareExchangeMulti", (PyCFunction)dbm_CompareExchangeMulti, METH_VARARGS,
+     "Compares the values of records and exchanges if the condition meets."},
+    {"Rekey", (PyCFunction)dbm_Rekey, METH_VARARGS,
+     "Changes the key of a record."},
+    {"PopFirst", (PyCFunction)dbm_PopFirst, METH_VARARGS,
+     "Gets the first record and removes it."},
+    {"PopFirstStr", (PyCFunction)dbm_PopFirstStr, METH_VARARGS,
+     "Gets the first record as strings and removes it."},
+    {"PushLast", (PyCFunction)dbm_PushLast, METH_VARARGS,
+     "Adds a record with a key of the current timestamp."},
+    {"ProcessEach", (PyCFunction)dbm_ProcessEach, METH_VARARGS,
+     "Processes each and every record in the database with an arbitrary function."},
+    {"Count", (PyCFunction)dbm_Count, METH_NOARGS,
+     "Gets the number of records."},
+    {"GetFileSize", (PyCFunction)dbm_GetFileSize, METH_NOARGS,
+     "Gets the current file size of the database."},
+    {"GetFilePath", (PyCFunction)dbm_GetFilePath, METH_NOARGS,
+     "Gets the path of the database file."},
+    {"GetTimestamp", (PyCFunction)dbm_GetTimestamp, METH_NOARGS,
+     "Gets the timestamp in seconds of the last modified time."},
+    {"Clear", (PyCFunction)dbm_Clear, METH_NOARGS,
+     "Removes all records."},
+    {"Rebuild", (PyCFunction)dbm_Rebuild, METH_VARARGS | METH_KEYWORDS,
+     "Rebuilds the entire database."},
+    {"StartRebuild", (PyCFunction)dbm_StartRebuild, METH_VARARGS | METH_KEYWORDS,
+     "Starts a job to rebuild the entire database in background."},
+    {"StartMaintenance", (PyCFunction)dbm_StartMaintenance, METH_VARARGS | METH_KEYWORDS,
+     "Starts a background thread to rebuild and synchronize the database automatically."},
+    {"StopMaintenance", (PyCFunction)dbm_StopMaintenance, METH_NOARGS,
+     "Stops the background maintenance thread."},
+    {"InspectMaintenance", (PyCFunction)dbm_InspectMaintenance, METH_NOARGS,
+     "Inspects the background maintenance."},
+    {"ShouldBeRebuilt", (PyCFunction)dbm_ShouldBeRebuilt, METH_NOARGS,
+     "Checks whether the database should be rebuilt."},
+    {"Synchronize", (PyCFunction)dbm_Synchronize, METH_VARARGS | METH_KEYWORDS,
+     "Synchronizes the content of the database to the file system."},
+    {"ApplyUpdateLog", (PyCFunction)dbm_ApplyUpdateLog, METH_VARARGS,
+     "Applies update log messages written by another database."},
+    {"Commit", (PyCFunction)dbm_Commit, METH_VARARGS,
+     "Makes the updates done before the call durable, sharing synchronization with others."},
+    {"CopyFileData", (PyCFunction)dbm_CopyFileData, METH_VARARGS,
+     "Copies the content of the database file to another file."},
+    {"Snapshot", (PyCFunction)dbm_Snapshot, METH_VARARGS,
+     "Makes a read-only database handle of a point-in-time copy."},
+    {"Backup", (PyCFunction)dbm_Backup, METH_VARARGS,
+     "Copies the database file to a file or a path, with a rate limit."},
+    {"Export", (PyCFunction)dbm_Export, METH_VARARGS,
+     "Exports all records to another database."},
+    {"ExportToFlatRecords", (PyCFunction)dbm_ExportToFlatRecords, METH_VARARGS,
+     "Exports all records of a database to a flat record file."},
+    {"ImportFromFlatRecords", (PyCFunction)dbm_ImportFromFlatRecords, METH_VARARGS,
+     "Imports records to a database from a flat record file."},
+    {"ParallelExport", (PyCFunction)dbm_ParallelExport, METH_VARARGS,
+     "Exports all records to another database, using one thread per shard."},
+    {"ParallelExportToFlatRecords", (PyCFunction)dbm_ParallelExportToFlatRecords, METH_VARARGS,
+     "Exports each shard to its own flat record file in parallel."},
+    {"ParallelImportFromFlatRecords", (PyCFunction)dbm_ParallelImportFromFlatRecords,
+     METH_VARARGS, "Imports records from flat record files in parallel."},
+    {"BulkLoadSorted", (PyCFunction)dbm_BulkLoadSorted, METH_VARARGS,
+     "Loads records in ascending order of the key, sorting them if necessary."},
+    {"ExportKeysAsLines", (PyCFunction)dbm_ExportKeysAsLines, METH_VARARGS,
+     "Exports the keys of all records as lines to a text file."},
+    {"Inspect", (PyCFunction)dbm_Inspect, METH_NOARGS,
+     "Inspects the database."},
+    {"IsOpen", (PyCFunction)dbm_IsOpen, METH_NOARGS,
+     "Checks whether the database is open."},
+    {"IsWritable", (PyCFunction)dbm_IsWritable, METH_NOARGS,
+     "Checks whether the database is writable."},
+    {"IsHealthy", (PyCFunction)dbm_IsHealthy, METH_NOARGS,
+     "Checks whether the database condition is healthy."},
+    {"IsOrdered", (PyCFunction)dbm_IsOrdered, METH_NOARGS,
+     "Checks whether ordered operations are supported."},
+    {"Search", (PyCFunction)dbm_Search, METH_VARARGS,
+     "Searches the database and get keys which match a pattern."},
+    {"MakeIterator", (PyCFunction)dbm_MakeIterator, METH_NOARGS,
+     "Makes an iterator for each record."},   
+    {"SetObjectCache", (PyCFunction)dbm_SetObjectCache, METH_VARARGS,
+     "Sets the cache of objects decoded from record values."},
+    {"InspectObjectCache", (PyCFunction)dbm_InspectObjectCache, METH_NOARGS,
+     "Inspects the cache of decoded objects."},
+    {"GetDescriptor", (PyCFunction)dbm_GetDescriptor, METH_NOARGS,
+     "Gets a picklable descriptor to open the database again in another process."},
+    {"ParallelMap", (PyCFunction)dbm_ParallelMap, METH_VARARGS,
+     "Applies a function to every record in parallel by worker processes."},
+    {"_MapPart", (PyCFunction)dbm_MapPart, METH_CLASS | METH_VARARGS,
+     "Applies a function to every record of a part of the database."},
+    {"RestoreDatabase", (PyCFunction)dbm_RestoreDatabase, METH_CLASS | METH_VARARGS,
+     "Makes an iterator for each record."},   
+    {nullptr, nullptr, 0, nullptr},
   };
-  Processor proc(&impl_status, &old_value);
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  static PyType_Slot slots[] = {
+    {Py_tp_doc, (void*)"Polymorphic database manager."},
+    {Py_tp_new, (void*)dbm_new},
+    {Py_tp_dealloc, (void*)dbm_dealloc},
+    {Py_tp_init, (void*)dbm_init},
+    {Py_tp_repr, (void*)dbm_repr},
+    {Py_tp_str, (void*)dbm_str},
+    {Py_tp_methods, (void*)methods},
+    {Py_mp_length, (void*)dbm_len},
+    {Py_mp_subscript, (void*)dbm_getitem},
+    {Py_mp_ass_subscript, (void*)dbm_setitem},
+    {Py_sq_contains, (void*)dbm_contains},
+    {Py_tp_iter, (void*)dbm_iter},
+    {0, nullptr},
+  };
+  static PyType_Spec spec = {
+    "tkrzw.DBM", sizeof(PyDBM), 0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, slots};
+  state->cls_dbm = PyType_FromModuleAndSpec(module, &spec, nullptr);
+  if (state->cls_dbm == nullptr) return false;
+  state->obj_dbm_any_data = PyBytes_FromStringAndSize("\0[ANY]\0", 7);
+  if (PyObject_GenericSetAttr(
+          state->cls_dbm, PyUnicode_FromString("ANY_DATA"), state->obj_dbm_any_data) != 0) {
+    return false;
+  }
+  if (PyModule_AddObjectRef(module, "DBM", state->cls_dbm) != 0) return false;
+  return true;
+}
+
+// Implementation of Iterator.new.
+static PyObject* iter_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
+  PyIterator* self = (PyIterator*)pytype->tp_alloc(pytype, 0);
+  if (!self) return nullptr;
+  self->mutex = NewHandleMutex();
+  self->iter = nullptr;
+  new (&self->object_cache) std::shared_ptr<ObjectCache>();
+  self->concurrent = false;
+  RegisterForkHandle((PyObject*)self, AbandonIteratorHandle);
+  return (PyObject*)self;
+}
+
+// Implementation of Iterator#dealloc.
+static void iter_dealloc(PyIterator* self) {
+  UnregisterForkHandle((PyObject*)self);
+  delete self->iter;
+  self->object_cache.~shared_ptr();
+  delete self->mutex;
+  PyTypeObject* pytype = Py_TYPE(self);
+  pytype->tp_free((PyObject*)self);
+  Py_DECREF(pytype);
+}
+
+// Implementation of Iterator#__init__.
+static int iter_init(PyIterator* self, PyObject* pyargs, PyObject* pykwds) {
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return -1;
+  }
+  PyObject* pydbm_obj = PyTuple_GET_ITEM(pyargs, 0);
+  if (!PyObject_IsInstance(pydbm_obj, GetModuleState(self)->cls_dbm)) {
+    ThrowInvalidArguments("the argument is not a DBM");
+    return -1;
+  }
+  PyDBM* pydbm = (PyDBM*)pydbm_obj;
+  HandleLock dbm_lock(pydbm->mutex, false);
   {
-    NativeLock lock(self->concurrent);
-    status = self->dbm->Process(key.Get(), &proc, true);
+    NativeLock lock(pydbm->concurrent);
+    self->iter = pydbm->dbm->MakeIterator().release();
   }
-  status |= impl_status;
-  PyObject* pytuple = PyTuple_New(2);
-  const bool success = status == tkrzw::Status::SUCCESS;
-  PyTuple_SET_ITEM(pytuple, 0, CreatePyTkStatusMove(std::move(status)));
-  if (success) {
-    PyObject* pyold_value = PyUnicode_Check(pykey) ?
-        CreatePyString(old_value) : CreatePyBytes(old_value);
-    PyTuple_SET_ITEM(pytuple, 1, pyold_value);
-  } else {
-    Py_INCREF(Py_None);
-    PyTuple_SET_ITEM(pytuple, 1, Py_None);
+  self->object_cache = pydbm->object_cache;
+  self->concurrent = pydbm->concurrent;
+  return 0;
+}
+
+// Implementation of Iterator#__repr__.
+static PyObject* iter_repr(PyIterator* self) {
+  HandleLock handle_lock(self->mutex, true);
+  std::string key;
+  {
+    NativeLock lock(self->concurrent);
+    const tkrzw::Status status = self->iter == nullptr ?
+        tkrzw::Status(tkrzw::Status::PRECONDITION_ERROR) : self->iter->Get(&key);
+    if (status != tkrzw::Status::SUCCESS) {
+      key = "(unlocated)";
+    }
   }
-  return pytuple;
+  return CreatePyString(tkrzw::StrCat(
+      "<tkrzw.Iterator: key=", tkrzw::StrEscapeC(key, true), ">"));
 }
 
-// Implementation of DBM#Append.
-static PyObject* dbm_Append(PyDBM* self, PyObject* pyargs) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
-    return nullptr;
+// Implementation of Iterator#__str__.
+static PyObject* iter_str(PyIterator* self) {
+  HandleLock handle_lock(self->mutex, true);
+  std::string key;
+  {
+    NativeLock lock(self->concurrent);
+    const tkrzw::Status status = self->iter == nullptr ?
+        tkrzw::Status(tkrzw::Status::PRECONDITION_ERROR) : self->iter->Get(&key);
+    if (status != tkrzw::Status::SUCCESS) {
+      key = "(unlocated)";
+    }
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 2 || argc > 3) {
-    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
+  return CreatePyString(tkrzw::StrEscapeC(key, true));
+}
+
+// Implementation of Iterator#First.
+static PyObject* iter_First(PyIterator* self) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->iter == nullptr) {
+    ThrowInvalidArguments("abandoned iterator");
     return nullptr;
   }
-  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
-  PyObject* pyvalue = PyTuple_GET_ITEM(pyargs, 1);
-  PyObject* pydelim = argc > 2 ? PyTuple_GET_ITEM(pyargs, 2) : nullptr;
-  SoftString key(pykey);
-  SoftString value(pyvalue);
-  SoftString delim(pydelim == nullptr ? Py_None : pydelim);
   tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
     NativeLock lock(self->concurrent);
-    status = self->dbm->Append(key.Get(), value.Get(), delim.Get());
+    status = self->iter->First();
   }
-  return CreatePyTkStatusMove(std::move(status));
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of DBM#AppendMulti.
-static PyObject* dbm_AppendMulti(PyDBM* self, PyObject* pyargs, PyObject* pykwds) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
-    return nullptr;
-  }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc > 1) {
-    ThrowInvalidArguments("too many arguments");
+// Implementation of Iterator#Last.
+static PyObject* iter_Last(PyIterator* self) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->iter == nullptr) {
+    ThrowInvalidArguments("abandoned iterator");
     return nullptr;
   }
-  PyObject* pydelim = argc > 0 ? PyTuple_GET_ITEM(pyargs, 0) : nullptr;
-  SoftString delim(pydelim == nullptr ? Py_None : pydelim);
-  std::map<std::string, std::string> records;
-  if (pykwds != nullptr) {
-    records = MapKeywords(pykwds);
-  }
-  std::map<std::string_view, std::string_view> record_views;
-  for (const auto& record : records) {
-    record_views.emplace(std::make_pair(
-        std::string_view(record.first), std::string_view(record.second)));
-  }
   tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
     NativeLock lock(self->concurrent);
-    status = self->dbm->AppendMulti(record_views, delim.Get());
+    status = self->iter->Last();
   }
-  return CreatePyTkStatusMove(std::move(status));
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of DBM#CompareExchange.
-static PyObject* dbm_CompareExchange(PyDBM* self, PyObject* pyargs) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+// Implementation of Iterator#Jump.
+static PyObject* iter_Jump(PyIterator* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->iter == nullptr) {
+    ThrowInvalidArguments("abandoned iterator");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 3) {
-    ThrowInvalidArguments(argc < 3 ? "too few arguments" : "too many arguments");
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
   PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
-  PyObject* pyexpected = PyTuple_GET_ITEM(pyargs, 1);
-  PyObject* pydesired = PyTuple_GET_ITEM(pyargs, 2);
   SoftString key(pykey);
-  std::unique_ptr<SoftString> expected;
-  std::string_view expected_view;
-  if (pyexpected != Py_None) {
-    if (pyexpected == obj_dbm_any_data) {
-      expected_view = tkrzw::DBM::ANY_DATA;
-    } else {
-      expected = std::make_unique<SoftString>(pyexpected);
-      expected_view = expected->Get();
-    }
-  }
-  std::unique_ptr<SoftString> desired;
-  std::string_view desired_view;
-  if (pydesired != Py_None) {
-    if (pydesired == obj_dbm_any_data) {
-      desired_view = tkrzw::DBM::ANY_DATA;
-    } else {
-      desired = std::make_unique<SoftString>(pydesired);
-      desired_view = desired->Get();
-    }
-  }
   tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
     NativeLock lock(self->concurrent);
-    status = self->dbm->CompareExchange(key.Get(), expected_view, desired_view);
+    status = self->iter->Jump(key.Get());
   }
-  return CreatePyTkStatusMove(std::move(status));
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of DBM#CompareExchangeAndGet.
-static PyObject* dbm_CompareExchangeAndGet(PyDBM* self, PyObject* pyargs) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+// Implementation of Iterator#JumpLower.
+static PyObject* iter_JumpLower(PyIterator* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->iter == nullptr) {
+    ThrowInvalidArguments("abandoned iterator");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 3) {
-    ThrowInvalidArguments(argc < 3 ? "too few arguments" : "too many arguments");
+  if (argc < 1 || argc > 2) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
   PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
-  PyObject* pyexpected = PyTuple_GET_ITEM(pyargs, 1);
-  PyObject* pydesired = PyTuple_GET_ITEM(pyargs, 2);
+  const bool inclusive = argc > 1 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 1)) : false;
   SoftString key(pykey);
-  std::unique_ptr<SoftString> expected;
-  std::string_view expected_view;
-  if (pyexpected != Py_None) {
-    if (pyexpected == obj_dbm_any_data) {
-      expected_view = tkrzw::DBM::ANY_DATA;
-    } else {
-      expected = std::make_unique<SoftString>(pyexpected);
-      expected_view = expected->Get();
-    }
-  }
-  std::unique_ptr<SoftString> desired;
-  std::string_view desired_view;
-  if (pydesired != Py_None) {
-    if (pydesired == obj_dbm_any_data) {
-      desired_view = tkrzw::DBM::ANY_DATA;
-    } else {
-      desired = std::make_unique<SoftString>(pydesired);
-      desired_view = desired->Get();
-    }
-  }
   tkrzw::Status status(tkrzw::Status::SUCCESS);
-  std::string actual;
-  bool found = false;
   {
     NativeLock lock(self->concurrent);
-    status = self->dbm->CompareExchange(key.Get(), expected_view, desired_view, &actual, &found);
-  }
-  PyObject* pytuple = PyTuple_New(2);
-  PyTuple_SET_ITEM(pytuple, 0, CreatePyTkStatusMove(std::move(status)));
-  if (found) {
-    PyObject* pyactual = PyUnicode_Check(pyexpected) || PyUnicode_Check(pydesired) ?
-        CreatePyString(actual) : CreatePyBytes(actual);
-    PyTuple_SET_ITEM(pytuple, 1, pyactual);
-  } else {
-    Py_INCREF(Py_None);
-    PyTuple_SET_ITEM(pytuple, 1, Py_None);
+    status = self->iter->JumpLower(key.Get(), inclusive);
   }
-  return pytuple;
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of DBM#Increment.
-static PyObject* dbm_Increment(PyDBM* self, PyObject* pyargs) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+// Implementation of Iterator#JumpUpper.
+static PyObject* iter_JumpUpper(PyIterator* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->iter == nullptr) {
+    ThrowInvalidArguments("abandoned iterator");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 1 || argc > 4) {
+  if (argc < 1 || argc > 2) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
   PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
+  const bool inclusive = argc > 1 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 1)) : false;
   SoftString key(pykey);
-  int64_t inc = 1;
-  if (argc > 1) {
-    PyObject* pyinc = PyTuple_GET_ITEM(pyargs, 1);
-    inc = PyObjToInt(pyinc);
-  }
-  int64_t init = 0;
-  if (argc > 2) {
-    PyObject* pyinit = PyTuple_GET_ITEM(pyargs, 2);
-    init = PyObjToInt(pyinit);
-  }
-  PyObject* pystatus = nullptr;
-  if (argc > 3) {
-    pystatus = PyTuple_GET_ITEM(pyargs, 3);
-    if (pystatus == Py_None) {
-      pystatus = nullptr;
-    } else if (!PyObject_IsInstance(pystatus, cls_status)) {
-      ThrowInvalidArguments("not a status object");
-      return nullptr;
-    }
-  }
   tkrzw::Status status(tkrzw::Status::SUCCESS);
-  int64_t current = 0;
   {
     NativeLock lock(self->concurrent);
-    status = self->dbm->Increment(key.Get(), inc, &current, init);
-  }
-  if (pystatus != nullptr) {
-    *((PyTkStatus*)pystatus)->status = status;
-  }
-  if (status == tkrzw::Status::SUCCESS) {
-    return PyLong_FromLongLong(current);
-  }
-  Py_RETURN_NONE;
-}
-
-
-// Implementation of DBM#ProcessMulti.
-static PyObject* dbm_ProcessMulti(PyDBM* self, PyObject* pyargs) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
-    return nullptr;
-  }
-  if (self->concurrent) {
-    return CreatePyTkStatusMove(tkrzw::Status(
-        tkrzw::Status::PRECONDITION_ERROR, "the concurrent mode is not supported"));
-  }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 2) {
-    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
-    return nullptr;
-  }
-  PyObject* pykfpairs = PyTuple_GET_ITEM(pyargs, 0);
-  const bool writable = PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 1));
-  if (!PySequence_Check(pykfpairs)) {
-    ThrowInvalidArguments("parameters must be sequences of tuples and strings and functions");
-    return nullptr;
-  }
-  const auto& kfpairs_ph = ExtractKFPairs(pykfpairs);
-  std::vector<std::pair<std::string_view, tkrzw::DBM::RecordProcessor*>> kfpairs;
-  kfpairs.reserve(kfpairs_ph.size());
-  for (const auto& key_proc : kfpairs_ph) {
-    auto kfpair = std::make_pair(std::string_view(key_proc.first), key_proc.second.get());
-    kfpairs.emplace_back(std::move(kfpair));
+    status = self->iter->JumpUpper(key.Get(), inclusive);
   }
-  tkrzw::Status status = self->dbm->ProcessMulti(kfpairs, writable);
-  return CreatePyTkStatusMove(std::move(status));
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of DBM#CompareExchangeMulti.
-static PyObject* dbm_CompareExchangeMulti(PyDBM* self, PyObject* pyargs) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
-    return nullptr;
-  }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 2) {
-    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
-    return nullptr;
-  }
-  PyObject* pyexpected = PyTuple_GET_ITEM(pyargs, 0);
-  PyObject* pydesired = PyTuple_GET_ITEM(pyargs, 1);
-  if (!PySequence_Check(pyexpected) || !PySequence_Check(pydesired)) {
-    ThrowInvalidArguments("parameters must be sequences of strings");
+// Implementation of Iterator#Next.
+static PyObject* iter_Next(PyIterator* self) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->iter == nullptr) {
+    ThrowInvalidArguments("abandoned iterator");
     return nullptr;
   }
-  std::vector<std::string> expected_ph;
-  const auto& expected = ExtractSVPairs(pyexpected, &expected_ph);
-  std::vector<std::string> desired_ph;
-  const auto& desired = ExtractSVPairs(pydesired, &desired_ph);
   tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
     NativeLock lock(self->concurrent);
-    status = self->dbm->CompareExchangeMulti(expected, desired);
+    status = self->iter->Next();
   }
-  return CreatePyTkStatusMove(std::move(status));
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of DBM#Rekey.
-static PyObject* dbm_Rekey(PyDBM* self, PyObject* pyargs) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
-    return nullptr;
-  }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 2 || argc > 4) {
-    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
+// Implementation of Iterator#Previous.
+static PyObject* iter_Previous(PyIterator* self) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->iter == nullptr) {
+    ThrowInvalidArguments("abandoned iterator");
     return nullptr;
   }
-  PyObject* pyold_key = PyTuple_GET_ITEM(pyargs, 0);
-  PyObject* pynew_key = PyTuple_GET_ITEM(pyargs, 1);
-  const bool overwrite = argc > 2 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 2)) : true;
-  const bool copying = argc > 3 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 3)) : false;
-  SoftString old_key(pyold_key);
-  SoftString new_key(pynew_key);
   tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
     NativeLock lock(self->concurrent);
-    status = self->dbm->Rekey(old_key.Get(), new_key.Get(), overwrite, copying);
+    status = self->iter->Previous();
   }
-  return CreatePyTkStatusMove(std::move(status));
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of DBM#PopFirst.
-static PyObject* dbm_PopFirst(PyDBM* self, PyObject* pyargs) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+// Implementation of Iterator#Get.
+static PyObject* iter_Get(PyIterator* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->iter == nullptr) {
+    ThrowInvalidArguments("abandoned iterator");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
@@ -2035,7 +6808,7 @@ static PyObject* dbm_PopFirst(PyDBM* self, PyObject* pyargs) {
     pystatus = PyTuple_GET_ITEM(pyargs, 0);
     if (pystatus == Py_None) {
       pystatus = nullptr;
-    } else if (!PyObject_IsInstance(pystatus, cls_status)) {
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
       ThrowInvalidArguments("not a status object");
       return nullptr;
     }
@@ -2044,7 +6817,7 @@ static PyObject* dbm_PopFirst(PyDBM* self, PyObject* pyargs) {
   tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
     NativeLock lock(self->concurrent);
-    status = self->dbm->PopFirst(&key, &value);
+    status = self->iter->Get(&key, &value);
   }
   if (pystatus != nullptr) {
     *((PyTkStatus*)pystatus)->status = status;
@@ -2060,10 +6833,11 @@ static PyObject* dbm_PopFirst(PyDBM* self, PyObject* pyargs) {
   Py_RETURN_NONE;
 }
 
-// Implementation of DBM#PopFirstStr.
-static PyObject* dbm_PopFirstStr(PyDBM* self, PyObject* pyargs) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+// Implementation of Iterator#GetStr.
+static PyObject* iter_GetStr(PyIterator* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->iter == nullptr) {
+    ThrowInvalidArguments("abandoned iterator");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
@@ -2076,7 +6850,7 @@ static PyObject* dbm_PopFirstStr(PyDBM* self, PyObject* pyargs) {
     pystatus = PyTuple_GET_ITEM(pyargs, 0);
     if (pystatus == Py_None) {
       pystatus = nullptr;
-    } else if (!PyObject_IsInstance(pystatus, cls_status)) {
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
       ThrowInvalidArguments("not a status object");
       return nullptr;
     }
@@ -2085,7 +6859,7 @@ static PyObject* dbm_PopFirstStr(PyDBM* self, PyObject* pyargs) {
   tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
     NativeLock lock(self->concurrent);
-    status = self->dbm->PopFirst(&key, &value);
+    status = self->iter->Get(&key, &value);
   }
   if (pystatus != nullptr) {
     *((PyTkStatus*)pystatus)->status = status;
@@ -2101,288 +6875,159 @@ static PyObject* dbm_PopFirstStr(PyDBM* self, PyObject* pyargs) {
   Py_RETURN_NONE;
 }
 
-// Implementation of DBM#PushLast.
-static PyObject* dbm_PushLast(PyDBM* self, PyObject* pyargs) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+// Implementation of Iterator#GetKey.
+static PyObject* iter_GetKey(PyIterator* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->iter == nullptr) {
+    ThrowInvalidArguments("abandoned iterator");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 1 || argc > 2) {
+  if (argc > 1) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pyvalue = PyTuple_GET_ITEM(pyargs, 0);
-  const double wtime = argc > 1 ? PyObjToDouble(PyTuple_GET_ITEM(pyargs, 1)) : -1;
-  SoftString value(pyvalue);
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->dbm->PushLast(value.Get(), wtime);
-  }
-  return CreatePyTkStatusMove(std::move(status));
-}
-
-// Implementation of DBM#ProcessEach.
-static PyObject* dbm_ProcessEach(PyDBM* self, PyObject* pyargs) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
-    return nullptr;
-  }
-  if (self->concurrent) {
-    return CreatePyTkStatusMove(tkrzw::Status(
-        tkrzw::Status::PRECONDITION_ERROR, "the concurrent mode is not supported"));
-  }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 2) {
-    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
-    return nullptr;
-  }
-  PyObject* pyfunc = PyTuple_GET_ITEM(pyargs, 0);
-  const bool writable = PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 1));
-  if (!PyCallable_Check(pyfunc)) {
-    ThrowInvalidArguments("non callable is given");
-    return nullptr;
-  }
-  std::unique_ptr<SoftString> funcrvstr;
-  auto func = [&](std::string_view k, std::string_view v) -> std::string_view {
-    PyObject* pyfuncargs = PyTuple_New(2);
-    if (k.data() == tkrzw::DBM::RecordProcessor::NOOP.data()) {
-      Py_INCREF(Py_None);
-      PyTuple_SET_ITEM(pyfuncargs, 0, Py_None);
-    } else {
-      PyTuple_SET_ITEM(pyfuncargs, 0, CreatePyBytes(k));
-    }
-    if (v.data() == tkrzw::DBM::RecordProcessor::NOOP.data()) {
-      Py_INCREF(Py_None);
-      PyTuple_SET_ITEM(pyfuncargs, 1, Py_None);
-    } else {
-      PyTuple_SET_ITEM(pyfuncargs, 1, CreatePyBytes(v));
-    }
-    PyObject* pyfuncrv = PyObject_CallObject(pyfunc, pyfuncargs);
-    std::string_view funcrv = tkrzw::DBM::RecordProcessor::NOOP;
-    if (pyfuncrv != nullptr) {
-      if (pyfuncrv == Py_None) {
-        funcrv = tkrzw::DBM::RecordProcessor::NOOP;
-      } else if (pyfuncrv == Py_False) {
-        funcrv = tkrzw::DBM::RecordProcessor::REMOVE;
-      } else {
-        funcrvstr = std::make_unique<SoftString>(pyfuncrv);
-        funcrv = funcrvstr->Get();
-      }
-      Py_DECREF(pyfuncrv);
+  PyObject* pystatus = nullptr;
+  if (argc > 0) {
+    pystatus = PyTuple_GET_ITEM(pyargs, 0);
+    if (pystatus == Py_None) {
+      pystatus = nullptr;
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
+      ThrowInvalidArguments("not a status object");
+      return nullptr;
     }
-    Py_DECREF(pyfuncargs);
-    return funcrv;
-  };
-  tkrzw::Status status = self->dbm->ProcessEach(func, writable);
-  return CreatePyTkStatusMove(std::move(status));
-}
-
-// Implementation of DBM#Count.
-static PyObject* dbm_Count(PyDBM* self) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
-    return nullptr;
-  }
-  int64_t count = -1;
-  {
-    NativeLock lock(self->concurrent);
-    count = self->dbm->CountSimple();
-  }
-  if (count >= 0) {
-    return PyLong_FromLongLong(count);
-  }
-  Py_RETURN_NONE;
-}
-
-// Implementation of DBM#GetFileSize.
-static PyObject* dbm_GetFileSize(PyDBM* self) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
-    return nullptr;
-  }
-  int64_t file_size = -1;
-  {
-    NativeLock lock(self->concurrent);
-    file_size = self->dbm->GetFileSizeSimple();
-  }
-  if (file_size >= 0) {
-    return PyLong_FromLongLong(file_size);
-  }
-  Py_RETURN_NONE;
-}
-
-// Implementation of DBM#GetFilePath.
-static PyObject* dbm_GetFilePath(PyDBM* self) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
-    return nullptr;
-  }
-  std::string path;
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->dbm->GetFilePath(&path);
-  }
-  if (status == tkrzw::Status::SUCCESS) {
-    return CreatePyString(path);
-  }
-  Py_RETURN_NONE;
-}
-
-// Implementation of DBM#GetTimestamp.
-static PyObject* dbm_GetTimestamp(PyDBM* self) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
-    return nullptr;
-  }
-  double timestamp = -1;
-  {
-    NativeLock lock(self->concurrent);
-    timestamp = self->dbm->GetTimestampSimple();
-  }
-  if (timestamp >= 0) {
-    return PyFloat_FromDouble(timestamp);
-  }
-  Py_RETURN_NONE;
-}
-
-// Implementation of DBM#Clear.
-static PyObject* dbm_Clear(PyDBM* self) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
-    return nullptr;
-  }
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->dbm->Clear();
-  }
-  return CreatePyTkStatusMove(std::move(status));
-}
-
-// Implementation of DBM#Rebuild.
-static PyObject* dbm_Rebuild(PyDBM* self, PyObject* pyargs, PyObject* pykwds) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
-    return nullptr;
-  }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 0) {
-    ThrowInvalidArguments("too many arguments");
-    return nullptr;
-  }
-  std::map<std::string, std::string> params;
-  if (pykwds != nullptr) {
-    params = MapKeywords(pykwds);
   }
+  std::string key;
   tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
     NativeLock lock(self->concurrent);
-    status = self->dbm->RebuildAdvanced(params);
+    status = self->iter->Get(&key);
   }
-  return CreatePyTkStatusMove(std::move(status));
-}
-
-// Implementation of DBM#ShouldBeRebuilt.
-static PyObject* dbm_ShouldBeRebuilt(PyDBM* self) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
-    return nullptr;
+  if (pystatus != nullptr) {
+    *((PyTkStatus*)pystatus)->status = status;
   }
-  bool tobe = false;
-  {
-    NativeLock lock(self->concurrent);
-    tobe = self->dbm->ShouldBeRebuiltSimple();
+  if (status != tkrzw::Status::SUCCESS) {
+    Py_RETURN_NONE;
   }
-  return PyBool_FromLong(tobe);
+  return CreatePyBytes(key);
 }
 
-// Implementation of DBM#Synchronize.
-static PyObject* dbm_Synchronize(PyDBM* self, PyObject* pyargs, PyObject* pykwds) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+// Implementation of Iterator#GetKeyStr.
+static PyObject* iter_GetKeyStr(PyIterator* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->iter == nullptr) {
+    ThrowInvalidArguments("abandoned iterator");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 1) {
+  if (argc > 1) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pyhard = PyTuple_GET_ITEM(pyargs, 0);
-  const bool hard = PyObject_IsTrue(pyhard);
-  std::map<std::string, std::string> params;
-  if (pykwds != nullptr) {
-    params = MapKeywords(pykwds);
+  PyObject* pystatus = nullptr;
+  if (argc > 0) {
+    pystatus = PyTuple_GET_ITEM(pyargs, 0);
+    if (pystatus == Py_None) {
+      pystatus = nullptr;
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
+      ThrowInvalidArguments("not a status object");
+      return nullptr;
+    }
   }
+  std::string key;
   tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
     NativeLock lock(self->concurrent);
-    status = self->dbm->SynchronizeAdvanced(hard, nullptr, params);
+    status = self->iter->Get(&key);
+  }
+  if (pystatus != nullptr) {
+    *((PyTkStatus*)pystatus)->status = status;
+  }
+  if (status != tkrzw::Status::SUCCESS) {
+    Py_RETURN_NONE;
   }
-  return CreatePyTkStatusMove(std::move(status));
+  return CreatePyString(key);
 }
 
-// Implementation of DBM#CopyFileData.
-static PyObject* dbm_CopyFileData(PyDBM* self, PyObject* pyargs) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+// Implementation of Iterator#GetValue.
+static PyObject* iter_GetValue(PyIterator* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->iter == nullptr) {
+    ThrowInvalidArguments("abandoned iterator");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 1 || argc > 2) {
+  if (argc > 1) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pydest = PyTuple_GET_ITEM(pyargs, 0);
-  bool sync_hard = false;
-  if (argc > 1) {
-    PyObject* pysync_hard = PyTuple_GET_ITEM(pyargs, 1);
-    sync_hard = PyObject_IsTrue(pysync_hard);
+  PyObject* pystatus = nullptr;
+  if (argc > 0) {
+    pystatus = PyTuple_GET_ITEM(pyargs, 0);
+    if (pystatus == Py_None) {
+      pystatus = nullptr;
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
+      ThrowInvalidArguments("not a status object");
+      return nullptr;
+    }
   }
-  SoftString dest(pydest);
+  std::string value;
   tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
     NativeLock lock(self->concurrent);
-    status = self->dbm->CopyFileData(std::string(dest.Get()), sync_hard);
+    status = self->iter->Get(nullptr, &value);
+  }
+  if (pystatus != nullptr) {
+    *((PyTkStatus*)pystatus)->status = status;
+  }
+  if (status != tkrzw::Status::SUCCESS) {
+    Py_RETURN_NONE;
   }
-  return CreatePyTkStatusMove(std::move(status));
+  return CreatePyBytes(value);
 }
 
-// Implementation of DBM#Export.
-static PyObject* dbm_Export(PyDBM* self, PyObject* pyargs) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+// Implementation of Iterator#GetValueStr.
+static PyObject* iter_GetValueStr(PyIterator* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->iter == nullptr) {
+    ThrowInvalidArguments("abandoned iterator");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 1) {
+  if (argc > 1) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pydest = PyTuple_GET_ITEM(pyargs, 0);
-  if (!PyObject_IsInstance(pydest, cls_dbm)) {
-    ThrowInvalidArguments("the argument is not a DBM");
-    return nullptr;
-  }
-  PyDBM* dest = (PyDBM*)pydest;
-  if (dest->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
-    return nullptr;
+  PyObject* pystatus = nullptr;
+  if (argc > 0) {
+    pystatus = PyTuple_GET_ITEM(pyargs, 0);
+    if (pystatus == Py_None) {
+      pystatus = nullptr;
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
+      ThrowInvalidArguments("not a status object");
+      return nullptr;
+    }
   }
+  std::string value;
   tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
     NativeLock lock(self->concurrent);
-    status = self->dbm->Export(dest->dbm);
+    status = self->iter->Get(nullptr, &value);
+  }
+  if (pystatus != nullptr) {
+    *((PyTkStatus*)pystatus)->status = status;
   }
-  return CreatePyTkStatusMove(std::move(status));
+  if (status != tkrzw::Status::SUCCESS) {
+    Py_RETURN_NONE;
+  }
+  return CreatePyString(value);
 }
 
-// Implementation of DBM#ExportToFlatRecords.
-static PyObject* dbm_ExportToFlatRecords(PyDBM* self, PyObject* pyargs) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+// Implementation of Iterator#Set.
+static PyObject* iter_Set(PyIterator* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->iter == nullptr) {
+    ThrowInvalidArguments("abandoned iterator");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
@@ -2390,561 +7035,854 @@ static PyObject* dbm_ExportToFlatRecords(PyDBM* self, PyObject* pyargs) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pydest_file = PyTuple_GET_ITEM(pyargs, 0);
-  if (!PyObject_IsInstance(pydest_file, cls_file)) {
-    ThrowInvalidArguments("the argument is not a File");
-    return nullptr;
+  PyObject* pyvalue = PyTuple_GET_ITEM(pyargs, 0);
+  SoftString value(pyvalue);
+  std::string key;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    self->iter->Get(&key);
+    status = self->iter->Set(value.Get());
   }
-  PyFile* dest_file = (PyFile*)pydest_file;
-  if (dest_file->file == nullptr) {
-    ThrowInvalidArguments("not opened file");
+  InvalidateIteratorRecord(self, key);
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of Iterator#Remove.
+static PyObject* iter_Remove(PyIterator* self) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->iter == nullptr) {
+    ThrowInvalidArguments("abandoned iterator");
     return nullptr;
   }
+  std::string key;
   tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
     NativeLock lock(self->concurrent);
-    status = tkrzw::ExportDBMToFlatRecords(self->dbm, dest_file->file);
+    self->iter->Get(&key);
+    status = self->iter->Remove();
   }
-  return CreatePyTkStatusMove(std::move(status));
+  InvalidateIteratorRecord(self, key);
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of DBM#ImportFromFlatRecords.
-static PyObject* dbm_ImportFromFlatRecords(PyDBM* self, PyObject* pyargs) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+// Implementation of Iterator#Step.
+static PyObject* iter_Step(PyIterator* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->iter == nullptr) {
+    ThrowInvalidArguments("abandoned iterator");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 1) {
+  if (argc > 1) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pysrc_file = PyTuple_GET_ITEM(pyargs, 0);
-  if (!PyObject_IsInstance(pysrc_file, cls_file)) {
-    ThrowInvalidArguments("the argument is not a File");
-    return nullptr;
-  }
-  PyFile* src_file = (PyFile*)pysrc_file;
-  if (src_file->file == nullptr) {
-    ThrowInvalidArguments("not opened file");
-    return nullptr;
-  }
+  PyObject* pystatus = nullptr;
+  if (argc > 0) {
+    pystatus = PyTuple_GET_ITEM(pyargs, 0);
+    if (pystatus == Py_None) {
+      pystatus = nullptr;
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
+      ThrowInvalidArguments("not a status object");
+      return nullptr;
+    }
+  }  
+  std::string key, value;
   tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
     NativeLock lock(self->concurrent);
-    status = tkrzw::ImportDBMFromFlatRecords(self->dbm, src_file->file);
+    status = self->iter->Step(&key, &value);
+  }
+  if (pystatus != nullptr) {
+    *((PyTkStatus*)pystatus)->status = status;
+  }
+  if (status == tkrzw::Status::SUCCESS) {
+    PyObject* pykey = CreatePyBytes(key);
+    PyObject* pyvalue = CreatePyBytes(value);
+    PyObject * pyrv = PyTuple_Pack(2, pykey, pyvalue);
+    Py_DECREF(pyvalue);
+    Py_DECREF(pykey);
+    return pyrv;
   }
-  return CreatePyTkStatusMove(std::move(status));
+  Py_RETURN_NONE;
 }
 
-// Implementation of DBM#ExportKeysAsLines.
-static PyObject* dbm_ExportKeysAsLines(PyDBM* self, PyObject* pyargs) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+// Implementation of Iterator#StepStr.
+static PyObject* iter_StepStr(PyIterator* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->iter == nullptr) {
+    ThrowInvalidArguments("abandoned iterator");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 1) {
+  if (argc > 1) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pydest_file = PyTuple_GET_ITEM(pyargs, 0);
-  if (!PyObject_IsInstance(pydest_file, cls_file)) {
-    ThrowInvalidArguments("the argument is not a File");
-    return nullptr;
+  PyObject* pystatus = nullptr;
+  if (argc > 0) {
+    pystatus = PyTuple_GET_ITEM(pyargs, 0);
+    if (pystatus == Py_None) {
+      pystatus = nullptr;
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
+      ThrowInvalidArguments("not a status object");
+      return nullptr;
+    }
+  }  
+  std::string key, value;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->iter->Step(&key, &value);
   }
-  PyFile* dest_file = (PyFile*)pydest_file;
-  if (dest_file->file == nullptr) {
-    ThrowInvalidArguments("not opened file");
+  if (pystatus != nullptr) {
+    *((PyTkStatus*)pystatus)->status = status;
+  }
+  if (status == tkrzw::Status::SUCCESS) {
+    PyObject* pykey = CreatePyString(key);
+    PyObject* pyvalue = CreatePyString(value);
+    PyObject * pyrv = PyTuple_Pack(2, pykey, pyvalue);
+    Py_DECREF(pyvalue);
+    Py_DECREF(pykey);
+    return pyrv;
+  }
+  Py_RETURN_NONE;
+}
+
+// Implementation of Iterator#__next__.
+static PyObject* iter_iternext(PyIterator* self) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->iter == nullptr) {
+    ThrowInvalidArguments("abandoned iterator");
     return nullptr;
   }
+  std::string key, value;
   tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
     NativeLock lock(self->concurrent);
-    status = tkrzw::ExportDBMKeysAsLines(self->dbm, dest_file->file);
+    status = self->iter->Get(&key, &value);
+  }
+  PyObject* pyrv = nullptr;
+  if (status == tkrzw::Status::SUCCESS) {
+    PyObject* pykey = CreatePyBytes(key);
+    PyObject* pyvalue = CreatePyBytes(value);
+    pyrv = PyTuple_Pack(2, pykey, pyvalue);
+    Py_DECREF(pykey);
+    Py_DECREF(pyvalue);
+    self->iter->Next();
+  } else {
+    PyErr_SetString(PyExc_StopIteration, "end of iteration");
+    pyrv = nullptr;
   }
-  return CreatePyTkStatusMove(std::move(status));
+  return pyrv;
 }
 
-// Implementation of DBM#Inspect.
-static PyObject* dbm_Inspect(PyDBM* self) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
-    return nullptr;
-  }
-  std::vector<std::pair<std::string, std::string>> records;
+// Defines the Iterator class.
+static bool DefineIterator(PyObject* module, ModuleState* state) {
+  static PyMethodDef methods[] = {
+    {"First", (PyCFunction)iter_First, METH_NOARGS,
+     "Initializes the iterator to indicate the first record."},
+    {"Last", (PyCFunction)iter_Last, METH_NOARGS,
+     "Initializes the iterator to indicate the last record."},
+    {"Jump", (PyCFunction)iter_Jump, METH_VARARGS,
+     "Initializes the iterator to indicate a specific record."},
+    {"JumpLower", (PyCFunction)iter_JumpLower, METH_VARARGS,
+     "Initializes the iterator to indicate the last record whose key is lower."},
+    {"JumpUpper", (PyCFunction)iter_JumpUpper, METH_VARARGS,
+     "Initializes the iterator to indicate the first record whose key is upper."},
+    {"Next", (PyCFunction)iter_Next, METH_NOARGS,
+     "Moves the iterator to the next record."},
+    {"Previous", (PyCFunction)iter_Previous, METH_NOARGS,
+     "Moves the iterator to the previous record."},
+    {"Get", (PyCFunction)iter_Get, METH_VARARGS,
+     "Gets the key and the value of the current record of the iterator."},
+    {"GetStr", (PyCFunction)iter_GetStr, METH_VARARGS,
+     "Gets the key and the value of the current record of the iterator, as strings."},
+    {"GetKey", (PyCFunction)iter_GetKey, METH_VARARGS,
+     "Gets the key of the current record."},
+    {"GetKeyStr", (PyCFunction)iter_GetKeyStr, METH_VARARGS,
+     "Gets the key of the current record, as a string."},
+    {"GetValue", (PyCFunction)iter_GetValue, METH_VARARGS,
+     "Gets the value of the current record."},
+    {"GetValueStr", (PyCFunction)iter_GetValueStr, METH_VARARGS,
+     "Gets the value of the current record, as a string."},
+    {"Set", (PyCFunction)iter_Set, METH_VARARGS,
+     "Sets the value of the current record."},
+    {"Remove", (PyCFunction)iter_Remove, METH_NOARGS,
+     "Removes the current record."},
+    {"Step", (PyCFunction)iter_Step, METH_VARARGS,
+     "Gets the current record and moves the iterator to the next record."},
+    {"StepStr", (PyCFunction)iter_StepStr, METH_VARARGS,
+     "Gets the current record and moves the iterator to the next record, as strings."},
+    {nullptr, nullptr, 0, nullptr}
+  };
+  static PyType_Slot slots[] = {
+    {Py_tp_doc, (void*)"Iterator for each record."},
+    {Py_tp_new, (void*)iter_new},
+    {Py_tp_dealloc, (void*)iter_dealloc},
+    {Py_tp_init, (void*)iter_init},
+    {Py_tp_repr, (void*)iter_repr},
+    {Py_tp_str, (void*)iter_str},
+    {Py_tp_methods, (void*)methods},
+    {Py_tp_iternext, (void*)iter_iternext},
+    {0, nullptr},
+  };
+  static PyType_Spec spec = {
+    "tkrzw.Iterator", sizeof(PyIterator), 0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, slots};
+  state->cls_iter = PyType_FromModuleAndSpec(module, &spec, nullptr);
+  if (state->cls_iter == nullptr) return false;
+  if (PyModule_AddObjectRef(module, "Iterator", state->cls_iter) != 0) return false;
+  return true;
+}
+
+// Implementation of RebuildJob.new.
+static PyObject* rebuildjob_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
+  PyRebuildJob* self = (PyRebuildJob*)pytype->tp_alloc(pytype, 0);
+  if (!self) return nullptr;
+  self->job = nullptr;
+  self->pydbm = nullptr;
+  RegisterForkHandle((PyObject*)self, AbandonRebuildJobHandle);
+  return (PyObject*)self;
+}
+
+// Implementation of RebuildJob#dealloc.
+static void rebuildjob_dealloc(PyRebuildJob* self) {
+  UnregisterForkHandle((PyObject*)self);
   {
-    NativeLock lock(self->concurrent);
-    records = self->dbm->Inspect();
-  }
-  PyObject* pyrv = PyDict_New();
-  for (const auto& rec : records) {
-    PyObject* pyname = CreatePyString(rec.first);
-    PyObject* pyvalue = CreatePyString(rec.second);
-    PyDict_SetItem(pyrv, pyname, pyvalue);
-    Py_DECREF(pyvalue);
-    Py_DECREF(pyname);
+    NativeLock lock(true);
+    delete self->job;
   }
-  return pyrv;
+  Py_XDECREF(self->pydbm);
+  PyTypeObject* pytype = Py_TYPE(self);
+  pytype->tp_free((PyObject*)self);
+  Py_DECREF(pytype);
 }
 
-// Implementation of DBM#IsOpen.
-static PyObject* dbm_IsOpen(PyDBM* self) {
-  if (self->dbm == nullptr) {
-    Py_RETURN_FALSE;
+// Implementation of RebuildJob#__init__.
+static int rebuildjob_init(PyRebuildJob* self, PyObject* pyargs, PyObject* pykwds) {
+  ThrowStatusException(self, tkrzw::Status(tkrzw::Status::NOT_IMPLEMENTED_ERROR));
+  return -1;
+}
+
+// Gets the name of the state of a rebuild job.
+static const char* GetRebuildJobStateName(RebuildJob* job) {
+  if (job == nullptr) {
+    return "abandoned";
   }
-  Py_RETURN_TRUE;  
+  return RebuildJob::GetStateName(job->GetState());
 }
 
-// Implementation of DBM#IsWritable.
-static PyObject* dbm_IsWritable(PyDBM* self) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+// Implementation of RebuildJob#__repr__.
+static PyObject* rebuildjob_repr(PyRebuildJob* self) {
+  const std::string& str = tkrzw::StrCat(
+      "<tkrzw.RebuildJob: state=", GetRebuildJobStateName(self->job), ">");
+  return CreatePyString(str);
+}
+
+// Implementation of RebuildJob#__str__.
+static PyObject* rebuildjob_str(PyRebuildJob* self) {
+  const std::string& str = tkrzw::StrCat("RebuildJob:", GetRebuildJobStateName(self->job));
+  return CreatePyString(str);
+}
+
+// Implementation of RebuildJob#Wait.
+static PyObject* rebuildjob_Wait(PyRebuildJob* self, PyObject* pyargs) {
+  if (self->job == nullptr) {
+    ThrowInvalidArguments("abandoned job");
     return nullptr;
   }
-  const bool writable = self->dbm->IsWritable();
-  if (writable) {
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc > 1) {
+    ThrowInvalidArguments("too many arguments");
+    return nullptr;
+  }
+  const double timeout = argc > 0 ? PyObjToDouble(PyTuple_GET_ITEM(pyargs, 0)) : -1.0;
+  bool ok = false;
+  {
+    NativeLock lock(true);
+    ok = self->job->Wait(timeout);
+  }
+  if (ok) {
     Py_RETURN_TRUE;
   }
   Py_RETURN_FALSE;
 }
 
-// Implementation of DBM#IsHealthy.
-static PyObject* dbm_IsHealthy(PyDBM* self) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+// Implementation of RebuildJob#Get.
+static PyObject* rebuildjob_Get(PyRebuildJob* self) {
+  if (self->job == nullptr) {
+    ThrowInvalidArguments("abandoned job");
     return nullptr;
   }
-  const bool healthy = self->dbm->IsHealthy();
-  if (healthy) {
-    Py_RETURN_TRUE;
+  {
+    NativeLock lock(true);
+    self->job->Wait(-1);
   }
-  Py_RETURN_FALSE;
+  return CreatePyTkStatusMove(self, self->job->GetStatus());
 }
 
-// Implementation of DBM#IsOrdered.
-static PyObject* dbm_IsOrdered(PyDBM* self) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+// Implementation of RebuildJob#Cancel.
+static PyObject* rebuildjob_Cancel(PyRebuildJob* self) {
+  if (self->job == nullptr) {
+    ThrowInvalidArguments("abandoned job");
     return nullptr;
   }
-  const bool ordered = self->dbm->IsOrdered();
-  if (ordered) {
+  if (self->job->Cancel()) {
     Py_RETURN_TRUE;
   }
   Py_RETURN_FALSE;
 }
 
-// Implementation of DBM#Search.
-static PyObject* dbm_Search(PyDBM* self, PyObject* pyargs) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+// Implementation of RebuildJob#Inspect.
+static PyObject* rebuildjob_Inspect(PyRebuildJob* self) {
+  if (self->job == nullptr) {
+    ThrowInvalidArguments("abandoned job");
     return nullptr;
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 2 || argc > 3) {
-    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
-    return nullptr;
-  }
-  PyObject* pymode = PyTuple_GET_ITEM(pyargs, 0);
-  PyObject* pypattern = PyTuple_GET_ITEM(pyargs, 1);
-  int32_t capacity = 0;
-  if (argc > 2) {
-    capacity = PyObjToInt(PyTuple_GET_ITEM(pyargs, 2));
-  }
-  SoftString pattern(pypattern);
-  SoftString mode(pymode);
-  std::vector<std::string> keys;
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = tkrzw::SearchDBMModal(self->dbm, mode.Get(), pattern.Get(), &keys, capacity);
-  }
-  if (status != tkrzw::Status::SUCCESS) {
-    ThrowStatusException(status);    
-    return nullptr;
-  }
-  PyObject* pyrv = PyList_New(keys.size());
-  for (size_t i = 0; i < keys.size(); i++) {
-    PyList_SET_ITEM(pyrv, i, CreatePyString(keys[i]));
+  PyObject* pyrv = PyDict_New();
+  for (const auto& prop : self->job->Inspect()) {
+    PyObject* pyname = CreatePyString(prop.first);
+    PyObject* pyvalue = CreatePyString(prop.second);
+    PyDict_SetItem(pyrv, pyname, pyvalue);
+    Py_DECREF(pyvalue);
+    Py_DECREF(pyname);
   }
   return pyrv;
 }
 
-// Implementation of DBM#MakeIterator.
-static PyObject* dbm_MakeIterator(PyDBM* self) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
-    return nullptr;
-  }
-  PyTypeObject* pyitertype = (PyTypeObject*)cls_iter;
-  PyIterator* pyiter = (PyIterator*)pyitertype->tp_alloc(pyitertype, 0);
-  if (!pyiter) return nullptr;
+// Defines the RebuildJob class.
+static bool DefineRebuildJob(PyObject* module, ModuleState* state) {
+  static PyMethodDef methods[] = {
+    {"Wait", (PyCFunction)rebuildjob_Wait, METH_VARARGS,
+     "Waits for the job to finish."},
+    {"Get", (PyCFunction)rebuildjob_Get, METH_NOARGS,
+     "Waits for the job to finish and gets the result status."},
+    {"Cancel", (PyCFunction)rebuildjob_Cancel, METH_NOARGS,
+     "Cancels the job if it has not started."},
+    {"Inspect", (PyCFunction)rebuildjob_Inspect, METH_NOARGS,
+     "Inspects the state and the statistics of the job."},
+    {nullptr, nullptr, 0, nullptr},
+  };
+  static PyType_Slot slots[] = {
+    {Py_tp_doc, (void*)"Job to rebuild a database in background."},
+    {Py_tp_new, (void*)rebuildjob_new},
+    {Py_tp_dealloc, (void*)rebuildjob_dealloc},
+    {Py_tp_init, (void*)rebuildjob_init},
+    {Py_tp_repr, (void*)rebuildjob_repr},
+    {Py_tp_str, (void*)rebuildjob_str},
+    {Py_tp_methods, (void*)methods},
+    {0, nullptr},
+  };
+  static PyType_Spec spec = {
+    "tkrzw.RebuildJob", sizeof(PyRebuildJob), 0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, slots};
+  state->cls_rebuildjob = PyType_FromModuleAndSpec(module, &spec, nullptr);
+  if (state->cls_rebuildjob == nullptr) return false;
+  if (PyModule_AddObjectRef(module, "RebuildJob", state->cls_rebuildjob) != 0) return false;
+  return true;
+}
+
+// Implementation of AsyncExecutor.new.
+static PyObject* asyncexecutor_new(
+    PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
+  PyAsyncExecutor* self = (PyAsyncExecutor*)pytype->tp_alloc(pytype, 0);
+  if (!self) return nullptr;
+  new (&self->executor) std::shared_ptr<AsyncExecutor>();
+  RegisterForkHandle((PyObject*)self, AbandonAsyncExecutorHandle);
+  return (PyObject*)self;
+}
+
+// Implementation of AsyncExecutor#dealloc.
+static void asyncexecutor_dealloc(PyAsyncExecutor* self) {
+  UnregisterForkHandle((PyObject*)self);
   {
-    NativeLock lock(self->concurrent);
-    pyiter->iter = self->dbm->MakeIterator().release();
+    NativeLock lock(true);
+    self->executor.reset();
   }
-  pyiter->concurrent = self->concurrent;
-  return (PyObject*)pyiter;
+  self->executor.~shared_ptr();
+  PyTypeObject* pytype = Py_TYPE(self);
+  pytype->tp_free((PyObject*)self);
+  Py_DECREF(pytype);
 }
 
-// Implementation of DBM.RestoreDatabase.
-static PyObject* dbm_RestoreDatabase(PyObject* self, PyObject* pyargs) {
+// Implementation of AsyncExecutor#__init__.
+static int asyncexecutor_init(PyAsyncExecutor* self, PyObject* pyargs, PyObject* pykwds) {
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 2 || argc > 5) {
-    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
-    return nullptr;
+  if (argc > 1) {
+    ThrowInvalidArguments("too many arguments");
+    return -1;
   }
-  SoftString old_file_path(PyTuple_GET_ITEM(pyargs, 0));
-  SoftString new_file_path(PyTuple_GET_ITEM(pyargs, 1));
-  SoftString class_name(argc > 2 ? PyTuple_GET_ITEM(pyargs, 2) : Py_None);
-  const int64_t end_offset = argc > 3 ? PyObjToInt(PyTuple_GET_ITEM(pyargs, 3)) : -1;
-  SoftString cipher_key(argc > 4 ? PyTuple_GET_ITEM(pyargs, 4) : Py_None);
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  int32_t num_shards = 0;
-  if (tkrzw::ShardDBM::GetNumberOfShards(std::string(old_file_path.Get()), &num_shards) ==
-      tkrzw::Status::SUCCESS) {
-    NativeLock lock(true);
-    status = tkrzw::ShardDBM::RestoreDatabase(
-        std::string(old_file_path.Get()), std::string(new_file_path.Get()),
-        std::string(class_name.Get()), end_offset, cipher_key.Get());
-  } else {
-    NativeLock lock(true);
-    status = tkrzw::PolyDBM::RestoreDatabase(
-        std::string(old_file_path.Get()), std::string(new_file_path.Get()),
-        std::string(class_name.Get()), end_offset, cipher_key.Get());
+  int32_t num_threads = argc > 0 ? PyObjToInt(PyTuple_GET_ITEM(pyargs, 0)) : 0;
+  if (num_threads < 1) {
+    num_threads = std::thread::hardware_concurrency();
+  }
+  bool pin_cpus = false;
+  if (pykwds != nullptr) {
+    const auto& params = MapKeywords(pykwds);
+    pin_cpus = tkrzw::StrToBool(tkrzw::SearchMap(params, "pin_cpus", "false"));
   }
-  return CreatePyTkStatusMove(std::move(status));
+  self->executor = std::make_shared<AsyncExecutor>(num_threads, pin_cpus);
+  return 0;
 }
 
-// Implementation of DBM#__len__.
-static Py_ssize_t dbm_len(PyDBM* self) {
-  if (self->dbm == nullptr) {
-    return 0;
-  }
-  int64_t count = -1;
-  {
-    NativeLock lock(self->concurrent);
-    count = self->dbm->CountSimple();
-  }
-  return std::max<int64_t>(count, 0);
+// Implementation of AsyncExecutor#__repr__.
+static PyObject* asyncexecutor_repr(PyAsyncExecutor* self) {
+  const std::string& str = tkrzw::SPrintF(
+      "<tkrzw.AsyncExecutor: %p>", (void*)self->executor.get());
+  return CreatePyString(str);
 }
 
-// Implementation of DBM#__getitem__.
-static PyObject* dbm_getitem(PyDBM* self, PyObject* pykey) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
-    return nullptr;
-  }
-  const bool is_unicode = PyUnicode_Check(pykey);
-  SoftString key(pykey);
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  std::string value;
-  {
-    NativeLock lock(self->concurrent);
-    status = self->dbm->Get(key.Get(), &value);
-  }
-  if (status != tkrzw::Status::SUCCESS) {
-    ThrowStatusException(status);
+// Implementation of AsyncExecutor#__str__.
+static PyObject* asyncexecutor_str(PyAsyncExecutor* self) {
+  const std::string& str = tkrzw::SPrintF("AsyncExecutor:%p", (void*)self->executor.get());
+  return CreatePyString(str);
+}
+
+// Implementation of AsyncExecutor#Inspect.
+static PyObject* asyncexecutor_Inspect(PyAsyncExecutor* self) {
+  if (self->executor == nullptr) {
+    ThrowInvalidArguments("not initialized object");
     return nullptr;
   }
-  if (is_unicode) {
-    return CreatePyString(value);
+  const AsyncExecutor::Stats stats = self->executor->GetStats();
+  const std::vector<std::pair<const char*, PyObject*>> records = {
+    {"num_threads", PyLong_FromLong(stats.num_threads)},
+    {"num_pending", PyLong_FromLongLong(stats.num_pending)},
+    {"num_executed", PyLong_FromLongLong(stats.num_executed)},
+    {"num_stolen", PyLong_FromLongLong(stats.num_stolen)},
+  };
+  PyObject* pyrv = PyDict_New();
+  for (const auto& rec : records) {
+    PyDict_SetItemString(pyrv, rec.first, rec.second);
+    Py_DECREF(rec.second);
   }
-  return CreatePyBytes(value);
+  return pyrv;
 }
 
-// Implementation of DBM#__contains__.
-static int dbm_contains(PyDBM* self, PyObject* pykey) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
-    return -1;
-  }
-  SoftString key(pykey);
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
+// Implementation of AsyncDBM.new.
+static PyObject* asyncdbm_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
+  PyAsyncDBM* self = (PyAsyncDBM*)pytype->tp_alloc(pytype, 0);
+  if (!self) return nullptr;
+  self->mutex = NewHandleMutex();
+  self->dbm = nullptr;
+  new (&self->queue) std::shared_ptr<AsyncQueue>();
+  new (&self->bloom_filter) std::shared_ptr<BloomFilter>();
+  new (&self->object_cache) std::shared_ptr<ObjectCache>();
+  self->priority = AsyncQueue::PRIORITY_NORMAL;
+  self->timeout = -1;
+  self->concurrent = false;
+  RegisterForkHandle((PyObject*)self, AbandonAsyncDBMHandle);
+  return (PyObject*)self;
+}
+
+// Implementation of AsyncDBM#dealloc.
+static void asyncdbm_dealloc(PyAsyncDBM* self) {
+  UnregisterForkHandle((PyObject*)self);
   {
     NativeLock lock(self->concurrent);
-    status = self->dbm->Get(key.Get());
-  }
-  if (status == tkrzw::Status::SUCCESS) {
-    return 1;
-  }
-  if (status == tkrzw::Status::NOT_FOUND_ERROR) {
-    return 0;
+    self->queue.reset();
   }
-  return -1;
+  self->queue.~shared_ptr();
+  self->bloom_filter.~shared_ptr();
+  self->object_cache.~shared_ptr();
+  delete self->mutex;
+  PyTypeObject* pytype = Py_TYPE(self);
+  pytype->tp_free((PyObject*)self);
+  Py_DECREF(pytype);
 }
 
-// Implementation of DBM#__setitem__ and DBM#__delitem__.
-static int dbm_setitem(PyDBM* self, PyObject* pykey, PyObject* pyvalue) {
-  if (self->dbm == nullptr) {
+// Implementation of AsyncDBM#__init__.
+static int asyncdbm_init(PyAsyncDBM* self, PyObject* pyargs, PyObject* pykwds) {
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 2) {
+    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");    
+    return -1;
+  }
+  PyObject* pydbm = PyTuple_GET_ITEM(pyargs, 0);
+  if (!PyObject_IsInstance(pydbm, GetModuleState(self)->cls_dbm)) {
+    ThrowInvalidArguments("the argument is not a DBM");
+    return -1;
+  }
+  PyDBM* dbm = (PyDBM*)pydbm;
+  HandleLock dbm_lock(dbm->mutex, false);
+  if (dbm->dbm == nullptr) {
     ThrowInvalidArguments("not opened database");
     return -1;
   }
-  if (pyvalue) {
-    SoftString key(pykey);
-    SoftString value(pyvalue);
-    tkrzw::Status status(tkrzw::Status::SUCCESS);
-    {
-      NativeLock lock(self->concurrent);
-      status = self->dbm->Set(key.Get(), value.Get());
-    }
-    if (status != tkrzw::Status::SUCCESS) {
-      ThrowStatusException(status);
+  PyObject* pyexecutor = PyTuple_GET_ITEM(pyargs, 1);
+  std::shared_ptr<AsyncExecutor> executor;
+  if (PyObject_IsInstance(pyexecutor, GetModuleState(self)->cls_asyncexecutor)) {
+    executor = ((PyAsyncExecutor*)pyexecutor)->executor;
+    if (executor == nullptr) {
+      ThrowInvalidArguments("not initialized executor");
       return -1;
     }
   } else {
-    SoftString key(pykey);
-    tkrzw::Status status(tkrzw::Status::SUCCESS);
-    {
-      NativeLock lock(self->concurrent);
-      status = self->dbm->Remove(key.Get());
-    }
-    if (status != tkrzw::Status::SUCCESS) {
-      ThrowStatusException(status);
+    executor = std::make_shared<AsyncExecutor>(PyObjToInt(pyexecutor), false);
+  }
+  int64_t max_queue_size = 0;
+  AsyncQueue::OverflowPolicy overflow = AsyncQueue::OVERFLOW_BLOCK;
+  int32_t priority = AsyncQueue::PRIORITY_NORMAL;
+  double timeout = -1;
+  bool coalesce = false;
+  bool shard_routing = false;
+  if (pykwds != nullptr) {
+    const auto& params = MapKeywords(pykwds);
+    coalesce = tkrzw::StrToBool(tkrzw::SearchMap(params, "coalesce", "false"));
+    shard_routing = tkrzw::StrToBool(tkrzw::SearchMap(params, "shard_routing", "false"));
+    priority = tkrzw::StrToInt(tkrzw::SearchMap(params, "priority", "1"));
+    timeout = tkrzw::StrToDouble(tkrzw::SearchMap(params, "timeout", "-1"));
+    max_queue_size = std::max<int64_t>(
+        0, tkrzw::StrToInt(tkrzw::SearchMap(params, "max_queue_size", "0")));
+    const std::string& overflow_name = tkrzw::SearchMap(params, "overflow", "block");
+    if (overflow_name == "block") {
+      overflow = AsyncQueue::OVERFLOW_BLOCK;
+    } else if (overflow_name == "fail") {
+      overflow = AsyncQueue::OVERFLOW_FAIL;
+    } else if (overflow_name == "drop_read") {
+      overflow = AsyncQueue::OVERFLOW_DROP_READ;
+    } else {
+      ThrowInvalidArguments("unknown overflow policy");
       return -1;
     }
   }
-  return 0;
+  if (priority < 0 || priority >= AsyncQueue::NUM_PRIORITIES) {
+    ThrowInvalidArguments("invalid priority");
+    return -1;
+  }
+  if (shard_routing && dbm->num_shards < 1) {
+    ThrowInvalidArguments("not sharded database");
+    return -1;
+  }
+  self->dbm = dbm->dbm;
+  if (dbm->has_bloom_filter) {
+    self->bloom_filter = std::atomic_load(&dbm->bloom_filter);
+  }
+  self->object_cache = dbm->object_cache;
+  self->queue = std::make_shared<AsyncQueue>(
+      std::move(executor), max_queue_size, overflow, coalesce,
+      shard_routing ? dbm->num_shards : 0);
+  self->priority = static_cast<AsyncQueue::Priority>(priority);
+  self->timeout = timeout;
+  self->concurrent = dbm->concurrent;
+  return 0;
+}
+
+// Implementation of AsyncDBM#__repr__.
+static PyObject* asyncdbm_repr(PyAsyncDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  const std::string& str = tkrzw::SPrintF("<tkrzw.AsyncDBM: %p>", (void*)self->queue.get());
+  return CreatePyString(str);
+}
+
+// Implementation of AsyncDBM#__str__.
+static PyObject* asyncdbm_str(PyAsyncDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  const std::string& str = tkrzw::SPrintF("AsyncDBM:%p", (void*)self->queue.get());
+  return CreatePyString(str);
+}
+
+// Adds a task to the queue of AsyncDBM and makes a future object of the result.
+static PyObject* SubmitAsyncTask(
+    PyAsyncDBM* self, std::unique_ptr<AsyncQueue::Task> task, tkrzw::StatusFuture&& future,
+    bool is_str = false) {
+  task->priority = self->priority;
+  if (self->timeout >= 0) {
+    task->deadline = std::chrono::steady_clock::now() +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(self->timeout));
+  }
+  if (!task->readonly && self->object_cache != nullptr) {
+    // The cached object is invalidated after the write so that a value read before it is not
+    // cached later.  Operations on unknown keys clear the whole cache.
+    std::shared_ptr<ObjectCache> cache = self->object_cache;
+    if (task->has_key) {
+      task->on_done = [cache, key = task->key]() { cache->Remove(key); };
+    } else {
+      task->on_done = [cache]() { cache->Clear(); };
+    }
+  }
+  if (!self->queue->Add(std::move(task), false)) {
+    NativeLock lock(true);
+    self->queue->Add(std::move(task), true);
+  }
+  return CreatePyFutureMove(self, std::move(future), self->concurrent, is_str);
 }
 
-// Implementation of DBM#__iter__.
-static PyObject* dbm_iter(PyDBM* self) {
-  if (self->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+// Implementation of AsyncDBM#Destruct.
+static PyObject* asyncdbm_Destruct(PyAsyncDBM* self) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
     return nullptr;
   }
-  PyTypeObject* pyitertype = (PyTypeObject*)cls_iter;
-  PyIterator* pyiter = (PyIterator*)pyitertype->tp_alloc(pyitertype, 0);
-  if (!pyiter) return nullptr;
   {
     NativeLock lock(self->concurrent);
-    pyiter->iter = self->dbm->MakeIterator().release();
-    pyiter->concurrent = self->concurrent;
-    pyiter->iter->First();
+    self->queue->Stop();
+    self->queue.reset();
   }
-  return (PyObject*)pyiter;
+  self->dbm = nullptr;
+  Py_RETURN_NONE;  
 }
 
-// Defines the DBM class.
-static bool DefineDBM() {
-  static PyTypeObject pytype = {PyVarObject_HEAD_INIT(nullptr, 0)};
-  const size_t zoff = offsetof(PyTypeObject, tp_name);
-  std::memset((char*)&pytype + zoff, 0, sizeof(pytype) - zoff);
-  pytype.tp_name = "tkrzw.DBM";
-  pytype.tp_basicsize = sizeof(PyDBM);
-  pytype.tp_itemsize = 0;
-  pytype.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
-  pytype.tp_doc = "Polymorphic database manager.";
-  pytype.tp_new = dbm_new;
-  pytype.tp_dealloc = (destructor)dbm_dealloc;
-  pytype.tp_init = (initproc)dbm_init;
-  pytype.tp_repr = (unaryfunc)dbm_repr;
-  pytype.tp_str = (unaryfunc)dbm_str;
-  static PyMethodDef methods[] = {
-    {"Open", (PyCFunction)dbm_Open, METH_VARARGS | METH_KEYWORDS,
-     "Opens a database file."},
-    {"Close", (PyCFunction)dbm_Close, METH_NOARGS,
-     "Closes the database file."},
-    {"Process", (PyCFunction)dbm_Process, METH_VARARGS,
-     "Processes a record with an arbitrary function."},
-    {"Get", (PyCFunction)dbm_Get, METH_VARARGS,
-     "Gets the value of a record of a key."},
-    {"GetStr", (PyCFunction)dbm_GetStr, METH_VARARGS,
-     "Gets the value of a record of a key, as a string."},
-    {"GetMulti", (PyCFunction)dbm_GetMulti, METH_VARARGS,
-     "Gets the values of multiple records of keys."},
-    {"GetMultiStr", (PyCFunction)dbm_GetMultiStr, METH_VARARGS,
-     "Gets the values of multiple records of keys, as strings."},
-    {"Set", (PyCFunction)dbm_Set, METH_VARARGS,
-     "Sets a record of a key and a value."},
-    {"SetMulti", (PyCFunction)dbm_SetMulti, METH_VARARGS | METH_KEYWORDS,
-     "Sets multiple records specified by an initializer list of pairs of strings."},
-    {"SetAndGet", (PyCFunction)dbm_SetAndGet, METH_VARARGS,
-     "Sets a record and get the old value."},
-    {"Remove", (PyCFunction)dbm_Remove, METH_VARARGS,
-     "Removes a record of a key."},
-    {"RemoveMulti", (PyCFunction)dbm_RemoveMulti, METH_VARARGS,
-     "Removes records of keys."},
-    {"RemoveAndGet", (PyCFunction)dbm_RemoveAndGet, METH_VARARGS,
-     "Removes a record and get the value."},
-    {"Append", (PyCFunction)dbm_Append, METH_VARARGS,
-     "Appends data at the end of a record of a key."},
-    {"AppendMulti", (PyCFunction)dbm_AppendMulti, METH_VARARGS | METH_KEYWORDS,
-     "Appends data to multiple records of the keyword arguments."},
-    {"CompareExchange", (PyCFunction)dbm_CompareExchange, METH_VARARGS,
-     "Compares the value of a record and exchanges if the condition meets."},
-    {"CompareExchangeAndGet", (PyCFunction)dbm_CompareExchangeAndGet, METH_VARARGS,
-     "Does compare-and-exchange and/or gets the old value of the record."},
-    {"Increment", (PyCFunction)dbm_Increment, METH_VARARGS,
-     "Increments the numeric value of a record."},
-    {"ProcessMulti", (PyCFunction)dbm_ProcessMulti, METH_VARARGS,
-     "Processes multiple records with arbitrary functions."},
-    {"CompareExchangeMulti", (PyCFunction)dbm_CompareExchangeMulti, METH_VARARGS,
-     "Compares the values of records and exchanges if the condition meets."},
-    {"Rekey", (PyCFunction)dbm_Rekey, METH_VARARGS,
-     "Changes the key of a record."},
-    {"PopFirst", (PyCFunction)dbm_PopFirst, METH_VARARGS,
-     "Gets the first record and removes it."},
-    {"PopFirstStr", (PyCFunction)dbm_PopFirstStr, METH_VARARGS,
-     "Gets the first record as strings and removes it."},
-    {"PushLast", (PyCFunction)dbm_PushLast, METH_VARARGS,
-     "Adds a record with a key of the current timestamp."},
-    {"ProcessEach", (PyCFunction)dbm_ProcessEach, METH_VARARGS,
-     "Processes each and every record in the database with an arbitrary function."},
-    {"Count", (PyCFunction)dbm_Count, METH_NOARGS,
-     "Gets the number of records."},
-    {"GetFileSize", (PyCFunction)dbm_GetFileSize, METH_NOARGS,
-     "Gets the current file size of the database."},
-    {"GetFilePath", (PyCFunction)dbm_GetFilePath, METH_NOARGS,
-     "Gets the path of the database file."},
-    {"GetTimestamp", (PyCFunction)dbm_GetTimestamp, METH_NOARGS,
-     "Gets the timestamp in seconds of the last modified time."},
-    {"Clear", (PyCFunction)dbm_Clear, METH_NOARGS,
-     "Removes all records."},
-    {"Rebuild", (PyCFunction)dbm_Rebuild, METH_VARARGS | METH_KEYWORDS,
-     "Rebuilds the entire database."},
-    {"ShouldBeRebuilt", (PyCFunction)dbm_ShouldBeRebuilt, METH_NOARGS,
-     "Checks whether the database should be rebuilt."},
-    {"Synchronize", (PyCFunction)dbm_Synchronize, METH_VARARGS | METH_KEYWORDS,
-     "Synchronizes the content of the database to the file system."},
-    {"CopyFileData", (PyCFunction)dbm_CopyFileData, METH_VARARGS,
-     "Copies the content of the database file to another file."},
-    {"Export", (PyCFunction)dbm_Export, METH_VARARGS,
-     "Exports all records to another database."},
-    {"ExportToFlatRecords", (PyCFunction)dbm_ExportToFlatRecords, METH_VARARGS,
-     "Exports all records of a database to a flat record file."},
-    {"ImportFromFlatRecords", (PyCFunction)dbm_ImportFromFlatRecords, METH_VARARGS,
-     "Imports records to a database from a flat record file."},
-    {"ExportKeysAsLines", (PyCFunction)dbm_ExportKeysAsLines, METH_VARARGS,
-     "Exports the keys of all records as lines to a text file."},
-    {"Inspect", (PyCFunction)dbm_Inspect, METH_NOARGS,
-     "Inspects the database."},
-    {"IsOpen", (PyCFunction)dbm_IsOpen, METH_NOARGS,
-     "Checks whether the database is open."},
-    {"IsWritable", (PyCFunction)dbm_IsWritable, METH_NOARGS,
-     "Checks whether the database is writable."},
-    {"IsHealthy", (PyCFunction)dbm_IsHealthy, METH_NOARGS,
-     "Checks whether the database condition is healthy."},
-    {"IsOrdered", (PyCFunction)dbm_IsOrdered, METH_NOARGS,
-     "Checks whether ordered operations are supported."},
-    {"Search", (PyCFunction)dbm_Search, METH_VARARGS,
-     "Searches the database and get keys which match a pattern."},
-    {"MakeIterator", (PyCFunction)dbm_MakeIterator, METH_NOARGS,
-     "Makes an iterator for each record."},   
-    {"RestoreDatabase", (PyCFunction)dbm_RestoreDatabase, METH_CLASS | METH_VARARGS,
-     "Makes an iterator for each record."},   
-    {nullptr, nullptr, 0, nullptr},
-  };
-  pytype.tp_methods = methods;
-  static PyMappingMethods map_methods;
-  std::memset(&map_methods, 0, sizeof(map_methods));
-  map_methods.mp_length = (lenfunc)dbm_len;
-  map_methods.mp_subscript = (binaryfunc)dbm_getitem;
-  map_methods.mp_ass_subscript = (objobjargproc)dbm_setitem;
-  pytype.tp_as_mapping = &map_methods;
-  static PySequenceMethods seq_methods;
-  std::memset(&seq_methods, 0, sizeof(seq_methods));
-  seq_methods.sq_contains = (objobjproc)dbm_contains;
-  pytype.tp_as_sequence = &seq_methods;
-  pytype.tp_iter = (getiterfunc)dbm_iter;
-  if (PyType_Ready(&pytype) != 0) return false;
-  cls_dbm = (PyObject*)&pytype;
-  Py_INCREF(cls_dbm);
-  obj_dbm_any_data = PyBytes_FromStringAndSize("\0[ANY]\0", 7);
-  if (PyObject_GenericSetAttr(
-          cls_dbm, PyUnicode_FromString("ANY_DATA"), obj_dbm_any_data) != 0) {
-    return false;
+// Implementation of AsyncDBM#WithOptions.
+static PyObject* asyncdbm_WithOptions(PyAsyncDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
   }
-  if (PyModule_AddObject(mod_tkrzw, "DBM", cls_dbm) != 0) return false;
-  return true;
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc < 1 || argc > 2) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  const int32_t priority = PyObjToInt(PyTuple_GET_ITEM(pyargs, 0));
+  if (priority < 0 || priority >= AsyncQueue::NUM_PRIORITIES) {
+    ThrowInvalidArguments("invalid priority");
+    return nullptr;
+  }
+  PyObject* pytimeout = argc > 1 ? PyTuple_GET_ITEM(pyargs, 1) : Py_None;
+  const double timeout = pytimeout == Py_None ? -1 : PyObjToDouble(pytimeout);
+  PyAsyncDBM* pyrv = (PyAsyncDBM*)asyncdbm_new(Py_TYPE(self), nullptr, nullptr);
+  if (!pyrv) return nullptr;
+  pyrv->dbm = self->dbm;
+  pyrv->queue = self->queue;
+  pyrv->bloom_filter = self->bloom_filter;
+  pyrv->object_cache = self->object_cache;
+  pyrv->priority = static_cast<AsyncQueue::Priority>(priority);
+  pyrv->timeout = timeout;
+  pyrv->concurrent = self->concurrent;
+  return (PyObject*)pyrv;
 }
 
-// Implementation of Iterator.new.
-static PyObject* iter_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
-  PyIterator* self = (PyIterator*)pytype->tp_alloc(pytype, 0);
-  if (!self) return nullptr;
-  self->iter = nullptr;
-  self->concurrent = false;
-  return (PyObject*)self;
+// Implementation of AsyncDBM#Inspect.
+static PyObject* asyncdbm_Inspect(PyAsyncDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
+  }
+  const AsyncQueue::Stats stats = self->queue->GetStats();
+  const double wait_time_mean =
+      stats.num_done > 0 ? stats.wait_time_total / stats.num_done : 0.0;
+  const double utilization = stats.elapsed_time > 0 ?
+      stats.busy_time / (stats.elapsed_time * stats.num_threads) : 0.0;
+  const std::vector<std::pair<const char*, PyObject*>> records = {
+    {"num_threads", PyLong_FromLong(stats.num_threads)},
+    {"num_shards", PyLong_FromLong(stats.num_shards)},
+    {"max_queue_size", PyLong_FromLongLong(stats.max_size)},
+    {"queue_size", PyLong_FromLongLong(stats.queue_size)},
+    {"num_running", PyLong_FromLong(stats.num_running)},
+    {"num_done", PyLong_FromLongLong(stats.num_done)},
+    {"num_rejected", PyLong_FromLongLong(stats.num_rejected)},
+    {"num_dropped", PyLong_FromLongLong(stats.num_dropped)},
+    {"num_expired", PyLong_FromLongLong(stats.num_expired)},
+    {"num_coalesced", PyLong_FromLongLong(stats.num_coalesced)},
+    {"wait_time_total", PyFloat_FromDouble(stats.wait_time_total)},
+    {"wait_time_mean", PyFloat_FromDouble(wait_time_mean)},
+    {"wait_time_max", PyFloat_FromDouble(stats.wait_time_max)},
+    {"busy_time", PyFloat_FromDouble(stats.busy_time)},
+    {"elapsed_time", PyFloat_FromDouble(stats.elapsed_time)},
+    {"utilization", PyFloat_FromDouble(utilization)},
+  };
+  PyObject* pyrv = PyDict_New();
+  for (const auto& rec : records) {
+    PyDict_SetItemString(pyrv, rec.first, rec.second);
+    Py_DECREF(rec.second);
+  }
+  return pyrv;
 }
 
-// Implementation of Iterator#dealloc.
-static void iter_dealloc(PyIterator* self) {
-  delete self->iter;
-  Py_TYPE(self)->tp_free((PyObject*)self);
+// Implementation of AsyncDBM#Get.
+static PyObject* asyncdbm_Get(PyAsyncDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
+  SoftString key(pykey);
+  tkrzw::ParamDBM* dbm = self->dbm;
+  auto task = std::make_unique<AsyncTask<std::pair<tkrzw::Status, std::string>>>(
+      [dbm, key = std::string(key.Get())]() {
+        std::string value;
+        tkrzw::Status status = dbm->Get(key, &value);
+        return std::make_pair(std::move(status), std::move(value));
+      }, true);
+  task->coalesce = AsyncQueue::COALESCE_READ;
+  task->SetKey(key.Get());
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
 }
 
-// Implementation of Iterator#__init__.
-static int iter_init(PyIterator* self, PyObject* pyargs, PyObject* pykwds) {
+// Implementation of AsyncDBM#GetStr.
+static PyObject* asyncdbm_GetStr(PyAsyncDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
+  }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
   if (argc != 1) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
-    return -1;
+    return nullptr;
   }
-  PyObject* pydbm_obj = PyTuple_GET_ITEM(pyargs, 0);
-  if (!PyObject_IsInstance(pydbm_obj, cls_dbm)) {
-    ThrowInvalidArguments("the argument is not a DBM");
-    return -1;
+  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
+  SoftString key(pykey);
+  tkrzw::ParamDBM* dbm = self->dbm;
+  auto task = std::make_unique<AsyncTask<std::pair<tkrzw::Status, std::string>>>(
+      [dbm, key = std::string(key.Get())]() {
+        std::string value;
+        tkrzw::Status status = dbm->Get(key, &value);
+        return std::make_pair(std::move(status), std::move(value));
+      }, true);
+  task->coalesce = AsyncQueue::COALESCE_READ;
+  task->SetKey(key.Get());
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future), true);
+}
+
+// Implementation of AsyncDBM#GetMulti.
+static PyObject* asyncdbm_GetMulti(PyAsyncDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
   }
-  PyDBM* pydbm = (PyDBM*)pydbm_obj;
-  {
-    NativeLock lock(pydbm->concurrent);
-    self->iter = pydbm->dbm->MakeIterator().release();
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  std::vector<std::string> keys;
+  for (int32_t i = 0; i < argc; i++) {
+    PyObject* pykey = PyTuple_GET_ITEM(pyargs, i);
+    SoftString key(pykey);
+    keys.emplace_back(std::string(key.Get()));
   }
-  self->concurrent = pydbm->concurrent;
-  return 0;
+  tkrzw::ParamDBM* dbm = self->dbm;
+  auto task = std::make_unique<AsyncTask<
+    std::pair<tkrzw::Status, std::map<std::string, std::string>>>>(
+        [dbm, keys = std::move(keys)]() {
+          std::vector<std::string_view> key_views(keys.begin(), keys.end());
+          std::map<std::string, std::string> records;
+          tkrzw::Status status = dbm->GetMulti(key_views, &records);
+          return std::make_pair(std::move(status), std::move(records));
+        }, true);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
 }
 
-// Implementation of Iterator#__repr__.
-static PyObject* iter_repr(PyIterator* self) {
-  std::string key;
-  {
-    NativeLock lock(self->concurrent);
-    const tkrzw::Status status = self->iter->Get(&key);
-    if (status != tkrzw::Status::SUCCESS) {
-      key = "(unlocated)";
-    }
+// Implementation of AsyncDBM#GetMultiStr.
+static PyObject* asyncdbm_GetMultiStr(PyAsyncDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
   }
-  return CreatePyString(tkrzw::StrCat(
-      "<tkrzw.Iterator: key=", tkrzw::StrEscapeC(key, true), ">"));
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  std::vector<std::string> keys;
+  for (int32_t i = 0; i < argc; i++) {
+    PyObject* pykey = PyTuple_GET_ITEM(pyargs, i);
+    SoftString key(pykey);
+    keys.emplace_back(std::string(key.Get()));
+  }
+  tkrzw::ParamDBM* dbm = self->dbm;
+  auto task = std::make_unique<AsyncTask<
+    std::pair<tkrzw::Status, std::map<std::string, std::string>>>>(
+        [dbm, keys = std::move(keys)]() {
+          std::vector<std::string_view> key_views(keys.begin(), keys.end());
+          std::map<std::string, std::string> records;
+          tkrzw::Status status = dbm->GetMulti(key_views, &records);
+          return std::make_pair(std::move(status), std::move(records));
+        }, true);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future), true);
 }
 
-// Implementation of Iterator#__str__.
-static PyObject* iter_str(PyIterator* self) {
-  std::string key;
-  {
-    NativeLock lock(self->concurrent);
-    const tkrzw::Status status = self->iter->Get(&key);
-    if (status != tkrzw::Status::SUCCESS) {
-      key = "(unlocated)";
-    }
+// Implementation of AsyncDBM#Set.
+static PyObject* asyncdbm_Set(PyAsyncDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
   }
-  return CreatePyString(tkrzw::StrEscapeC(key, true));
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc < 2 || argc > 3) {
+    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
+  PyObject* pyvalue = PyTuple_GET_ITEM(pyargs, 1);
+  const bool overwrite = argc > 2 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 2)) : true;
+  SoftString key(pykey);
+  SoftString value(pyvalue);
+  tkrzw::ParamDBM* dbm = self->dbm;
+  std::shared_ptr<BloomFilter> bloom = self->bloom_filter;
+  auto task = std::make_unique<AsyncTask<tkrzw::Status>>(
+      [dbm, bloom, key = std::string(key.Get()), value = std::string(value.Get()), overwrite]() {
+        tkrzw::Status status = dbm->Set(key, value, overwrite);
+        if (bloom != nullptr) {
+          bloom->Add(key);
+        }
+        return status;
+      }, false);
+  task->coalesce = overwrite ? AsyncQueue::COALESCE_WRITE : AsyncQueue::COALESCE_NONE;
+  task->SetKey(key.Get());
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
 }
 
-// Implementation of Iterator#First.
-static PyObject* iter_First(PyIterator* self) {
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->iter->First();
+// Implementation of AsyncDBM#SetMulti.
+static PyObject* asyncdbm_SetMulti(PyAsyncDBM* self, PyObject* pyargs, PyObject* pykwds) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc > 1) {
+    ThrowInvalidArguments("too many arguments");
+    return nullptr;
   }
-  return CreatePyTkStatusMove(std::move(status));
-}
-
-// Implementation of Iterator#Last.
-static PyObject* iter_Last(PyIterator* self) {
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->iter->Last();
+  PyObject* pyoverwrite = argc > 0 ? PyTuple_GET_ITEM(pyargs, 0) : Py_True;
+  const bool overwrite = PyObject_IsTrue(pyoverwrite);
+  std::map<std::string, std::string> records;
+  if (pykwds != nullptr) {
+    records = MapKeywords(pykwds);
   }
-  return CreatePyTkStatusMove(std::move(status));
+  tkrzw::ParamDBM* dbm = self->dbm;
+  std::shared_ptr<BloomFilter> bloom = self->bloom_filter;
+  auto task = std::make_unique<AsyncTask<tkrzw::Status>>(
+      [dbm, bloom, records = std::move(records), overwrite]() {
+        std::map<std::string_view, std::string_view> record_views;
+        for (const auto& record : records) {
+          record_views.emplace(std::make_pair(
+              std::string_view(record.first), std::string_view(record.second)));
+        }
+        tkrzw::Status status = dbm->SetMulti(record_views, overwrite);
+        if (bloom != nullptr) {
+          for (const auto& record : records) {
+            bloom->Add(record.first);
+          }
+        }
+        return status;
+      }, false);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
 }
 
-// Implementation of Iterator#Jump.
-static PyObject* iter_Jump(PyIterator* self, PyObject* pyargs) {
+// Implementation of AsyncDBM#Remove.
+static PyObject* asyncdbm_Remove(PyAsyncDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
+  }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
   if (argc != 1) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
@@ -2952,593 +7890,962 @@ static PyObject* iter_Jump(PyIterator* self, PyObject* pyargs) {
   }
   PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
   SoftString key(pykey);
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->iter->Jump(key.Get());
-  }
-  return CreatePyTkStatusMove(std::move(status));
+  tkrzw::ParamDBM* dbm = self->dbm;
+  auto task = std::make_unique<AsyncTask<tkrzw::Status>>(
+      [dbm, key = std::string(key.Get())]() {
+        return dbm->Remove(key);
+      }, false);
+  task->SetKey(key.Get());
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
 }
 
-// Implementation of Iterator#JumpLower.
-static PyObject* iter_JumpLower(PyIterator* self, PyObject* pyargs) {
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 1 || argc > 2) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+// Implementation of AsyncDBM#RemoveMulti.
+static PyObject* asyncdbm_RemoveMulti(PyAsyncDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
     return nullptr;
   }
-  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
-  const bool inclusive = argc > 1 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 1)) : false;
-  SoftString key(pykey);
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->iter->JumpLower(key.Get(), inclusive);
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  std::vector<std::string> keys;
+  for (int32_t i = 0; i < argc; i++) {
+    PyObject* pykey = PyTuple_GET_ITEM(pyargs, i);
+    SoftString key(pykey);
+    keys.emplace_back(std::string(key.Get()));
   }
-  return CreatePyTkStatusMove(std::move(status));
+  tkrzw::ParamDBM* dbm = self->dbm;
+  auto task = std::make_unique<AsyncTask<tkrzw::Status>>(
+      [dbm, keys = std::move(keys)]() {
+        std::vector<std::string_view> key_views(keys.begin(), keys.end());
+        return dbm->RemoveMulti(key_views);
+      }, false);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
 }
 
-// Implementation of Iterator#JumpUpper.
-static PyObject* iter_JumpUpper(PyIterator* self, PyObject* pyargs) {
+// Implementation of AsyncDBM#Append.
+static PyObject* asyncdbm_Append(PyAsyncDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
+  }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 1 || argc > 2) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+  if (argc < 2 || argc > 3) {
+    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
   PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
-  const bool inclusive = argc > 1 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 1)) : false;
+  PyObject* pyvalue = PyTuple_GET_ITEM(pyargs, 1);
+  PyObject* pydelim = argc > 2 ? PyTuple_GET_ITEM(pyargs, 2) : nullptr;
   SoftString key(pykey);
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->iter->JumpUpper(key.Get(), inclusive);
-  }
-  return CreatePyTkStatusMove(std::move(status));
+  SoftString value(pyvalue);
+  SoftString delim(pydelim == nullptr ? Py_None : pydelim);
+  tkrzw::ParamDBM* dbm = self->dbm;
+  std::shared_ptr<BloomFilter> bloom = self->bloom_filter;
+  auto task = std::make_unique<AsyncTask<tkrzw::Status>>(
+      [dbm, bloom, key = std::string(key.Get()), value = std::string(value.Get()),
+       delim = std::string(delim.Get())]() {
+        tkrzw::Status status = dbm->Append(key, value, delim);
+        if (bloom != nullptr) {
+          bloom->Add(key);
+        }
+        return status;
+      }, false);
+  task->SetKey(key.Get());
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
 }
 
-// Implementation of Iterator#Next.
-static PyObject* iter_Next(PyIterator* self) {
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->iter->Next();
+// Implementation of AsyncDBM#AppendMulti.
+static PyObject* asyncdbm_AppendMulti(PyAsyncDBM* self, PyObject* pyargs, PyObject* pykwds) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
   }
-  return CreatePyTkStatusMove(std::move(status));
-}
-
-// Implementation of Iterator#Previous.
-static PyObject* iter_Previous(PyIterator* self) {
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->iter->Previous();
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc > 1) {
+    ThrowInvalidArguments("too many arguments");
+    return nullptr;
+  }
+  PyObject* pydelim = argc > 0 ? PyTuple_GET_ITEM(pyargs, 0) : nullptr;
+  SoftString delim(pydelim == nullptr ? Py_None : pydelim);
+  std::map<std::string, std::string> records;
+  if (pykwds != nullptr) {
+    records = MapKeywords(pykwds);
   }
-  return CreatePyTkStatusMove(std::move(status));
+  tkrzw::ParamDBM* dbm = self->dbm;
+  std::shared_ptr<BloomFilter> bloom = self->bloom_filter;
+  auto task = std::make_unique<AsyncTask<tkrzw::Status>>(
+      [dbm, bloom, records = std::move(records), delim = std::string(delim.Get())]() {
+        std::map<std::string_view, std::string_view> record_views;
+        for (const auto& record : records) {
+          record_views.emplace(std::make_pair(
+              std::string_view(record.first), std::string_view(record.second)));
+        }
+        tkrzw::Status status = dbm->AppendMulti(record_views, delim);
+        if (bloom != nullptr) {
+          for (const auto& record : records) {
+            bloom->Add(record.first);
+          }
+        }
+        return status;
+      }, false);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
 }
 
-// Implementation of Iterator#Get.
-static PyObject* iter_Get(PyIterator* self, PyObject* pyargs) {
+// Implementation of AsyncDBM#CompareExchange.
+static PyObject* asyncdbm_CompareExchange(PyAsyncDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
+  }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc > 1) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+  if (argc != 3) {
+    ThrowInvalidArguments(argc < 3 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pystatus = nullptr;
-  if (argc > 0) {
-    pystatus = PyTuple_GET_ITEM(pyargs, 0);
-    if (pystatus == Py_None) {
-      pystatus = nullptr;
-    } else if (!PyObject_IsInstance(pystatus, cls_status)) {
-      ThrowInvalidArguments("not a status object");
-      return nullptr;
+  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
+  PyObject* pyexpected = PyTuple_GET_ITEM(pyargs, 1);
+  PyObject* pydesired = PyTuple_GET_ITEM(pyargs, 2);
+  SoftString key(pykey);
+  auto expected = std::make_shared<std::string>();
+  std::string_view expected_view;
+  if (pyexpected != Py_None) {
+    if (pyexpected == GetModuleState(self)->obj_dbm_any_data) {
+      expected_view = tkrzw::DBM::ANY_DATA;
+    } else {
+      SoftString expected_str(pyexpected);
+      *expected = expected_str.Get();
+      expected_view = *expected;
     }
-  }  
-  std::string key, value;
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->iter->Get(&key, &value);
   }
-  if (pystatus != nullptr) {
-    *((PyTkStatus*)pystatus)->status = status;
-  }
-  if (status == tkrzw::Status::SUCCESS) {
-    PyObject* pykey = CreatePyBytes(key);
-    PyObject* pyvalue = CreatePyBytes(value);
-    PyObject * pyrv = PyTuple_Pack(2, pykey, pyvalue);
-    Py_DECREF(pyvalue);
-    Py_DECREF(pykey);
-    return pyrv;
+  auto desired = std::make_shared<std::string>();
+  std::string_view desired_view;
+  if (pydesired != Py_None) {
+    if (pydesired == GetModuleState(self)->obj_dbm_any_data) {
+      desired_view = tkrzw::DBM::ANY_DATA;
+    } else {
+      SoftString desired_str(pydesired);
+      *desired = desired_str.Get();
+      desired_view = *desired;
+    }
   }
-  Py_RETURN_NONE;
+  tkrzw::ParamDBM* dbm = self->dbm;
+  std::shared_ptr<BloomFilter> bloom = self->bloom_filter;
+  auto task = std::make_unique<AsyncTask<tkrzw::Status>>(
+      [dbm, bloom, key = std::string(key.Get()), expected, expected_view,
+       desired, desired_view]() {
+        tkrzw::Status status = dbm->CompareExchange(key, expected_view, desired_view);
+        if (bloom != nullptr) {
+          bloom->Add(key);
+        }
+        return status;
+      }, false);
+  task->SetKey(key.Get());
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
 }
 
-// Implementation of Iterator#GetStr.
-static PyObject* iter_GetStr(PyIterator* self, PyObject* pyargs) {
+// Implementation of AsyncDBM#Increment.
+static PyObject* asyncdbm_Increment(PyAsyncDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
+  }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc > 1) {
+  if (argc < 1 || argc > 3) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pystatus = nullptr;
-  if (argc > 0) {
-    pystatus = PyTuple_GET_ITEM(pyargs, 0);
-    if (pystatus == Py_None) {
-      pystatus = nullptr;
-    } else if (!PyObject_IsInstance(pystatus, cls_status)) {
-      ThrowInvalidArguments("not a status object");
-      return nullptr;
-    }
-  }  
-  std::string key, value;
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->iter->Get(&key, &value);
-  }
-  if (pystatus != nullptr) {
-    *((PyTkStatus*)pystatus)->status = status;
+  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
+  SoftString key(pykey);
+  int64_t inc = 1;
+  if (argc > 1) {
+    PyObject* pyinc = PyTuple_GET_ITEM(pyargs, 1);
+    inc = PyObjToInt(pyinc);
   }
-  if (status == tkrzw::Status::SUCCESS) {
-    PyObject* pykey = CreatePyString(key);
-    PyObject* pyvalue = CreatePyString(value);
-    PyObject * pyrv = PyTuple_Pack(2, pykey, pyvalue);
-    Py_DECREF(pyvalue);
-    Py_DECREF(pykey);
-    return pyrv;
+  int64_t init = 0;
+  if (argc > 2) {
+    PyObject* pyinit = PyTuple_GET_ITEM(pyargs, 2);
+    init = PyObjToInt(pyinit);
   }
-  Py_RETURN_NONE;
+  tkrzw::ParamDBM* dbm = self->dbm;
+  std::shared_ptr<BloomFilter> bloom = self->bloom_filter;
+  auto task = std::make_unique<AsyncTask<std::pair<tkrzw::Status, int64_t>>>(
+      [dbm, bloom, key = std::string(key.Get()), inc, init]() {
+        int64_t current = 0;
+        tkrzw::Status status = dbm->Increment(key, inc, &current, init);
+        if (bloom != nullptr) {
+          bloom->Add(key);
+        }
+        return std::make_pair(std::move(status), current);
+      }, false);
+  task->SetKey(key.Get());
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
 }
 
-// Implementation of Iterator#GetKey.
-static PyObject* iter_GetKey(PyIterator* self, PyObject* pyargs) {
+// Implementation of AsyncDBM#CompareExchangeMulti.
+static PyObject* asyncdbm_CompareExchangeMulti(PyAsyncDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
+  }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc > 1) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+  if (argc != 2) {
+    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pystatus = nullptr;
-  if (argc > 0) {
-    pystatus = PyTuple_GET_ITEM(pyargs, 0);
-    if (pystatus == Py_None) {
-      pystatus = nullptr;
-    } else if (!PyObject_IsInstance(pystatus, cls_status)) {
-      ThrowInvalidArguments("not a status object");
-      return nullptr;
-    }
+  PyObject* pyexpected = PyTuple_GET_ITEM(pyargs, 0);
+  PyObject* pydesired = PyTuple_GET_ITEM(pyargs, 1);
+  if (!PySequence_Check(pyexpected) || !PySequence_Check(pydesired)) {
+    ThrowInvalidArguments("parameters must be sequences of strings");
+    return nullptr;
   }
-  std::string key;
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->iter->Get(&key);
+  auto expected_ph = std::make_shared<std::vector<std::string>>();
+  auto expected = ExtractSVPairs(self, pyexpected, expected_ph.get());
+  auto desired_ph = std::make_shared<std::vector<std::string>>();
+  auto desired = ExtractSVPairs(self, pydesired, desired_ph.get());
+  tkrzw::ParamDBM* dbm = self->dbm;
+  std::shared_ptr<BloomFilter> bloom = self->bloom_filter;
+  auto task = std::make_unique<AsyncTask<tkrzw::Status>>(
+      [dbm, bloom, expected_ph, expected = std::move(expected),
+       desired_ph, desired = std::move(desired)]() {
+        tkrzw::Status status = dbm->CompareExchangeMulti(expected, desired);
+        if (bloom != nullptr) {
+          for (const auto& record : desired) {
+            bloom->Add(record.first);
+          }
+        }
+        return status;
+      }, false);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
+}
+
+// Implementation of AsyncDBM#Rekey.
+static PyObject* asyncdbm_Rekey(PyAsyncDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
   }
-  if (pystatus != nullptr) {
-    *((PyTkStatus*)pystatus)->status = status;
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc < 2 || argc > 4) {
+    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pyold_key = PyTuple_GET_ITEM(pyargs, 0);
+  PyObject* pynew_key = PyTuple_GET_ITEM(pyargs, 1);
+  const bool overwrite = argc > 2 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 2)) : true;
+  const bool copying = argc > 3 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 3)) : false;
+  SoftString old_key(pyold_key);
+  SoftString new_key(pynew_key);
+  tkrzw::ParamDBM* dbm = self->dbm;
+  std::shared_ptr<BloomFilter> bloom = self->bloom_filter;
+  auto task = std::make_unique<AsyncTask<tkrzw::Status>>(
+      [dbm, bloom, old_key = std::string(old_key.Get()), new_key = std::string(new_key.Get()),
+       overwrite, copying]() {
+        tkrzw::Status status = dbm->Rekey(old_key, new_key, overwrite, copying);
+        if (bloom != nullptr) {
+          bloom->Add(new_key);
+        }
+        return status;
+      }, false);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
+}
+
+// Makes a task of AsyncDBM#PopFirst.
+static std::unique_ptr<AsyncTask<std::pair<tkrzw::Status, std::pair<std::string, std::string>>>>
+MakePopFirstTask(tkrzw::ParamDBM* dbm) {
+  return std::make_unique<AsyncTask<
+    std::pair<tkrzw::Status, std::pair<std::string, std::string>>>>(
+        [dbm]() {
+          std::string key, value;
+          tkrzw::Status status = dbm->PopFirst(&key, &value);
+          return std::make_pair(std::move(status),
+                                std::make_pair(std::move(key), std::move(value)));
+        }, false);
+}
+
+// Implementation of AsyncDBM#PopFirst.
+static PyObject* asyncdbm_PopFirst(PyAsyncDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
   }
-  if (status != tkrzw::Status::SUCCESS) {
-    Py_RETURN_NONE;
+  auto task = MakePopFirstTask(self->dbm);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
+}
+
+// Implementation of AsyncDBM#PopFirstStr.
+static PyObject* asyncdbm_PopFirstStr(PyAsyncDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
   }
-  return CreatePyBytes(key);
+  auto task = MakePopFirstTask(self->dbm);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future), true);
 }
 
-// Implementation of Iterator#GetKeyStr.
-static PyObject* iter_GetKeyStr(PyIterator* self, PyObject* pyargs) {
+// Implementation of AsyncDBM#PushLast.
+static PyObject* asyncdbm_PushLast(PyAsyncDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
+  }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc > 1) {
+  if (argc < 1 || argc > 2) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pystatus = nullptr;
-  if (argc > 0) {
-    pystatus = PyTuple_GET_ITEM(pyargs, 0);
-    if (pystatus == Py_None) {
-      pystatus = nullptr;
-    } else if (!PyObject_IsInstance(pystatus, cls_status)) {
-      ThrowInvalidArguments("not a status object");
-      return nullptr;
-    }
-  }
-  std::string key;
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->iter->Get(&key);
-  }
-  if (pystatus != nullptr) {
-    *((PyTkStatus*)pystatus)->status = status;
-  }
-  if (status != tkrzw::Status::SUCCESS) {
-    Py_RETURN_NONE;
+  PyObject* pyvalue = PyTuple_GET_ITEM(pyargs, 0);
+  const double wtime = argc > 1 ? PyObjToDouble(PyTuple_GET_ITEM(pyargs, 1)) : -1;
+  SoftString value(pyvalue);
+  if (self->bloom_filter != nullptr) {
+    self->bloom_filter->Disable();
   }
-  return CreatePyString(key);
+  tkrzw::ParamDBM* dbm = self->dbm;
+  auto task = std::make_unique<AsyncTask<tkrzw::Status>>(
+      [dbm, value = std::string(value.Get()), wtime]() {
+        return dbm->PushLast(value, wtime);
+      }, false);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
 }
 
-// Implementation of Iterator#GetValue.
-static PyObject* iter_GetValue(PyIterator* self, PyObject* pyargs) {
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc > 1) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+// Implementation of AsyncDBM#Clear.
+static PyObject* asyncdbm_Clear(PyAsyncDBM* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
     return nullptr;
   }
-  PyObject* pystatus = nullptr;
-  if (argc > 0) {
-    pystatus = PyTuple_GET_ITEM(pyargs, 0);
-    if (pystatus == Py_None) {
-      pystatus = nullptr;
-    } else if (!PyObject_IsInstance(pystatus, cls_status)) {
-      ThrowInvalidArguments("not a status object");
-      return nullptr;
-    }
-  }
-  std::string value;
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->iter->Get(nullptr, &value);
+  tkrzw::ParamDBM* dbm = self->dbm;
+  auto task = std::make_unique<AsyncTask<tkrzw::Status>>(
+      [dbm]() {
+        return dbm->Clear();
+      }, false);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
+}
+
+// Implementation of AsyncDBM#Rebuild.
+static PyObject* asyncdbm_Rebuild(PyAsyncDBM* self, PyObject* pyargs, PyObject* pykwds) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
   }
-  if (pystatus != nullptr) {
-    *((PyTkStatus*)pystatus)->status = status;
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 0) {
+    ThrowInvalidArguments("too many arguments");
+    return nullptr;
   }
-  if (status != tkrzw::Status::SUCCESS) {
-    Py_RETURN_NONE;
+  std::map<std::string, std::string> params;
+  if (pykwds != nullptr) {
+    params = MapKeywords(pykwds);
   }
-  return CreatePyBytes(value);
+  tkrzw::ParamDBM* dbm = self->dbm;
+  auto task = std::make_unique<AsyncTask<tkrzw::Status>>(
+      [dbm, params = std::move(params)]() {
+        return dbm->RebuildAdvanced(params);
+      }, false);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
 }
 
-// Implementation of Iterator#GetValueStr.
-static PyObject* iter_GetValueStr(PyIterator* self, PyObject* pyargs) {
+// Implementation of AsyncDBM#Synchronize.
+static PyObject* asyncdbm_Synchronize(PyAsyncDBM* self, PyObject* pyargs, PyObject* pykwds) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
+  }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc > 1) {
+  if (argc != 1) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pystatus = nullptr;
-  if (argc > 0) {
-    pystatus = PyTuple_GET_ITEM(pyargs, 0);
-    if (pystatus == Py_None) {
-      pystatus = nullptr;
-    } else if (!PyObject_IsInstance(pystatus, cls_status)) {
-      ThrowInvalidArguments("not a status object");
-      return nullptr;
-    }
-  }
-  std::string value;
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->iter->Get(nullptr, &value);
+  PyObject* pyhard = PyTuple_GET_ITEM(pyargs, 0);
+  const bool hard = PyObject_IsTrue(pyhard);
+  std::map<std::string, std::string> params;
+  if (pykwds != nullptr) {
+    params = MapKeywords(pykwds);
   }
-  if (pystatus != nullptr) {
-    *((PyTkStatus*)pystatus)->status = status;
+  tkrzw::ParamDBM* dbm = self->dbm;
+  auto task = std::make_unique<AsyncTask<tkrzw::Status>>(
+      [dbm, hard, params = std::move(params)]() {
+        return dbm->SynchronizeAdvanced(hard, nullptr, params);
+      }, false);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
+}
+
+// Implementation of AsyncDBM#CopyFileData.
+static PyObject* asyncdbm_CopyFileData(PyAsyncDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
   }
-  if (status != tkrzw::Status::SUCCESS) {
-    Py_RETURN_NONE;
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc < 1 || argc > 2) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
   }
-  return CreatePyString(value);
+  bool sync_hard = false;
+  if (argc > 1) {
+    PyObject* pysync_hard = PyTuple_GET_ITEM(pyargs, 1);
+    sync_hard = PyObject_IsTrue(pysync_hard);
+  }  
+  PyObject* pydest = PyTuple_GET_ITEM(pyargs, 0);
+  SoftString dest(pydest);
+  tkrzw::ParamDBM* dbm = self->dbm;
+  auto task = std::make_unique<AsyncTask<tkrzw::Status>>(
+      [dbm, dest = std::string(dest.Get()), sync_hard]() {
+        return dbm->CopyFileData(dest, sync_hard);
+      }, false);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
 }
 
-// Implementation of Iterator#Set.
-static PyObject* iter_Set(PyIterator* self, PyObject* pyargs) {
+// Implementation of AsyncDBM#Export.
+static PyObject* asyncdbm_Export(PyAsyncDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
+  }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
   if (argc != 1) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pyvalue = PyTuple_GET_ITEM(pyargs, 0);
-  SoftString value(pyvalue);
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->iter->Set(value.Get());
+  PyObject* pydest = PyTuple_GET_ITEM(pyargs, 0);
+  if (!PyObject_IsInstance(pydest, GetModuleState(self)->cls_dbm)) {
+    ThrowInvalidArguments("the argument is not a DBM");
+    return nullptr;
   }
-  return CreatePyTkStatusMove(std::move(status));
-}
-
-// Implementation of Iterator#Remove.
-static PyObject* iter_Remove(PyIterator* self) {
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->iter->Remove();
+  PyDBM* dest = (PyDBM*)pydest;
+  HandleLock dest_lock(dest->mutex, false);
+  if (dest->dbm == nullptr) {
+    ThrowInvalidArguments("not opened database");
+    return nullptr;
   }
-  return CreatePyTkStatusMove(std::move(status));
+  DisableBloomFilter(dest);
+  tkrzw::ParamDBM* dbm = self->dbm;
+  tkrzw::ParamDBM* dest_dbm = dest->dbm;
+  auto task = std::make_unique<AsyncTask<tkrzw::Status>>(
+      [dbm, dest_dbm]() {
+        return dbm->Export(dest_dbm);
+      }, false);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
 }
 
-// Implementation of Iterator#Step.
-static PyObject* iter_Step(PyIterator* self, PyObject* pyargs) {
+// Implementation of AsyncDBM#ExportToFlatRecords.
+static PyObject* asyncdbm_ExportToFlatRecords(PyAsyncDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
+  }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc > 1) {
+  if (argc != 1) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pystatus = nullptr;
-  if (argc > 0) {
-    pystatus = PyTuple_GET_ITEM(pyargs, 0);
-    if (pystatus == Py_None) {
-      pystatus = nullptr;
-    } else if (!PyObject_IsInstance(pystatus, cls_status)) {
-      ThrowInvalidArguments("not a status object");
-      return nullptr;
-    }
-  }  
-  std::string key, value;
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->iter->Step(&key, &value);
-  }
-  if (pystatus != nullptr) {
-    *((PyTkStatus*)pystatus)->status = status;
+  PyObject* pydest_file = PyTuple_GET_ITEM(pyargs, 0);
+  if (!PyObject_IsInstance(pydest_file, GetModuleState(self)->cls_file)) {
+    ThrowInvalidArguments("the argument is not a File");
+    return nullptr;
   }
-  if (status == tkrzw::Status::SUCCESS) {
-    PyObject* pykey = CreatePyBytes(key);
-    PyObject* pyvalue = CreatePyBytes(value);
-    PyObject * pyrv = PyTuple_Pack(2, pykey, pyvalue);
-    Py_DECREF(pyvalue);
-    Py_DECREF(pykey);
-    return pyrv;
+  PyFile* dest_file = (PyFile*)pydest_file;
+  HandleLock dest_lock(dest_file->mutex, false);
+  if (dest_file->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
+    return nullptr;
   }
-  Py_RETURN_NONE;
+  tkrzw::ParamDBM* dbm = self->dbm;
+  tkrzw::PolyFile* file = dest_file->file;
+  auto remap_guard = std::make_shared<FileRemapGuard>(dest_file);
+  auto task = std::make_unique<AsyncTask<tkrzw::Status>>(
+      [dbm, file, remap_guard]() {
+        if (remap_guard->GetStatus() != tkrzw::Status::SUCCESS) {
+          return remap_guard->GetStatus();
+        }
+        return tkrzw::ExportDBMToFlatRecords(dbm, file);
+      }, false);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
 }
 
-// Implementation of Iterator#StepStr.
-static PyObject* iter_StepStr(PyIterator* self, PyObject* pyargs) {
+// Implementation of AsyncDBM#ImportFromFlatRecords.
+static PyObject* asyncdbm_ImportFromFlatRecords(PyAsyncDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
+  }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc > 1) {
+  if (argc != 1) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pystatus = nullptr;
-  if (argc > 0) {
-    pystatus = PyTuple_GET_ITEM(pyargs, 0);
-    if (pystatus == Py_None) {
-      pystatus = nullptr;
-    } else if (!PyObject_IsInstance(pystatus, cls_status)) {
-      ThrowInvalidArguments("not a status object");
-      return nullptr;
-    }
-  }  
-  std::string key, value;
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->iter->Step(&key, &value);
+  PyObject* pysrc_file = PyTuple_GET_ITEM(pyargs, 0);
+  if (!PyObject_IsInstance(pysrc_file, GetModuleState(self)->cls_file)) {
+    ThrowInvalidArguments("the argument is not a File");
+    return nullptr;
   }
-  if (pystatus != nullptr) {
-    *((PyTkStatus*)pystatus)->status = status;
+  PyFile* src_file = (PyFile*)pysrc_file;
+  HandleLock src_lock(src_file->mutex, false);
+  if (src_file->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
+    return nullptr;
   }
-  if (status == tkrzw::Status::SUCCESS) {
-    PyObject* pykey = CreatePyString(key);
-    PyObject* pyvalue = CreatePyString(value);
-    PyObject * pyrv = PyTuple_Pack(2, pykey, pyvalue);
-    Py_DECREF(pyvalue);
-    Py_DECREF(pykey);
-    return pyrv;
+  if (self->bloom_filter != nullptr) {
+    self->bloom_filter->Disable();
   }
-  Py_RETURN_NONE;
+  tkrzw::ParamDBM* dbm = self->dbm;
+  tkrzw::PolyFile* file = src_file->file;
+  auto task = std::make_unique<AsyncTask<tkrzw::Status>>(
+      [dbm, file]() {
+        return tkrzw::ImportDBMFromFlatRecords(dbm, file);
+      }, false);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future));
 }
 
-// Implementation of Iterator#__next__.
-static PyObject* iter_iternext(PyIterator* self) {
-  std::string key, value;
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->iter->Get(&key, &value);
+// Implementation of AsyncDBM#Search.
+static PyObject* asyncdbm_Search(PyAsyncDBM* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc < 2 || argc > 3) {
+    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
+    return nullptr;
   }
-  PyObject* pyrv = nullptr;
-  if (status == tkrzw::Status::SUCCESS) {
-    PyObject* pykey = CreatePyBytes(key);
-    PyObject* pyvalue = CreatePyBytes(value);
-    pyrv = PyTuple_Pack(2, pykey, pyvalue);
-    Py_DECREF(pykey);
-    Py_DECREF(pyvalue);
-    self->iter->Next();
-  } else {
-    PyErr_SetString(PyExc_StopIteration, "end of iteration");
-    pyrv = nullptr;
+  PyObject* pymode = PyTuple_GET_ITEM(pyargs, 0);
+  PyObject* pypattern = PyTuple_GET_ITEM(pyargs, 1);
+  int32_t capacity = 0;
+  if (argc > 2) {
+    capacity = PyObjToInt(PyTuple_GET_ITEM(pyargs, 2));
   }
-  return pyrv;
+  SoftString pattern(pypattern);
+  SoftString mode(pymode);
+  tkrzw::ParamDBM* dbm = self->dbm;
+  auto task = std::make_unique<AsyncTask<std::pair<tkrzw::Status, std::vector<std::string>>>>(
+      [dbm, mode = std::string(mode.Get()), pattern = std::string(pattern.Get()), capacity]() {
+        std::vector<std::string> keys;
+        tkrzw::Status status = tkrzw::SearchDBMModal(dbm, mode, pattern, &keys, capacity);
+        return std::make_pair(std::move(status), std::move(keys));
+      }, true);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncTask(self, std::move(task), std::move(future), true);
+}
+
+// Defines the AsyncExecutor class.
+static bool DefineAsyncExecutor(PyObject* module, ModuleState* state) {
+  static PyMethodDef methods[] = {
+    {"Inspect", (PyCFunction)asyncexecutor_Inspect, METH_NOARGS,
+     "Inspects the worker threads."},
+    {nullptr, nullptr, 0, nullptr},
+  };
+  static PyType_Slot slots[] = {
+    {Py_tp_doc, (void*)"Pool of worker threads shared by asynchronous database adapters."},
+    {Py_tp_new, (void*)asyncexecutor_new},
+    {Py_tp_dealloc, (void*)asyncexecutor_dealloc},
+    {Py_tp_init, (void*)asyncexecutor_init},
+    {Py_tp_repr, (void*)asyncexecutor_repr},
+    {Py_tp_str, (void*)asyncexecutor_str},
+    {Py_tp_methods, (void*)methods},
+    {0, nullptr},
+  };
+  static PyType_Spec spec = {
+    "tkrzw.AsyncExecutor", sizeof(PyAsyncExecutor), 0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, slots};
+  state->cls_asyncexecutor = PyType_FromModuleAndSpec(module, &spec, nullptr);
+  if (state->cls_asyncexecutor == nullptr) return false;
+  if (PyModule_AddObjectRef(module, "AsyncExecutor", state->cls_asyncexecutor) != 0) return false;
+  return true;
 }
 
-// Defines the Iterator class.
-static bool DefineIterator() {
-  static PyTypeObject pytype = {PyVarObject_HEAD_INIT(nullptr, 0)};
-  const size_t zoff = offsetof(PyTypeObject, tp_name);
-  std::memset((char*)&pytype + zoff, 0, sizeof(pytype) - zoff);
-  pytype.tp_name = "tkrzw.Iterator";
-  pytype.tp_basicsize = sizeof(PyIterator);
-  pytype.tp_itemsize = 0;
-  pytype.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
-  pytype.tp_doc = "Iterator for each record.";
-  pytype.tp_new = iter_new;
-  pytype.tp_dealloc = (destructor)iter_dealloc;
-  pytype.tp_init = (initproc)iter_init;
-  pytype.tp_repr = (unaryfunc)iter_repr;
-  pytype.tp_str = (unaryfunc)iter_str;
+// Defines the AsyncDBM class.
+static bool DefineAsyncDBM(PyObject* module, ModuleState* state) {
   static PyMethodDef methods[] = {
-    {"First", (PyCFunction)iter_First, METH_NOARGS,
-     "Initializes the iterator to indicate the first record."},
-    {"Last", (PyCFunction)iter_Last, METH_NOARGS,
-     "Initializes the iterator to indicate the last record."},
-    {"Jump", (PyCFunction)iter_Jump, METH_VARARGS,
-     "Initializes the iterator to indicate a specific record."},
-    {"JumpLower", (PyCFunction)iter_JumpLower, METH_VARARGS,
-     "Initializes the iterator to indicate the last record whose key is lower."},
-    {"JumpUpper", (PyCFunction)iter_JumpUpper, METH_VARARGS,
-     "Initializes the iterator to indicate the first record whose key is upper."},
-    {"Next", (PyCFunction)iter_Next, METH_NOARGS,
-     "Moves the iterator to the next record."},
-    {"Previous", (PyCFunction)iter_Previous, METH_NOARGS,
-     "Moves the iterator to the previous record."},
-    {"Get", (PyCFunction)iter_Get, METH_VARARGS,
-     "Gets the key and the value of the current record of the iterator."},
-    {"GetStr", (PyCFunction)iter_GetStr, METH_VARARGS,
-     "Gets the key and the value of the current record of the iterator, as strings."},
-    {"GetKey", (PyCFunction)iter_GetKey, METH_VARARGS,
-     "Gets the key of the current record."},
-    {"GetKeyStr", (PyCFunction)iter_GetKeyStr, METH_VARARGS,
-     "Gets the key of the current record, as a string."},
-    {"GetValue", (PyCFunction)iter_GetValue, METH_VARARGS,
-     "Gets the value of the current record."},
-    {"GetValueStr", (PyCFunction)iter_GetValueStr, METH_VARARGS,
-     "Gets the value of the current record, as a string."},
-    {"Set", (PyCFunction)iter_Set, METH_VARARGS,
-     "Sets the value of the current record."},
-    {"Remove", (PyCFunction)iter_Remove, METH_NOARGS,
-     "Removes the current record."},
-    {"Step", (PyCFunction)iter_Step, METH_VARARGS,
-     "Gets the current record and moves the iterator to the next record."},
-    {"StepStr", (PyCFunction)iter_StepStr, METH_VARARGS,
-     "Gets the current record and moves the iterator to the next record, as strings."},
-    {nullptr, nullptr, 0, nullptr}
+    {"Destruct", (PyCFunction)asyncdbm_Destruct, METH_NOARGS,
+     "Destructs the asynchronous database adapter."},
+    {"WithOptions", (PyCFunction)asyncdbm_WithOptions, METH_VARARGS,
+     "Makes an adapter which shares the task queue and applies the given options."},
+    {"Inspect", (PyCFunction)asyncdbm_Inspect, METH_NOARGS,
+     "Inspects the task queue."},
+    {"Get", (PyCFunction)asyncdbm_Get, METH_VARARGS,
+     "Gets the value of a record of a key."},
+    {"GetStr", (PyCFunction)asyncdbm_GetStr, METH_VARARGS,
+     "Gets the value of a record of a key, as a string."},
+    {"GetMulti", (PyCFunction)asyncdbm_GetMulti, METH_VARARGS,
+     "Gets the values of multiple records of keys."},
+    {"GetMultiStr", (PyCFunction)asyncdbm_GetMultiStr, METH_VARARGS,
+     "Gets the values of multiple records of keys, as strings."},
+    {"Set", (PyCFunction)asyncdbm_Set, METH_VARARGS,
+     "Sets a record of a key and a value."},
+    {"SetMulti", (PyCFunction)asyncdbm_SetMulti, METH_VARARGS | METH_KEYWORDS,
+     "Sets multiple records specified by an initializer list of pairs of strings."},
+    {"Remove", (PyCFunction)asyncdbm_Remove, METH_VARARGS,
+     "Removes a record of a key."},
+    {"RemoveMulti", (PyCFunction)asyncdbm_RemoveMulti, METH_VARARGS,
+     "Removes records of keys."},
+    {"Append", (PyCFunction)asyncdbm_Append, METH_VARARGS,
+     "Appends data at the end of a record of a key."},
+    {"AppendMulti", (PyCFunction)asyncdbm_AppendMulti, METH_VARARGS | METH_KEYWORDS,
+     "Appends data to multiple records of the keyword arguments."},
+    {"CompareExchange", (PyCFunction)asyncdbm_CompareExchange, METH_VARARGS,
+     "Compares the value of a record and exchanges if the condition meets."},
+    {"Increment", (PyCFunction)asyncdbm_Increment, METH_VARARGS,
+     "Increments the numeric value of a record."},
+    {"CompareExchangeMulti", (PyCFunction)asyncdbm_CompareExchangeMulti, METH_VARARGS,
+     "Compares the values of records and exchanges if the condition meets."},
+    {"Rekey", (PyCFunction)asyncdbm_Rekey, METH_VARARGS,
+     "Changes the key of a record."},
+    {"PopFirst", (PyCFunction)asyncdbm_PopFirst, METH_NOARGS,
+     "Gets the first record and removes it."},
+    {"PopFirstStr", (PyCFunction)asyncdbm_PopFirstStr, METH_NOARGS,
+     "Gets the first record as strings and removes it."},
+    {"PushLast", (PyCFunction)asyncdbm_PushLast, METH_VARARGS,
+     "Adds a record with a key of the current timestamp."},
+    {"Clear", (PyCFunction)asyncdbm_Clear, METH_NOARGS,
+     "Removes all records."},
+    {"Rebuild", (PyCFunction)asyncdbm_Rebuild, METH_VARARGS | METH_KEYWORDS,
+     "Rebuilds the entire database."},
+    {"Synchronize", (PyCFunction)asyncdbm_Synchronize, METH_VARARGS | METH_KEYWORDS,
+     "Synchronizes the content of the database to the file system."},
+    {"CopyFileData", (PyCFunction)asyncdbm_CopyFileData, METH_VARARGS,
+     "Copies the content of the database file to another file."},
+    {"Export", (PyCFunction)asyncdbm_Export, METH_VARARGS,
+     "Exports all records to another database."},
+    {"ExportToFlatRecords", (PyCFunction)asyncdbm_ExportToFlatRecords, METH_VARARGS,
+     "Exports all records of a database to a flat record file."},
+    {"ImportFromFlatRecords", (PyCFunction)asyncdbm_ImportFromFlatRecords, METH_VARARGS,
+     "Imports records to a database from a flat record file."},
+    {"Search", (PyCFunction)asyncdbm_Search, METH_VARARGS,
+     "Searches the database and get keys which match a pattern."},
+    {nullptr, nullptr, 0, nullptr},
+  };
+  static PyType_Slot slots[] = {
+    {Py_tp_doc, (void*)"Polymorphic database manager."},
+    {Py_tp_new, (void*)asyncdbm_new},
+    {Py_tp_dealloc, (void*)asyncdbm_dealloc},
+    {Py_tp_init, (void*)asyncdbm_init},
+    {Py_tp_repr, (void*)asyncdbm_repr},
+    {Py_tp_str, (void*)asyncdbm_str},
+    {Py_tp_methods, (void*)methods},
+    {0, nullptr},
   };
-  pytype.tp_methods = methods;
-  pytype.tp_iternext = (iternextfunc)iter_iternext;
-  if (PyType_Ready(&pytype) != 0) return false;
-  cls_iter = (PyObject*)&pytype;
-  Py_INCREF(cls_iter);
-  if (PyModule_AddObject(mod_tkrzw, "Iterator", cls_iter) != 0) return false;
+  static PyType_Spec spec = {
+    "tkrzw.AsyncDBM", sizeof(PyAsyncDBM), 0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, slots};
+  state->cls_asyncdbm = PyType_FromModuleAndSpec(module, &spec, nullptr);
+  if (state->cls_asyncdbm == nullptr) return false;
+  if (!SetConstLong(state->cls_asyncdbm, "PRIORITY_INTERACTIVE",
+                    (int64_t)AsyncQueue::PRIORITY_INTERACTIVE)) return false;
+  if (!SetConstLong(state->cls_asyncdbm, "PRIORITY_NORMAL",
+                    (int64_t)AsyncQueue::PRIORITY_NORMAL)) return false;
+  if (!SetConstLong(state->cls_asyncdbm, "PRIORITY_BACKGROUND",
+                    (int64_t)AsyncQueue::PRIORITY_BACKGROUND)) return false;
+  if (PyModule_AddObjectRef(module, "AsyncDBM", state->cls_asyncdbm) != 0) return false;
   return true;
 }
 
-// Implementation of AsyncDBM.new.
-static PyObject* asyncdbm_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
-  PyAsyncDBM* self = (PyAsyncDBM*)pytype->tp_alloc(pytype, 0);
+// Implementation of File.new.
+static PyObject* file_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
+  PyFile* self = (PyFile*)pytype->tp_alloc(pytype, 0);
   if (!self) return nullptr;
-  self->async = nullptr;
+  // Some methods and the objects made from the file use the handle without the GIL, so the
+  // mutex is made on every build.
+  self->mutex = new std::shared_mutex();
+  self->file = nullptr;
+  self->generation = 0;
   self->concurrent = false;
+  self->writable = false;
+  new (&self->num_views) std::atomic<int64_t>(0);
+  new (&self->num_remaps) std::atomic<int64_t>(0);
+  new (&self->remap_mutex) std::mutex();
+  new (&self->remap_cond) std::condition_variable();
+  RegisterForkHandle((PyObject*)self, AbandonFileHandle);
   return (PyObject*)self;
 }
 
-// Implementation of AsyncDBM#dealloc.
-static void asyncdbm_dealloc(PyAsyncDBM* self) {
-  delete self->async;
-  Py_TYPE(self)->tp_free((PyObject*)self);
+// Implementation of File#dealloc.
+static void file_dealloc(PyFile* self) {
+  UnregisterForkHandle((PyObject*)self);
+  delete self->file;
+  delete self->mutex;
+  self->remap_cond.~condition_variable();
+  self->remap_mutex.~mutex();
+  PyTypeObject* pytype = Py_TYPE(self);
+  pytype->tp_free((PyObject*)self);
+  Py_DECREF(pytype);
 }
 
-// Implementation of AsyncDBM#__init__.
-static int asyncdbm_init(PyAsyncDBM* self, PyObject* pyargs, PyObject* pykwds) {
+// Implementation of File#__init__.
+static int file_init(PyFile* self, PyObject* pyargs, PyObject* pykwds) {
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 2) {
-    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");    
-    return -1;
-  }
-  PyObject* pydbm = PyTuple_GET_ITEM(pyargs, 0);
-  if (!PyObject_IsInstance(pydbm, cls_dbm)) {
-    ThrowInvalidArguments("the argument is not a DBM");
-    return -1;
-  }
-  PyDBM* dbm = (PyDBM*)pydbm;
-  if (dbm->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+  if (argc != 0) {
+    ThrowInvalidArguments("too many arguments");
     return -1;
   }
-  PyObject* pynum_threads = PyTuple_GET_ITEM(pyargs, 1);
-  const int32_t num_threads = PyObjToInt(pynum_threads);
-  self->async = new tkrzw::AsyncDBM(dbm->dbm, num_threads);
-  self->concurrent = dbm->concurrent;
   return 0;
 }
 
-// Implementation of AsyncDBM#__repr__.
-static PyObject* asyncdbm_repr(PyAsyncDBM* self) {
-  const std::string& str = tkrzw::SPrintF("<tkrzw.AsyncDBM: %p>", (void*)self->async);
+// Implementation of File#__repr__.
+static PyObject* file_repr(PyFile* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->file == nullptr) {
+    return CreatePyString("<tkrzw.File:(unopened)>");
+  }
+  std::string class_name = "unknown";
+  auto* in_file = self->file->GetInternalFile();
+  if (in_file != nullptr) {
+    const auto& file_type = in_file->GetType();
+    if (file_type == typeid(tkrzw::StdFile)) {
+      class_name = "StdFile";
+    } else if (file_type == typeid(tkrzw::MemoryMapParallelFile)) {
+      class_name = "MemoryMapParallelFile";
+    } else if (file_type == typeid(tkrzw::MemoryMapAtomicFile)) {
+      class_name = "MemoryMapAtomicFile";
+    } else if (file_type == typeid(tkrzw::PositionalParallelFile)) {
+      class_name = "PositionalParallelFile";
+    } else if (file_type == typeid(tkrzw::PositionalAtomicFile)) {
+      class_name = "PositionalAtomicFile";
+    }
+  }
+  const std::string path = self->file->GetPathSimple();
+  const int64_t size = self->file->GetSizeSimple();
+  const std::string& str = tkrzw::StrCat(
+      "<tkrzw.File: class=", class_name,
+      " path=", tkrzw::StrEscapeC(path, true), " size=", size, ">");
   return CreatePyString(str);
 }
 
-// Implementation of AsyncDBM#__str__.
-static PyObject* asyncdbm_str(PyAsyncDBM* self) {
-  const std::string& str = tkrzw::SPrintF("AsyncDBM:%p", (void*)self->async);
+// Implementation of File#__str__.
+static PyObject* file_str(PyFile* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->file == nullptr) {
+    return CreatePyString("(unopened)");
+  }
+  std::string class_name = "unknown";
+  auto* in_file = self->file->GetInternalFile();
+  if (in_file != nullptr) {
+    const auto& file_type = in_file->GetType();
+    if (file_type == typeid(tkrzw::StdFile)) {
+      class_name = "StdFile";
+    } else if (file_type == typeid(tkrzw::MemoryMapParallelFile)) {
+      class_name = "MemoryMapParallelFile";
+    } else if (file_type == typeid(tkrzw::MemoryMapAtomicFile)) {
+      class_name = "MemoryMapAtomicFile";
+    } else if (file_type == typeid(tkrzw::PositionalParallelFile)) {
+      class_name = "PositionalParallelFile";
+    } else if (file_type == typeid(tkrzw::PositionalAtomicFile)) {
+      class_name = "PositionalAtomicFile";
+    }
+  }
+  const std::string path = self->file->GetPathSimple();
+  const int64_t size = self->file->GetSizeSimple();
+  const std::string& str = tkrzw::StrCat(
+      "class=", class_name, " path=", tkrzw::StrEscapeC(path, true), " size=", size);
   return CreatePyString(str);
 }
 
-// Implementation of AsyncDBM#Destruct.
-static PyObject* asyncdbm_Destruct(PyAsyncDBM* self) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
+// Implementation of File#Open.
+static PyObject* file_Open(PyFile* self, PyObject* pyargs, PyObject* pykwds) {
+  HandleLock handle_lock(self->mutex, true);
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 2) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  delete self->async;
-  self->async = nullptr;
-  Py_RETURN_NONE;  
-}
-
-// Implementation of AsyncDBM#Get.
-static PyObject* asyncdbm_Get(PyAsyncDBM* self, PyObject* pyargs) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
-    return nullptr;
+  PyObject* pypath = PyTuple_GET_ITEM(pyargs, 0);
+  PyObject* pywritable = PyTuple_GET_ITEM(pyargs, 1);
+  SoftString path(pypath);
+  const bool writable = PyObject_IsTrue(pywritable);
+  bool concurrent = false;
+  int32_t open_options = 0;
+  std::map<std::string, std::string> params;
+  if (pykwds != nullptr) {
+    params = MapKeywords(pykwds);
+    if (tkrzw::StrToBool(tkrzw::SearchMap(params, "concurrent", "false"))) {
+      concurrent = true;
+    }
+    if (tkrzw::StrToBool(tkrzw::SearchMap(params, "truncate", "false"))) {
+      open_options |= tkrzw::File::OPEN_TRUNCATE;
+    }
+    if (tkrzw::StrToBool(tkrzw::SearchMap(params, "no_create", "false"))) {
+      open_options |= tkrzw::File::OPEN_NO_CREATE;
+    }
+    if (tkrzw::StrToBool(tkrzw::SearchMap(params, "no_wait", "false"))) {
+      open_options |= tkrzw::File::OPEN_NO_WAIT;
+    }
+    if (tkrzw::StrToBool(tkrzw::SearchMap(params, "no_lock", "false"))) {
+      open_options |= tkrzw::File::OPEN_NO_LOCK;
+    }
+    if (tkrzw::StrToBool(tkrzw::SearchMap(params, "sync_hard", "false"))) {
+      open_options |= tkrzw::File::OPEN_SYNC_HARD;
+    }
+    params.erase("concurrent");
+    params.erase("truncate");
+    params.erase("no_create");
+    params.erase("no_wait");
+    params.erase("no_lock");
+    params.erase("sync_hard");
+  }
+  self->file = new tkrzw::PolyFile();
+  self->concurrent = concurrent;
+  self->writable = writable;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->file->OpenAdvanced(std::string(path.Get()), writable, open_options, params);
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 1) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
-    return nullptr;
+  if (status != tkrzw::Status::SUCCESS) {
+    delete self->file;
+    self->file = nullptr;
   }
-  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
-  SoftString key(pykey);
-  tkrzw::StatusFuture future(self->async->Get(key.Get()));
-  return CreatePyFutureMove(std::move(future), self->concurrent);
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of AsyncDBM#GetStr.
-static PyObject* asyncdbm_GetStr(PyAsyncDBM* self, PyObject* pyargs) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
+// Implementation of File#Close
+static PyObject* file_Close(PyFile* self) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
     return nullptr;
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 1) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
-    return nullptr;
+  FileRemapGuard remap_guard(self);
+  if (remap_guard.GetStatus() != tkrzw::Status::SUCCESS) {
+    return CreatePyTkStatus(self, remap_guard.GetStatus());
   }
-  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
-  SoftString key(pykey);
-  tkrzw::StatusFuture future(self->async->Get(key.Get()));
-  return CreatePyFutureMove(std::move(future), self->concurrent, true);
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->file->Close();
+  }
+  delete self->file;
+  self->file = nullptr;
+  self->generation++;
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of AsyncDBM#GetMulti.
-static PyObject* asyncdbm_GetMulti(PyAsyncDBM* self, PyObject* pyargs) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
-    return nullptr;
+// Range of a file to be read into a destination buffer.
+struct FileReadRange {
+  int64_t off;
+  int64_t size;
+  char* dest;
+};
+
+// Reads ranges of a file, coalescing overlapping and adjacent ones and reading them in parallel.
+static tkrzw::Status ReadFileRanges(tkrzw::File* file, std::vector<FileReadRange>* ranges) {
+  std::stable_sort(ranges->begin(), ranges->end(),
+                   [](const FileReadRange& a, const FileReadRange& b) { return a.off < b.off; });
+  struct RangeGroup {
+    size_t begin;
+    size_t end;
+    int64_t off;
+    int64_t size;
+  };
+  std::vector<RangeGroup> groups;
+  for (size_t i = 0; i < ranges->size(); i++) {
+    const auto& range = (*ranges)[i];
+    if (range.size < 1) {
+      continue;
+    }
+    if (!groups.empty() && range.off <= groups.back().off + groups.back().size) {
+      auto& group = groups.back();
+      group.size = std::max(group.size, range.off + range.size - group.off);
+      group.end = i + 1;
+    } else {
+      groups.emplace_back(RangeGroup{i, i + 1, range.off, range.size});
+    }
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  std::vector<std::string> keys;
-  for (int32_t i = 0; i < argc; i++) {
-    PyObject* pykey = PyTuple_GET_ITEM(pyargs, i);
-    SoftString key(pykey);
-    keys.emplace_back(std::string(key.Get()));
+  auto read_group = [&](const RangeGroup& group) {
+    if (group.end - group.begin == 1) {
+      return file->Read(group.off, (*ranges)[group.begin].dest, group.size);
+    }
+    std::string buf(group.size, 0);
+    tkrzw::Status status = file->Read(group.off, buf.data(), group.size);
+    if (status == tkrzw::Status::SUCCESS) {
+      for (size_t i = group.begin; i < group.end; i++) {
+        const auto& range = (*ranges)[i];
+        if (range.size > 0) {
+          std::memcpy(range.dest, buf.data() + range.off - group.off, range.size);
+        }
+      }
+    }
+    return status;
+  };
+  constexpr int64_t MIN_GROUPS_PER_THREAD = 16;
+  constexpr int32_t MAX_THREADS = 8;
+  const int32_t num_threads = std::min<int64_t>(
+      {static_cast<int64_t>(std::thread::hardware_concurrency()),
+       static_cast<int64_t>(groups.size()) / MIN_GROUPS_PER_THREAD, MAX_THREADS});
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  if (num_threads < 2) {
+    for (const auto& group : groups) {
+      status = read_group(group);
+      if (status != tkrzw::Status::SUCCESS) {
+        break;
+      }
+    }
+    return status;
+  }
+  std::atomic<size_t> next_index(0);
+  std::vector<tkrzw::Status> statuses(num_threads);
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (int32_t i = 0; i < num_threads; i++) {
+    threads.emplace_back([&, i]() {
+      while (true) {
+        const size_t index = next_index.fetch_add(1);
+        if (index >= groups.size()) {
+          break;
+        }
+        statuses[i] |= read_group(groups[index]);
+        if (statuses[i] != tkrzw::Status::SUCCESS) {
+          next_index.store(groups.size());
+          break;
+        }
+      }
+    });
   }
-  std::vector<std::string_view> key_views(keys.begin(), keys.end());
-  tkrzw::StatusFuture future(self->async->GetMulti(keys));
-  return CreatePyFutureMove(std::move(future), self->concurrent);
-}
-
-// Implementation of AsyncDBM#GetMultiStr.
-static PyObject* asyncdbm_GetMultiStr(PyAsyncDBM* self, PyObject* pyargs) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
-    return nullptr;
+  for (auto& thread : threads) {
+    thread.join();
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  std::vector<std::string> keys;
-  for (int32_t i = 0; i < argc; i++) {
-    PyObject* pykey = PyTuple_GET_ITEM(pyargs, i);
-    SoftString key(pykey);
-    keys.emplace_back(std::string(key.Get()));
+  for (const auto& thread_status : statuses) {
+    status |= thread_status;
   }
-  std::vector<std::string_view> key_views(keys.begin(), keys.end());
-  tkrzw::StatusFuture future(self->async->GetMulti(keys));
-  return CreatePyFutureMove(std::move(future), self->concurrent, true);
+  return status;
 }
 
-// Implementation of AsyncDBM#Set.
-static PyObject* asyncdbm_Set(PyAsyncDBM* self, PyObject* pyargs) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
+static PyObject* file_Read(PyFile* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
@@ -3546,261 +8853,237 @@ static PyObject* asyncdbm_Set(PyAsyncDBM* self, PyObject* pyargs) {
     ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
-  PyObject* pyvalue = PyTuple_GET_ITEM(pyargs, 1);
-  const bool overwrite = argc > 2 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 2)) : true;
-  SoftString key(pykey);
-  SoftString value(pyvalue);
-  tkrzw::StatusFuture future(self->async->Set(key.Get(), value.Get(), overwrite));
-  return CreatePyFutureMove(std::move(future), self->concurrent);
-}
-
-// Implementation of AsyncDBM#SetMulti.
-static PyObject* asyncdbm_SetMulti(PyAsyncDBM* self, PyObject* pyargs, PyObject* pykwds) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
-    return nullptr;
+  const int64_t off = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 0)));
+  const int64_t size = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 1)));
+  PyObject* pystatus = nullptr;
+  if (argc > 2) {
+    pystatus = PyTuple_GET_ITEM(pyargs, 2);
+    if (pystatus == Py_None) {
+      pystatus = nullptr;
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
+      ThrowInvalidArguments("not a status object");
+      return nullptr;
+    }
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc > 1) {
-    ThrowInvalidArguments("too many arguments");
-    return nullptr;
+  char* buf = new char[size];
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->file->Read(off, buf, size);
   }
-  PyObject* pyoverwrite = argc > 0 ? PyTuple_GET_ITEM(pyargs, 0) : Py_True;
-  const bool overwrite = PyObject_IsTrue(pyoverwrite);
-  std::map<std::string, std::string> records;
-  if (pykwds != nullptr) {
-    records = MapKeywords(pykwds);
+  if (pystatus != nullptr) {
+    *((PyTkStatus*)pystatus)->status = status;
   }
-  std::map<std::string_view, std::string_view> record_views;
-  for (const auto& record : records) {
-    record_views.emplace(std::make_pair(
-        std::string_view(record.first), std::string_view(record.second)));
+  if (status != tkrzw::Status::SUCCESS) {
+    delete[] buf;
+    Py_RETURN_NONE;
   }
-  tkrzw::StatusFuture future(self->async->SetMulti(record_views, overwrite));
-  return CreatePyFutureMove(std::move(future), self->concurrent);
+  PyObject* pydata = CreatePyBytes(std::string_view(buf, size));
+  delete[] buf;
+  return pydata;
 }
 
-// Implementation of AsyncDBM#Remove.
-static PyObject* asyncdbm_Remove(PyAsyncDBM* self, PyObject* pyargs) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
+// Implementation of File#ReadInto.
+static PyObject* file_ReadInto(PyFile* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 1) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
-    return nullptr;
-  }
-  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
-  SoftString key(pykey);
-  tkrzw::StatusFuture future(self->async->Remove(key.Get()));
-  return CreatePyFutureMove(std::move(future), self->concurrent);
-}
-
-// Implementation of AsyncDBM#RemoveMulti.
-static PyObject* asyncdbm_RemoveMulti(PyAsyncDBM* self, PyObject* pyargs) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
+  if (argc != 2) {
+    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  std::vector<std::string> keys;
-  for (int32_t i = 0; i < argc; i++) {
-    PyObject* pykey = PyTuple_GET_ITEM(pyargs, i);
-    SoftString key(pykey);
-    keys.emplace_back(std::string(key.Get()));
-  }
-  std::vector<std::string_view> key_views(keys.begin(), keys.end());
-  tkrzw::StatusFuture future(self->async->RemoveMulti(key_views));
-  return CreatePyFutureMove(std::move(future), self->concurrent);
-}
-
-// Implementation of AsyncDBM#Append.
-static PyObject* asyncdbm_Append(PyAsyncDBM* self, PyObject* pyargs) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
+  const int64_t off = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 0)));
+  PyObject* pybuf = PyTuple_GET_ITEM(pyargs, 1);
+  Py_buffer view;
+  if (PyObject_GetBuffer(pybuf, &view, PyBUF_WRITABLE) != 0) {
+    PyErr_Clear();
+    ThrowInvalidArguments("not a writable contiguous buffer");
     return nullptr;
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 2 || argc > 3) {
-    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
-    return nullptr;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->file->Read(off, view.buf, view.len);
   }
-  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
-  PyObject* pyvalue = PyTuple_GET_ITEM(pyargs, 1);
-  PyObject* pydelim = argc > 2 ? PyTuple_GET_ITEM(pyargs, 2) : nullptr;
-  SoftString key(pykey);
-  SoftString value(pyvalue);
-  SoftString delim(pydelim == nullptr ? Py_None : pydelim);
-  tkrzw::StatusFuture future(self->async->Append(key.Get(), value.Get(), delim.Get()));
-  return CreatePyFutureMove(std::move(future), self->concurrent);
+  PyBuffer_Release(&view);
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of AsyncDBM#AppendMulti.
-static PyObject* asyncdbm_AppendMulti(PyAsyncDBM* self, PyObject* pyargs, PyObject* pykwds) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
+// Implementation of File#ReadMulti.
+static PyObject* file_ReadMulti(PyFile* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc > 1) {
-    ThrowInvalidArguments("too many arguments");
+  if (argc < 1 || argc > 3) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pydelim = argc > 0 ? PyTuple_GET_ITEM(pyargs, 0) : nullptr;
-  SoftString delim(pydelim == nullptr ? Py_None : pydelim);
-  std::map<std::string, std::string> records;
-  if (pykwds != nullptr) {
-    records = MapKeywords(pykwds);
-  }
-  std::map<std::string_view, std::string_view> record_views;
-  for (const auto& record : records) {
-    record_views.emplace(std::make_pair(
-        std::string_view(record.first), std::string_view(record.second)));
+  PyObject* pyranges = PyTuple_GET_ITEM(pyargs, 0);
+  const bool contiguous = argc > 1 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 1)) : false;
+  PyObject* pystatus = nullptr;
+  if (argc > 2) {
+    pystatus = PyTuple_GET_ITEM(pyargs, 2);
+    if (pystatus == Py_None) {
+      pystatus = nullptr;
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
+      ThrowInvalidArguments("not a status object");
+      return nullptr;
+    }
   }
-  tkrzw::StatusFuture future(self->async->AppendMulti(record_views, delim.Get()));
-  return CreatePyFutureMove(std::move(future), self->concurrent);
-}
-
-// Implementation of AsyncDBM#CompareExchange.
-static PyObject* asyncdbm_CompareExchange(PyAsyncDBM* self, PyObject* pyargs) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
+  if (!PySequence_Check(pyranges)) {
+    ThrowInvalidArguments("ranges must be a sequence");
     return nullptr;
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 3) {
-    ThrowInvalidArguments(argc < 3 ? "too few arguments" : "too many arguments");
+  PyObject* pyrangeseq = PySequence_Fast(pyranges, "");
+  if (pyrangeseq == nullptr) {
     return nullptr;
   }
-  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
-  PyObject* pyexpected = PyTuple_GET_ITEM(pyargs, 1);
-  PyObject* pydesired = PyTuple_GET_ITEM(pyargs, 2);
-  SoftString key(pykey);
-  std::unique_ptr<SoftString> expected;
-  std::string_view expected_view;
-  if (pyexpected != Py_None) {
-    if (pyexpected == obj_dbm_any_data) {
-      expected_view = tkrzw::DBM::ANY_DATA;
-    } else {
-      expected = std::make_unique<SoftString>(pyexpected);
-      expected_view = expected->Get();
+  const size_t num_ranges = PySequence_Fast_GET_SIZE(pyrangeseq);
+  PyObject** pyrangeitems = PySequence_Fast_ITEMS(pyrangeseq);
+  std::vector<FileReadRange> ranges;
+  ranges.reserve(num_ranges);
+  int64_t total_size = 0;
+  for (size_t i = 0; i < num_ranges; i++) {
+    PyObject* pyrange = pyrangeitems[i];
+    if (!PySequence_Check(pyrange) || PySequence_Size(pyrange) != 2) {
+      Py_DECREF(pyrangeseq);
+      ThrowInvalidArguments("a range must be a pair of the offset and the size");
+      return nullptr;
     }
-  }
-  std::unique_ptr<SoftString> desired;
-  std::string_view desired_view;
-  if (pydesired != Py_None) {
-    if (pydesired == obj_dbm_any_data) {
-      desired_view = tkrzw::DBM::ANY_DATA;
-    } else {
-      desired = std::make_unique<SoftString>(pydesired);
-      desired_view = desired->Get();
+    PyObject* pyoff = PySequence_GetItem(pyrange, 0);
+    PyObject* pysize = PySequence_GetItem(pyrange, 1);
+    const int64_t off = std::max<int64_t>(0, PyObjToInt(pyoff));
+    const int64_t size = std::max<int64_t>(0, PyObjToInt(pysize));
+    Py_DECREF(pysize);
+    Py_DECREF(pyoff);
+    ranges.emplace_back(FileReadRange{off, size, nullptr});
+    total_size += size;
+  }
+  Py_DECREF(pyrangeseq);
+  PyObject* pybuf = nullptr;
+  PyObject* pylist = PyList_New(num_ranges);
+  if (contiguous) {
+    pybuf = PyBytes_FromStringAndSize(nullptr, total_size);
+    char* wp = PyBytes_AS_STRING(pybuf);
+    int64_t buf_off = 0;
+    for (size_t i = 0; i < num_ranges; i++) {
+      ranges[i].dest = wp + buf_off;
+      PyList_SET_ITEM(pylist, i, PyLong_FromLongLong(buf_off));
+      buf_off += ranges[i].size;
+    }
+  } else {
+    for (size_t i = 0; i < num_ranges; i++) {
+      PyObject* pydata = PyBytes_FromStringAndSize(nullptr, ranges[i].size);
+      ranges[i].dest = PyBytes_AS_STRING(pydata);
+      PyList_SET_ITEM(pylist, i, pydata);
     }
   }
-  tkrzw::StatusFuture future(self->async->CompareExchange(
-      key.Get(), expected_view, desired_view));
-  return CreatePyFutureMove(std::move(future), self->concurrent);
-}
-
-// Implementation of AsyncDBM#Increment.
-static PyObject* asyncdbm_Increment(PyAsyncDBM* self, PyObject* pyargs) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
-    return nullptr;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(true);
+    status = ReadFileRanges(self->file, &ranges);
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 1 || argc > 3) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
-    return nullptr;
+  if (pystatus != nullptr) {
+    *((PyTkStatus*)pystatus)->status = status;
   }
-  PyObject* pykey = PyTuple_GET_ITEM(pyargs, 0);
-  SoftString key(pykey);
-  int64_t inc = 1;
-  if (argc > 1) {
-    PyObject* pyinc = PyTuple_GET_ITEM(pyargs, 1);
-    inc = PyObjToInt(pyinc);
+  if (status != tkrzw::Status::SUCCESS) {
+    Py_XDECREF(pybuf);
+    Py_DECREF(pylist);
+    Py_RETURN_NONE;
   }
-  int64_t init = 0;
-  if (argc > 2) {
-    PyObject* pyinit = PyTuple_GET_ITEM(pyargs, 2);
-    init = PyObjToInt(pyinit);
+  if (contiguous) {
+    PyObject* pyrv = PyTuple_New(2);
+    PyTuple_SET_ITEM(pyrv, 0, pybuf);
+    PyTuple_SET_ITEM(pyrv, 1, pylist);
+    return pyrv;
   }
-  tkrzw::StatusFuture future(self->async->Increment(key.Get(), inc, init));
-  return CreatePyFutureMove(std::move(future), self->concurrent);
+  return pylist;
 }
 
-// Implementation of AsyncDBM#CompareExchangeMulti.
-static PyObject* asyncdbm_CompareExchangeMulti(PyAsyncDBM* self, PyObject* pyargs) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
+static PyObject* file_ReadStr(PyFile* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 2) {
+  if (argc < 2 || argc > 3) {
     ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pyexpected = PyTuple_GET_ITEM(pyargs, 0);
-  PyObject* pydesired = PyTuple_GET_ITEM(pyargs, 1);
-  if (!PySequence_Check(pyexpected) || !PySequence_Check(pydesired)) {
-    ThrowInvalidArguments("parameters must be sequences of strings");
-    return nullptr;
+  const int64_t off = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 0)));
+  const int64_t size = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 1)));
+  PyObject* pystatus = nullptr;
+  if (argc > 2) {
+    pystatus = PyTuple_GET_ITEM(pyargs, 2);
+    if (pystatus == Py_None) {
+      pystatus = nullptr;
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
+      ThrowInvalidArguments("not a status object");
+      return nullptr;
+    }
   }
-  std::vector<std::string> expected_ph;
-  const auto& expected = ExtractSVPairs(pyexpected, &expected_ph);
-  std::vector<std::string> desired_ph;
-  const auto& desired = ExtractSVPairs(pydesired, &desired_ph);
-  tkrzw::StatusFuture future(self->async->CompareExchangeMulti(expected, desired));
-  return CreatePyFutureMove(std::move(future), self->concurrent);
+  char* buf = new char[size];
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->file->Read(off, buf, size);
+  }
+  if (pystatus != nullptr) {
+    *((PyTkStatus*)pystatus)->status = status;
+  }
+  if (status != tkrzw::Status::SUCCESS) {
+    delete[] buf;
+    Py_RETURN_NONE;
+  }
+  PyObject* pystr = CreatePyString(std::string_view(buf, size));
+  delete[] buf;
+  return pystr;
 }
 
-// Implementation of AsyncDBM#Rekey.
-static PyObject* asyncdbm_Rekey(PyAsyncDBM* self, PyObject* pyargs) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
+static PyObject* file_Write(PyFile* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 2 || argc > 4) {
+  if (argc != 2) {
     ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pyold_key = PyTuple_GET_ITEM(pyargs, 0);
-  PyObject* pynew_key = PyTuple_GET_ITEM(pyargs, 1);
-  const bool overwrite = argc > 2 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 2)) : true;
-  const bool copying = argc > 3 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 3)) : false;
-  SoftString old_key(pyold_key);
-  SoftString new_key(pynew_key);
-  tkrzw::StatusFuture future(self->async->Rekey(
-      old_key.Get(), new_key.Get(), overwrite, copying));
-  return CreatePyFutureMove(std::move(future), self->concurrent);
-}
-
-// Implementation of AsyncDBM#PopFirst.
-static PyObject* asyncdbm_PopFirst(PyAsyncDBM* self) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
+  const int64_t off = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 0)));
+  PyObject* pydata = PyTuple_GET_ITEM(pyargs, 1);
+  BufferString data(pydata);
+  if (!data.IsValid()) {
     return nullptr;
   }
-  tkrzw::StatusFuture future(self->async->PopFirst());
-  return CreatePyFutureMove(std::move(future), self->concurrent);
-}
-
-// Implementation of AsyncDBM#PopFirstStr.
-static PyObject* asyncdbm_PopFirstStr(PyAsyncDBM* self) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
-    return nullptr;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    if (off + static_cast<int64_t>(data.Get().size()) > self->file->GetSizeSimple()) {
+      FileRemapGuard remap_guard(self);
+      status = remap_guard.GetStatus();
+      if (status == tkrzw::Status::SUCCESS) {
+        status = self->file->Write(off, data.Get().data(), data.Get().size());
+      }
+    } else {
+      status = self->file->Write(off, data.Get().data(), data.Get().size());
+    }
   }
-  tkrzw::StatusFuture future(self->async->PopFirst());
-  return CreatePyFutureMove(std::move(future), self->concurrent, true);
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of AsyncDBM#PushLast.
-static PyObject* asyncdbm_PushLast(PyAsyncDBM* self, PyObject* pyargs) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
+static PyObject* file_Append(PyFile* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
@@ -3808,497 +9091,734 @@ static PyObject* asyncdbm_PushLast(PyAsyncDBM* self, PyObject* pyargs) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pyvalue = PyTuple_GET_ITEM(pyargs, 0);
-  const double wtime = argc > 1 ? PyObjToDouble(PyTuple_GET_ITEM(pyargs, 1)) : -1;
-  SoftString value(pyvalue);
-  tkrzw::StatusFuture future(self->async->PushLast(value.Get(), wtime));
-  return CreatePyFutureMove(std::move(future), self->concurrent);
-}
-
-// Implementation of AsyncDBM#Clear.
-static PyObject* asyncdbm_Clear(PyAsyncDBM* self) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
+  PyObject* pydata = PyTuple_GET_ITEM(pyargs, 0);
+  BufferString data(pydata);
+  if (!data.IsValid()) {
     return nullptr;
   }
-  tkrzw::StatusFuture future(self->async->Clear());
-  return CreatePyFutureMove(std::move(future), self->concurrent);
+  PyObject* pystatus = nullptr;
+  if (argc > 1) {
+    pystatus = PyTuple_GET_ITEM(pyargs, 1);
+    if (pystatus == Py_None) {
+      pystatus = nullptr;
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
+      ThrowInvalidArguments("not a status object");
+      return nullptr;
+    }
+  }
+  int64_t new_off = 0;
+  FileRemapGuard remap_guard(self);
+  tkrzw::Status status = remap_guard.GetStatus();
+  if (status == tkrzw::Status::SUCCESS) {
+    NativeLock lock(self->concurrent);
+    status = self->file->Append(data.Get().data(), data.Get().size(), &new_off);
+  }
+  if (pystatus != nullptr) {
+    *((PyTkStatus*)pystatus)->status = status;
+  }
+  if (status != tkrzw::Status::SUCCESS) {
+    Py_RETURN_NONE;
+  }
+  return PyLong_FromLongLong(new_off);
 }
 
-// Implementation of AsyncDBM#Rebuild.
-static PyObject* asyncdbm_Rebuild(PyAsyncDBM* self, PyObject* pyargs, PyObject* pykwds) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
+static PyObject* file_Truncate(PyFile* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 0) {
-    ThrowInvalidArguments("too many arguments");
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  std::map<std::string, std::string> params;
-  if (pykwds != nullptr) {
-    params = MapKeywords(pykwds);
+  const int64_t size = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 0)));
+  FileRemapGuard remap_guard(self);
+  tkrzw::Status status = remap_guard.GetStatus();
+  if (status == tkrzw::Status::SUCCESS) {
+    NativeLock lock(self->concurrent);
+    status = self->file->Truncate(size);
   }
-  tkrzw::StatusFuture future(self->async->Rebuild(params));
-  return CreatePyFutureMove(std::move(future), self->concurrent);
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of AsyncDBM#Synchronize.
-static PyObject* asyncdbm_Synchronize(PyAsyncDBM* self, PyObject* pyargs, PyObject* pykwds) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
+static PyObject* file_Synchronize(PyFile* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 1) {
+  if (argc < 1 || argc > 3) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
   PyObject* pyhard = PyTuple_GET_ITEM(pyargs, 0);
   const bool hard = PyObject_IsTrue(pyhard);
-  std::map<std::string, std::string> params;
-  if (pykwds != nullptr) {
-    params = MapKeywords(pykwds);
+  int64_t off = 0;
+  int64_t size = 0;
+  if (argc > 1) {
+    off = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 1)));
+  }
+  if (argc > 2) {
+    size = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 2)));
+  }
+  FileRemapGuard remap_guard(self);
+  tkrzw::Status status = remap_guard.GetStatus();
+  if (status == tkrzw::Status::SUCCESS) {
+    NativeLock lock(self->concurrent);
+    status = self->file->Synchronize(hard, off, size);
   }
-  tkrzw::StatusFuture future(self->async->Synchronize(hard, nullptr, params));
-  return CreatePyFutureMove(std::move(future), self->concurrent);
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
-// Implementation of AsyncDBM#CopyFileData.
-static PyObject* asyncdbm_CopyFileData(PyAsyncDBM* self, PyObject* pyargs) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
+static PyObject* file_GetSize(PyFile* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
     return nullptr;
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 1 || argc > 2) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
-    return nullptr;
+  int64_t size = -1;
+  {
+    NativeLock lock(self->concurrent);
+    size = self->file->GetSizeSimple();
   }
-  bool sync_hard = false;
-  if (argc > 1) {
-    PyObject* pysync_hard = PyTuple_GET_ITEM(pyargs, 1);
-    sync_hard = PyObject_IsTrue(pysync_hard);
-  }  
-  PyObject* pydest = PyTuple_GET_ITEM(pyargs, 0);
-  SoftString dest(pydest);
-  tkrzw::StatusFuture future(self->async->CopyFileData(std::string(dest.Get()), sync_hard));
-  return CreatePyFutureMove(std::move(future), self->concurrent);
+  if (size >= 0) {
+    return PyLong_FromLongLong(size);
+  }
+  Py_RETURN_NONE;
 }
 
-// Implementation of AsyncDBM#Export.
-static PyObject* asyncdbm_Export(PyAsyncDBM* self, PyObject* pyargs) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
+static PyObject* file_GetPath(PyFile* self) {
+  HandleLock handle_lock(self->mutex, false);
+  std::string path;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = self->file->GetPath(&path);
+  }
+  if (status == tkrzw::Status::SUCCESS) {
+    return CreatePyString(path);
+  }
+  Py_RETURN_NONE;
+}
+
+// Implementation of File#Search.
+static PyObject* file_Search(PyFile* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 1) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+  if (argc < 2 || argc > 3) {
+    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pydest = PyTuple_GET_ITEM(pyargs, 0);
-  if (!PyObject_IsInstance(pydest, cls_dbm)) {
-    ThrowInvalidArguments("the argument is not a DBM");
-    return nullptr;
+  PyObject* pymode = PyTuple_GET_ITEM(pyargs, 0);
+  PyObject* pypattern = PyTuple_GET_ITEM(pyargs, 1);
+  int32_t capacity = 0;
+  if (argc > 2) {
+    capacity = PyObjToInt(PyTuple_GET_ITEM(pyargs, 2));
   }
-  PyDBM* dest = (PyDBM*)pydest;
-  if (dest->dbm == nullptr) {
-    ThrowInvalidArguments("not opened database");
+  SoftString pattern(pypattern);
+  SoftString mode(pymode);
+  std::vector<std::string> lines;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    status = tkrzw::SearchTextFileModal(self->file, mode.Get(), pattern.Get(), &lines, capacity);
+  }
+  if (status != tkrzw::Status::SUCCESS) {
+    ThrowStatusException(self, status);    
     return nullptr;
   }
-  tkrzw::StatusFuture future(self->async->Export(dest->dbm));
-  return CreatePyFutureMove(std::move(future), self->concurrent);
+  PyObject* pyrv = PyList_New(lines.size());
+  for (size_t i = 0; i < lines.size(); i++) {
+    PyList_SET_ITEM(pyrv, i, CreatePyString(lines[i]));
+  }
+  return pyrv;
+}
+
+// Gets the pointer to a region of a memory-mapped file.
+static tkrzw::Status GetMappedRegion(
+    tkrzw::PolyFile* file, int64_t off, int64_t size, char** ptr, int64_t* region_size) {
+  tkrzw::File* in_file = file->GetInternalFile();
+  auto* parallel_file = dynamic_cast<tkrzw::MemoryMapParallelFile*>(in_file);
+  auto* atomic_file = dynamic_cast<tkrzw::MemoryMapAtomicFile*>(in_file);
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  if (parallel_file != nullptr) {
+    std::unique_ptr<tkrzw::MemoryMapParallelFile::Zone> zone;
+    status = parallel_file->MakeZone(false, off, size, &zone);
+    if (status == tkrzw::Status::SUCCESS) {
+      *ptr = zone->Pointer();
+      *region_size = zone->Size();
+    }
+  } else if (atomic_file != nullptr) {
+    std::unique_ptr<tkrzw::MemoryMapAtomicFile::Zone> zone;
+    status = atomic_file->MakeZone(false, off, size, &zone);
+    if (status == tkrzw::Status::SUCCESS) {
+      *ptr = zone->Pointer();
+      *region_size = zone->Size();
+    }
+  } else {
+    status.Set(tkrzw::Status::NOT_IMPLEMENTED_ERROR, "not a memory-mapped file");
+  }
+  return status;
 }
 
-// Implementation of AsyncDBM#ExportToFlatRecords.
-static PyObject* asyncdbm_ExportToFlatRecords(PyAsyncDBM* self, PyObject* pyargs) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
+// Implementation of File#MakeView.
+static PyObject* file_MakeView(PyFile* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc < 2 || argc > 4) {
+    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 1) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
-    return nullptr;
+  const int64_t off = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 0)));
+  const int64_t size = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 1)));
+  const bool writable = argc > 2 ? PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 2)) : false;
+  PyObject* pystatus = nullptr;
+  if (argc > 3) {
+    pystatus = PyTuple_GET_ITEM(pyargs, 3);
+    if (pystatus == Py_None) {
+      pystatus = nullptr;
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
+      ThrowInvalidArguments("not a status object");
+      return nullptr;
+    }
+  }
+  while (true) {
+    self->num_views.fetch_add(1);
+    if (self->num_remaps.load() == 0) {
+      break;
+    }
+    self->num_views.fetch_sub(1);
+    NativeLock lock(true);
+    std::unique_lock<std::mutex> remap_lock(self->remap_mutex);
+    self->remap_cond.wait(remap_lock, [&]() { return self->num_remaps.load() == 0; });
+  }
+  char* ptr = nullptr;
+  int64_t region_size = 0;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  if (writable && !self->writable) {
+    status.Set(tkrzw::Status::PRECONDITION_ERROR, "not writable file");
+  } else {
+    status = GetMappedRegion(self->file, off, size, &ptr, &region_size);
+  }
+  if (pystatus != nullptr) {
+    *((PyTkStatus*)pystatus)->status = status;
   }
-  PyObject* pydest_file = PyTuple_GET_ITEM(pyargs, 0);
-  if (!PyObject_IsInstance(pydest_file, cls_file)) {
-    ThrowInvalidArguments("the argument is not a File");
-    return nullptr;
+  if (status != tkrzw::Status::SUCCESS) {
+    self->num_views.fetch_sub(1);
+    Py_RETURN_NONE;
   }
-  PyFile* dest_file = (PyFile*)pydest_file;
-  if (dest_file->file == nullptr) {
-    ThrowInvalidArguments("not opened file");
+  PyTypeObject* pytype = (PyTypeObject*)GetModuleState(self)->cls_fileregion;
+  PyFileRegion* pyregion = (PyFileRegion*)pytype->tp_alloc(pytype, 0);
+  if (!pyregion) {
+    self->num_views.fetch_sub(1);
     return nullptr;
   }
-  tkrzw::StatusFuture future(self->async->ExportToFlatRecords(dest_file->file));
-  return CreatePyFutureMove(std::move(future), self->concurrent);
+  Py_INCREF(self);
+  pyregion->pyfile = (PyObject*)self;
+  pyregion->ptr = ptr;
+  pyregion->size = region_size;
+  pyregion->writable = writable;
+  PyObject* pyview = PyMemoryView_FromObject((PyObject*)pyregion);
+  Py_DECREF(pyregion);
+  return pyview;
 }
 
-// Implementation of AsyncDBM#ImportFromFlatRecords.
-static PyObject* asyncdbm_ImportFromFlatRecords(PyAsyncDBM* self, PyObject* pyargs) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
+// Implementation of File#Advise.
+static PyObject* file_Advise(PyFile* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 1) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+  if (argc != 3) {
+    ThrowInvalidArguments(argc < 3 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pysrc_file = PyTuple_GET_ITEM(pyargs, 0);
-  if (!PyObject_IsInstance(pysrc_file, cls_file)) {
-    ThrowInvalidArguments("the argument is not a File");
+  const int64_t off = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 0)));
+  const int64_t size = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 1)));
+  SoftString advice(PyTuple_GET_ITEM(pyargs, 2));
+#if defined(__unix__) || defined(__APPLE__)
+  int32_t native_advice = 0;
+  if (advice.Get() == "normal") {
+    native_advice = POSIX_MADV_NORMAL;
+  } else if (advice.Get() == "sequential") {
+    native_advice = POSIX_MADV_SEQUENTIAL;
+  } else if (advice.Get() == "random") {
+    native_advice = POSIX_MADV_RANDOM;
+  } else if (advice.Get() == "willneed") {
+    native_advice = POSIX_MADV_WILLNEED;
+  } else if (advice.Get() == "dontneed") {
+    native_advice = POSIX_MADV_DONTNEED;
+  } else {
+    ThrowInvalidArguments("unknown advice");
     return nullptr;
   }
-  PyFile* src_file = (PyFile*)pysrc_file;
-  if (src_file->file == nullptr) {
-    ThrowInvalidArguments("not opened file");
-    return nullptr;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(self->concurrent);
+    char* ptr = nullptr;
+    int64_t region_size = 0;
+    status = GetMappedRegion(self->file, off, size, &ptr, &region_size);
+    if (status == tkrzw::Status::SUCCESS && region_size > 0) {
+      const uintptr_t page_size = tkrzw::PAGE_SIZE;
+      const uintptr_t begin = reinterpret_cast<uintptr_t>(ptr) / page_size * page_size;
+      const uintptr_t end = reinterpret_cast<uintptr_t>(ptr) + region_size;
+      const int32_t rv = posix_madvise(reinterpret_cast<void*>(begin), end - begin, native_advice);
+      if (rv != 0) {
+        status.Set(tkrzw::Status::SYSTEM_ERROR, tkrzw::StrCat("posix_madvise failed: ", rv));
+      }
+    }
   }
-  tkrzw::StatusFuture future(self->async->ImportFromFlatRecords(src_file->file));
-  return CreatePyFutureMove(std::move(future), self->concurrent);
+  return CreatePyTkStatusMove(self, std::move(status));
+#else
+  return CreatePyTkStatusMove(self, tkrzw::Status(tkrzw::Status::NOT_IMPLEMENTED_ERROR));
+#endif
 }
 
-// Implementation of AsyncDBM#Search.
-static PyObject* asyncdbm_Search(PyAsyncDBM* self, PyObject* pyargs) {
-  if (self->async == nullptr) {
-    ThrowInvalidArguments("destructed object");
+// Implementation of File#IterLines.
+static PyObject* file_IterLines(PyFile* self, PyObject* pyargs, PyObject* pykwds) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 2 || argc > 3) {
-    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
+  if (argc != 0) {
+    ThrowInvalidArguments("too many arguments");
     return nullptr;
   }
-  PyObject* pymode = PyTuple_GET_ITEM(pyargs, 0);
-  PyObject* pypattern = PyTuple_GET_ITEM(pyargs, 1);
-  int32_t capacity = 0;
-  if (argc > 2) {
-    capacity = PyObjToInt(PyTuple_GET_ITEM(pyargs, 2));
+  int64_t batch = 1000;
+  int64_t block_size = 1 << 20;
+  bool is_str = false;
+  std::string mode, pattern;
+  if (pykwds != nullptr) {
+    const auto& params = MapKeywords(pykwds);
+    batch = tkrzw::StrToInt(tkrzw::SearchMap(params, "batch", "1000"));
+    block_size = tkrzw::StrToIntMetric(tkrzw::SearchMap(params, "block_size", "1Mi"));
+    is_str = tkrzw::StrToBool(tkrzw::SearchMap(params, "str", "false"));
+    mode = tkrzw::SearchMap(params, "mode", "");
+    pattern = tkrzw::SearchMap(params, "pattern", "");
+  }
+  if (batch < 1) {
+    ThrowInvalidArguments("invalid batch size");
+    return nullptr;
+  }
+  LineScanner::Matcher matcher;
+  if (mode == "contain") {
+    matcher = [pattern](std::string_view line) {
+      return line.find(pattern) != std::string_view::npos;
+    };
+  } else if (mode == "begin") {
+    matcher = [pattern](std::string_view line) {
+      return tkrzw::StrBeginsWith(line, pattern);
+    };
+  } else if (mode == "end") {
+    matcher = [pattern](std::string_view line) {
+      return tkrzw::StrEndsWith(line, pattern);
+    };
+  } else if (mode == "regex") {
+    std::shared_ptr<std::regex> regex;
+    try {
+      regex = std::make_shared<std::regex>(pattern);
+    } catch (const std::regex_error& err) {
+      ThrowInvalidArguments(tkrzw::StrCat("invalid regex: ", err.what()));
+      return nullptr;
+    }
+    matcher = [regex](std::string_view line) {
+      return std::regex_search(line.begin(), line.end(), *regex);
+    };
+  } else if (!mode.empty()) {
+    ThrowInvalidArguments("unsupported search mode");
+    return nullptr;
   }
-  SoftString pattern(pypattern);
-  SoftString mode(pymode);
-  tkrzw::StatusFuture future(self->async->SearchModal(mode.Get(), pattern.Get(), capacity));
-  return CreatePyFutureMove(std::move(future), self->concurrent, true);
+  PyTypeObject* pyitertype = (PyTypeObject*)GetModuleState(self)->cls_lineiter;
+  PyLineIterator* pyiter = (PyLineIterator*)pyitertype->tp_new(pyitertype, nullptr, nullptr);
+  if (!pyiter) return nullptr;
+  Py_INCREF(self);
+  pyiter->pyfile = (PyObject*)self;
+  pyiter->scanner = new LineScanner(block_size, std::move(matcher));
+  pyiter->batch = batch;
+  pyiter->is_str = is_str;
+  return (PyObject*)pyiter;
 }
 
-// Defines the AsyncDBM class.
-static bool DefineAsyncDBM() {
-  static PyTypeObject pytype = {PyVarObject_HEAD_INIT(nullptr, 0)};
-  const size_t zoff = offsetof(PyTypeObject, tp_name);
-  std::memset((char*)&pytype + zoff, 0, sizeof(pytype) - zoff);
-  pytype.tp_name = "tkrzw.AsyncDBM";
-  pytype.tp_basicsize = sizeof(PyAsyncDBM);
-  pytype.tp_itemsize = 0;
-  pytype.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
-  pytype.tp_doc = "Polymorphic database manager.";
-  pytype.tp_new = asyncdbm_new;
-  pytype.tp_dealloc = (destructor)asyncdbm_dealloc;
-  pytype.tp_init = (initproc)asyncdbm_init;
-  pytype.tp_repr = (unaryfunc)asyncdbm_repr;
-  pytype.tp_str = (unaryfunc)asyncdbm_str;
+// Defines the File class.
+static bool DefineFile(PyObject* module, ModuleState* state) {
   static PyMethodDef methods[] = {
-    {"Destruct", (PyCFunction)asyncdbm_Destruct, METH_NOARGS,
-     "Destructs the asynchronous database adapter."},
-    {"Get", (PyCFunction)asyncdbm_Get, METH_VARARGS,
-     "Gets the value of a record of a key."},
-    {"GetStr", (PyCFunction)asyncdbm_GetStr, METH_VARARGS,
-     "Gets the value of a record of a key, as a string."},
-    {"GetMulti", (PyCFunction)asyncdbm_GetMulti, METH_VARARGS,
-     "Gets the values of multiple records of keys."},
-    {"GetMultiStr", (PyCFunction)asyncdbm_GetMultiStr, METH_VARARGS,
-     "Gets the values of multiple records of keys, as strings."},
-    {"Set", (PyCFunction)asyncdbm_Set, METH_VARARGS,
-     "Sets a record of a key and a value."},
-    {"SetMulti", (PyCFunction)asyncdbm_SetMulti, METH_VARARGS | METH_KEYWORDS,
-     "Sets multiple records specified by an initializer list of pairs of strings."},
-    {"Remove", (PyCFunction)asyncdbm_Remove, METH_VARARGS,
-     "Removes a record of a key."},
-    {"RemoveMulti", (PyCFunction)asyncdbm_RemoveMulti, METH_VARARGS,
-     "Removes records of keys."},
-    {"Append", (PyCFunction)asyncdbm_Append, METH_VARARGS,
-     "Appends data at the end of a record of a key."},
-    {"AppendMulti", (PyCFunction)asyncdbm_AppendMulti, METH_VARARGS | METH_KEYWORDS,
-     "Appends data to multiple records of the keyword arguments."},
-    {"CompareExchange", (PyCFunction)asyncdbm_CompareExchange, METH_VARARGS,
-     "Compares the value of a record and exchanges if the condition meets."},
-    {"Increment", (PyCFunction)asyncdbm_Increment, METH_VARARGS,
-     "Increments the numeric value of a record."},
-    {"CompareExchangeMulti", (PyCFunction)asyncdbm_CompareExchangeMulti, METH_VARARGS,
-     "Compares the values of records and exchanges if the condition meets."},
-    {"Rekey", (PyCFunction)asyncdbm_Rekey, METH_VARARGS,
-     "Changes the key of a record."},
-    {"PopFirst", (PyCFunction)asyncdbm_PopFirst, METH_NOARGS,
-     "Gets the first record and removes it."},
-    {"PopFirstStr", (PyCFunction)asyncdbm_PopFirstStr, METH_NOARGS,
-     "Gets the first record as strings and removes it."},
-    {"PushLast", (PyCFunction)asyncdbm_PushLast, METH_VARARGS,
-     "Adds a record with a key of the current timestamp."},
-    {"Clear", (PyCFunction)asyncdbm_Clear, METH_NOARGS,
-     "Removes all records."},
-    {"Rebuild", (PyCFunction)asyncdbm_Rebuild, METH_VARARGS | METH_KEYWORDS,
-     "Rebuilds the entire database."},
-    {"Synchronize", (PyCFunction)asyncdbm_Synchronize, METH_VARARGS | METH_KEYWORDS,
-     "Synchronizes the content of the database to the file system."},
-    {"CopyFileData", (PyCFunction)asyncdbm_CopyFileData, METH_VARARGS,
-     "Copies the content of the database file to another file."},
-    {"Export", (PyCFunction)asyncdbm_Export, METH_VARARGS,
-     "Exports all records to another database."},
-    {"ExportToFlatRecords", (PyCFunction)asyncdbm_ExportToFlatRecords, METH_VARARGS,
-     "Exports all records of a database to a flat record file."},
-    {"ImportFromFlatRecords", (PyCFunction)asyncdbm_ImportFromFlatRecords, METH_VARARGS,
-     "Imports records to a database from a flat record file."},
-    {"Search", (PyCFunction)asyncdbm_Search, METH_VARARGS,
-     "Searches the database and get keys which match a pattern."},
-    {nullptr, nullptr, 0, nullptr},
+    {"Open", (PyCFunction)file_Open, METH_VARARGS | METH_KEYWORDS,
+     "Opens a text file."},
+    {"Close", (PyCFunction)file_Close, METH_NOARGS,
+     "Closes the text file."},
+    {"Read", (PyCFunction)file_Read, METH_VARARGS,
+     "Reads data."},
+    {"ReadStr", (PyCFunction)file_ReadStr, METH_VARARGS,
+     "Reads data as a string."},
+    {"ReadInto", (PyCFunction)file_ReadInto, METH_VARARGS,
+     "Reads data into a writable buffer."},
+    {"ReadMulti", (PyCFunction)file_ReadMulti, METH_VARARGS,
+     "Reads data of multiple ranges at once."},
+    {"Write", (PyCFunction)file_Write, METH_VARARGS,
+     "Writes data."},
+    {"Append", (PyCFunction)file_Append, METH_VARARGS,
+     "Appends data at the end of the file."},
+    {"Truncate", (PyCFunction)file_Truncate, METH_VARARGS,
+     "Truncates the file."},
+    {"Synchronize", (PyCFunction)file_Synchronize, METH_VARARGS,
+     "Synchronizes the content of the file to the file system."},
+    {"GetSize", (PyCFunction)file_GetSize, METH_NOARGS,
+     "Gets the size of the file."},
+    {"GetPath", (PyCFunction)file_GetPath, METH_NOARGS,
+     "Gets the path of the file."},
+    {"Search", (PyCFunction)file_Search, METH_VARARGS,
+     "Searches the text file and get lines which match a pattern."},
+    {"MakeView", (PyCFunction)file_MakeView, METH_VARARGS,
+     "Makes a memoryview of a region of the memory-mapped file."},
+    {"Advise", (PyCFunction)file_Advise, METH_VARARGS,
+     "Gives an advice about the access pattern of a region of the memory-mapped file."},
+    {"IterLines", (PyCFunction)file_IterLines, METH_VARARGS | METH_KEYWORDS,
+     "Makes an iterator for batches of lines of the file."},
+    {nullptr, nullptr, 0, nullptr}
+  };
+  static PyType_Slot slots[] = {
+    {Py_tp_doc, (void*)"Generic file implemenation."},
+    {Py_tp_new, (void*)file_new},
+    {Py_tp_dealloc, (void*)file_dealloc},
+    {Py_tp_init, (void*)file_init},
+    {Py_tp_repr, (void*)file_repr},
+    {Py_tp_str, (void*)file_str},
+    {Py_tp_methods, (void*)methods},
+    {0, nullptr},
   };
-  pytype.tp_methods = methods;
-  if (PyType_Ready(&pytype) != 0) return false;
-  cls_asyncdbm = (PyObject*)&pytype;
-  Py_INCREF(cls_asyncdbm);
-  if (PyModule_AddObject(mod_tkrzw, "AsyncDBM", cls_asyncdbm) != 0) return false;
+  static PyType_Spec spec = {
+    "tkrzw.File", sizeof(PyFile), 0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, slots};
+  state->cls_file = PyType_FromModuleAndSpec(module, &spec, nullptr);
+  if (state->cls_file == nullptr) return false;
+  if (PyModule_AddObjectRef(module, "File", state->cls_file) != 0) return false;
   return true;
 }
 
-// Implementation of File.new.
-static PyObject* file_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
-  PyFile* self = (PyFile*)pytype->tp_alloc(pytype, 0);
-  if (!self) return nullptr;
-  self->file = nullptr;
-  self->concurrent = false;
-  return (PyObject*)self;
+// Implementation of FileRegion#dealloc.
+static void fileregion_dealloc(PyFileRegion* self) {
+  if (self->pyfile != nullptr) {
+    ((PyFile*)self->pyfile)->num_views.fetch_sub(1);
+    Py_DECREF(self->pyfile);
+  }
+  PyTypeObject* pytype = Py_TYPE(self);
+  pytype->tp_free((PyObject*)self);
+  Py_DECREF(pytype);
 }
 
-// Implementation of File#dealloc.
-static void file_dealloc(PyFile* self) {
-  delete self->file;
-  Py_TYPE(self)->tp_free((PyObject*)self);
+// Implementation of FileRegion#__init__.
+static int fileregion_init(PyFileRegion* self, PyObject* pyargs, PyObject* pykwds) {
+  ThrowStatusException(self, tkrzw::Status(tkrzw::Status::NOT_IMPLEMENTED_ERROR));
+  return -1;
 }
 
-// Implementation of File#__init__.
-static int file_init(PyFile* self, PyObject* pyargs, PyObject* pykwds) {
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 0) {
-    ThrowInvalidArguments("too many arguments");
+// Implementation of the buffer protocol of FileRegion.
+static int fileregion_getbuffer(PyFileRegion* self, Py_buffer* view, int flags) {
+  if (self->pyfile == nullptr) {
+    PyErr_SetString(PyExc_BufferError, "not initialized region");
+    view->obj = nullptr;
     return -1;
   }
-  return 0;
+  return PyBuffer_FillInfo(view, (PyObject*)self, self->ptr, self->size,
+                           self->writable ? 0 : 1, flags);
 }
 
-// Implementation of File#__repr__.
-static PyObject* file_repr(PyFile* self) {
-  if (self->file == nullptr) {
-    return CreatePyString("<tkrzw.File:(unopened)>");
-  }
-  std::string class_name = "unknown";
-  auto* in_file = self->file->GetInternalFile();
-  if (in_file != nullptr) {
-    const auto& file_type = in_file->GetType();
-    if (file_type == typeid(tkrzw::StdFile)) {
-      class_name = "StdFile";
-    } else if (file_type == typeid(tkrzw::MemoryMapParallelFile)) {
-      class_name = "MemoryMapParallelFile";
-    } else if (file_type == typeid(tkrzw::MemoryMapAtomicFile)) {
-      class_name = "MemoryMapAtomicFile";
-    } else if (file_type == typeid(tkrzw::PositionalParallelFile)) {
-      class_name = "PositionalParallelFile";
-    } else if (file_type == typeid(tkrzw::PositionalAtomicFile)) {
-      class_name = "PositionalAtomicFile";
-    }
-  }
-  const std::string path = self->file->GetPathSimple();
-  const int64_t size = self->file->GetSizeSimple();
-  const std::string& str = tkrzw::StrCat(
-      "<tkrzw.File: class=", class_name,
-      " path=", tkrzw::StrEscapeC(path, true), " size=", size, ">");
-  return CreatePyString(str);
+// Defines the FileRegion class.
+static bool DefineFileRegion(PyObject* module, ModuleState* state) {
+  static PyType_Slot slots[] = {
+    {Py_tp_doc, (void*)"Region of a memory-mapped file exported by the buffer protocol."},
+    {Py_tp_dealloc, (void*)fileregion_dealloc},
+    {Py_tp_init, (void*)fileregion_init},
+    {Py_bf_getbuffer, (void*)fileregion_getbuffer},
+    {0, nullptr},
+  };
+  static PyType_Spec spec = {
+    "tkrzw.FileRegion", sizeof(PyFileRegion), 0, Py_TPFLAGS_DEFAULT, slots};
+  state->cls_fileregion = PyType_FromModuleAndSpec(module, &spec, nullptr);
+  if (state->cls_fileregion == nullptr) return false;
+  return true;
 }
 
-// Implementation of File#__str__.
-static PyObject* file_str(PyFile* self) {
-  if (self->file == nullptr) {
-    return CreatePyString("(unopened)");
-  }
-  std::string class_name = "unknown";
-  auto* in_file = self->file->GetInternalFile();
-  if (in_file != nullptr) {
-    const auto& file_type = in_file->GetType();
-    if (file_type == typeid(tkrzw::StdFile)) {
-      class_name = "StdFile";
-    } else if (file_type == typeid(tkrzw::MemoryMapParallelFile)) {
-      class_name = "MemoryMapParallelFile";
-    } else if (file_type == typeid(tkrzw::MemoryMapAtomicFile)) {
-      class_name = "MemoryMapAtomicFile";
-    } else if (file_type == typeid(tkrzw::PositionalParallelFile)) {
-      class_name = "PositionalParallelFile";
-    } else if (file_type == typeid(tkrzw::PositionalAtomicFile)) {
-      class_name = "PositionalAtomicFile";
-    }
-  }
-  const std::string path = self->file->GetPathSimple();
-  const int64_t size = self->file->GetSizeSimple();
-  const std::string& str = tkrzw::StrCat(
-      "class=", class_name, " path=", tkrzw::StrEscapeC(path, true), " size=", size);
-  return CreatePyString(str);
+// Implementation of LineIterator.new.
+static PyObject* lineiter_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
+  PyLineIterator* self = (PyLineIterator*)pytype->tp_alloc(pytype, 0);
+  if (!self) return nullptr;
+  // The scanner and its buffer are used without the GIL, so the mutex is made on every build.
+  self->mutex = new std::shared_mutex();
+  self->pyfile = nullptr;
+  self->scanner = nullptr;
+  self->batch = 0;
+  self->is_str = false;
+  RegisterForkHandle((PyObject*)self, AbandonLineIteratorHandle);
+  return (PyObject*)self;
 }
 
-// Implementation of File#Open.
-static PyObject* file_Open(PyFile* self, PyObject* pyargs, PyObject* pykwds) {
-  const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc != 2) {
-    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
-    return nullptr;
-  }
-  PyObject* pypath = PyTuple_GET_ITEM(pyargs, 0);
-  PyObject* pywritable = PyTuple_GET_ITEM(pyargs, 1);
-  SoftString path(pypath);
-  const bool writable = PyObject_IsTrue(pywritable);
-  bool concurrent = false;
-  int32_t open_options = 0;
-  std::map<std::string, std::string> params;
-  if (pykwds != nullptr) {
-    params = MapKeywords(pykwds);
-    if (tkrzw::StrToBool(tkrzw::SearchMap(params, "concurrent", "false"))) {
-      concurrent = true;
-    }
-    if (tkrzw::StrToBool(tkrzw::SearchMap(params, "truncate", "false"))) {
-      open_options |= tkrzw::File::OPEN_TRUNCATE;
-    }
-    if (tkrzw::StrToBool(tkrzw::SearchMap(params, "no_create", "false"))) {
-      open_options |= tkrzw::File::OPEN_NO_CREATE;
-    }
-    if (tkrzw::StrToBool(tkrzw::SearchMap(params, "no_wait", "false"))) {
-      open_options |= tkrzw::File::OPEN_NO_WAIT;
-    }
-    if (tkrzw::StrToBool(tkrzw::SearchMap(params, "no_lock", "false"))) {
-      open_options |= tkrzw::File::OPEN_NO_LOCK;
-    }
-    if (tkrzw::StrToBool(tkrzw::SearchMap(params, "sync_hard", "false"))) {
-      open_options |= tkrzw::File::OPEN_SYNC_HARD;
-    }
-    params.erase("concurrent");
-    params.erase("truncate");
-    params.erase("no_create");
-    params.erase("no_wait");
-    params.erase("no_lock");
-    params.erase("sync_hard");
+// Implementation of LineIterator#dealloc.
+static void lineiter_dealloc(PyLineIterator* self) {
+  UnregisterForkHandle((PyObject*)self);
+  delete self->scanner;
+  Py_XDECREF(self->pyfile);
+  delete self->mutex;
+  PyTypeObject* pytype = Py_TYPE(self);
+  pytype->tp_free((PyObject*)self);
+  Py_DECREF(pytype);
+}
+
+// Implementation of LineIterator#__init__.
+static int lineiter_init(PyLineIterator* self, PyObject* pyargs, PyObject* pykwds) {
+  ThrowStatusException(self, tkrzw::Status(tkrzw::Status::NOT_IMPLEMENTED_ERROR));
+  return -1;
+}
+
+// Implementation of LineIterator#__repr__.
+static PyObject* lineiter_repr(PyLineIterator* self) {
+  HandleLock handle_lock(self->mutex, false);
+  const std::string& str = tkrzw::StrCat(
+      "<tkrzw.LineIterator: batch=", self->batch,
+      " end=", self->scanner != nullptr && self->scanner->IsEnd() ? "true" : "false", ">");
+  return CreatePyString(str);
+}
+
+// Implementation of LineIterator#__next__.
+static PyObject* lineiter_iternext(PyLineIterator* self) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->scanner == nullptr) {
+    ThrowInvalidArguments("not initialized iterator");
+    return nullptr;
   }
-  self->file = new tkrzw::PolyFile();
-  self->concurrent = concurrent;
+  PyFile* pyfile = (PyFile*)self->pyfile;
+  HandleLock file_lock(pyfile->mutex, false);
+  if (pyfile->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
+    return nullptr;
+  }
+  std::vector<std::pair<size_t, size_t>> lines;
+  lines.reserve(std::min<int64_t>(self->batch, 1 << 16));
   tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
-    NativeLock lock(self->concurrent);
-    status = self->file->OpenAdvanced(std::string(path.Get()), writable, open_options, params);
+    NativeLock lock(true);
+    status = self->scanner->Scan(pyfile->file, self->batch, &lines);
   }
   if (status != tkrzw::Status::SUCCESS) {
-    delete self->file;
-    self->file = nullptr;
+    ThrowStatusException(self, status);
+    return nullptr;
+  }
+  if (lines.empty()) {
+    PyErr_SetString(PyExc_StopIteration, "end of iteration");
+    return nullptr;
   }
-  return CreatePyTkStatusMove(std::move(status));
+  const char* buf = self->scanner->GetBuffer().data();
+  PyObject* pyrv = PyList_New(lines.size());
+  for (size_t i = 0; i < lines.size(); i++) {
+    const std::string_view line(buf + lines[i].first, lines[i].second - lines[i].first);
+    PyList_SET_ITEM(pyrv, i, self->is_str ? CreatePyString(line) : CreatePyBytes(line));
+  }
+  return pyrv;
 }
 
-// Implementation of File#Close
-static PyObject* file_Close(PyFile* self) {
-  if (self->file == nullptr) {
-    ThrowInvalidArguments("not opened file");
-    return nullptr;
+// Defines the LineIterator class.
+static bool DefineLineIterator(PyObject* module, ModuleState* state) {
+  static PyType_Slot slots[] = {
+    {Py_tp_doc, (void*)"Iterator for batches of lines of a file."},
+    {Py_tp_new, (void*)lineiter_new},
+    {Py_tp_dealloc, (void*)lineiter_dealloc},
+    {Py_tp_init, (void*)lineiter_init},
+    {Py_tp_repr, (void*)lineiter_repr},
+    {Py_tp_iter, (void*)PyObject_SelfIter},
+    {Py_tp_iternext, (void*)lineiter_iternext},
+    {0, nullptr},
+  };
+  static PyType_Spec spec = {
+    "tkrzw.LineIterator", sizeof(PyLineIterator), 0, Py_TPFLAGS_DEFAULT, slots};
+  state->cls_lineiter = PyType_FromModuleAndSpec(module, &spec, nullptr);
+  if (state->cls_lineiter == nullptr) return false;
+  if (PyModule_AddObjectRef(module, "LineIterator", state->cls_lineiter) != 0) return false;
+  return true;
+}
+
+// Runs an operation of a task of AsyncFile on a worker thread.  As the GIL is not held, the mutex
+// of the File object is locked directly.  The operation fails if the file has been closed since
+// the AsyncFile object was made.
+static tkrzw::Status RunAsyncFileOperation(
+    PyFile* pyfile, int64_t generation, const std::function<tkrzw::Status(tkrzw::PolyFile*)>& op) {
+  std::shared_lock<std::shared_mutex> lock(*pyfile->mutex);
+  if (pyfile->file == nullptr || pyfile->generation != generation) {
+    return tkrzw::Status(tkrzw::Status::PRECONDITION_ERROR, "not opened file");
   }
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  return op(pyfile->file);
+}
+
+// Implementation of AsyncFile.new.
+static PyObject* asyncfile_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
+  PyAsyncFile* self = (PyAsyncFile*)pytype->tp_alloc(pytype, 0);
+  if (!self) return nullptr;
+  self->mutex = NewHandleMutex();
+  self->pyfile = nullptr;
+  self->file_generation = 0;
+  new (&self->queue) std::shared_ptr<AsyncQueue>();
+  self->concurrent = false;
+  RegisterForkHandle((PyObject*)self, AbandonAsyncFileHandle);
+  return (PyObject*)self;
+}
+
+// Implementation of AsyncFile#dealloc.
+static void asyncfile_dealloc(PyAsyncFile* self) {
+  UnregisterForkHandle((PyObject*)self);
   {
     NativeLock lock(self->concurrent);
-    status = self->file->Close();
+    self->queue.reset();
   }
-  delete self->file;
-  self->file = nullptr;
-  return CreatePyTkStatusMove(std::move(status));
+  self->queue.~shared_ptr();
+  Py_XDECREF(self->pyfile);
+  delete self->mutex;
+  PyTypeObject* pytype = Py_TYPE(self);
+  pytype->tp_free((PyObject*)self);
+  Py_DECREF(pytype);
 }
 
-static PyObject* file_Read(PyFile* self, PyObject* pyargs) {
-  if (self->file == nullptr) {
-    ThrowInvalidArguments("not opened file");
-    return nullptr;
-  }
+// Implementation of AsyncFile#__init__.
+static int asyncfile_init(PyAsyncFile* self, PyObject* pyargs, PyObject* pykwds) {
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 2 || argc > 3) {
+  if (argc != 2) {
     ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
-    return nullptr;
+    return -1;
   }
-  const int64_t off = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 0)));
-  const int64_t size = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 1)));
-  PyObject* pystatus = nullptr;
-  if (argc > 2) {
-    pystatus = PyTuple_GET_ITEM(pyargs, 2);
-    if (pystatus == Py_None) {
-      pystatus = nullptr;
-    } else if (!PyObject_IsInstance(pystatus, cls_status)) {
-      ThrowInvalidArguments("not a status object");
-      return nullptr;
+  PyObject* pyfile = PyTuple_GET_ITEM(pyargs, 0);
+  if (!PyObject_IsInstance(pyfile, GetModuleState(self)->cls_file)) {
+    ThrowInvalidArguments("the argument is not a File");
+    return -1;
+  }
+  PyFile* file = (PyFile*)pyfile;
+  HandleLock file_lock(file->mutex, false);
+  if (file->file == nullptr) {
+    ThrowInvalidArguments("not opened file");
+    return -1;
+  }
+  PyObject* pyexecutor = PyTuple_GET_ITEM(pyargs, 1);
+  std::shared_ptr<AsyncExecutor> executor;
+  if (PyObject_IsInstance(pyexecutor, GetModuleState(self)->cls_asyncexecutor)) {
+    executor = ((PyAsyncExecutor*)pyexecutor)->executor;
+    if (executor == nullptr) {
+      ThrowInvalidArguments("not initialized executor");
+      return -1;
     }
+  } else {
+    executor = std::make_shared<AsyncExecutor>(PyObjToInt(pyexecutor), false);
+  }
+  // The tasks refer to the File object, which is kept alive until the queue is stopped.
+  Py_INCREF(pyfile);
+  Py_XDECREF(self->pyfile);
+  self->pyfile = pyfile;
+  self->file_generation = file->generation;
+  self->queue = std::make_shared<AsyncQueue>(
+      std::move(executor), 0, AsyncQueue::OVERFLOW_BLOCK, false, 0);
+  self->concurrent = file->concurrent;
+  return 0;
+}
+
+// Implementation of AsyncFile#__repr__.
+static PyObject* asyncfile_repr(PyAsyncFile* self) {
+  HandleLock handle_lock(self->mutex, false);
+  const std::string& str = tkrzw::SPrintF("<tkrzw.AsyncFile: %p>", (void*)self->queue.get());
+  return CreatePyString(str);
+}
+
+// Implementation of AsyncFile#__str__.
+static PyObject* asyncfile_str(PyAsyncFile* self) {
+  HandleLock handle_lock(self->mutex, false);
+  const std::string& str = tkrzw::SPrintF("AsyncFile:%p", (void*)self->queue.get());
+  return CreatePyString(str);
+}
+
+// Adds a task to the queue of AsyncFile and makes a future object of the result.
+static PyObject* SubmitAsyncFileTask(
+    PyAsyncFile* self, std::unique_ptr<AsyncQueue::Task> task, tkrzw::StatusFuture&& future,
+    bool is_str = false) {
+  if (!self->queue->Add(std::move(task), false)) {
+    NativeLock lock(true);
+    self->queue->Add(std::move(task), true);
+  }
+  return CreatePyFutureMove(self, std::move(future), self->concurrent, is_str);
+}
+
+// Implementation of AsyncFile#Destruct.
+static PyObject* asyncfile_Destruct(PyAsyncFile* self) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
   }
-  char* buf = new char[size];
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
     NativeLock lock(self->concurrent);
-    status = self->file->Read(off, buf, size);
-  }
-  if (pystatus != nullptr) {
-    *((PyTkStatus*)pystatus)->status = status;
-  }
-  if (status != tkrzw::Status::SUCCESS) {
-    delete[] buf;
-    Py_RETURN_NONE;
+    self->queue->Stop();
+    self->queue.reset();
   }
-  PyObject* pydata = CreatePyBytes(std::string_view(buf, size));
-  delete[] buf;
-  return pydata;
+  Py_CLEAR(self->pyfile);
+  Py_RETURN_NONE;
 }
 
-static PyObject* file_ReadStr(PyFile* self, PyObject* pyargs) {
-  if (self->file == nullptr) {
-    ThrowInvalidArguments("not opened file");
+// Implementation of AsyncFile#Read and AsyncFile#ReadStr.
+static PyObject* asyncfile_ReadImpl(PyAsyncFile* self, PyObject* pyargs, bool is_str) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 2 || argc > 3) {
+  if (argc != 2) {
     ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
   const int64_t off = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 0)));
   const int64_t size = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 1)));
-  PyObject* pystatus = nullptr;
-  if (argc > 2) {
-    pystatus = PyTuple_GET_ITEM(pyargs, 2);
-    if (pystatus == Py_None) {
-      pystatus = nullptr;
-    } else if (!PyObject_IsInstance(pystatus, cls_status)) {
-      ThrowInvalidArguments("not a status object");
-      return nullptr;
-    }
-  }
-  char* buf = new char[size];
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->file->Read(off, buf, size);
-  }
-  if (pystatus != nullptr) {
-    *((PyTkStatus*)pystatus)->status = status;
-  }
-  if (status != tkrzw::Status::SUCCESS) {
-    delete[] buf;
-    Py_RETURN_NONE;
-  }
-  PyObject* pystr = CreatePyString(std::string_view(buf, size));
-  delete[] buf;
-  return pystr;
+  PyFile* pyfile = (PyFile*)self->pyfile;
+  const int64_t generation = self->file_generation;
+  auto task = std::make_unique<AsyncTask<std::pair<tkrzw::Status, std::string>>>(
+      [pyfile, generation, off, size]() {
+        std::string data(size, 0);
+        tkrzw::Status status = RunAsyncFileOperation(
+            pyfile, generation, [&](tkrzw::PolyFile* file) {
+              return file->Read(off, data.data(), size);
+            });
+        if (status != tkrzw::Status::SUCCESS) {
+          data.clear();
+        }
+        return std::make_pair(std::move(status), std::move(data));
+      }, true);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncFileTask(self, std::move(task), std::move(future), is_str);
 }
 
-static PyObject* file_Write(PyFile* self, PyObject* pyargs) {
-  if (self->file == nullptr) {
-    ThrowInvalidArguments("not opened file");
+// Implementation of AsyncFile#Read.
+static PyObject* asyncfile_Read(PyAsyncFile* self, PyObject* pyargs) {
+  return asyncfile_ReadImpl(self, pyargs, false);
+}
+
+// Implementation of AsyncFile#ReadStr.
+static PyObject* asyncfile_ReadStr(PyAsyncFile* self, PyObject* pyargs) {
+  return asyncfile_ReadImpl(self, pyargs, true);
+}
+
+// Implementation of AsyncFile#Write.
+static PyObject* asyncfile_Write(PyAsyncFile* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
@@ -4307,56 +9827,185 @@ static PyObject* file_Write(PyFile* self, PyObject* pyargs) {
     return nullptr;
   }
   const int64_t off = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 0)));
-  PyObject* pydata = PyTuple_GET_ITEM(pyargs, 1);
-  SoftString data(pydata);
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->file->Write(off, data.Get().data(), data.Get().size());
-  }
-  return CreatePyTkStatusMove(std::move(status));
+  BufferString data(PyTuple_GET_ITEM(pyargs, 1));
+  if (!data.IsValid()) {
+    return nullptr;
+  }
+  PyFile* pyfile = (PyFile*)self->pyfile;
+  const int64_t generation = self->file_generation;
+  auto task = std::make_unique<AsyncTask<tkrzw::Status>>(
+      [pyfile, generation, off, data = std::string(data.Get())]() {
+        return RunAsyncFileOperation(pyfile, generation, [&](tkrzw::PolyFile* file) {
+          if (off + static_cast<int64_t>(data.size()) > file->GetSizeSimple()) {
+            FileRemapGuard remap_guard(pyfile);
+            if (remap_guard.GetStatus() != tkrzw::Status::SUCCESS) {
+              return remap_guard.GetStatus();
+            }
+            return file->Write(off, data.data(), data.size());
+          }
+          return file->Write(off, data.data(), data.size());
+        });
+      }, false);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncFileTask(self, std::move(task), std::move(future));
 }
 
-static PyObject* file_Append(PyFile* self, PyObject* pyargs) {
-  if (self->file == nullptr) {
-    ThrowInvalidArguments("not opened file");
+// Implementation of AsyncFile#Append.
+static PyObject* asyncfile_Append(PyAsyncFile* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 1 || argc > 2) {
+  if (argc != 1) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  PyObject* pydata = PyTuple_GET_ITEM(pyargs, 0);
-  SoftString data(pydata);
-  PyObject* pystatus = nullptr;
-  if (argc > 2) {
-    pystatus = PyTuple_GET_ITEM(pyargs, 1);
-    if (pystatus == Py_None) {
-      pystatus = nullptr;
-    } else if (!PyObject_IsInstance(pystatus, cls_status)) {
-      ThrowInvalidArguments("not a status object");
-      return nullptr;
-    }
+  BufferString data(PyTuple_GET_ITEM(pyargs, 0));
+  if (!data.IsValid()) {
+    return nullptr;
   }
-  int64_t new_off = 0;
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->file->Append(data.Get().data(), data.Get().size(), &new_off);
+  PyFile* pyfile = (PyFile*)self->pyfile;
+  const int64_t generation = self->file_generation;
+  auto task = std::make_unique<AsyncTask<std::pair<tkrzw::Status, int64_t>>>(
+      [pyfile, generation, data = std::string(data.Get())]() {
+        int64_t new_off = 0;
+        tkrzw::Status status = RunAsyncFileOperation(
+            pyfile, generation, [&](tkrzw::PolyFile* file) {
+              FileRemapGuard remap_guard(pyfile);
+              if (remap_guard.GetStatus() != tkrzw::Status::SUCCESS) {
+                return remap_guard.GetStatus();
+              }
+              return file->Append(data.data(), data.size(), &new_off);
+            });
+        return std::make_pair(std::move(status), new_off);
+      }, false);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncFileTask(self, std::move(task), std::move(future));
+}
+
+// Implementation of AsyncFile#Synchronize.
+static PyObject* asyncfile_Synchronize(PyAsyncFile* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->queue == nullptr) {
+    ThrowInvalidArguments("destructed object");
+    return nullptr;
   }
-  if (pystatus != nullptr) {
-    *((PyTkStatus*)pystatus)->status = status;
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
   }
-  if (status != tkrzw::Status::SUCCESS) {
-    Py_RETURN_NONE;
+  const bool hard = PyObject_IsTrue(PyTuple_GET_ITEM(pyargs, 0));
+  PyFile* pyfile = (PyFile*)self->pyfile;
+  const int64_t generation = self->file_generation;
+  auto task = std::make_unique<AsyncTask<tkrzw::Status>>(
+      [pyfile, generation, hard]() {
+        return RunAsyncFileOperation(pyfile, generation, [&](tkrzw::PolyFile* file) {
+          FileRemapGuard remap_guard(pyfile);
+          if (remap_guard.GetStatus() != tkrzw::Status::SUCCESS) {
+            return remap_guard.GetStatus();
+          }
+          return file->Synchronize(hard);
+        });
+      }, false);
+  tkrzw::StatusFuture future(task->GetFuture());
+  return SubmitAsyncFileTask(self, std::move(task), std::move(future));
+}
+
+// Defines the AsyncFile class.
+static bool DefineAsyncFile(PyObject* module, ModuleState* state) {
+  static PyMethodDef methods[] = {
+    {"Destruct", (PyCFunction)asyncfile_Destruct, METH_NOARGS,
+     "Destructs the asynchronous file adapter."},
+    {"Read", (PyCFunction)asyncfile_Read, METH_VARARGS,
+     "Reads data."},
+    {"ReadStr", (PyCFunction)asyncfile_ReadStr, METH_VARARGS,
+     "Reads data as a string."},
+    {"Write", (PyCFunction)asyncfile_Write, METH_VARARGS,
+     "Writes data."},
+    {"Append", (PyCFunction)asyncfile_Append, METH_VARARGS,
+     "Appends data at the end of the file."},
+    {"Synchronize", (PyCFunction)asyncfile_Synchronize, METH_VARARGS,
+     "Synchronizes the content of the file to the file system."},
+    {nullptr, nullptr, 0, nullptr}
+  };
+  static PyType_Slot slots[] = {
+    {Py_tp_doc, (void*)"Asynchronous file adapter."},
+    {Py_tp_new, (void*)asyncfile_new},
+    {Py_tp_dealloc, (void*)asyncfile_dealloc},
+    {Py_tp_init, (void*)asyncfile_init},
+    {Py_tp_repr, (void*)asyncfile_repr},
+    {Py_tp_str, (void*)asyncfile_str},
+    {Py_tp_methods, (void*)methods},
+    {0, nullptr},
+  };
+  static PyType_Spec spec = {
+    "tkrzw.AsyncFile", sizeof(PyAsyncFile), 0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, slots};
+  state->cls_asyncfile = PyType_FromModuleAndSpec(module, &spec, nullptr);
+  if (state->cls_asyncfile == nullptr) return false;
+  if (PyModule_AddObjectRef(module, "AsyncFile", state->cls_asyncfile) != 0) return false;
+  return true;
+}
+
+// Implementation of FlatRecordWriter.new.
+static PyObject* flatwriter_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
+  PyFlatRecordWriter* self = (PyFlatRecordWriter*)pytype->tp_alloc(pytype, 0);
+  if (!self) return nullptr;
+  // Records of a call are written without the GIL and must not be interleaved with those of
+  // another call, so the mutex is made on every build.
+  self->mutex = new std::shared_mutex();
+  self->pyfile = nullptr;
+  self->num_records = 0;
+  RegisterForkHandle((PyObject*)self, AbandonFlatRecordWriterHandle);
+  return (PyObject*)self;
+}
+
+// Implementation of FlatRecordWriter#dealloc.
+static void flatwriter_dealloc(PyFlatRecordWriter* self) {
+  UnregisterForkHandle((PyObject*)self);
+  Py_XDECREF(self->pyfile);
+  delete self->mutex;
+  PyTypeObject* pytype = Py_TYPE(self);
+  pytype->tp_free((PyObject*)self);
+  Py_DECREF(pytype);
+}
+
+// Implementation of FlatRecordWriter#__init__.
+static int flatwriter_init(PyFlatRecordWriter* self, PyObject* pyargs, PyObject* pykwds) {
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return -1;
   }
-  return PyLong_FromLongLong(new_off);
+  PyObject* pyfile = PyTuple_GET_ITEM(pyargs, 0);
+  if (!PyObject_IsInstance(pyfile, GetModuleState(self)->cls_file)) {
+    ThrowInvalidArguments("the argument is not a File");
+    return -1;
+  }
+  HandleLock handle_lock(self->mutex, true);
+  Py_INCREF(pyfile);
+  Py_XDECREF(self->pyfile);
+  self->pyfile = pyfile;
+  self->num_records = 0;
+  return 0;
 }
 
-static PyObject* file_Truncate(PyFile* self, PyObject* pyargs) {
-  if (self->file == nullptr) {
-    ThrowInvalidArguments("not opened file");
+// Implementation of FlatRecordWriter#__repr__.
+static PyObject* flatwriter_repr(PyFlatRecordWriter* self) {
+  HandleLock handle_lock(self->mutex, false);
+  const std::string& str = tkrzw::StrCat(
+      "<tkrzw.FlatRecordWriter: num_records=", self->num_records, ">");
+  return CreatePyString(str);
+}
+
+// Implementation of FlatRecordWriter#Write.
+static PyObject* flatwriter_Write(PyFlatRecordWriter* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->pyfile == nullptr) {
+    ThrowInvalidArguments("not initialized writer");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
@@ -4364,153 +10013,266 @@ static PyObject* file_Truncate(PyFile* self, PyObject* pyargs) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
     return nullptr;
   }
-  const int64_t size = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 0)));
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->file->Truncate(size);
+  PyObject* pyrecords = PyTuple_GET_ITEM(pyargs, 0);
+  if (!PySequence_Check(pyrecords)) {
+    ThrowInvalidArguments("records must be a sequence");
+    return nullptr;
+  }
+  PyObject* pyrecseq = PySequence_Fast(pyrecords, "");
+  if (pyrecseq == nullptr) {
+    return nullptr;
+  }
+  const int32_t num_items = PySequence_Fast_GET_SIZE(pyrecseq);
+  PyObject** pyrecitems = PySequence_Fast_ITEMS(pyrecseq);
+  std::vector<std::unique_ptr<BufferString>> strs;
+  strs.reserve(num_items);
+  for (int32_t i = 0; i < num_items; i++) {
+    PyObject* pyrec = pyrecitems[i];
+    if (PyTuple_Check(pyrec) && PyTuple_GET_SIZE(pyrec) == 2) {
+      strs.emplace_back(std::make_unique<BufferString>(PyTuple_GET_ITEM(pyrec, 0)));
+      if (strs.back()->IsValid()) {
+        strs.emplace_back(std::make_unique<BufferString>(PyTuple_GET_ITEM(pyrec, 1)));
+      }
+    } else {
+      strs.emplace_back(std::make_unique<BufferString>(pyrec));
+    }
+    if (!strs.back()->IsValid()) {
+      Py_DECREF(pyrecseq);
+      return nullptr;
+    }
+  }
+  PyFile* pyfile = (PyFile*)self->pyfile;
+  HandleLock file_lock(pyfile->mutex, false);
+  if (pyfile->file == nullptr) {
+    Py_DECREF(pyrecseq);
+    ThrowInvalidArguments("not opened file");
+    return nullptr;
+  }
+  FileRemapGuard remap_guard(pyfile);
+  tkrzw::Status status = remap_guard.GetStatus();
+  if (status == tkrzw::Status::SUCCESS) {
+    NativeLock lock(true);
+    tkrzw::FlatRecord rec(pyfile->file);
+    for (const auto& str : strs) {
+      status = rec.Write(str->Get());
+      if (status != tkrzw::Status::SUCCESS) {
+        break;
+      }
+      self->num_records++;
+    }
+  }
+  strs.clear();
+  Py_DECREF(pyrecseq);
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Defines the FlatRecordWriter class.
+static bool DefineFlatRecordWriter(PyObject* module, ModuleState* state) {
+  static PyMethodDef methods[] = {
+    {"Write", (PyCFunction)flatwriter_Write, METH_VARARGS,
+     "Writes records."},
+    {nullptr, nullptr, 0, nullptr}
+  };
+  static PyType_Slot slots[] = {
+    {Py_tp_doc, (void*)"Writer of a stream of flat records."},
+    {Py_tp_new, (void*)flatwriter_new},
+    {Py_tp_dealloc, (void*)flatwriter_dealloc},
+    {Py_tp_init, (void*)flatwriter_init},
+    {Py_tp_repr, (void*)flatwriter_repr},
+    {Py_tp_methods, (void*)methods},
+    {0, nullptr},
+  };
+  static PyType_Spec spec = {
+    "tkrzw.FlatRecordWriter", sizeof(PyFlatRecordWriter), 0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, slots};
+  state->cls_flatwriter = PyType_FromModuleAndSpec(module, &spec, nullptr);
+  if (state->cls_flatwriter == nullptr) return false;
+  if (PyModule_AddObjectRef(module, "FlatRecordWriter", state->cls_flatwriter) != 0) {
+    return false;
   }
-  return CreatePyTkStatusMove(std::move(status));
+  return true;
+}
+
+// Implementation of FlatRecordReader.new.
+static PyObject* flatreader_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
+  PyFlatRecordReader* self = (PyFlatRecordReader*)pytype->tp_alloc(pytype, 0);
+  if (!self) return nullptr;
+  // The state of the reader is updated without the GIL, so the mutex is made on every build.
+  self->mutex = new std::shared_mutex();
+  self->pyfile = nullptr;
+  self->file_generation = 0;
+  self->reader = nullptr;
+  self->num_records = 0;
+  RegisterForkHandle((PyObject*)self, AbandonFlatRecordReaderHandle);
+  return (PyObject*)self;
 }
 
-static PyObject* file_Synchronize(PyFile* self, PyObject* pyargs) {
-  if (self->file == nullptr) {
-    ThrowInvalidArguments("not opened file");
-    return nullptr;
-  }
+// Implementation of FlatRecordReader#dealloc.
+static void flatreader_dealloc(PyFlatRecordReader* self) {
+  UnregisterForkHandle((PyObject*)self);
+  delete self->reader;
+  Py_XDECREF(self->pyfile);
+  delete self->mutex;
+  PyTypeObject* pytype = Py_TYPE(self);
+  pytype->tp_free((PyObject*)self);
+  Py_DECREF(pytype);
+}
+
+// Implementation of FlatRecordReader#__init__.
+static int flatreader_init(PyFlatRecordReader* self, PyObject* pyargs, PyObject* pykwds) {
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 1 || argc > 3) {
+  if (argc < 1 || argc > 2) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
-    return nullptr;
-  }
-  PyObject* pyhard = PyTuple_GET_ITEM(pyargs, 0);
-  const bool hard = PyObject_IsTrue(pyhard);
-  int64_t off = 0;
-  int64_t size = 0;
-  if (argc > 1) {
-    off = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 1)));
+    return -1;
   }
-  if (argc > 2) {
-    size = std::max<int64_t>(0, PyObjToInt(PyTuple_GET_ITEM(pyargs, 2)));
+  PyObject* pyfile = PyTuple_GET_ITEM(pyargs, 0);
+  if (!PyObject_IsInstance(pyfile, GetModuleState(self)->cls_file)) {
+    ThrowInvalidArguments("the argument is not a File");
+    return -1;
   }
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->file->Synchronize(hard, off, size);
+  const int64_t buffer_size = argc > 1 ? PyObjToInt(PyTuple_GET_ITEM(pyargs, 1)) : 1 << 20;
+  if (buffer_size < 1) {
+    ThrowInvalidArguments("invalid buffer size");
+    return -1;
   }
-  return CreatePyTkStatusMove(std::move(status));
-}
-
-static PyObject* file_GetSize(PyFile* self) {
-  if (self->file == nullptr) {
+  HandleLock handle_lock(self->mutex, true);
+  PyFile* file = (PyFile*)pyfile;
+  HandleLock file_lock(file->mutex, false);
+  if (file->file == nullptr) {
     ThrowInvalidArguments("not opened file");
-    return nullptr;
-  }
-  int64_t size = -1;
-  {
-    NativeLock lock(self->concurrent);
-    size = self->file->GetSizeSimple();
-  }
-  if (size >= 0) {
-    return PyLong_FromLongLong(size);
+    return -1;
   }
-  Py_RETURN_NONE;
+  Py_INCREF(pyfile);
+  Py_XDECREF(self->pyfile);
+  self->pyfile = pyfile;
+  self->file_generation = file->generation;
+  delete self->reader;
+  self->reader = new tkrzw::FlatRecordReader(file->file, buffer_size);
+  self->num_records = 0;
+  return 0;
 }
 
-static PyObject* file_GetPath(PyFile* self) {
-  std::string path;
-  tkrzw::Status status(tkrzw::Status::SUCCESS);
-  {
-    NativeLock lock(self->concurrent);
-    status = self->file->GetPath(&path);
-  }
-  if (status == tkrzw::Status::SUCCESS) {
-    return CreatePyString(path);
-  }
-  Py_RETURN_NONE;
+// Implementation of FlatRecordReader#__repr__.
+static PyObject* flatreader_repr(PyFlatRecordReader* self) {
+  HandleLock handle_lock(self->mutex, false);
+  const std::string& str = tkrzw::StrCat(
+      "<tkrzw.FlatRecordReader: num_records=", self->num_records, ">");
+  return CreatePyString(str);
 }
 
-// Implementation of File#Search.
-static PyObject* file_Search(PyFile* self, PyObject* pyargs) {
-  if (self->file == nullptr) {
-    ThrowInvalidArguments("not opened file");
+// Implementation of FlatRecordReader#Read and FlatRecordReader#ReadPairs.
+static PyObject* flatreader_ReadImpl(PyFlatRecordReader* self, PyObject* pyargs, bool pairs) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->reader == nullptr) {
+    ThrowInvalidArguments("not initialized reader");
     return nullptr;
   }
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
-  if (argc < 2 || argc > 3) {
-    ThrowInvalidArguments(argc < 2 ? "too few arguments" : "too many arguments");
+  if (argc > 2) {
+    ThrowInvalidArguments("too many arguments");
     return nullptr;
   }
-  PyObject* pymode = PyTuple_GET_ITEM(pyargs, 0);
-  PyObject* pypattern = PyTuple_GET_ITEM(pyargs, 1);
-  int32_t capacity = 0;
-  if (argc > 2) {
-    capacity = PyObjToInt(PyTuple_GET_ITEM(pyargs, 2));
+  const int64_t max_count = argc > 0 ? PyObjToInt(PyTuple_GET_ITEM(pyargs, 0)) : 1;
+  PyObject* pystatus = nullptr;
+  if (argc > 1) {
+    pystatus = PyTuple_GET_ITEM(pyargs, 1);
+    if (pystatus == Py_None) {
+      pystatus = nullptr;
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
+      ThrowInvalidArguments("not a status object");
+      return nullptr;
+    }
   }
-  SoftString pattern(pypattern);
-  SoftString mode(pymode);
-  std::vector<std::string> lines;
+  PyFile* pyfile = (PyFile*)self->pyfile;
+  HandleLock file_lock(pyfile->mutex, false);
+  // The generation tells a reopened file from the one given to the reader.
+  if (pyfile->file == nullptr || pyfile->generation != self->file_generation) {
+    ThrowInvalidArguments("not opened file");
+    return nullptr;
+  }
+  const int64_t num_reads = pairs ? max_count * 2 : max_count;
+  std::vector<std::string> records;
   tkrzw::Status status(tkrzw::Status::SUCCESS);
   {
-    NativeLock lock(self->concurrent);
-    status = tkrzw::SearchTextFileModal(self->file, mode.Get(), pattern.Get(), &lines, capacity);
+    NativeLock lock(true);
+    while (static_cast<int64_t>(records.size()) < num_reads) {
+      std::string_view record;
+      tkrzw::FlatRecord::RecordType rec_type = tkrzw::FlatRecord::RECORD_NORMAL;
+      status = self->reader->Read(&record, &rec_type);
+      if (status != tkrzw::Status::SUCCESS) {
+        break;
+      }
+      if (rec_type != tkrzw::FlatRecord::RECORD_NORMAL) {
+        continue;
+      }
+      records.emplace_back(record);
+    }
   }
-  if (status != tkrzw::Status::SUCCESS) {
-    ThrowStatusException(status);    
-    return nullptr;
+  if (pairs && records.size() % 2 != 0) {
+    status.Set(tkrzw::Status::BROKEN_DATA_ERROR, "odd number of records");
+    records.pop_back();
   }
-  PyObject* pyrv = PyList_New(lines.size());
-  for (size_t i = 0; i < lines.size(); i++) {
-    PyList_SET_ITEM(pyrv, i, CreatePyString(lines[i]));
+  if (status == tkrzw::Status::NOT_FOUND_ERROR && !records.empty()) {
+    status.Set(tkrzw::Status::SUCCESS);
+  }
+  if (pystatus != nullptr) {
+    *((PyTkStatus*)pystatus)->status = status;
+  }
+  self->num_records += records.size();
+  if (pairs) {
+    PyObject* pyrv = PyList_New(records.size() / 2);
+    for (size_t i = 0; i < records.size(); i += 2) {
+      PyObject* pykey = CreatePyBytes(records[i]);
+      PyObject* pyvalue = CreatePyBytes(records[i + 1]);
+      PyList_SET_ITEM(pyrv, i / 2, PyTuple_Pack(2, pykey, pyvalue));
+      Py_DECREF(pykey);
+      Py_DECREF(pyvalue);
+    }
+    return pyrv;
+  }
+  PyObject* pyrv = PyList_New(records.size());
+  for (size_t i = 0; i < records.size(); i++) {
+    PyList_SET_ITEM(pyrv, i, CreatePyBytes(records[i]));
   }
   return pyrv;
 }
 
-// Defines the File class.
-static bool DefineFile() {
-  static PyTypeObject pytype = {PyVarObject_HEAD_INIT(nullptr, 0)};
-  const size_t zoff = offsetof(PyTypeObject, tp_name);
-  std::memset((char*)&pytype + zoff, 0, sizeof(pytype) - zoff);
-  pytype.tp_name = "tkrzw.File";
-  pytype.tp_basicsize = sizeof(PyFile);
-  pytype.tp_itemsize = 0;
-  pytype.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
-  pytype.tp_doc = "Generic file implemenation.";
-  pytype.tp_new = file_new;
-  pytype.tp_dealloc = (destructor)file_dealloc;
-  pytype.tp_init = (initproc)file_init;
-  pytype.tp_repr = (unaryfunc)file_repr;
-  pytype.tp_str = (unaryfunc)file_str;
+// Implementation of FlatRecordReader#Read.
+static PyObject* flatreader_Read(PyFlatRecordReader* self, PyObject* pyargs) {
+  return flatreader_ReadImpl(self, pyargs, false);
+}
+
+// Implementation of FlatRecordReader#ReadPairs.
+static PyObject* flatreader_ReadPairs(PyFlatRecordReader* self, PyObject* pyargs) {
+  return flatreader_ReadImpl(self, pyargs, true);
+}
+
+// Defines the FlatRecordReader class.
+static bool DefineFlatRecordReader(PyObject* module, ModuleState* state) {
   static PyMethodDef methods[] = {
-    {"Open", (PyCFunction)file_Open, METH_VARARGS | METH_KEYWORDS,
-     "Opens a text file."},
-    {"Close", (PyCFunction)file_Close, METH_NOARGS,
-     "Closes the text file."},
-    {"Read", (PyCFunction)file_Read, METH_VARARGS,
-     "Reads data."},
-    {"ReadStr", (PyCFunction)file_ReadStr, METH_VARARGS,
-     "Reads data as a string."},
-    {"Write", (PyCFunction)file_Write, METH_VARARGS,
-     "Writes data."},
-    {"Append", (PyCFunction)file_Append, METH_VARARGS,
-     "Appends data at the end of the file."},
-    {"Truncate", (PyCFunction)file_Truncate, METH_VARARGS,
-     "Truncates the file."},
-    {"Synchronize", (PyCFunction)file_Synchronize, METH_VARARGS,
-     "Synchronizes the content of the file to the file system."},
-    {"GetSize", (PyCFunction)file_GetSize, METH_NOARGS,
-     "Gets the size of the file."},
-    {"GetPath", (PyCFunction)file_GetPath, METH_NOARGS,
-     "Gets the path of the file."},
-    {"Search", (PyCFunction)file_Search, METH_VARARGS,
-     "Searches the text file and get lines which match a pattern."},
+    {"Read", (PyCFunction)flatreader_Read, METH_VARARGS,
+     "Reads records."},
+    {"ReadPairs", (PyCFunction)flatreader_ReadPairs, METH_VARARGS,
+     "Reads pairs of records as keys and values."},
     {nullptr, nullptr, 0, nullptr}
   };
-  pytype.tp_methods = methods;
-  if (PyType_Ready(&pytype) != 0) return false;
-  cls_file = (PyObject*)&pytype;
-  Py_INCREF(cls_file);
-  if (PyModule_AddObject(mod_tkrzw, "File", cls_file) != 0) return false;
+  static PyType_Slot slots[] = {
+    {Py_tp_doc, (void*)"Reader of a stream of flat records."},
+    {Py_tp_new, (void*)flatreader_new},
+    {Py_tp_dealloc, (void*)flatreader_dealloc},
+    {Py_tp_init, (void*)flatreader_init},
+    {Py_tp_repr, (void*)flatreader_repr},
+    {Py_tp_methods, (void*)methods},
+    {0, nullptr},
+  };
+  static PyType_Spec spec = {
+    "tkrzw.FlatRecordReader", sizeof(PyFlatRecordReader), 0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, slots};
+  state->cls_flatreader = PyType_FromModuleAndSpec(module, &spec, nullptr);
+  if (state->cls_flatreader == nullptr) return false;
+  if (PyModule_AddObjectRef(module, "FlatRecordReader", state->cls_flatreader) != 0) {
+    return false;
+  }
   return true;
 }
 
@@ -4518,15 +10280,21 @@ static bool DefineFile() {
 static PyObject* index_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
   PyIndex* self = (PyIndex*)pytype->tp_alloc(pytype, 0);
   if (!self) return nullptr;
+  self->mutex = NewHandleMutex();
   self->index = nullptr;
   self->concurrent = false;
+  RegisterForkHandle((PyObject*)self, AbandonIndexHandle);
   return (PyObject*)self;
 }
 
 // Implementation of Index#dealloc.
 static void index_dealloc(PyIndex* self) {
+  UnregisterForkHandle((PyObject*)self);
   delete self->index;
-  Py_TYPE(self)->tp_free((PyObject*)self);
+  delete self->mutex;
+  PyTypeObject* pytype = Py_TYPE(self);
+  pytype->tp_free((PyObject*)self);
+  Py_DECREF(pytype);
 }
 
 // Implementation of Index#__init__.
@@ -4541,6 +10309,7 @@ static int index_init(PyIndex* self, PyObject* pyargs, PyObject* pykwds) {
 
 // Implementation of Index#__repr__.
 static PyObject* index_repr(PyIndex* self) {
+  HandleLock handle_lock(self->mutex, false);
   std::string path = "-";
   int64_t num_records = -1;
   if (self->index != nullptr) {
@@ -4555,6 +10324,7 @@ static PyObject* index_repr(PyIndex* self) {
 
 // Implementation of Index#__str__.
 static PyObject* index_str(PyIndex* self) {
+  HandleLock handle_lock(self->mutex, false);
   std::string path = "-";
   int64_t num_records = -1;
   if (self->index != nullptr) {
@@ -4569,6 +10339,7 @@ static PyObject* index_str(PyIndex* self) {
 
 // Implementation of Index#Open.
 static PyObject* index_Open(PyIndex* self, PyObject* pyargs, PyObject* pykwds) {
+  HandleLock handle_lock(self->mutex, true);
   if (self->index != nullptr) {
     ThrowInvalidArguments("opened index");
     return nullptr;
@@ -4623,11 +10394,12 @@ static PyObject* index_Open(PyIndex* self, PyObject* pyargs, PyObject* pykwds) {
     delete self->index;
     self->index = nullptr;
   }
-  return CreatePyTkStatusMove(std::move(status));
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
 // Implementation of Index#Close.
 static PyObject* index_Close(PyIndex* self) {
+  HandleLock handle_lock(self->mutex, true);
   if (self->index == nullptr) {
     ThrowInvalidArguments("not opened index");
     return nullptr;
@@ -4639,11 +10411,12 @@ static PyObject* index_Close(PyIndex* self) {
   }
   delete self->index;
   self->index = nullptr;
-  return CreatePyTkStatusMove(std::move(status));
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
 // Implementation of Index#GetValues.
 static PyObject* index_GetValues(PyIndex* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->index == nullptr) {
     ThrowInvalidArguments("not opened index");
     return nullptr;
@@ -4673,6 +10446,7 @@ static PyObject* index_GetValues(PyIndex* self, PyObject* pyargs) {
 
 // Implementation of Index#GetValuesStr.
 static PyObject* index_GetValuesStr(PyIndex* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->index == nullptr) {
     ThrowInvalidArguments("not opened index");
     return nullptr;
@@ -4702,6 +10476,7 @@ static PyObject* index_GetValuesStr(PyIndex* self, PyObject* pyargs) {
 
 // Implementation of Index#Add.
 static PyObject* index_Add(PyIndex* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->index == nullptr) {
     ThrowInvalidArguments("not opened index");
     return nullptr;
@@ -4720,11 +10495,12 @@ static PyObject* index_Add(PyIndex* self, PyObject* pyargs) {
     NativeLock lock(self->concurrent);
     status = self->index->Add(key.Get(), value.Get());
   }
-  return CreatePyTkStatusMove(std::move(status));
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
 // Implementation of Index#Remove.
 static PyObject* index_Remove(PyIndex* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->index == nullptr) {
     ThrowInvalidArguments("not opened index");
     return nullptr;
@@ -4743,11 +10519,12 @@ static PyObject* index_Remove(PyIndex* self, PyObject* pyargs) {
     NativeLock lock(self->concurrent);
     status = self->index->Remove(key.Get(), value.Get());
   }
-  return CreatePyTkStatusMove(std::move(status));
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
 // Implementation of Index#Count.
 static PyObject* index_Count(PyIndex* self) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->index == nullptr) {
     ThrowInvalidArguments("not opened index");
     return nullptr;
@@ -4762,6 +10539,7 @@ static PyObject* index_Count(PyIndex* self) {
 
 // Implementation of Index#GetFilePath.
 static PyObject* index_GetFilePath(PyIndex* self) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->index == nullptr) {
     ThrowInvalidArguments("not opened index");
     return nullptr;
@@ -4776,6 +10554,7 @@ static PyObject* index_GetFilePath(PyIndex* self) {
 
 // Implementation of Index#Clear.
 static PyObject* index_Clear(PyIndex* self) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->index == nullptr) {
     ThrowInvalidArguments("not opened index");
     return nullptr;
@@ -4785,11 +10564,12 @@ static PyObject* index_Clear(PyIndex* self) {
     NativeLock lock(self->concurrent);
     status = self->index->Clear();
   }
-  return CreatePyTkStatusMove(std::move(status));
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
 // Implementation of Index#Rebuild.
 static PyObject* index_Rebuild(PyIndex* self) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->index == nullptr) {
     ThrowInvalidArguments("not opened index");
     return nullptr;
@@ -4799,11 +10579,12 @@ static PyObject* index_Rebuild(PyIndex* self) {
     NativeLock lock(self->concurrent);
     status = self->index->Rebuild();
   }
-  return CreatePyTkStatusMove(std::move(status));
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
 // Implementation of Index#Synchronize.
 static PyObject* index_Synchronize(PyIndex* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->index == nullptr) {
     ThrowInvalidArguments("not opened index");
     return nullptr;
@@ -4820,11 +10601,12 @@ static PyObject* index_Synchronize(PyIndex* self, PyObject* pyargs) {
     NativeLock lock(self->concurrent);
     status = self->index->Synchronize(hard);
   }
-  return CreatePyTkStatusMove(std::move(status));
+  return CreatePyTkStatusMove(self, std::move(status));
 }
 
 // Implementation of Index#IsOpen.
 static PyObject* index_IsOpen(PyIndex* self) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->index == nullptr) {
     Py_RETURN_FALSE;
   }
@@ -4833,6 +10615,7 @@ static PyObject* index_IsOpen(PyIndex* self) {
 
 // Implementation of Index#IsWritable.
 static PyObject* index_IsWritable(PyIndex* self) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->index == nullptr) {
     ThrowInvalidArguments("not opened index");
     return nullptr;
@@ -4846,13 +10629,15 @@ static PyObject* index_IsWritable(PyIndex* self) {
 
 // Implementation of Index#MakeIterator.
 static PyObject* index_MakeIterator(PyIndex* self) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->index == nullptr) {
     ThrowInvalidArguments("not opened index");
     return nullptr;
   }
-  PyTypeObject* pyitertype = (PyTypeObject*)cls_indexiter;
+  PyTypeObject* pyitertype = (PyTypeObject*)GetModuleState(self)->cls_indexiter;
   PyIndexIterator* pyiter = (PyIndexIterator*)pyitertype->tp_alloc(pyitertype, 0);
   if (!pyiter) return nullptr;
+  pyiter->mutex = NewHandleMutex();
   {
     NativeLock lock(self->concurrent);
     pyiter->iter = self->index->MakeIterator().release();
@@ -4863,6 +10648,7 @@ static PyObject* index_MakeIterator(PyIndex* self) {
 
 // Implementation of Index#__len__.
 static Py_ssize_t index_len(PyIndex* self) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->index == nullptr) {
     return 0;
   }
@@ -4876,6 +10662,7 @@ static Py_ssize_t index_len(PyIndex* self) {
 
 // Implementation of Index#__contains__.
 static int index_contains(PyIndex* self, PyObject* pyrec) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->index == nullptr) {
     ThrowInvalidArguments("not opened index");
     return -1;
@@ -4904,13 +10691,15 @@ static int index_contains(PyIndex* self, PyObject* pyrec) {
 
 // Implementation of Index#__iter__.
 static PyObject* index_iter(PyIndex* self) {
+  HandleLock handle_lock(self->mutex, false);
   if (self->index == nullptr) {
     ThrowInvalidArguments("not opened index");
     return nullptr;
   }
-  PyTypeObject* pyitertype = (PyTypeObject*)cls_indexiter;
+  PyTypeObject* pyitertype = (PyTypeObject*)GetModuleState(self)->cls_indexiter;
   PyIndexIterator* pyiter = (PyIndexIterator*)pyitertype->tp_alloc(pyitertype, 0);
   if (!pyiter) return nullptr;
+  pyiter->mutex = NewHandleMutex();
   {
     NativeLock lock(self->concurrent);
     pyiter->iter = self->index->MakeIterator().release();
@@ -4921,20 +10710,7 @@ static PyObject* index_iter(PyIndex* self) {
 }
 
 // Defines the Index class.
-static bool DefineIndex() {
-  static PyTypeObject pytype = {PyVarObject_HEAD_INIT(nullptr, 0)};
-  const size_t zoff = offsetof(PyTypeObject, tp_name);
-  std::memset((char*)&pytype + zoff, 0, sizeof(pytype) - zoff);
-  pytype.tp_name = "tkrzw.Index";
-  pytype.tp_basicsize = sizeof(PyIndex);
-  pytype.tp_itemsize = 0;
-  pytype.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
-  pytype.tp_doc = "Secondary index.";
-  pytype.tp_new = index_new;
-  pytype.tp_dealloc = (destructor)index_dealloc;
-  pytype.tp_init = (initproc)index_init;
-  pytype.tp_repr = (unaryfunc)index_repr;
-  pytype.tp_str = (unaryfunc)index_str;
+static bool DefineIndex(PyObject* module, ModuleState* state) {
   static PyMethodDef methods[] = {
     {"Open", (PyCFunction)index_Open, METH_VARARGS | METH_KEYWORDS,
      "Opens an index file."},
@@ -4966,20 +10742,25 @@ static bool DefineIndex() {
      "Makes an iterator for each record."},
     {nullptr, nullptr, 0, nullptr},
   };
-  pytype.tp_methods = methods;
-  static PyMappingMethods map_methods;
-  std::memset(&map_methods, 0, sizeof(map_methods));
-  map_methods.mp_length = (lenfunc)index_len;
-  pytype.tp_as_mapping = &map_methods;
-  static PySequenceMethods seq_methods;
-  std::memset(&seq_methods, 0, sizeof(seq_methods));
-  seq_methods.sq_contains = (objobjproc)index_contains;
-  pytype.tp_as_sequence = &seq_methods;
-  pytype.tp_iter = (getiterfunc)index_iter;
-  if (PyType_Ready(&pytype) != 0) return false;
-  cls_index = (PyObject*)&pytype;
-  Py_INCREF(cls_index);
-  if (PyModule_AddObject(mod_tkrzw, "Index", cls_index) != 0) return false;
+  static PyType_Slot slots[] = {
+    {Py_tp_doc, (void*)"Secondary index."},
+    {Py_tp_new, (void*)index_new},
+    {Py_tp_dealloc, (void*)index_dealloc},
+    {Py_tp_init, (void*)index_init},
+    {Py_tp_repr, (void*)index_repr},
+    {Py_tp_str, (void*)index_str},
+    {Py_tp_methods, (void*)methods},
+    {Py_mp_length, (void*)index_len},
+    {Py_sq_contains, (void*)index_contains},
+    {Py_tp_iter, (void*)index_iter},
+    {0, nullptr},
+  };
+  static PyType_Spec spec = {
+    "tkrzw.Index", sizeof(PyIndex), 0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, slots};
+  state->cls_index = PyType_FromModuleAndSpec(module, &spec, nullptr);
+  if (state->cls_index == nullptr) return false;
+  if (PyModule_AddObjectRef(module, "Index", state->cls_index) != 0) return false;
   return true;
 }
 
@@ -4987,6 +10768,7 @@ static bool DefineIndex() {
 static PyObject* indexiter_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
   PyIndexIterator* self = (PyIndexIterator*)pytype->tp_alloc(pytype, 0);
   if (!self) return nullptr;
+  self->mutex = NewHandleMutex();
   self->iter = nullptr;
   self->concurrent = false;
   return (PyObject*)self;
@@ -4995,7 +10777,10 @@ static PyObject* indexiter_new(PyTypeObject* pytype, PyObject* pyargs, PyObject*
 // Implementation of IndexIterator#dealloc.
 static void indexiter_dealloc(PyIndexIterator* self) {
   delete self->iter;
-  Py_TYPE(self)->tp_free((PyObject*)self);
+  delete self->mutex;
+  PyTypeObject* pytype = Py_TYPE(self);
+  pytype->tp_free((PyObject*)self);
+  Py_DECREF(pytype);
 }
 
 // Implementation of IndexIterator#__init__.
@@ -5006,11 +10791,12 @@ static int indexiter_init(PyIndexIterator* self, PyObject* pyargs, PyObject* pyk
     return -1;
   }
   PyObject* pyindex_obj = PyTuple_GET_ITEM(pyargs, 0);
-  if (!PyObject_IsInstance(pyindex_obj, cls_index)) {
+  if (!PyObject_IsInstance(pyindex_obj, GetModuleState(self)->cls_index)) {
     ThrowInvalidArguments("the argument is not an Index");
     return -1;
   }
   PyIndex* pyindex = (PyIndex*)pyindex_obj;
+  HandleLock index_lock(pyindex->mutex, false);
   {
     NativeLock lock(pyindex->concurrent);
     self->iter = pyindex->index->MakeIterator().release();
@@ -5021,6 +10807,7 @@ static int indexiter_init(PyIndexIterator* self, PyObject* pyargs, PyObject* pyk
 
 // Implementation of IndexIterator#__repr__.
 static PyObject* indexiter_repr(PyIndexIterator* self) {
+  HandleLock handle_lock(self->mutex, true);
   std::string key;
   {
     NativeLock lock(self->concurrent);
@@ -5034,6 +10821,7 @@ static PyObject* indexiter_repr(PyIndexIterator* self) {
 
 // Implementation of IndexIterator#__str__.
 static PyObject* indexiter_str(PyIndexIterator* self) {
+  HandleLock handle_lock(self->mutex, true);
   std::string key;
   {
     NativeLock lock(self->concurrent);
@@ -5046,6 +10834,7 @@ static PyObject* indexiter_str(PyIndexIterator* self) {
 
 // Implementation of IndexIterator#First.
 static PyObject* indexiter_First(PyIndexIterator* self) {
+  HandleLock handle_lock(self->mutex, true);
   {
     NativeLock lock(self->concurrent);
     self->iter->First();
@@ -5055,6 +10844,7 @@ static PyObject* indexiter_First(PyIndexIterator* self) {
 
 // Implementation of IndexIterator#Last.
 static PyObject* indexiter_Last(PyIndexIterator* self) {
+  HandleLock handle_lock(self->mutex, true);
   {
     NativeLock lock(self->concurrent);
     self->iter->Last();
@@ -5064,6 +10854,7 @@ static PyObject* indexiter_Last(PyIndexIterator* self) {
 
 // Implementation of IndexIterator#Jump.
 static PyObject* indexiter_Jump(PyIndexIterator* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, true);
   const int32_t argc = PyTuple_GET_SIZE(pyargs);
   if (argc < 1 || argc > 2) {
     ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
@@ -5085,6 +10876,7 @@ static PyObject* indexiter_Jump(PyIndexIterator* self, PyObject* pyargs) {
 
 // Implementation of IndexIterator#Next.
 static PyObject* indexiter_Next(PyIndexIterator* self) {
+  HandleLock handle_lock(self->mutex, true);
   {
     NativeLock lock(self->concurrent);
     self->iter->Next();
@@ -5094,6 +10886,7 @@ static PyObject* indexiter_Next(PyIndexIterator* self) {
 
 // Implementation of IndexIterator#Previous.
 static PyObject* indexiter_Previous(PyIndexIterator* self) {
+  HandleLock handle_lock(self->mutex, true);
   {
     NativeLock lock(self->concurrent);
     self->iter->Previous();
@@ -5103,6 +10896,7 @@ static PyObject* indexiter_Previous(PyIndexIterator* self) {
 
 // Implementation of IndexIterator#Get.
 static PyObject* indexiter_Get(PyIndexIterator* self) {
+  HandleLock handle_lock(self->mutex, true);
   std::string key, value;
   bool ok = false;
   {
@@ -5122,6 +10916,7 @@ static PyObject* indexiter_Get(PyIndexIterator* self) {
 
 // Implementation of IndexIterator#GetStr.
 static PyObject* indexiter_GetStr(PyIndexIterator* self) {
+  HandleLock handle_lock(self->mutex, true);
   std::string key, value;
   bool ok = false;
   {
@@ -5141,6 +10936,7 @@ static PyObject* indexiter_GetStr(PyIndexIterator* self) {
 
 // Implementation of IndexIterator#__next__.
 static PyObject* indexiter_iternext(PyIndexIterator* self) {
+  HandleLock handle_lock(self->mutex, true);
   std::string key, value;
   bool ok = false;
   {
@@ -5163,20 +10959,7 @@ static PyObject* indexiter_iternext(PyIndexIterator* self) {
 }
 
 // Defines the IndexIterator class.
-static bool DefineIndexIterator() {
-  static PyTypeObject pytype = {PyVarObject_HEAD_INIT(nullptr, 0)};
-  const size_t zoff = offsetof(PyTypeObject, tp_name);
-  std::memset((char*)&pytype + zoff, 0, sizeof(pytype) - zoff);
-  pytype.tp_name = "tkrzw.IndexIterator";
-  pytype.tp_basicsize = sizeof(PyIndexIterator);
-  pytype.tp_itemsize = 0;
-  pytype.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
-  pytype.tp_doc = "Iterator for each record of the secondary index.";
-  pytype.tp_new = indexiter_new;
-  pytype.tp_dealloc = (destructor)indexiter_dealloc;
-  pytype.tp_init = (initproc)indexiter_init;
-  pytype.tp_repr = (unaryfunc)indexiter_repr;
-  pytype.tp_str = (unaryfunc)indexiter_str;
+static bool DefineIndexIterator(PyObject* module, ModuleState* state) {
   static PyMethodDef methods[] = {
     {"First", (PyCFunction)indexiter_First, METH_NOARGS,
      "Initializes the iterator to indicate the first record."},
@@ -5194,29 +10977,357 @@ static bool DefineIndexIterator() {
      "Gets the key and the value of the current record of the iterator, as strings."},
     {nullptr, nullptr, 0, nullptr}
   };
-  pytype.tp_methods = methods;
-  pytype.tp_iternext = (iternextfunc)indexiter_iternext;
-  if (PyType_Ready(&pytype) != 0) return false;
-  cls_indexiter = (PyObject*)&pytype;
-  Py_INCREF(cls_indexiter);
-  if (PyModule_AddObject(mod_tkrzw, "IndexIterator", cls_indexiter) != 0) return false;
+  static PyType_Slot slots[] = {
+    {Py_tp_doc, (void*)"Iterator for each record of the secondary index."},
+    {Py_tp_new, (void*)indexiter_new},
+    {Py_tp_dealloc, (void*)indexiter_dealloc},
+    {Py_tp_init, (void*)indexiter_init},
+    {Py_tp_repr, (void*)indexiter_repr},
+    {Py_tp_str, (void*)indexiter_str},
+    {Py_tp_methods, (void*)methods},
+    {Py_tp_iternext, (void*)indexiter_iternext},
+    {0, nullptr},
+  };
+  static PyType_Spec spec = {
+    "tkrzw.IndexIterator", sizeof(PyIndexIterator), 0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, slots};
+  state->cls_indexiter = PyType_FromModuleAndSpec(module, &spec, nullptr);
+  if (state->cls_indexiter == nullptr) return false;
+  if (PyModule_AddObjectRef(module, "IndexIterator", state->cls_indexiter) != 0) return false;
+  return true;
+}
+
+// Implementation of UpdateLogReader.new.
+static PyObject* ulogreader_new(PyTypeObject* pytype, PyObject* pyargs, PyObject* pykwds) {
+  PyUpdateLogReader* self = (PyUpdateLogReader*)pytype->tp_alloc(pytype, 0);
+  if (!self) return nullptr;
+  self->mutex = NewHandleMutex();
+  self->mq = nullptr;
+  self->reader = nullptr;
+  RegisterForkHandle((PyObject*)self, AbandonUpdateLogReaderHandle);
+  return (PyObject*)self;
+}
+
+// Implementation of UpdateLogReader#dealloc.
+static void ulogreader_dealloc(PyUpdateLogReader* self) {
+  UnregisterForkHandle((PyObject*)self);
+  delete self->reader;
+  delete self->mq;
+  delete self->mutex;
+  PyTypeObject* pytype = Py_TYPE(self);
+  pytype->tp_free((PyObject*)self);
+  Py_DECREF(pytype);
+}
+
+// Implementation of UpdateLogReader#__init__.
+static int ulogreader_init(PyUpdateLogReader* self, PyObject* pyargs, PyObject* pykwds) {
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 0) {
+    ThrowInvalidArguments("too many arguments");
+    return -1;
+  }
+  return 0;
+}
+
+// Implementation of UpdateLogReader#__repr__.
+static PyObject* ulogreader_repr(PyUpdateLogReader* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->reader == nullptr) {
+    return CreatePyString("<tkrzw.UpdateLogReader:(unopened)>");
+  }
+  const std::string& str = tkrzw::StrCat(
+      "<tkrzw.UpdateLogReader: timestamp=", self->reader->GetTimestamp(), ">");
+  return CreatePyString(str);
+}
+
+// Implementation of UpdateLogReader#__str__.
+static PyObject* ulogreader_str(PyUpdateLogReader* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->reader == nullptr) {
+    return CreatePyString("(unopened)");
+  }
+  return CreatePyString(tkrzw::ToString(self->reader->GetTimestamp()));
+}
+
+// Implementation of UpdateLogReader#Open.
+static PyObject* ulogreader_Open(PyUpdateLogReader* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->reader != nullptr) {
+    ThrowInvalidArguments("opened update log");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc < 1 || argc > 2) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pyprefix = PyTuple_GET_ITEM(pyargs, 0);
+  const int64_t min_timestamp = argc > 1 ? PyObjToInt(PyTuple_GET_ITEM(pyargs, 1)) : 0;
+  SoftString prefix(pyprefix);
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(true);
+    auto mq = std::make_unique<tkrzw::MessageQueue>();
+    status = mq->Open(std::string(prefix.Get()), 1LL << 30,
+                      tkrzw::MessageQueue::OPEN_READ_ONLY);
+    if (status == tkrzw::Status::SUCCESS) {
+      self->reader = mq->MakeReader(min_timestamp).release();
+      self->mq = mq.release();
+    }
+  }
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of UpdateLogReader#Close.
+static PyObject* ulogreader_Close(PyUpdateLogReader* self) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->reader == nullptr) {
+    ThrowInvalidArguments("not opened update log");
+    return nullptr;
+  }
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(true);
+    delete self->reader;
+    status = self->mq->Close();
+  }
+  self->reader = nullptr;
+  delete self->mq;
+  self->mq = nullptr;
+  return CreatePyTkStatusMove(self, std::move(status));
+}
+
+// Implementation of UpdateLogReader#Read.
+static PyObject* ulogreader_Read(PyUpdateLogReader* self, PyObject* pyargs) {
+  HandleLock handle_lock(self->mutex, true);
+  if (self->reader == nullptr) {
+    ThrowInvalidArguments("not opened update log");
+    return nullptr;
+  }
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc > 3) {
+    ThrowInvalidArguments("too many arguments");
+    return nullptr;
+  }
+  const int64_t max_count = argc > 0 ? PyObjToInt(PyTuple_GET_ITEM(pyargs, 0)) : 1;
+  const double timeout = argc > 1 ? PyObjToDouble(PyTuple_GET_ITEM(pyargs, 1)) : 0;
+  PyObject* pystatus = nullptr;
+  if (argc > 2) {
+    pystatus = PyTuple_GET_ITEM(pyargs, 2);
+    if (pystatus == Py_None) {
+      pystatus = nullptr;
+    } else if (!PyObject_IsInstance(pystatus, GetModuleState(self)->cls_status)) {
+      ThrowInvalidArguments("not a status object");
+      return nullptr;
+    }
+  }
+  std::vector<std::pair<int64_t, std::string>> entries;
+  tkrzw::Status status(tkrzw::Status::SUCCESS);
+  {
+    NativeLock lock(true);
+    while (static_cast<int64_t>(entries.size()) < max_count) {
+      int64_t timestamp = 0;
+      std::string message;
+      status = self->reader->Read(entries.empty() ? timeout : 0, &timestamp, &message);
+      if (status != tkrzw::Status::SUCCESS) {
+        break;
+      }
+      entries.emplace_back(timestamp, std::move(message));
+    }
+  }
+  if (status == tkrzw::Status::INFEASIBLE_ERROR && !entries.empty()) {
+    status.Set(tkrzw::Status::SUCCESS);
+  }
+  if (pystatus != nullptr) {
+    *((PyTkStatus*)pystatus)->status = status;
+  }
+  PyObject* pyrv = PyList_New(entries.size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    PyObject* pyentry = PyTuple_New(2);
+    PyTuple_SET_ITEM(pyentry, 0, PyLong_FromLongLong(entries[i].first));
+    PyTuple_SET_ITEM(pyentry, 1, CreatePyBytes(entries[i].second));
+    PyList_SET_ITEM(pyrv, i, pyentry);
+  }
+  return pyrv;
+}
+
+// Implementation of UpdateLogReader#GetTimestamp.
+static PyObject* ulogreader_GetTimestamp(PyUpdateLogReader* self) {
+  HandleLock handle_lock(self->mutex, false);
+  if (self->reader == nullptr) {
+    ThrowInvalidArguments("not opened update log");
+    return nullptr;
+  }
+  return PyLong_FromLongLong(self->reader->GetTimestamp());
+}
+
+// Implementation of UpdateLogReader.ParseMessage.
+static PyObject* ulogreader_ParseMessage(PyObject* self, PyObject* pyargs) {
+  const int32_t argc = PyTuple_GET_SIZE(pyargs);
+  if (argc != 1) {
+    ThrowInvalidArguments(argc < 1 ? "too few arguments" : "too many arguments");
+    return nullptr;
+  }
+  PyObject* pymessage = PyTuple_GET_ITEM(pyargs, 0);
+  SoftString message(pymessage);
+  tkrzw::DBMUpdateLoggerMQ::UpdateLog op;
+  tkrzw::Status status = tkrzw::DBMUpdateLoggerMQ::ParseUpdateLog(message.Get(), &op);
+  if (status != tkrzw::Status::SUCCESS) {
+    ThrowStatusException(self, status);
+    return nullptr;
+  }
+  const char* op_name = "void";
+  switch (op.op_type) {
+    case tkrzw::DBMUpdateLoggerMQ::OP_SET:
+      op_name = "set";
+      break;
+    case tkrzw::DBMUpdateLoggerMQ::OP_REMOVE:
+      op_name = "remove";
+      break;
+    case tkrzw::DBMUpdateLoggerMQ::OP_CLEAR:
+      op_name = "clear";
+      break;
+    default:
+      break;
+  }
+  PyObject* pyrv = PyTuple_New(5);
+  PyTuple_SET_ITEM(pyrv, 0, CreatePyString(op_name));
+  PyTuple_SET_ITEM(pyrv, 1, CreatePyBytes(op.key));
+  PyTuple_SET_ITEM(pyrv, 2, CreatePyBytes(op.value));
+  PyTuple_SET_ITEM(pyrv, 3, PyLong_FromLong(op.server_id));
+  PyTuple_SET_ITEM(pyrv, 4, PyLong_FromLong(op.dbm_index));
+  return pyrv;
+}
+
+// Defines the UpdateLogReader class.
+static bool DefineUpdateLogReader(PyObject* module, ModuleState* state) {
+  static PyMethodDef methods[] = {
+    {"Open", (PyCFunction)ulogreader_Open, METH_VARARGS,
+     "Opens the update log files of a prefix to read."},
+    {"Close", (PyCFunction)ulogreader_Close, METH_NOARGS,
+     "Closes the update log files."},
+    {"Read", (PyCFunction)ulogreader_Read, METH_VARARGS,
+     "Reads update log entries."},
+    {"GetTimestamp", (PyCFunction)ulogreader_GetTimestamp, METH_NOARGS,
+     "Gets the timestamp of the last read entry."},
+    {"ParseMessage", (PyCFunction)ulogreader_ParseMessage, METH_CLASS | METH_VARARGS,
+     "Parses an update log message."},
+    {nullptr, nullptr, 0, nullptr}
+  };
+  static PyType_Slot slots[] = {
+    {Py_tp_doc, (void*)"Reader of the update log of a database."},
+    {Py_tp_new, (void*)ulogreader_new},
+    {Py_tp_dealloc, (void*)ulogreader_dealloc},
+    {Py_tp_init, (void*)ulogreader_init},
+    {Py_tp_repr, (void*)ulogreader_repr},
+    {Py_tp_str, (void*)ulogreader_str},
+    {Py_tp_methods, (void*)methods},
+    {0, nullptr},
+  };
+  static PyType_Spec spec = {
+    "tkrzw.UpdateLogReader", sizeof(PyUpdateLogReader), 0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, slots};
+  state->cls_ulogreader = PyType_FromModuleAndSpec(module, &spec, nullptr);
+  if (state->cls_ulogreader == nullptr) return false;
+  if (PyModule_AddObjectRef(module, "UpdateLogReader", state->cls_ulogreader) != 0) return false;
   return true;
 }
 
+// Lists the references held by the module state.
+static std::vector<PyObject**> ListModuleStateRefs(ModuleState* state) {
+  return {&state->cls_utility, &state->cls_status, &state->cls_expt, &state->cls_future,
+          &state->cls_dbm, &state->cls_iter, &state->cls_rebuildjob, &state->cls_asyncdbm,
+          &state->cls_asyncexecutor, &state->cls_file, &state->cls_fileregion,
+          &state->cls_lineiter, &state->cls_asyncfile, &state->cls_flatwriter,
+          &state->cls_flatreader, &state->cls_index, &state->cls_indexiter,
+          &state->cls_ulogreader, &state->obj_dbm_any_data};
+}
+
+// Implementation of the traverse function of the module.
+static int module_traverse(PyObject* module, visitproc visit, void* arg) {
+  ModuleState* state = (ModuleState*)PyModule_GetState(module);
+  for (PyObject** ref : ListModuleStateRefs(state)) {
+    Py_VISIT(*ref);
+  }
+  return 0;
+}
+
+// Implementation of the clear function of the module.
+static int module_clear(PyObject* module) {
+  ModuleState* state = (ModuleState*)PyModule_GetState(module);
+  for (PyObject** ref : ListModuleStateRefs(state)) {
+    Py_CLEAR(*ref);
+  }
+  return 0;
+}
+
+// Implementation of the free function of the module.
+static void module_free(void* module) {
+  module_clear((PyObject*)module);
+}
+
+// Implementation of the exec function of the module.
+static int module_exec(PyObject* module) {
+  ModuleState* state = (ModuleState*)PyModule_GetState(module);
+  if (!DefineUtility(module, state)) return -1;
+  if (!DefineStatus(module, state)) return -1;
+  if (!DefineStatusException(module, state)) return -1;
+  if (!DefineFuture(module, state)) return -1;
+  if (!DefineDBM(module, state)) return -1;
+  if (!DefineIterator(module, state)) return -1;
+  if (!DefineRebuildJob(module, state)) return -1;
+  if (!DefineAsyncExecutor(module, state)) return -1;
+  if (!DefineAsyncDBM(module, state)) return -1;
+  if (!DefineFile(module, state)) return -1;
+  if (!DefineFileRegion(module, state)) return -1;
+  if (!DefineLineIterator(module, state)) return -1;
+  if (!DefineAsyncFile(module, state)) return -1;
+  if (!DefineFlatRecordWriter(module, state)) return -1;
+  if (!DefineFlatRecordReader(module, state)) return -1;
+  if (!DefineIndex(module, state)) return -1;
+  if (!DefineIndexIterator(module, state)) return -1;
+  if (!DefineUpdateLogReader(module, state)) return -1;
+  return 0;
+}
+
+// Makes the definition of the module.
+static PyModuleDef MakeModuleDef() {
+  PyModuleDef module_def = {PyModuleDef_HEAD_INIT};
+  const size_t zoff = offsetof(PyModuleDef, m_name);
+  std::memset((char*)&module_def + zoff, 0, sizeof(module_def) - zoff);
+  module_def.m_name = "tkrzw";
+  module_def.m_doc = "a set of implementations of DBM";
+  module_def.m_size = sizeof(ModuleState);
+  static PyMethodDef methods[] = {
+    {nullptr, nullptr, 0, nullptr},
+  };
+  module_def.m_methods = methods;
+  static PyModuleDef_Slot slots[] = {
+    {Py_mod_exec, (void*)module_exec},
+#if defined(Py_mod_multiple_interpreters)
+    {Py_mod_multiple_interpreters, Py_MOD_PER_INTERPRETER_GIL_SUPPORTED},
+#endif
+#if defined(Py_mod_gil)
+    {Py_mod_gil, Py_MOD_GIL_NOT_USED},
+#endif
+    {0, nullptr},
+  };
+  module_def.m_slots = slots;
+  module_def.m_traverse = module_traverse;
+  module_def.m_clear = module_clear;
+  module_def.m_free = module_free;
+  return module_def;
+}
+
+// Gets the definition of the module.
+static PyModuleDef* GetModuleDef() {
+  static PyModuleDef module_def = MakeModuleDef();
+  return &module_def;
+}
+
 // Entry point of the library.
 PyMODINIT_FUNC PyInit_tkrzw() {
-  if (!DefineModule()) return nullptr;
-  if (!DefineUtility()) return nullptr;
-  if (!DefineStatus()) return nullptr;
-  if (!DefineStatusException()) return nullptr;
-  if (!DefineFuture()) return nullptr;
-  if (!DefineDBM()) return nullptr;
-  if (!DefineIterator()) return nullptr;
-  if (!DefineAsyncDBM()) return nullptr;
-  if (!DefineFile()) return nullptr;
-  if (!DefineIndex()) return nullptr;
-  if (!DefineIndexIterator()) return nullptr;
-  return mod_tkrzw;
+  return PyModuleDef_Init(GetModuleDef());
 }
 
 }  // extern "C"